@@ -1,18 +1,233 @@
 #include "echo2.h"
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "envoy/buffer/buffer.h"
+#include "envoy/event/dispatcher.h"
 #include "envoy/network/connection.h"
 
 #include "source/common/common/assert.h"
+#include "source/common/network/connection_impl.h"
+#include "source/common/network/raw_buffer_socket.h"
+#include "source/common/protobuf/utility.h"
 
 namespace Envoy {
 namespace Filter {
 
-Network::FilterStatus Echo2::onData(Buffer::Instance& data, bool) {
+Echo2Config::Echo2Config(const echo2::Config& proto_config, Stats::Scope& scope)
+    : splice_(proto_config.splice()),
+      buffer_limit_(proto_config.has_buffer_limit_bytes()
+                        ? absl::make_optional(proto_config.buffer_limit_bytes().value())
+                        : absl::nullopt),
+      batch_max_bytes_(proto_config.batch().max_bytes()),
+      batch_max_delay_(Protobuf::util::TimeUtil::DurationToMicroseconds(
+          proto_config.batch().max_delay())),
+      stats_(generateStats(scope)) {}
+
+Echo2Stats Echo2Config::generateStats(Stats::Scope& scope) {
+  const std::string prefix = "echo2.";
+  return {ALL_ECHO2_STATS(POOL_COUNTER_PREFIX(scope, prefix), POOL_GAUGE_PREFIX(scope, prefix),
+                          POOL_HISTOGRAM_PREFIX(scope, prefix))};
+}
+
+Echo2::Echo2(Echo2ConfigSharedPtr config) : config_(config) {}
+
+Echo2::~Echo2() { closePipe(); }
+
+Network::FilterStatus Echo2::onData(Buffer::Instance& data, bool end_stream) {
   ENVOY_CONN_LOG(trace, "echo: got {} bytes", read_callbacks_->connection(), data.length());
-  read_callbacks_->connection().write(data, false);
+  if (!config_->batch()) {
+    read_callbacks_->connection().write(data, false);
+    return Network::FilterStatus::StopIteration;
+  }
+
+  if (batch_buffer_.length() > 0) {
+    config_->stats().batch_coalesced_reads_.inc();
+  }
+  batch_buffer_.move(data);
+  if (batch_buffer_.length() >= config_->batchMaxBytes()) {
+    config_->stats().batch_flush_max_bytes_.inc();
+    flushBatch();
+  } else if (end_stream) {
+    flushBatch();
+  } else if (!batch_timer_->enabled()) {
+    batch_timer_->enableHRTimer(config_->batchMaxDelay());
+  }
   return Network::FilterStatus::StopIteration;
 }
 
+Network::FilterStatus Echo2::onNewConnection() {
+  if (config_->bufferLimit().has_value()) {
+    read_callbacks_->connection().setBufferLimits(config_->bufferLimit().value());
+  }
+
+  if (config_->splice() && startSplice()) {
+    ENVOY_CONN_LOG(debug, "echo: using splice", read_callbacks_->connection());
+    return Network::FilterStatus::Continue;
+  }
+
+  if (config_->batch()) {
+    batch_timer_ = read_callbacks_->connection().dispatcher().createTimer([this]() {
+      config_->stats().batch_flush_max_delay_.inc();
+      flushBatch();
+    });
+  }
+  read_callbacks_->connection().addConnectionCallbacks(*this);
+  return Network::FilterStatus::Continue;
+}
+
+void Echo2::onEvent(Network::ConnectionEvent event) {
+  if (event == Network::ConnectionEvent::RemoteClose ||
+      event == Network::ConnectionEvent::LocalClose) {
+    // The socket is already closed at this point; drop the event before the fd can be reused.
+    splice_event_.reset();
+    closePipe();
+    if (batch_timer_ != nullptr) {
+      batch_timer_->disableTimer();
+    }
+    if (read_paused_at_.has_value()) {
+      resumeReading();
+    }
+  }
+}
+
+void Echo2::onAboveWriteBufferHighWatermark() {
+  ASSERT(!read_paused_at_.has_value());
+  ENVOY_CONN_LOG(debug, "echo: write buffer above high watermark, pausing reads",
+                 read_callbacks_->connection());
+  read_paused_at_ = read_callbacks_->connection().dispatcher().timeSource().monotonicTime();
+  config_->stats().flow_control_paused_reading_total_.inc();
+  config_->stats().flow_control_paused_reading_active_.inc();
+  read_callbacks_->connection().readDisable(true);
+}
+
+void Echo2::onBelowWriteBufferLowWatermark() {
+  if (!read_paused_at_.has_value()) {
+    return;
+  }
+  ENVOY_CONN_LOG(debug, "echo: write buffer below low watermark, resuming reads",
+                 read_callbacks_->connection());
+  resumeReading();
+}
+
+void Echo2::resumeReading() {
+  const auto paused = read_callbacks_->connection().dispatcher().timeSource().monotonicTime() -
+                      read_paused_at_.value();
+  read_paused_at_.reset();
+  config_->stats().flow_control_resumed_reading_total_.inc();
+  config_->stats().flow_control_paused_reading_active_.dec();
+  config_->stats().flow_control_paused_reading_ms_.recordValue(
+      std::chrono::duration_cast<std::chrono::milliseconds>(paused).count());
+  // Watermark callbacks also fire while a closing connection drains its write buffer.
+  if (read_callbacks_->connection().state() == Network::Connection::State::Open) {
+    read_callbacks_->connection().readDisable(false);
+  }
+}
+
+void Echo2::flushBatch() {
+  batch_timer_->disableTimer();
+  if (batch_buffer_.length() == 0) {
+    return;
+  }
+  ENVOY_CONN_LOG(trace, "echo: flushing batch of {} bytes", read_callbacks_->connection(),
+                 batch_buffer_.length());
+  config_->stats().batch_writes_.inc();
+  read_callbacks_->connection().write(batch_buffer_, false);
+}
+
+bool Echo2::startSplice() {
+#ifdef __linux__
+  // Splicing reads and writes the socket directly, which is only equivalent to the buffered path
+  // when the transport socket does not transform the bytes.
+  auto* connection = dynamic_cast<Network::ConnectionImpl*>(&read_callbacks_->connection());
+  if (connection == nullptr ||
+      dynamic_cast<Network::RawBufferSocket*>(connection->transportSocket().get()) == nullptr) {
+    ENVOY_CONN_LOG(debug, "echo: transport socket is not raw_buffer, not using splice",
+                   read_callbacks_->connection());
+    return false;
+  }
+
+  int fds[2];
+  if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+    ENVOY_CONN_LOG(debug, "echo: unable to create splice pipe: {}", *connection, errno);
+    return false;
+  }
+  pipe_read_fd_ = fds[0];
+  pipe_write_fd_ = fds[1];
+  socket_fd_ = connection->ioHandle().fdDoNotUse();
+
+  // The connection keeps its own file event for writes; a remote FIN is observed by splice()
+  // returning zero, so early close detection would only cut off data still in the pipe.
+  connection->addConnectionCallbacks(*this);
+  connection->detectEarlyCloseWhenReadDisabled(false);
+  connection->readDisable(true);
+  splice_event_ = connection->dispatcher().createFileEvent(
+      socket_fd_, [this](uint32_t) { onSpliceReady(); }, Event::PlatformDefaultTriggerType,
+      Event::FileReadyType::Read | Event::FileReadyType::Write);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void Echo2::onSpliceReady() {
+#ifdef __linux__
+  // Events are edge triggered, so keep going until either the socket has nothing left to read or
+  // the socket cannot take any more writes.
+  while (true) {
+    if (pipe_bytes_ > 0) {
+      const ssize_t rc = ::splice(pipe_read_fd_, nullptr, socket_fd_, nullptr, pipe_bytes_,
+                                  SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if (rc < 0) {
+        if (errno == EAGAIN) {
+          return;
+        }
+        ENVOY_CONN_LOG(debug, "echo: splice write failed: {}", read_callbacks_->connection(),
+                       errno);
+        read_callbacks_->connection().close(Network::ConnectionCloseType::NoFlush);
+        return;
+      }
+      pipe_bytes_ -= rc;
+      continue;
+    }
+
+    if (read_end_stream_) {
+      read_callbacks_->connection().close(Network::ConnectionCloseType::NoFlush);
+      return;
+    }
+
+    const ssize_t rc = ::splice(socket_fd_, nullptr, pipe_write_fd_, nullptr, SpliceChunkSize,
+                                SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (rc < 0) {
+      if (errno == EAGAIN) {
+        return;
+      }
+      ENVOY_CONN_LOG(debug, "echo: splice read failed: {}", read_callbacks_->connection(), errno);
+      read_callbacks_->connection().close(Network::ConnectionCloseType::NoFlush);
+      return;
+    }
+    ENVOY_CONN_LOG(trace, "echo: spliced {} bytes", read_callbacks_->connection(), rc);
+    read_end_stream_ = rc == 0;
+    pipe_bytes_ += rc;
+  }
+#endif
+}
+
+void Echo2::closePipe() {
+#ifdef __linux__
+  if (SOCKET_VALID(pipe_read_fd_)) {
+    ::close(pipe_read_fd_);
+    SET_SOCKET_INVALID(pipe_read_fd_);
+  }
+  if (SOCKET_VALID(pipe_write_fd_)) {
+    ::close(pipe_write_fd_);
+    SET_SOCKET_INVALID(pipe_write_fd_);
+  }
+#endif
+}
+
 } // namespace Filter
 } // namespace Envoy
@@ -1,26 +1,134 @@
 #pragma once
 
+#include <chrono>
+
+#include "envoy/event/file_event.h"
+#include "envoy/common/time.h"
+#include "envoy/event/timer.h"
+#include "envoy/network/connection.h"
 #include "envoy/network/filter.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
 
+#include "source/common/buffer/buffer_impl.h"
 #include "source/common/common/logger.h"
 
+#include "absl/types/optional.h"
+
+#include "echo2.pb.h"
+
 namespace Envoy {
 namespace Filter {
 
+/**
+ * All echo2 stats. @see stats_macros.h
+ */
+#define ALL_ECHO2_STATS(COUNTER, GAUGE, HISTOGRAM)                                                 \
+  COUNTER(batch_coalesced_reads)                                                                   \
+  COUNTER(batch_flush_max_bytes)                                                                   \
+  COUNTER(batch_flush_max_delay)                                                                   \
+  COUNTER(batch_writes)                                                                            \
+  COUNTER(flow_control_paused_reading_total)                                                       \
+  COUNTER(flow_control_resumed_reading_total)                                                      \
+  GAUGE(flow_control_paused_reading_active, Accumulate)                                            \
+  HISTOGRAM(flow_control_paused_reading_ms, Milliseconds)
+
+/**
+ * Struct definition for all echo2 stats. @see stats_macros.h
+ */
+struct Echo2Stats {
+  ALL_ECHO2_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT, GENERATE_HISTOGRAM_STRUCT)
+};
+
+/**
+ * Configuration for the echo2 filter, shared across all connections.
+ */
+class Echo2Config {
+public:
+  Echo2Config(const echo2::Config& proto_config, Stats::Scope& scope);
+
+  bool splice() const { return splice_; }
+  absl::optional<uint32_t> bufferLimit() const { return buffer_limit_; }
+  bool batch() const { return batch_max_bytes_ > 0; }
+  uint32_t batchMaxBytes() const { return batch_max_bytes_; }
+  std::chrono::microseconds batchMaxDelay() const { return batch_max_delay_; }
+  Echo2Stats& stats() { return stats_; }
+
+private:
+  static Echo2Stats generateStats(Stats::Scope& scope);
+
+  const bool splice_;
+  const absl::optional<uint32_t> buffer_limit_;
+  const uint32_t batch_max_bytes_;
+  const std::chrono::microseconds batch_max_delay_;
+  Echo2Stats stats_;
+};
+
+using Echo2ConfigSharedPtr = std::shared_ptr<Echo2Config>;
+
 /**
  * Implementation of a basic echo filter.
+ *
+ * When splice is enabled and the connection uses the raw_buffer transport socket, the connection
+ * is read disabled and the filter moves bytes socket -> pipe -> socket with splice(2), so the
+ * payload never enters a Buffer::Instance. Bytes moved this way bypass the connection's read and
+ * write buffers and are therefore not reflected in the connection's buffer stats.
+ *
+ * When batching is enabled, the buffered path holds echoed bytes until either the configured
+ * byte count is pending or the configured delay since the first pending read has passed, and
+ * then writes them with a single connection write.
+ *
+ * The buffered path takes part in flow control: once the connection's write buffer is above its
+ * high watermark the filter stops reading from the connection, and resumes once the buffer drains
+ * below the low watermark, so a slow reader cannot grow the write buffer without bound. The
+ * splice path gets the same effect by not reading while the socket cannot take writes.
  */
-class Echo2 : public Network::ReadFilter, Logger::Loggable<Logger::Id::filter> {
+class Echo2 : public Network::ReadFilter,
+              public Network::ConnectionCallbacks,
+              Logger::Loggable<Logger::Id::filter> {
 public:
+  Echo2(Echo2ConfigSharedPtr config);
+  ~Echo2() override;
+
   // Network::ReadFilter
   Network::FilterStatus onData(Buffer::Instance& data, bool end_stream) override;
-  Network::FilterStatus onNewConnection() override { return Network::FilterStatus::Continue; }
+  Network::FilterStatus onNewConnection() override;
   void initializeReadFilterCallbacks(Network::ReadFilterCallbacks& callbacks) override {
     read_callbacks_ = &callbacks;
   }
 
+  // Network::ConnectionCallbacks
+  void onEvent(Network::ConnectionEvent event) override;
+  void onAboveWriteBufferHighWatermark() override;
+  void onBelowWriteBufferLowWatermark() override;
+
 private:
+  // Upper bound on the bytes moved by a single splice(2) call.
+  static constexpr size_t SpliceChunkSize = 64 * 1024;
+
+  void flushBatch();
+  void resumeReading();
+  bool startSplice();
+  void onSpliceReady();
+  void closePipe();
+
+  const Echo2ConfigSharedPtr config_;
   Network::ReadFilterCallbacks* read_callbacks_{};
+
+  // Set while reads are disabled because the write buffer is above its high watermark.
+  absl::optional<MonotonicTime> read_paused_at_;
+
+  // Batch state, only used when the config enables batching.
+  Buffer::OwnedImpl batch_buffer_;
+  Event::TimerPtr batch_timer_;
+
+  // Splice state, only used once startSplice() has succeeded.
+  Event::FileEventPtr splice_event_;
+  os_fd_t socket_fd_{INVALID_SOCKET};
+  os_fd_t pipe_read_fd_{INVALID_SOCKET};
+  os_fd_t pipe_write_fd_{INVALID_SOCKET};
+  size_t pipe_bytes_{};
+  bool read_end_stream_{};
 };
 
 } // namespace Filter
@@ -0,0 +1,264 @@
+// Throughput and latency benchmarks for echo2 running behind a real listener, compared against
+// the upstream envoy.filters.network.echo filter. Run with:
+//
+//   bazel run -c opt //:echo2_benchmark
+//
+// Each benchmark argument tuple is {connections, message size, worker threads}. Every
+// connection keeps exactly one message in flight, so items_per_second (requests per second),
+// bytes_per_second and the p50/p99/p999 latency counters describe a closed loop.
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/event/libevent.h"
+#include "source/common/network/filter_impl.h"
+
+#include "test/benchmark/main.h"
+#include "test/integration/integration.h"
+#include "test/test_common/environment.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+
+// The integration tests read echo2_server.yaml from runfiles, which the benchmark main does not
+// set up, so the same listener configuration is embedded here with the filter left open.
+constexpr absl::string_view BenchmarkConfig = R"EOF(
+admin:
+  access_log_path: /dev/null
+  address:
+    socket_address:
+      address: 127.0.0.1
+      port_value: 0
+static_resources:
+  clusters:
+    name: cluster_0
+    connect_timeout: 0.25s
+    load_assignment:
+      cluster_name: cluster_0
+      endpoints:
+        - lb_endpoints:
+            - endpoint:
+                address:
+                  socket_address:
+                    address: 127.0.0.1
+                    port_value: 0
+  listeners:
+    name: listener_0
+    address:
+      socket_address:
+        address: 127.0.0.1
+        port_value: 0
+    filter_chains:
+    - filters:
+)EOF";
+
+// Round trips completed per benchmark iteration, spread across all connections.
+constexpr uint64_t RoundTripsPerIteration = 10000;
+
+class Echo2Benchmark : public BaseIntegrationTest {
+public:
+  Echo2Benchmark(absl::string_view filter_config, uint32_t workers)
+      : BaseIntegrationTest(TestEnvironment::getIpVersionsForTest().front(),
+                            absl::StrCat(BenchmarkConfig, filter_config)) {
+    concurrency_ = workers;
+    initialize();
+  }
+
+  ~Echo2Benchmark() override {
+    for (auto& connection : connections_) {
+      connection->close(Network::ConnectionCloseType::NoFlush);
+    }
+    connections_.clear();
+    test_server_.reset();
+    fake_upstreams_.clear();
+  }
+
+  /**
+   * Opens connections to the listener and waits until all of them are connected.
+   */
+  void connect(uint32_t connections, uint32_t message_size) {
+    message_ = std::string(message_size, 'a');
+    for (uint32_t i = 0; i < connections; i++) {
+      connections_.push_back(makeClientConnection(lookupPort("listener_0")));
+      auto client = std::make_shared<Client>(*this, *connections_.back());
+      connections_.back()->addConnectionCallbacks(*client);
+      connections_.back()->addReadFilter(client);
+      connections_.back()->connect();
+      clients_.push_back(client);
+    }
+    dispatcher_->run(Event::Dispatcher::RunType::Block);
+  }
+
+  /**
+   * Runs the given number of round trips across all connections and records their latencies.
+   */
+  void run(uint64_t round_trips) {
+    pending_ = round_trips;
+    completed_ = 0;
+    target_ = round_trips;
+    for (auto& client : clients_) {
+      if (pending_ == 0) {
+        break;
+      }
+      pending_--;
+      client->send();
+    }
+    dispatcher_->run(Event::Dispatcher::RunType::Block);
+  }
+
+  std::vector<std::chrono::nanoseconds>& latencies() { return latencies_; }
+
+private:
+  class Client : public Network::ReadFilterBaseImpl, public Network::ConnectionCallbacks {
+  public:
+    Client(Echo2Benchmark& parent, Network::ClientConnection& connection)
+        : parent_(parent), connection_(connection) {}
+
+    void send() {
+      sent_at_ = parent_.timeSystem().monotonicTime();
+      Buffer::OwnedImpl buffer(parent_.message_);
+      connection_.write(buffer, false);
+    }
+
+    // Network::ReadFilter
+    Network::FilterStatus onData(Buffer::Instance& data, bool) override {
+      received_ += data.length();
+      data.drain(data.length());
+      if (received_ >= parent_.message_.size()) {
+        received_ -= parent_.message_.size();
+        parent_.onRoundTrip(*this, parent_.timeSystem().monotonicTime() - sent_at_);
+      }
+      return Network::FilterStatus::StopIteration;
+    }
+
+    // Network::ConnectionCallbacks
+    void onEvent(Network::ConnectionEvent event) override {
+      if (event == Network::ConnectionEvent::Connected) {
+        parent_.onConnected();
+      } else if (event == Network::ConnectionEvent::RemoteClose) {
+        RELEASE_ASSERT(false, "echo listener closed a benchmark connection");
+      }
+    }
+    void onAboveWriteBufferHighWatermark() override {}
+    void onBelowWriteBufferLowWatermark() override {}
+
+  private:
+    Echo2Benchmark& parent_;
+    Network::ClientConnection& connection_;
+    MonotonicTime sent_at_;
+    uint64_t received_{};
+  };
+
+  void onConnected() {
+    if (++connected_ == connections_.size()) {
+      dispatcher_->exit();
+    }
+  }
+
+  void onRoundTrip(Client& client, MonotonicTime::duration latency) {
+    latencies_.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(latency));
+    if (++completed_ == target_) {
+      dispatcher_->exit();
+      return;
+    }
+    if (pending_ > 0) {
+      pending_--;
+      client.send();
+    }
+  }
+
+  std::string message_;
+  std::vector<Network::ClientConnectionPtr> connections_;
+  std::vector<std::shared_ptr<Client>> clients_;
+  std::vector<std::chrono::nanoseconds> latencies_;
+  size_t connected_{};
+  uint64_t pending_{};
+  uint64_t completed_{};
+  uint64_t target_{};
+};
+
+static double percentileUs(std::vector<std::chrono::nanoseconds>& latencies, double percentile) {
+  if (latencies.empty()) {
+    return 0;
+  }
+  const size_t index =
+      std::min(latencies.size() - 1, static_cast<size_t>(percentile * latencies.size()));
+  std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+  return std::chrono::duration<double, std::micro>(latencies[index]).count();
+}
+
+static void runEcho(::benchmark::State& state, absl::string_view filter_config) {
+  const uint32_t connections = state.range(0);
+  const uint32_t message_size = state.range(1);
+  const uint32_t workers = state.range(2);
+
+  // Skip expensive benchmarks for unit tests.
+  if (benchmark::skipExpensiveBenchmarks() && (connections > 1 || workers > 1)) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  if (!Event::Libevent::Global::initialized()) {
+    Event::Libevent::Global::initialize();
+  }
+  Echo2Benchmark echo(filter_config, workers);
+  echo.connect(connections, message_size);
+
+  const uint64_t round_trips = benchmark::skipExpensiveBenchmarks() ? 10 : RoundTripsPerIteration;
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    echo.run(round_trips);
+  }
+
+  const uint64_t total = round_trips * state.iterations();
+  state.SetItemsProcessed(total);
+  state.SetBytesProcessed(total * message_size);
+  state.counters["p50_us"] = percentileUs(echo.latencies(), 0.5);
+  state.counters["p99_us"] = percentileUs(echo.latencies(), 0.99);
+  state.counters["p999_us"] = percentileUs(echo.latencies(), 0.999);
+}
+
+static void echoArgs(::benchmark::internal::Benchmark* b) {
+  for (int64_t connections : {1, 16, 128}) {
+    for (int64_t message_size : {64, 1024, 16384}) {
+      for (int64_t workers : {1, 4}) {
+        b->Args({connections, message_size, workers});
+      }
+    }
+  }
+}
+
+static void bmEcho2(::benchmark::State& state) {
+  runEcho(state, R"EOF(
+      - name: echo2
+        typed_config:
+)EOF");
+}
+BENCHMARK(bmEcho2)->Apply(echoArgs)->UseRealTime()->Unit(::benchmark::kMillisecond);
+
+static void bmEcho2Splice(::benchmark::State& state) {
+  runEcho(state, R"EOF(
+      - name: echo2
+        typed_config:
+          "@type": type.googleapis.com/echo2.Config
+          splice: true
+)EOF");
+}
+BENCHMARK(bmEcho2Splice)->Apply(echoArgs)->UseRealTime()->Unit(::benchmark::kMillisecond);
+
+// The upstream filter this example was derived from, as the baseline for regressions.
+static void bmUpstreamEcho(::benchmark::State& state) {
+  runEcho(state, R"EOF(
+      - name: envoy.filters.network.echo
+        typed_config:
+)EOF");
+}
+BENCHMARK(bmUpstreamEcho)->Apply(echoArgs)->UseRealTime()->Unit(::benchmark::kMillisecond);
+
+} // namespace Envoy
@@ -0,0 +1,11 @@
+#!/bin/bash
+#
+
+set -e
+
+# Only verify that the benchmarks run to completion; see echo2_benchmark_test.cc for how to
+# take real measurements. The two flag parsers require the -- separator.
+"${TEST_SRCDIR}/envoy_filter_example/echo2_benchmark" --skip_expensive_benchmarks -- \
+  --benchmark_min_time=0
+
+echo "PASS"
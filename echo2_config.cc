@@ -5,6 +5,9 @@
 #include "envoy/registry/registry.h"
 #include "envoy/server/filter_config.h"
 
+#include "echo2.pb.h"
+#include "echo2.pb.validate.h"
+
 namespace Envoy {
 namespace Server {
 namespace Configuration {
@@ -14,15 +17,20 @@ namespace Configuration {
  */
 class Echo2ConfigFactory : public NamedNetworkFilterConfigFactory {
 public:
-  Network::FilterFactoryCb createFilterFactoryFromProto(const Protobuf::Message&,
-                                                        FactoryContext&) override {
-    return [](Network::FilterManager& filter_manager) -> void {
-      filter_manager.addReadFilter(Network::ReadFilterSharedPtr{new Filter::Echo2()});
+  Network::FilterFactoryCb createFilterFactoryFromProto(const Protobuf::Message& proto_config,
+                                                        FactoryContext& context) override {
+    Filter::Echo2ConfigSharedPtr config = std::make_shared<Filter::Echo2Config>(
+        Envoy::MessageUtil::downcastAndValidate<const echo2::Config&>(
+            proto_config, context.messageValidationVisitor()),
+        context.scope());
+
+    return [config](Network::FilterManager& filter_manager) -> void {
+      filter_manager.addReadFilter(Network::ReadFilterSharedPtr{new Filter::Echo2(config)});
     };
   }
 
   ProtobufTypes::MessagePtr createEmptyConfigProto() override {
-    return ProtobufTypes::MessagePtr{new Envoy::ProtobufWkt::Struct()};
+    return ProtobufTypes::MessagePtr{new echo2::Config()};
   }
 
   std::string name() const override { return "echo2"; }
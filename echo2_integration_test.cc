@@ -5,13 +5,21 @@ namespace Envoy {
 class Echo2IntegrationTest : public BaseIntegrationTest,
                              public testing::TestWithParam<Network::Address::IpVersion> {
 
-  std::string echoConfig() {
+protected:
+  static std::string echoConfig() {
     return TestEnvironment::readFileToStringForTest(
         TestEnvironment::runfilesPath("echo2_server.yaml", "envoy_filter_example"));
   }
 
+  // Returns the echo config with the given echo2.Config fields added to the filter.
+  static std::string echo2Config(const std::string& fields) {
+    return echoConfig() + "          \"@type\": type.googleapis.com/echo2.Config\n" + fields;
+  }
+
+  Echo2IntegrationTest(const std::string& config) : BaseIntegrationTest(GetParam(), config) {}
+
 public:
-  Echo2IntegrationTest() : BaseIntegrationTest(GetParam(), echoConfig()) {}
+  Echo2IntegrationTest() : Echo2IntegrationTest(echoConfig()) {}
   /**
    * Initializer for an individual integration test.
    */
@@ -24,6 +32,24 @@ public:
     test_server_.reset();
     fake_upstreams_.clear();
   }
+
+  /**
+   * Sends the given payload and returns everything echoed back until the payload size is reached.
+   */
+  std::string echo(const std::string& payload) {
+    std::string response;
+    auto connection = createConnectionDriver(
+        lookupPort("listener_0"), payload,
+        [&](Network::ClientConnection& conn, const Buffer::Instance& data) -> void {
+          response.append(data.toString());
+          if (response.size() >= payload.size()) {
+            conn.close(Network::ConnectionCloseType::FlushWrite);
+          }
+        });
+
+    connection->run();
+    return response;
+  }
 };
 
 INSTANTIATE_TEST_SUITE_P(IpVersions, Echo2IntegrationTest,
@@ -35,10 +61,81 @@ TEST_P(Echo2IntegrationTest, Echo) {
       lookupPort("listener_0"), "hello",
       [&](Network::ClientConnection& conn, const Buffer::Instance& data) -> void {
         response.append(data.toString());
-	conn.close(Network::ConnectionCloseType::FlushWrite);
+        conn.close(Network::ConnectionCloseType::FlushWrite);
       });
 
   connection->run();
   EXPECT_EQ("hello", response);
 }
+
+class Echo2SpliceIntegrationTest : public Echo2IntegrationTest {
+public:
+  Echo2SpliceIntegrationTest()
+      : Echo2IntegrationTest(echo2Config("          splice: true\n")) {}
+};
+
+INSTANTIATE_TEST_SUITE_P(IpVersions, Echo2SpliceIntegrationTest,
+                         testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
+
+TEST_P(Echo2SpliceIntegrationTest, Echo) { EXPECT_EQ("hello", echo("hello")); }
+
+// Larger than a single splice chunk and the default pipe capacity.
+TEST_P(Echo2SpliceIntegrationTest, EchoLargePayload) {
+  const std::string payload(256 * 1024, 'a');
+  EXPECT_EQ(payload, echo(payload));
+}
+
+class Echo2BatchIntegrationTest : public Echo2IntegrationTest {
+public:
+  Echo2BatchIntegrationTest()
+      : Echo2IntegrationTest(echo2Config("          batch:\n"
+                                         "            max_bytes: 1024\n"
+                                         "            max_delay: 0.001s\n")) {}
+};
+
+INSTANTIATE_TEST_SUITE_P(IpVersions, Echo2BatchIntegrationTest,
+                         testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
+
+// A read smaller than max_bytes is flushed by the delay timer.
+TEST_P(Echo2BatchIntegrationTest, FlushOnDelay) {
+  EXPECT_EQ("hello", echo("hello"));
+  test_server_->waitForCounterGe("echo2.batch_flush_max_delay", 1);
+  test_server_->waitForCounterGe("echo2.batch_writes", 1);
+}
+
+// Reads reaching max_bytes are flushed without waiting for the timer.
+TEST_P(Echo2BatchIntegrationTest, FlushOnMaxBytes) {
+  const std::string payload(64 * 1024, 'a');
+  EXPECT_EQ(payload, echo(payload));
+  test_server_->waitForCounterGe("echo2.batch_flush_max_bytes", 1);
+}
+
+class Echo2FlowControlIntegrationTest : public Echo2IntegrationTest {
+public:
+  Echo2FlowControlIntegrationTest()
+      : Echo2IntegrationTest(echo2Config("          buffer_limit_bytes: 1024\n")) {}
+};
+
+INSTANTIATE_TEST_SUITE_P(IpVersions, Echo2FlowControlIntegrationTest,
+                         testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
+
+// A client that stops reading makes echo2 stop reading too, and reads resume once the client
+// drains the echoed data.
+TEST_P(Echo2FlowControlIntegrationTest, SlowReader) {
+  // Large enough to fill the kernel socket buffers on both sides of the loopback connection.
+  const std::string payload(16 * 1024 * 1024, 'a');
+  IntegrationTcpClientPtr tcp_client = makeTcpConnection(lookupPort("listener_0"));
+  tcp_client->readDisable(true);
+  // The write cannot drain while neither side reads, so don't wait for it.
+  ASSERT_TRUE(tcp_client->write(payload, false, false, TestUtility::DefaultTimeout, false));
+  test_server_->waitForCounterGe("echo2.flow_control_paused_reading_total", 1);
+  test_server_->waitForGaugeEq("echo2.flow_control_paused_reading_active", 1);
+  EXPECT_EQ(0, test_server_->counter("echo2.flow_control_resumed_reading_total")->value());
+
+  tcp_client->readDisable(false);
+  ASSERT_TRUE(tcp_client->waitForData(payload.size()));
+  test_server_->waitForCounterGe("echo2.flow_control_resumed_reading_total", 1);
+  test_server_->waitForGaugeEq("echo2.flow_control_paused_reading_active", 0);
+  tcp_client->close();
+}
 } // namespace Envoy
@@ -326,6 +326,20 @@ public:
    *  returned.
    */
   virtual absl::optional<std::chrono::milliseconds> lastRoundTripTime() const PURE;
+
+  /**
+   * Starts moving the data read from this connection straight to the socket of peer, and the data
+   * read from peer straight to this socket, through kernel pipes with splice(2). The data no
+   * longer passes through the read or write filters of either connection. The read filters are
+   * still told about end of stream, with no data, so that they can half-close or close the other
+   * connection as they would otherwise. Both connections must be open and on the same dispatcher.
+   * Note: Splicing is only possible on Linux, for plaintext connections whose IoHandle supports it
+   * (see IoHandle::supportsSplice()), whose buffers are empty and that have at most one read
+   * filter and no write filters.
+   * @param peer supplies the connection to exchange data with.
+   * @return bool whether splicing was started. If not, neither connection is changed.
+   */
+  virtual bool startSplice(Connection& peer) PURE;
 };
 
 using ConnectionPtr = std::unique_ptr<Connection>;
@@ -199,6 +199,12 @@ public:
    */
   virtual bool supportsUdpGro() const PURE;
 
+  /**
+   * return true if the file descriptor is a plain socket that may be read and written directly
+   * with splice(2), bypassing the handle's own read and write methods.
+   */
+  virtual bool supportsSplice() const { return false; }
+
   /**
    * Bind to address. The handle should have been created with a call to socket()
    * @param address address to bind to.
@@ -156,6 +156,13 @@ public:
    * @return boolean indicating if the transport socket was able to start secure transport.
    */
   virtual bool startSecureTransport() PURE;
+
+  /**
+   * @return bool whether the transport socket passes data to and from the underlying socket
+   *         unchanged, so that the connection may move data with splice(2) instead of doRead and
+   *         doWrite. See Connection::startSplice().
+   */
+  virtual bool supportsSplice() const { return false; }
 };
 
 using TransportSocketPtr = std::unique_ptr<TransportSocket>;
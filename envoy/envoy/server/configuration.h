@@ -84,6 +84,12 @@ public:
    * @return bool indicator to flush stats on-demand via the admin interface instead of on a timer.
    */
   virtual bool flushOnAdmin() const PURE;
+
+  /**
+   * @return bool whether each flush hands the sinks only the stats that changed since the previous
+   *         flush.
+   */
+  virtual bool flushChangedOnly() const PURE;
 };
 
 /**
@@ -58,6 +58,14 @@ public:
   virtual const SymbolTable& constSymbolTable() const PURE;
   virtual SymbolTable& symbolTable() PURE;
 
+  /**
+   * Shards the counters that are made from now on, so that threads incrementing the same counter
+   * don't contend for its cache line. Reading a sharded counter sums its shards, so it costs more.
+   * Only the first call with more than one shard has an effect.
+   * @param shards the number of shards, which is best set to the number of threads.
+   */
+  virtual void setCounterShards(uint32_t shards) PURE;
+
   /**
    * Mark rejected stats as deleted by moving them to a different vector, so they don't show up
    * when iterating over stats, but prevent crashes when trying to access references to them.
@@ -84,6 +92,19 @@ public:
   virtual void forEachTextReadout(std::function<void(std::size_t)> f_size,
                                   std::function<void(Stats::TextReadout&)> f_stat) const PURE;
 
+  /**
+   * Like forEachCounter(), forEachGauge() and forEachTextReadout(), but only visits the stats that
+   * changed since the previous call of the same method. The first call visits every stat, and
+   * starts tracking changes to that kind of stat; until then, tracking costs nothing. Changed stats
+   * are not referenced while tracked, so a stat that is freed after it changed is not visited.
+   */
+  virtual void forEachChangedCounter(std::function<void(std::size_t)> f_size,
+                                     std::function<void(Stats::Counter&)> f_stat) PURE;
+  virtual void forEachChangedGauge(std::function<void(std::size_t)> f_size,
+                                   std::function<void(Stats::Gauge&)> f_stat) PURE;
+  virtual void forEachChangedTextReadout(std::function<void(std::size_t)> f_size,
+                                         std::function<void(Stats::TextReadout&)> f_stat) PURE;
+
   // TODO(jmarantz): create a parallel mechanism to instantiate histograms. At
   // the moment, histograms don't fit the same pattern of counters and gauges
   // as they are not actually created in the context of a stats allocator.
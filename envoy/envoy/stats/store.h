@@ -17,6 +17,10 @@ namespace Event {
 class Dispatcher;
 }
 
+namespace Thread {
+class ThreadFactory;
+}
+
 namespace ThreadLocal {
 class Instance;
 }
@@ -65,6 +69,19 @@ public:
 
   virtual void forEachTextReadout(std::function<void(std::size_t)> f_size,
                                   std::function<void(Stats::TextReadout&)> f_stat) const PURE;
+
+  /**
+   * Iterate over the stats that changed since the previous call of the same method.
+   * @see Allocator::forEachChangedCounter().
+   */
+  virtual void forEachChangedCounter(std::function<void(std::size_t)> f_size,
+                                     std::function<void(Stats::Counter&)> f_stat) PURE;
+
+  virtual void forEachChangedGauge(std::function<void(std::size_t)> f_size,
+                                   std::function<void(Stats::Gauge&)> f_stat) PURE;
+
+  virtual void forEachChangedTextReadout(std::function<void(std::size_t)> f_size,
+                                         std::function<void(Stats::TextReadout&)> f_stat) PURE;
 };
 
 using StorePtr = std::unique_ptr<Store>;
@@ -102,6 +119,21 @@ public:
    */
   virtual void setHistogramSettings(HistogramSettingsConstPtr&& histogram_settings) PURE;
 
+  /**
+   * Shards the counters that are created from now on. @see Allocator::setCounterShards().
+   */
+  virtual void setCounterShards(uint32_t shards) PURE;
+
+  /**
+   * Spreads the merge of the histograms in mergeHistograms() over the given number of threads. The
+   * main thread is one of them, and waits for the others to finish.
+   * @param threads the number of threads, including the main thread.
+   * @param thread_factory creates the other threads, which are started here and kept for every
+   *        later merge.
+   */
+  virtual void setHistogramMergeThreads(uint32_t threads,
+                                        Thread::ThreadFactory& thread_factory) PURE;
+
   /**
    * Initialize the store for threading. This will be called once after all worker threads have
    * been initialized. At this point the store can initialize itself for multi-threaded operation.
@@ -102,6 +102,15 @@ public:
    */
   virtual Tcp::ConnectionPool::ConnectionData*
   onDownstreamEvent(Network::ConnectionEvent event) PURE;
+
+  /**
+   * Starts splicing the data of the downstream connection to and from the upstream.
+   * @see Network::Connection::startSplice().
+   * @param downstream supplies the downstream connection.
+   * @return bool whether splicing was started. It is not for upstreams which are not plain
+   *         connections, such as HTTP tunnels.
+   */
+  virtual bool startSplice(Network::Connection& downstream) PURE;
 };
 
 using GenericConnPoolPtr = std::unique_ptr<GenericConnPool>;
@@ -1,5 +1,6 @@
 #include "source/common/access_log/access_log_manager_impl.h"
 
+#include <algorithm>
 #include <string>
 
 #include "envoy/common/exception.h"
@@ -12,6 +13,17 @@
 
 namespace Envoy {
 namespace AccessLog {
+namespace {
+
+// An index for the calling thread, assigned on its first call. Threads write to the shard of their
+// index.
+uint32_t threadIndex() {
+  static std::atomic<uint32_t> next_index{0};
+  static thread_local const uint32_t index = next_index++;
+  return index;
+}
+
+} // namespace
 
 AccessLogManagerImpl::~AccessLogManagerImpl() {
   for (auto& [log_key, log_file_ptr] : access_logs_) {
@@ -34,23 +46,91 @@ AccessLogManagerImpl::createAccessLog(const Filesystem::FilePathAndType& file_in
   if (access_logs_.count(file_name)) {
     return access_logs_[file_name];
   }
-  access_logs_[file_name] =
-      std::make_shared<AccessLogFileImpl>(std::move(file), dispatcher_, lock_, file_stats_,
-                                          file_flush_interval_msec_, api_.threadFactory());
+  if (flush_thread_ == nullptr) {
+    flush_thread_ = std::make_shared<AccessLogFlushThread>(api_.threadFactory());
+  }
+  access_logs_[file_name] = std::make_shared<AccessLogFileImpl>(
+      std::move(file), dispatcher_, lock_, file_stats_, file_flush_interval_msec_, flush_thread_);
   return access_logs_[file_name];
 }
 
+AccessLogFlushThread::~AccessLogFlushThread() {
+  Thread::ThreadPtr thread;
+  {
+    Thread::LockGuard lock(mutex_);
+    exit_ = true;
+    request_event_.notifyOne();
+    thread = std::move(thread_);
+  }
+
+  if (thread != nullptr) {
+    thread->join();
+  }
+}
+
+void AccessLogFlushThread::requestFlush(AccessLogFileImpl& file) {
+  if (file.flush_requested_.exchange(true)) {
+    return;
+  }
+
+  Thread::LockGuard lock(mutex_);
+  if (thread_ == nullptr) {
+    thread_ = thread_factory_.createThread([this]() -> void { threadRoutine(); },
+                                           Thread::Options{"AccessLogFlush"});
+  }
+  requests_.push_back(&file);
+  request_event_.notifyOne();
+}
+
+void AccessLogFlushThread::removeFile(AccessLogFileImpl& file) {
+  Thread::LockGuard lock(mutex_);
+  requests_.erase(std::remove(requests_.begin(), requests_.end(), &file), requests_.end());
+  while (flushing_ == &file) {
+    flushed_event_.wait(mutex_);
+  }
+}
+
+void AccessLogFlushThread::threadRoutine() {
+  while (true) {
+    AccessLogFileImpl* file;
+    {
+      Thread::LockGuard lock(mutex_);
+      while (requests_.empty() && !exit_) {
+        // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
+        request_event_.wait(mutex_);
+      }
+
+      if (exit_) {
+        return;
+      }
+
+      file = requests_.front();
+      requests_.pop_front();
+      flushing_ = file;
+    }
+
+    file->flushFromThread();
+
+    {
+      Thread::LockGuard lock(mutex_);
+      flushing_ = nullptr;
+      flushed_event_.notifyAll();
+    }
+  }
+}
+
 AccessLogFileImpl::AccessLogFileImpl(Filesystem::FilePtr&& file, Event::Dispatcher& dispatcher,
                                      Thread::BasicLockable& lock, AccessLogFileStats& stats,
                                      std::chrono::milliseconds flush_interval_msec,
-                                     Thread::ThreadFactory& thread_factory)
-    : file_(std::move(file)), file_lock_(lock),
+                                     AccessLogFlushThreadSharedPtr flush_thread)
+    : file_(std::move(file)), file_lock_(lock), write_shards_(new WriteShard[WRITE_SHARDS]),
       flush_timer_(dispatcher.createTimer([this]() -> void {
         stats_.flushed_by_timer_.inc();
-        flush_event_.notifyOne();
+        requestFlush();
         flush_timer_->enableTimer(flush_interval_msec_);
       })),
-      thread_factory_(thread_factory), flush_interval_msec_(flush_interval_msec), stats_(stats) {
+      flush_thread_(std::move(flush_thread)), flush_interval_msec_(flush_interval_msec),
+      stats_(stats) {
   flush_timer_->enableTimer(flush_interval_msec_);
   auto open_result = open();
   if (!open_result.return_value_) {
@@ -75,20 +155,14 @@ Api::IoCallBoolResult AccessLogFileImpl::open() {
 void AccessLogFileImpl::reopen() { reopen_file_ = true; }
 
 AccessLogFileImpl::~AccessLogFileImpl() {
-  {
-    Thread::LockGuard lock(write_lock_);
-    flush_thread_exit_ = true;
-    flush_event_.notifyOne();
-  }
-
-  if (flush_thread_ != nullptr) {
-    flush_thread_->join();
-  }
+  flush_thread_->removeFile(*this);
 
   // Flush any remaining data. If file was not opened for some reason, skip flushing part.
   if (file_->isOpen()) {
-    if (flush_buffer_.length() > 0) {
-      doWrite(flush_buffer_);
+    Thread::LockGuard flush_lock(flush_lock_);
+    collectWriteShards();
+    if (about_to_write_buffer_.length() > 0) {
+      doWrite(about_to_write_buffer_);
     }
     const Api::IoCallBoolResult result = file_->close();
     ASSERT(result.return_value_, fmt::format("unable to close file '{}': {}", file_->path(),
@@ -96,6 +170,14 @@ AccessLogFileImpl::~AccessLogFileImpl() {
   }
 }
 
+void AccessLogFileImpl::collectWriteShards() {
+  for (uint32_t shard = 0; shard < WRITE_SHARDS; shard++) {
+    WriteShard& write_shard = write_shards_[shard];
+    Thread::LockGuard lock(write_shard.lock_);
+    about_to_write_buffer_.move(write_shard.buffer_);
+  }
+}
+
 void AccessLogFileImpl::doWrite(Buffer::Instance& buffer) {
   Buffer::RawSliceVector slices = buffer.getRawSlices();
 
@@ -125,91 +207,65 @@ void AccessLogFileImpl::doWrite(Buffer::Instance& buffer) {
   buffer.drain(buffer.length());
 }
 
-void AccessLogFileImpl::flushThreadFunc() {
+void AccessLogFileImpl::flushFromThread() {
+  // Cleared before the write shards are collected, so that data written after that asks for
+  // another flush.
+  flush_requested_ = false;
 
-  while (true) {
-    std::unique_lock<Thread::BasicLockable> flush_lock;
+  Thread::LockGuard flush_lock(flush_lock_);
+  collectWriteShards();
 
-    {
-      Thread::LockGuard write_lock(write_lock_);
-
-      // flush_event_ can be woken up either by large enough flush_buffer or by timer.
-      // In case it was timer, flush_buffer_ can be empty.
-      while (flush_buffer_.length() == 0 && !flush_thread_exit_ && !reopen_file_) {
-        // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
-        flush_event_.wait(write_lock_);
-      }
-
-      if (flush_thread_exit_) {
+  // if we failed to open file before, then simply ignore
+  if (file_->isOpen()) {
+    if (reopen_file_) {
+      reopen_file_ = false;
+      const Api::IoCallBoolResult result = file_->close();
+      ASSERT(result.return_value_, fmt::format("unable to close file '{}': {}", file_->path(),
+                                               result.err_->getErrorDetails()));
+      const Api::IoCallBoolResult open_result = open();
+      if (!open_result.return_value_) {
+        stats_.reopen_failed_.inc();
         return;
       }
-
-      flush_lock = std::unique_lock<Thread::BasicLockable>(flush_lock_);
-      about_to_write_buffer_.move(flush_buffer_);
-      ASSERT(flush_buffer_.length() == 0);
-    }
-
-    // if we failed to open file before, then simply ignore
-    if (file_->isOpen()) {
-      if (reopen_file_) {
-        reopen_file_ = false;
-        const Api::IoCallBoolResult result = file_->close();
-        ASSERT(result.return_value_, fmt::format("unable to close file '{}': {}", file_->path(),
-                                                 result.err_->getErrorDetails()));
-        const Api::IoCallBoolResult open_result = open();
-        if (!open_result.return_value_) {
-          stats_.reopen_failed_.inc();
-          return;
-        }
-      }
-      doWrite(about_to_write_buffer_);
     }
+    doWrite(about_to_write_buffer_);
   }
 }
 
-void AccessLogFileImpl::flush() {
-  std::unique_lock<Thread::BasicLockable> flush_buffer_lock;
+void AccessLogFileImpl::requestFlush() { flush_thread_->requestFlush(*this); }
 
-  {
-    Thread::LockGuard write_lock(write_lock_);
-
-    // flush_lock_ must be held while checking this or else it is
-    // possible that flushThreadFunc() has already moved data from
-    // flush_buffer_ to about_to_write_buffer_, has unlocked write_lock_,
-    // but has not yet completed doWrite(). This would allow flush() to
-    // return before the pending data has actually been written to disk.
-    flush_buffer_lock = std::unique_lock<Thread::BasicLockable>(flush_lock_);
-
-    if (flush_buffer_.length() == 0) {
-      return;
-    }
-
-    about_to_write_buffer_.move(flush_buffer_);
-    ASSERT(flush_buffer_.length() == 0);
+void AccessLogFileImpl::flush() {
+  Thread::LockGuard flush_lock(flush_lock_);
+  collectWriteShards();
+  if (about_to_write_buffer_.length() == 0) {
+    return;
   }
 
   doWrite(about_to_write_buffer_);
 }
 
 void AccessLogFileImpl::write(absl::string_view data) {
-  Thread::LockGuard lock(write_lock_);
+  WriteShard& shard = write_shards_[threadIndex() % WRITE_SHARDS];
+  uint64_t shard_length;
+  {
+    Thread::LockGuard lock(shard.lock_);
+    if (shard.buffer_.length() + data.length() > MAX_SHARD_SIZE) {
+      stats_.write_dropped_.inc();
+      return;
+    }
 
-  if (flush_thread_ == nullptr) {
-    createFlushStructures();
+    stats_.write_buffered_.inc();
+    stats_.write_total_buffered_.add(data.length());
+    shard.buffer_.add(data.data(), data.size());
+    shard_length = shard.buffer_.length();
   }
 
-  stats_.write_buffered_.inc();
-  stats_.write_total_buffered_.add(data.length());
-  flush_buffer_.add(data.data(), data.size());
-  if (flush_buffer_.length() > MIN_FLUSH_SIZE) {
-    flush_event_.notifyOne();
+  // The first write is flushed right away, rather than after the flush interval.
+  if (shard_length > MIN_FLUSH_SIZE ||
+      (!written_.load(std::memory_order_relaxed) && !written_.exchange(true))) {
+    requestFlush();
   }
 }
 
-void AccessLogFileImpl::createFlushStructures() {
-  flush_thread_ = thread_factory_.createThread([this]() -> void { flushThreadFunc(); },
-                                               Thread::Options{"AccessLogFlush"});
-}
-
 } // namespace AccessLog
 } // namespace Envoy
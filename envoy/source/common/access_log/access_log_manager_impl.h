@@ -1,5 +1,7 @@
 #pragma once
 
+#include <deque>
+#include <memory>
 #include <string>
 
 #include "envoy/access_log/access_log.h"
@@ -22,6 +24,7 @@ namespace Envoy {
   COUNTER(reopen_failed)                                                                           \
   COUNTER(write_buffered)                                                                          \
   COUNTER(write_completed)                                                                         \
+  COUNTER(write_dropped)                                                                           \
   COUNTER(write_failed)                                                                            \
   GAUGE(write_total_buffered, Accumulate)
 
@@ -31,6 +34,49 @@ struct AccessLogFileStats {
 
 namespace AccessLog {
 
+class AccessLogFileImpl;
+
+/**
+ * A thread that flushes access log files, shared by all the files of an AccessLogManagerImpl. The
+ * thread is started when a file first asks for a flush, and flushes files in the order they ask.
+ * It is joined when the manager and all the files it created are destroyed.
+ *
+ * The writes don't go through the io_uring socket interface. Its rings belong to the workers'
+ * dispatchers and only serve sockets, and the kernel hands buffered regular file writes on a ring
+ * to its own worker threads, which can block just as this thread can.
+ */
+class AccessLogFlushThread {
+public:
+  explicit AccessLogFlushThread(Thread::ThreadFactory& thread_factory)
+      : thread_factory_(thread_factory) {}
+  ~AccessLogFlushThread();
+
+  /**
+   * Asks the thread to flush a file. Does nothing if the file already waits for a flush.
+   */
+  void requestFlush(AccessLogFileImpl& file);
+
+  /**
+   * Drops any request to flush a file, and waits until the thread isn't flushing it. The thread
+   * doesn't touch the file afterwards.
+   */
+  void removeFile(AccessLogFileImpl& file);
+
+private:
+  void threadRoutine();
+
+  Thread::ThreadFactory& thread_factory_;
+  Thread::MutexBasicLockable mutex_;
+  Thread::CondVar request_event_;
+  Thread::CondVar flushed_event_;
+  std::deque<AccessLogFileImpl*> requests_ ABSL_GUARDED_BY(mutex_);
+  AccessLogFileImpl* flushing_ ABSL_GUARDED_BY(mutex_){};
+  bool exit_ ABSL_GUARDED_BY(mutex_){};
+  Thread::ThreadPtr thread_ ABSL_GUARDED_BY(mutex_);
+};
+
+using AccessLogFlushThreadSharedPtr = std::shared_ptr<AccessLogFlushThread>;
+
 class AccessLogManagerImpl : public AccessLogManager, Logger::Loggable<Logger::Id::main> {
 public:
   AccessLogManagerImpl(std::chrono::milliseconds file_flush_interval_msec, Api::Api& api,
@@ -52,22 +98,27 @@ private:
   Event::Dispatcher& dispatcher_;
   Thread::BasicLockable& lock_;
   AccessLogFileStats file_stats_;
+  // Created with the first file. Files keep a reference, so it outlives the manager if they do.
+  AccessLogFlushThreadSharedPtr flush_thread_;
   absl::node_hash_map<std::string, AccessLogFileSharedPtr> access_logs_;
 };
 
 /**
  * This is a file implementation geared for writing out access logs. It turn out that in certain
  * cases even if a standard file is opened with O_NONBLOCK, the kernel can still block when writing.
- * This implementation uses a flush thread per file, with the idea there aren't that many
- * files. If this turns out to be a good implementation we can potentially have a single flush
- * thread that flushes all files, but we will start with this.
+ * Writes are therefore buffered, and the buffers are written by a flush thread shared by all the
+ * files, when a write shard grows past MIN_FLUSH_SIZE or when the flush timer fires.
+ *
+ * Each thread that writes to the file adds to one of WRITE_SHARDS buffers, each with its own lock,
+ * so workers logging to the same file don't contend for one lock. Lines from one thread stay in
+ * order, while lines from different threads are written in the order of their buffers.
  */
 class AccessLogFileImpl : public AccessLogFile {
 public:
   AccessLogFileImpl(Filesystem::FilePtr&& file, Event::Dispatcher& dispatcher,
                     Thread::BasicLockable& lock, AccessLogFileStats& stats,
                     std::chrono::milliseconds flush_interval_msec,
-                    Thread::ThreadFactory& thread_factory);
+                    AccessLogFlushThreadSharedPtr flush_thread);
   ~AccessLogFileImpl() override;
 
   // AccessLog::AccessLogFile
@@ -82,22 +133,35 @@ public:
   void flush() override;
 
 private:
+  friend class AccessLogFlushThread;
+
+  struct alignas(64) WriteShard {
+    Thread::MutexBasicLockable lock_;
+    Buffer::OwnedImpl buffer_ ABSL_GUARDED_BY(lock_);
+  };
+
+  // Moves the data of all write shards to about_to_write_buffer_.
+  void collectWriteShards() ABSL_EXCLUSIVE_LOCKS_REQUIRED(flush_lock_);
   void doWrite(Buffer::Instance& buffer);
-  void flushThreadFunc();
+  // Called by the flush thread.
+  void flushFromThread();
+  void requestFlush();
   Api::IoCallBoolResult open();
-  void createFlushStructures();
 
   // return default flags set which used by open
   static Filesystem::FlagSet defaultFlags();
 
-  // Minimum size before the flush thread will be told to flush.
+  // Minimum size of a write shard before the flush thread will be told to flush.
   static const uint64_t MIN_FLUSH_SIZE = 1024 * 64;
+  // Maximum size of a write shard. Writes beyond it are dropped, as the file can't keep up.
+  static const uint64_t MAX_SHARD_SIZE = 1024 * 1024 * 8;
+  static const uint32_t WRITE_SHARDS = 16;
 
   Filesystem::FilePtr file_;
 
   // These locks are always acquired in the following order if multiple locks are held:
-  //    1) write_lock_
-  //    2) flush_lock_
+  //    1) flush_lock_
+  //    2) a write shard's lock_
   //    3) file_lock_
   Thread::BasicLockable& file_lock_;      // This lock is used only by the flush thread when writing
                                           // to disk. This is used to make sure that file blocks do
@@ -108,28 +172,15 @@ private:
                                           // concurrent access to the about_to_write_buffer_, fd_,
                                           // and all other data used during flushing and file
                                           // re-opening.
-  Thread::MutexBasicLockable
-      write_lock_; // The lock is used when filling the flush buffer. It allows
-                   // multiple threads to write to the same file at relatively
-                   // high performance. It is always local to the process.
-  Thread::ThreadPtr flush_thread_;
-  Thread::CondVar flush_event_;
-  std::atomic<bool> flush_thread_exit_{};
+  std::unique_ptr<WriteShard[]> write_shards_; // Filled by the threads writing to the file, and
+                                               // moved to about_to_write_buffer_ when flushing.
+  std::atomic<bool> written_{};                // Whether anything was ever written.
+  std::atomic<bool> flush_requested_{};        // Whether the file waits for the flush thread.
   std::atomic<bool> reopen_file_{};
-  Buffer::OwnedImpl
-      flush_buffer_ ABSL_GUARDED_BY(write_lock_); // This buffer is used by multiple threads. It
-                                                  // gets filled and then flushed either when max
-                                                  // size is reached or when a timer fires.
-  // TODO(jmarantz): this should be ABSL_GUARDED_BY(flush_lock_) but the analysis cannot poke
-  // through the std::make_unique assignment. I do not believe it's possible to annotate this
-  // properly now due to limitations in the clang thread annotation analysis.
-  Buffer::OwnedImpl about_to_write_buffer_; // This buffer is used only by the flush thread. Data
-                                            // is moved from flush_buffer_ under lock, and then
-                                            // the lock is released so that flush_buffer_ can
-                                            // continue to fill. This buffer is then used for the
-                                            // final write to disk.
+  // The data of the write shards is moved to this buffer for the final write to disk.
+  Buffer::OwnedImpl about_to_write_buffer_ ABSL_GUARDED_BY(flush_lock_);
   Event::TimerPtr flush_timer_;
-  Thread::ThreadFactory& thread_factory_;
+  const AccessLogFlushThreadSharedPtr flush_thread_;
   const std::chrono::milliseconds flush_interval_msec_; // Time interval buffer gets flushed no
                                                         // matter if it reached the MIN_FLUSH_SIZE
                                                         // or not.
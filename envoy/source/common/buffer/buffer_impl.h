@@ -9,6 +9,7 @@
 #include "envoy/buffer/buffer.h"
 #include "envoy/http/stream_reset_handler.h"
 
+#include "source/common/buffer/slice_storage_pool.h"
 #include "source/common/common/assert.h"
 #include "source/common/common/non_copyable.h"
 #include "source/common/common/utility.h"
@@ -35,7 +36,7 @@ namespace Buffer {
 class Slice {
 public:
   using Reservation = RawSlice;
-  using StoragePtr = std::unique_ptr<uint8_t[]>;
+  using StoragePtr = SliceStoragePool::StoragePtr;
 
   static constexpr uint32_t free_list_max_ = Buffer::Reservation::MAX_SLICES_;
   using FreeListType = absl::InlinedVector<StoragePtr, free_list_max_>;
@@ -371,8 +372,7 @@ protected:
       }
     }
 
-    storage.reset(new uint8_t[capacity]);
-    return storage;
+    return SliceStoragePool::allocate(capacity);
   }
 
   static void freeStorage(StoragePtr storage, uint64_t capacity,
@@ -390,7 +390,7 @@ protected:
       }
     }
 
-    storage.reset();
+    SliceStoragePool::release(std::move(storage), capacity);
   }
 
   static thread_local FreeListType free_list_;
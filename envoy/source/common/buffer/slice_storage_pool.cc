@@ -0,0 +1,183 @@
+#include "source/common/buffer/slice_storage_pool.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "source/common/common/assert.h"
+#include "source/common/common/lock_guard.h"
+#include "source/common/common/macros.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+// Set once the calling thread's cache has been destroyed. Trivially destructible so that it stays
+// readable from thread_local destructors that run after the cache's.
+thread_local bool thread_cache_destroyed = false;
+
+// The counters in ThreadCache only have a single writer, so a relaxed load and store is enough and
+// avoids a locked read-modify-write on the allocation path.
+void add(std::atomic<uint64_t>& counter, uint64_t delta) {
+  counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+void subtract(std::atomic<uint64_t>& counter, uint64_t delta) {
+  counter.store(counter.load(std::memory_order_relaxed) - delta, std::memory_order_relaxed);
+}
+
+} // namespace
+
+SliceStoragePool::ThreadCache::ThreadCache() { depot().registerCache(*this); }
+
+SliceStoragePool::ThreadCache::~ThreadCache() {
+  for (uint32_t size_class = 0; size_class < NumSizeClasses; size_class++) {
+    depot().push(size_class, free_lists_[size_class]);
+    free_lists_[size_class].clear();
+  }
+  depot().retireCache(*this);
+  thread_cache_destroyed = true;
+}
+
+void SliceStoragePool::Depot::registerCache(ThreadCache& cache) {
+  Thread::LockGuard lock(mutex_);
+  caches_.insert(&cache);
+}
+
+void SliceStoragePool::Depot::retireCache(ThreadCache& cache) {
+  Thread::LockGuard lock(mutex_);
+  retired_hits_ += cache.hits_.load(std::memory_order_relaxed);
+  retired_misses_ += cache.misses_.load(std::memory_order_relaxed);
+  caches_.erase(&cache);
+}
+
+void SliceStoragePool::Depot::push(uint32_t size_class, FreeList& batch) {
+  Thread::LockGuard lock(mutex_);
+  FreeList& free_list = free_lists_[size_class];
+  const uint64_t room = depotLimit(size_class) - free_list.size();
+  const uint64_t count = std::min<uint64_t>(room, batch.size());
+  for (uint64_t i = 0; i < count; i++) {
+    free_list.emplace_back(std::move(batch.back()));
+    batch.pop_back();
+  }
+  bytes_held_ += count * classCapacity(size_class);
+}
+
+void SliceStoragePool::Depot::pop(uint32_t size_class, FreeList& out, uint64_t max_entries) {
+  Thread::LockGuard lock(mutex_);
+  FreeList& free_list = free_lists_[size_class];
+  const uint64_t count = std::min<uint64_t>(max_entries, free_list.size());
+  for (uint64_t i = 0; i < count; i++) {
+    out.emplace_back(std::move(free_list.back()));
+    free_list.pop_back();
+  }
+  bytes_held_ -= count * classCapacity(size_class);
+}
+
+SliceStoragePoolStats SliceStoragePool::Depot::stats() {
+  Thread::LockGuard lock(mutex_);
+  SliceStoragePoolStats stats;
+  stats.hits_ = retired_hits_;
+  stats.misses_ = retired_misses_;
+  stats.bytes_held_ = bytes_held_;
+  for (const ThreadCache* cache : caches_) {
+    stats.hits_ += cache->hits_.load(std::memory_order_relaxed);
+    stats.misses_ += cache->misses_.load(std::memory_order_relaxed);
+    stats.bytes_held_ += cache->bytes_held_.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+SliceStoragePool::ThreadCache* SliceStoragePool::threadCache() {
+  if (thread_cache_destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadCache cache;
+  return &cache;
+}
+
+SliceStoragePool::Depot& SliceStoragePool::depot() { MUTABLE_CONSTRUCT_ON_FIRST_USE(Depot); }
+
+SliceStoragePoolStats SliceStoragePool::stats() { return depot().stats(); }
+
+uint32_t SliceStoragePool::sizeClass(uint64_t capacity) {
+  if (capacity == 0 || capacity > MaxPooledCapacity || capacity % PageSize != 0) {
+    return NumSizeClasses;
+  }
+  // 1-4 pages map to classes 0-3; 8, 12 and 16 pages map to classes 4-6.
+  const uint64_t pages = capacity / PageSize;
+  if (pages <= 4) {
+    return pages - 1;
+  }
+  if (pages % 4 != 0) {
+    return NumSizeClasses;
+  }
+  return pages / 4 + 2;
+}
+
+uint64_t SliceStoragePool::classCapacity(uint32_t size_class) {
+  ASSERT(size_class < NumSizeClasses);
+  return size_class < 4 ? (size_class + 1) * PageSize : (size_class - 2) * 4 * PageSize;
+}
+
+uint64_t SliceStoragePool::threadCacheLimit(uint32_t size_class) {
+  return std::max(MinThreadCacheEntries, ThreadCacheBytesPerClass / classCapacity(size_class));
+}
+
+uint64_t SliceStoragePool::depotLimit(uint32_t size_class) {
+  return DepotBytesPerClass / classCapacity(size_class);
+}
+
+SliceStoragePool::StoragePtr SliceStoragePool::allocate(uint64_t capacity) {
+  const uint32_t size_class = sizeClass(capacity);
+  ThreadCache* cache = size_class < NumSizeClasses ? threadCache() : nullptr;
+  if (cache == nullptr) {
+    return StoragePtr(new uint8_t[capacity]);
+  }
+
+  FreeList& free_list = cache->free_lists_[size_class];
+  if (free_list.empty()) {
+    // Refill half of the cache so that the next few allocations don't take the depot lock again.
+    depot().pop(size_class, free_list, threadCacheLimit(size_class) / 2);
+    add(cache->bytes_held_, free_list.size() * capacity);
+  }
+  if (free_list.empty()) {
+    add(cache->misses_, 1);
+    return StoragePtr(new uint8_t[capacity]);
+  }
+
+  StoragePtr storage = std::move(free_list.back());
+  free_list.pop_back();
+  ASSERT(storage != nullptr);
+  add(cache->hits_, 1);
+  subtract(cache->bytes_held_, capacity);
+  return storage;
+}
+
+void SliceStoragePool::release(StoragePtr storage, uint64_t capacity) {
+  if (storage == nullptr) {
+    return;
+  }
+  const uint32_t size_class = sizeClass(capacity);
+  ThreadCache* cache = size_class < NumSizeClasses ? threadCache() : nullptr;
+  if (cache == nullptr) {
+    return;
+  }
+
+  FreeList& free_list = cache->free_lists_[size_class];
+  const uint64_t limit = threadCacheLimit(size_class);
+  if (free_list.size() >= limit) {
+    // Hand the older half of the cache to the depot in one batch, where threads that are short of
+    // this class can pick it up. Whatever the depot has no room for is freed.
+    FreeList batch;
+    batch.reserve(limit / 2);
+    std::move(free_list.begin(), free_list.begin() + limit / 2, std::back_inserter(batch));
+    free_list.erase(free_list.begin(), free_list.begin() + limit / 2);
+    subtract(cache->bytes_held_, batch.size() * capacity);
+    depot().push(size_class, batch);
+  }
+  free_list.emplace_back(std::move(storage));
+  add(cache->bytes_held_, capacity);
+}
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "source/common/common/thread.h"
+
+#include "absl/container/flat_hash_set.h"
+
+namespace Envoy {
+namespace Buffer {
+
+/**
+ * Snapshot of the slice storage pool counters, summed over all threads.
+ */
+struct SliceStoragePoolStats {
+  // Allocations served from a thread cache or the shared depot.
+  uint64_t hits_{};
+  // Allocations of a pooled size class that had to fall back to the system allocator.
+  uint64_t misses_{};
+  // Bytes of storage currently held by the pool and not in use by any slice.
+  uint64_t bytes_held_{};
+};
+
+/**
+ * Size-classed allocator for Slice storage. Each thread keeps a bounded free list per size class,
+ * so the common case of a worker allocating and releasing slices takes no locks and never reaches
+ * the system allocator. When a thread's cache for a class is full, half of it is handed to a
+ * shared, bounded depot in one batch; threads whose cache for a class is empty refill from the
+ * depot before falling back to the system allocator. This keeps storage that migrates between
+ * workers (e.g. a buffer created on one worker and drained on another) in circulation instead of
+ * accumulating on one side.
+ *
+ * Size classes are 4, 8, 12, 16, 32, 48 and 64 KiB. Capacities that are not a multiple of the 4 KiB
+ * page size, or are larger than 64 KiB, are not pooled.
+ */
+class SliceStoragePool {
+public:
+  using StoragePtr = std::unique_ptr<uint8_t[]>;
+
+  static constexpr uint64_t PageSize = 4096;
+  static constexpr uint64_t MaxPooledCapacity = 64 * 1024;
+  static constexpr uint32_t NumSizeClasses = 7;
+  // Upper bound on the bytes each thread caches for a single size class. Every class may cache at
+  // least MinThreadCacheEntries entries regardless of this bound.
+  static constexpr uint64_t ThreadCacheBytesPerClass = 256 * 1024;
+  static constexpr uint64_t MinThreadCacheEntries = 4;
+  // Upper bound on the bytes the shared depot holds for a single size class.
+  static constexpr uint64_t DepotBytesPerClass = 4 * 1024 * 1024;
+
+  /**
+   * Allocate storage of exactly the given capacity.
+   * @param capacity supplies the size of the storage in bytes.
+   * @return storage, either reused from the pool or freshly allocated.
+   */
+  static StoragePtr allocate(uint64_t capacity);
+
+  /**
+   * Return storage to the pool, or free it if it is not of a pooled size or the pool is full.
+   * @param storage supplies storage previously returned by allocate(capacity).
+   * @param capacity supplies the capacity that was passed to allocate().
+   */
+  static void release(StoragePtr storage, uint64_t capacity);
+
+  /**
+   * @return a snapshot of the pool counters across all threads.
+   */
+  static SliceStoragePoolStats stats();
+
+  /**
+   * @return the size class for a capacity, or NumSizeClasses if the capacity is not pooled.
+   */
+  static uint32_t sizeClass(uint64_t capacity);
+
+  /**
+   * @return the capacity in bytes of storage in the given size class.
+   */
+  static uint64_t classCapacity(uint32_t size_class);
+
+  /**
+   * @return the maximum number of entries a thread caches for the given size class.
+   */
+  static uint64_t threadCacheLimit(uint32_t size_class);
+
+  /**
+   * @return the maximum number of entries the shared depot holds for the given size class.
+   */
+  static uint64_t depotLimit(uint32_t size_class);
+
+private:
+  using FreeList = std::vector<StoragePtr>;
+
+  class ThreadCache {
+  public:
+    ThreadCache();
+    ~ThreadCache();
+
+    std::array<FreeList, NumSizeClasses> free_lists_;
+    // Only written by the owning thread, but read by stats() from any thread.
+    std::atomic<uint64_t> hits_{};
+    std::atomic<uint64_t> misses_{};
+    std::atomic<uint64_t> bytes_held_{};
+  };
+
+  class Depot {
+  public:
+    void registerCache(ThreadCache& cache);
+    void retireCache(ThreadCache& cache);
+    // Move entries from `batch` into the depot until it is full. Entries left in `batch` are the
+    // caller's to free.
+    void push(uint32_t size_class, FreeList& batch);
+    // Move up to `max_entries` entries from the depot into `out`.
+    void pop(uint32_t size_class, FreeList& out, uint64_t max_entries);
+    SliceStoragePoolStats stats();
+
+  private:
+    Thread::MutexBasicLockable mutex_;
+    std::array<FreeList, NumSizeClasses> free_lists_ ABSL_GUARDED_BY(mutex_);
+    absl::flat_hash_set<ThreadCache*> caches_ ABSL_GUARDED_BY(mutex_);
+    // Counters folded in from caches of threads that have exited.
+    uint64_t retired_hits_ ABSL_GUARDED_BY(mutex_){};
+    uint64_t retired_misses_ ABSL_GUARDED_BY(mutex_){};
+    uint64_t bytes_held_ ABSL_GUARDED_BY(mutex_){};
+  };
+
+  // Returns nullptr once the calling thread's cache has been destroyed during thread exit, so that
+  // slices released by other thread_local destructors go straight to the system allocator.
+  static ThreadCache* threadCache();
+  static Depot& depot();
+};
+
+} // namespace Buffer
+} // namespace Envoy
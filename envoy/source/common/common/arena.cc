@@ -0,0 +1,55 @@
+#include "source/common/common/arena.h"
+
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+
+Arena::~Arena() {
+  for (Finalizer* finalizer = finalizers_; finalizer != nullptr; finalizer = finalizer->next_) {
+    finalizer->destroy_(finalizer->object_);
+  }
+  while (blocks_ != nullptr) {
+    Block* next = blocks_->next_;
+    ::operator delete(blocks_);
+    blocks_ = next;
+  }
+}
+
+void* Arena::allocateSlow(size_t size, size_t alignment) {
+  ASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0);
+  const size_t needed = size + alignment - 1;
+  if (needed > block_size_ / 4) {
+    // Large allocations don't replace the current block, whose space can still be used by smaller
+    // ones.
+    allocated_bytes_ += needed;
+    return alignUp(newBlock(needed), alignment);
+  }
+
+  allocated_bytes_ += next_ - block_start_;
+  const size_t block_data_size = block_size_ - sizeof(Block);
+  block_start_ = next_ = newBlock(block_data_size);
+  end_ = next_ + block_data_size;
+  char* start = alignUp(next_, alignment);
+  next_ = start + size;
+  ASSERT(next_ <= end_);
+  return start;
+}
+
+char* Arena::newBlock(size_t size) {
+  Block* block = static_cast<Block*>(::operator new(sizeof(Block) + size));
+  block->next_ = blocks_;
+  blocks_ = block;
+  heap_blocks_++;
+  return reinterpret_cast<char*>(block + 1);
+}
+
+void Arena::addFinalizer(void* object, void (*destroy)(void*)) {
+  Finalizer* finalizer =
+      static_cast<Finalizer*>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+  finalizer->destroy_ = destroy;
+  finalizer->object_ = object;
+  finalizer->next_ = finalizers_;
+  finalizers_ = finalizer;
+}
+
+} // namespace Envoy
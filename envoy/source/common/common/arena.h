@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "source/common/common/non_copyable.h"
+
+namespace Envoy {
+
+/**
+ * Destroys an object made with Arena::makeUnique() without freeing its memory. Deleting through a
+ * pointer to a base class requires a virtual destructor, as with std::default_delete.
+ */
+struct ArenaDeleter {
+  template <class T> void operator()(T* object) const { object->~T(); }
+};
+
+template <class T> using ArenaPtr = std::unique_ptr<T, ArenaDeleter>;
+
+/**
+ * A bump allocator for objects that live and die together, such as the objects of a stream. Memory
+ * is carved out of blocks in order, and is only released, all at once, when the arena is
+ * destroyed. This replaces an allocator call per object with a pointer increment, and keeps the
+ * objects of one owner next to each other.
+ *
+ * Objects made with create() are destroyed by the arena, in the reverse order of their creation.
+ * Objects made with makeUnique() are destroyed by their owner through ArenaPtr, and only their
+ * memory belongs to the arena. Either way nothing may refer to them once the arena is gone.
+ *
+ * An arena is not thread safe.
+ */
+class Arena : NonCopyable {
+public:
+  static constexpr size_t DefaultBlockSize = 4096;
+
+  /**
+   * @param block_size the size of the blocks that are allocated from the heap. Allocations larger
+   *        than a quarter of it get a block of their own.
+   */
+  explicit Arena(size_t block_size = DefaultBlockSize) : Arena(nullptr, 0, block_size) {}
+  ~Arena();
+
+  /**
+   * @return memory for size bytes, aligned to alignment, which must be a power of two.
+   */
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+    char* start = alignUp(next_, alignment);
+    if (start != nullptr && size <= static_cast<size_t>(end_ - start)) {
+      next_ = start + size;
+      return start;
+    }
+    return allocateSlow(size, alignment);
+  }
+
+  /**
+   * Constructs an object in the arena. The arena destroys it when it is itself destroyed.
+   */
+  template <class T, class... Args> T* create(Args&&... args) {
+    T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      addFinalizer(object, [](void* object) { static_cast<T*>(object)->~T(); });
+    }
+    return object;
+  }
+
+  /**
+   * Constructs an object in the arena that is destroyed by the returned pointer, e.g. so that it
+   * can be removed from its owner before the arena goes away.
+   */
+  template <class T, class... Args> ArenaPtr<T> makeUnique(Args&&... args) {
+    return ArenaPtr<T>(new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...));
+  }
+
+  // The number of bytes handed out, including alignment padding.
+  uint64_t allocatedBytes() const { return allocated_bytes_ + (next_ - block_start_); }
+  // The number of blocks that were allocated from the heap.
+  uint32_t heapBlocks() const { return heap_blocks_; }
+
+protected:
+  /**
+   * Starts with an initial block that the arena doesn't own. @see InlineArena.
+   */
+  Arena(char* initial_block, size_t initial_size, size_t block_size)
+      : next_(initial_block), end_(initial_block + initial_size), block_start_(initial_block),
+        block_size_(block_size) {}
+
+private:
+  // Heads every heap block.
+  struct Block {
+    Block* next_;
+  };
+
+  struct Finalizer {
+    void (*destroy_)(void*);
+    void* object_;
+    Finalizer* next_;
+  };
+
+  static char* alignUp(char* pointer, size_t alignment) {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+    return reinterpret_cast<char*>((address + alignment - 1) & ~(alignment - 1));
+  }
+
+  void* allocateSlow(size_t size, size_t alignment);
+  char* newBlock(size_t size);
+  void addFinalizer(void* object, void (*destroy)(void*));
+
+  char* next_;
+  char* end_;
+  // Where the current block's allocations start, for allocatedBytes().
+  char* block_start_;
+  const size_t block_size_;
+  uint64_t allocated_bytes_{};
+  uint32_t heap_blocks_{};
+  Block* blocks_{};
+  // Most recently created first.
+  Finalizer* finalizers_{};
+};
+
+/**
+ * An arena whose first InlineSize bytes are part of the arena itself. An owner that has an arena
+ * as a member allocates nothing more from the heap until it outgrows them.
+ */
+template <size_t InlineSize> class InlineArena : public Arena {
+public:
+  explicit InlineArena(size_t block_size = DefaultBlockSize)
+      : Arena(inline_block_, InlineSize, block_size) {}
+
+private:
+  alignas(std::max_align_t) char inline_block_[InlineSize];
+};
+
+} // namespace Envoy
@@ -17,8 +17,9 @@ namespace LinkedList {
  * @param item supplies the item to move in.
  * @param list supplies the list to move the item into.
  */
-template <typename T, typename U>
-void moveIntoList(std::unique_ptr<T>&& item, std::list<std::unique_ptr<U>>& list) {
+template <typename T, typename TDeleter, typename U, typename UDeleter>
+void moveIntoList(std::unique_ptr<T, TDeleter>&& item,
+                  std::list<std::unique_ptr<U, UDeleter>>& list) {
   ASSERT(!item->inserted_);
   item->inserted_ = true;
   auto position = list.emplace(list.begin(), std::move(item));
@@ -30,8 +31,9 @@ void moveIntoList(std::unique_ptr<T>&& item, std::list<std::unique_ptr<U>>& list
  * @param item supplies the item to move in.
  * @param list supplies the list to move the item into.
  */
-template <typename T, typename U>
-void moveIntoListBack(std::unique_ptr<T>&& item, std::list<std::unique_ptr<U>>& list) {
+template <typename T, typename TDeleter, typename U, typename UDeleter>
+void moveIntoListBack(std::unique_ptr<T, TDeleter>&& item,
+                      std::list<std::unique_ptr<U, UDeleter>>& list) {
   ASSERT(!item->inserted_);
   item->inserted_ = true;
   auto position = list.emplace(list.end(), std::move(item));
@@ -42,11 +44,13 @@ void moveIntoListBack(std::unique_ptr<T>&& item, std::list<std::unique_ptr<U>>&
 
 /**
  * Mixin class that allows an object contained in a unique pointer to be easily linked and unlinked
- * from lists.
+ * from lists. Deleter is the deleter of the unique pointer, for objects that aren't allocated with
+ * new.
  */
-template <class T> class LinkedObject {
+template <class T, class Deleter = std::default_delete<T>> class LinkedObject {
 public:
-  using ListType = std::list<std::unique_ptr<T>>;
+  using Ptr = std::unique_ptr<T, Deleter>;
+  using ListType = std::list<Ptr>;
 
   /**
    * @return the list iterator for the object.
@@ -77,11 +81,11 @@ public:
    * Remove this item from a list.
    * @param list supplies the list to remove from. This item should be in this list.
    */
-  std::unique_ptr<T> removeFromList(ListType& list) {
+  Ptr removeFromList(ListType& list) {
     ASSERT(inserted_);
     ASSERT(std::find(list.begin(), list.end(), *entry_) != list.end());
 
-    std::unique_ptr<T> removed = std::move(*entry_);
+    Ptr removed = std::move(*entry_);
     list.erase(entry_);
     inserted_ = false;
     return removed;
@@ -91,10 +95,12 @@ protected:
   LinkedObject() = default;
 
 private:
-  template <typename U, typename V>
-  friend void LinkedList::moveIntoList(std::unique_ptr<U>&&, std::list<std::unique_ptr<V>>&);
-  template <typename U, typename V>
-  friend void LinkedList::moveIntoListBack(std::unique_ptr<U>&&, std::list<std::unique_ptr<V>>&);
+  template <typename U, typename UDeleter, typename V, typename VDeleter>
+  friend void LinkedList::moveIntoList(std::unique_ptr<U, UDeleter>&&,
+                                       std::list<std::unique_ptr<V, VDeleter>>&);
+  template <typename U, typename UDeleter, typename V, typename VDeleter>
+  friend void LinkedList::moveIntoListBack(std::unique_ptr<U, UDeleter>&&,
+                                           std::list<std::unique_ptr<V, VDeleter>>&);
 
   typename ListType::iterator entry_;
   bool inserted_{false}; // iterators do not have any "invalid" value so we need this boolean for
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <ios>
@@ -603,15 +604,17 @@ private:
   double m2_{0};
 };
 
-template <class Value> struct TrieEntry {
-  Value value_{};
-  std::array<std::unique_ptr<TrieEntry>, 256> entries_;
-};
-
 /**
  * A trie used for faster lookup with lookup time at most equal to the size of the key.
+ *
+ * Nodes live in a single vector and refer to each other by position. Each node covers the range
+ * of bytes between its lowest and highest child with one slot per byte, so that a step is one
+ * bounds check and one load, while nodes with few or clustered children, which is typical for
+ * header names and other textual keys, stay small. Values are stored apart from the nodes and
+ * only for the nodes that have one.
  */
 template <class Value> struct TrieLookupTable {
+  TrieLookupTable() : nodes_(1), values_(1) {}
 
   /**
    * Adds an entry to the Trie at the given Key.
@@ -622,17 +625,26 @@ template <class Value> struct TrieLookupTable {
    * @return false when a value already exists for the given key.
    */
   bool add(absl::string_view key, Value value, bool overwrite_existing = true) {
-    TrieEntry<Value>* current = &root_;
+    uint32_t current = 0;
     for (uint8_t c : key) {
-      if (!current->entries_[c]) {
-        current->entries_[c] = std::make_unique<TrieEntry<Value>>();
+      uint32_t next = child(current, c);
+      if (next == 0) {
+        next = nodes_.size();
+        nodes_.emplace_back();
+        *childSlot(current, c) = next;
       }
-      current = current->entries_[c].get();
+      current = next;
+    }
+    Node& node = nodes_[current];
+    if (node.value_ == 0) {
+      node.value_ = values_.size();
+      values_.push_back(std::move(value));
+      return true;
     }
-    if (current->value_ && !overwrite_existing) {
+    if (values_[node.value_] && !overwrite_existing) {
       return false;
     }
-    current->value_ = value;
+    values_[node.value_] = std::move(value);
     return true;
   }
 
@@ -641,15 +653,15 @@ template <class Value> struct TrieLookupTable {
    * @param key the key used to find.
    * @return the value associated with the key.
    */
-  Value find(absl::string_view key) const {
-    const TrieEntry<Value>* current = &root_;
+  const Value& find(absl::string_view key) const {
+    uint32_t current = 0;
     for (uint8_t c : key) {
-      current = current->entries_[c].get();
-      if (current == nullptr) {
-        return nullptr;
+      current = child(current, c);
+      if (current == 0) {
+        return values_[0];
       }
     }
-    return current->value_;
+    return values_[nodes_[current].value_];
   }
 
   /**
@@ -658,26 +670,73 @@ template <class Value> struct TrieLookupTable {
    * @param key the key used to find.
    * @return the value matching the longest prefix based on the key.
    */
-  Value findLongestPrefix(const char* key) const {
-    const TrieEntry<Value>* current = &root_;
-    const TrieEntry<Value>* result = nullptr;
-    while (uint8_t c = *key) {
-      if (current->value_) {
-        result = current;
+  const Value& findLongestPrefix(const char* key) const {
+    uint32_t current = 0;
+    uint32_t result = 0;
+    while (true) {
+      const uint32_t value = nodes_[current].value_;
+      if (value != 0 && values_[value]) {
+        result = value;
       }
-
-      // https://github.com/facebook/mcrouter/blob/master/mcrouter/lib/fbi/cpp/Trie-inl.h#L126-L143
-      current = current->entries_[c].get();
-      if (current == nullptr) {
-        return result ? result->value_ : nullptr;
+      const uint8_t c = *key++;
+      if (c == 0) {
+        break;
+      }
+      current = child(current, c);
+      if (current == 0) {
+        break;
       }
+    }
+    return values_[result];
+  }
+
+private:
+  struct Node {
+    // Index into values_, or 0 if no key ends at this node.
+    uint32_t value_{};
+    // Index into slots_ of the slot for byte min_.
+    uint32_t slots_{};
+    uint16_t slot_count_{};
+    uint8_t min_{};
+  };
+
+  // @return the index of the child of the node for the byte, or 0 if there is none. The root is
+  // never a child, so 0 is free to mean none.
+  uint32_t child(uint32_t node_index, uint8_t c) const {
+    const Node& node = nodes_[node_index];
+    const uint32_t offset = static_cast<uint8_t>(c - node.min_);
+    return offset < node.slot_count_ ? slots_[node.slots_ + offset] : 0;
+  }
 
-      key++;
+  // @return the slot of the node for the byte, widening the node's range to cover it if needed.
+  uint32_t* childSlot(uint32_t node_index, uint8_t c) {
+    Node& node = nodes_[node_index];
+    if (node.slot_count_ == 0) {
+      node.min_ = c;
+      node.slot_count_ = 1;
+      node.slots_ = slots_.size();
+      slots_.push_back(0);
+    } else if (c < node.min_ || c >= node.min_ + node.slot_count_) {
+      // Move the slots to the end of slots_, with room for the new byte. The old slots are left
+      // unused, which only costs memory while tables are being built up byte by byte.
+      const uint8_t new_min = std::min(c, node.min_);
+      const uint8_t new_max = std::max<uint16_t>(c, node.min_ + node.slot_count_ - 1);
+      const uint16_t new_count = new_max - new_min + 1;
+      const uint32_t new_slots = slots_.size();
+      slots_.resize(slots_.size() + new_count, 0);
+      std::copy(slots_.begin() + node.slots_, slots_.begin() + node.slots_ + node.slot_count_,
+                slots_.begin() + new_slots + (node.min_ - new_min));
+      node.min_ = new_min;
+      node.slot_count_ = new_count;
+      node.slots_ = new_slots;
     }
-    return current ? current->value_ : result->value_;
+    return &slots_[node.slots_ + (c - node.min_)];
   }
 
-  TrieEntry<Value> root_;
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> slots_;
+  // values_[0] is the empty value returned for keys that aren't found.
+  std::vector<Value> values_;
 };
 
 /**
@@ -1,7 +1,12 @@
 #include "source/common/formatter/substitution_formatter.h"
 
+#include <algorithm>
+#include <array>
 #include <climits>
+#include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <regex>
 #include <string>
 #include <vector>
@@ -52,6 +57,48 @@ const std::regex& getSystemTimeFormatNewlinePattern() {
 }
 const std::regex& getNewlinePattern() { CONSTRUCT_ON_FIRST_USE(std::regex, "\n"); }
 
+// The escape of an ASCII character in JSON strings, or an empty view if it isn't escaped. The
+// protobuf JSON conversion escapes the control characters, and < and > for HTML.
+absl::string_view jsonEscape(uint8_t c) {
+  static const std::array<std::string, 0x80> escapes = [] {
+    std::array<std::string, 0x80> escapes;
+    for (uint8_t control = 0; control < 0x20; control++) {
+      escapes[control] = fmt::format("\\u{:04x}", control);
+    }
+    escapes['\b'] = "\\b";
+    escapes['\t'] = "\\t";
+    escapes['\n'] = "\\n";
+    escapes['\f'] = "\\f";
+    escapes['\r'] = "\\r";
+    escapes['"'] = "\\\"";
+    escapes['\\'] = "\\\\";
+    escapes['<'] = "\\u003c";
+    escapes['>'] = "\\u003e";
+    escapes[0x7f] = "\\u007f";
+    return escapes;
+  }();
+  return escapes[c];
+}
+
+// Appends a number as the protobuf JSON conversion writes it: with 15 significant digits, or 17 if
+// 15 don't round trip, and with infinities and NaN as strings.
+void appendJsonNumber(double value, std::string& output) {
+  if (std::isnan(value)) {
+    output.append("\"NaN\"");
+    return;
+  }
+  if (std::isinf(value)) {
+    output.append(value > 0 ? "\"Infinity\"" : "\"-Infinity\"");
+    return;
+  }
+  char buffer[32];
+  int length = snprintf(buffer, sizeof(buffer), "%.15g", value);
+  if (strtod(buffer, nullptr) != value) {
+    length = snprintf(buffer, sizeof(buffer), "%.17g", value);
+  }
+  output.append(buffer, length);
+}
+
 } // namespace
 
 const std::string SubstitutionFormatUtils::DEFAULT_FORMAT =
@@ -136,17 +183,218 @@ std::string FormatterImpl::format(const Http::RequestHeaderMap& request_headers,
   return log_line;
 }
 
+JsonFormatterImpl::JsonFormatterImpl(const ProtobufWkt::Struct& format_mapping,
+                                     bool preserve_types, bool omit_empty_values)
+    : JsonFormatterImpl(format_mapping, preserve_types, omit_empty_values, {}) {}
+
+JsonFormatterImpl::JsonFormatterImpl(const ProtobufWkt::Struct& format_mapping,
+                                     bool preserve_types, bool omit_empty_values,
+                                     const std::vector<CommandParserPtr>& commands)
+    : omit_empty_values_(omit_empty_values), preserve_types_(preserve_types),
+      empty_value_(omit_empty_values_ ? EMPTY_STRING : DefaultUnspecifiedValueString) {
+  compileObject(format_mapping, "", commands);
+  // The newline, plus a guess of 16 bytes per value.
+  reserve_size_ = 1;
+  for (const Step& step : steps_) {
+    reserve_size_ += step.key_.size() + (step.type_ == Step::Type::Value ? 16 : 1);
+  }
+}
+
+void JsonFormatterImpl::compileObject(const ProtobufWkt::Struct& struct_format, std::string key,
+                                      const std::vector<CommandParserPtr>& commands) {
+  steps_.push_back({Step::Type::StartObject, std::move(key), {}});
+  // Like the StructFormatter's format map, the properties are in the order of their keys.
+  std::vector<const ProtobufWkt::MapPair<std::string, ProtobufWkt::Value>*> fields;
+  for (const auto& pair : struct_format.fields()) {
+    fields.push_back(&pair);
+  }
+  std::sort(fields.begin(), fields.end(),
+            [](const auto* a, const auto* b) { return a->first < b->first; });
+  for (const auto* pair : fields) {
+    std::string field_key;
+    appendJsonString(pair->first, field_key);
+    field_key.push_back(':');
+    compileValue(pair->second, std::move(field_key), commands);
+  }
+  steps_.push_back({Step::Type::EndObject, "", {}});
+}
+
+void JsonFormatterImpl::compileList(const ProtobufWkt::ListValue& list_format, std::string key,
+                                    const std::vector<CommandParserPtr>& commands) {
+  steps_.push_back({Step::Type::StartList, std::move(key), {}});
+  for (const auto& value : list_format.values()) {
+    compileValue(value, "", commands);
+  }
+  steps_.push_back({Step::Type::EndList, "", {}});
+}
+
+void JsonFormatterImpl::compileValue(const ProtobufWkt::Value& value_format, std::string key,
+                                     const std::vector<CommandParserPtr>& commands) {
+  switch (value_format.kind_case()) {
+  case ProtobufWkt::Value::kStringValue:
+    steps_.push_back({Step::Type::Value, std::move(key),
+                      SubstitutionFormatParser::parse(value_format.string_value(), commands)});
+    break;
+
+  case ProtobufWkt::Value::kStructValue:
+    compileObject(value_format.struct_value(), std::move(key), commands);
+    break;
+
+  case ProtobufWkt::Value::kListValue:
+    compileList(value_format.list_value(), std::move(key), commands);
+    break;
+
+  default:
+    throw EnvoyException("Only string values, nested structs and list values are "
+                         "supported in structured access log format.");
+  }
+}
+
 std::string JsonFormatterImpl::format(const Http::RequestHeaderMap& request_headers,
                                       const Http::ResponseHeaderMap& response_headers,
                                       const Http::ResponseTrailerMap& response_trailers,
                                       const StreamInfo::StreamInfo& stream_info,
                                       absl::string_view local_reply_body) const {
-  const ProtobufWkt::Struct output_struct = struct_formatter_.format(
-      request_headers, response_headers, response_trailers, stream_info, local_reply_body);
+  std::string log_line;
+  log_line.reserve(reserve_size_);
+  // Whether the next element of the current object or list follows another one.
+  bool separate = false;
+  const auto start_element = [&log_line, &separate](const Step& step) {
+    if (separate) {
+      log_line.push_back(',');
+    }
+    log_line.append(step.key_);
+  };
+
+  for (const Step& step : steps_) {
+    switch (step.type_) {
+    case Step::Type::StartObject:
+    case Step::Type::StartList:
+      start_element(step);
+      log_line.push_back(step.type_ == Step::Type::StartObject ? '{' : '[');
+      separate = false;
+      break;
+
+    case Step::Type::EndObject:
+    case Step::Type::EndList:
+      log_line.push_back(step.type_ == Step::Type::EndObject ? '}' : ']');
+      separate = true;
+      break;
+
+    case Step::Type::Value:
+      if (step.providers_.size() == 1) {
+        const auto& provider = step.providers_.front();
+        if (preserve_types_) {
+          const ProtobufWkt::Value value = provider->formatValue(
+              request_headers, response_headers, response_trailers, stream_info, local_reply_body);
+          if (omit_empty_values_ && value.kind_case() == ProtobufWkt::Value::kNullValue) {
+            break;
+          }
+          start_element(step);
+          appendJsonValue(value, log_line);
+        } else {
+          const auto str = provider->format(request_headers, response_headers, response_trailers,
+                                            stream_info, local_reply_body);
+          if (omit_empty_values_ && !str.has_value()) {
+            break;
+          }
+          start_element(step);
+          appendJsonString(str.has_value() ? str.value() : DefaultUnspecifiedValueString,
+                           log_line);
+        }
+      } else {
+        // Multiple providers forces string output.
+        std::string str;
+        for (const auto& provider : step.providers_) {
+          const auto bit = provider->format(request_headers, response_headers, response_trailers,
+                                            stream_info, local_reply_body);
+          str += bit.value_or(empty_value_);
+        }
+        start_element(step);
+        appendJsonString(str, log_line);
+      }
+      separate = true;
+      break;
+    }
+  }
+
+  log_line.push_back('\n');
+  return log_line;
+}
+
+void JsonFormatterImpl::appendJsonString(absl::string_view str, std::string& output) {
+  const size_t start = output.size();
+  output.push_back('"');
+  const char* run = str.data();
+  for (const char& c : str) {
+    const uint8_t byte = static_cast<uint8_t>(c);
+    if (byte >= 0x80) {
+      // The protobuf JSON conversion also escapes some non-ASCII characters, and replaces invalid
+      // UTF-8. Leave strings with any to it.
+      output.resize(start);
+      output.append(MessageUtil::getJsonStringFromMessageOrDie(
+          ValueUtil::stringValue(std::string(str)), false, true));
+      return;
+    }
+    const absl::string_view escape = jsonEscape(byte);
+    if (!escape.empty()) {
+      output.append(run, &c - run);
+      output.append(escape.data(), escape.size());
+      run = &c + 1;
+    }
+  }
+  output.append(run, str.data() + str.size() - run);
+  output.push_back('"');
+}
+
+void JsonFormatterImpl::appendJsonValue(const ProtobufWkt::Value& value, std::string& output) {
+  switch (value.kind_case()) {
+  case ProtobufWkt::Value::kNumberValue:
+    appendJsonNumber(value.number_value(), output);
+    break;
+
+  case ProtobufWkt::Value::kStringValue:
+    appendJsonString(value.string_value(), output);
+    break;
+
+  case ProtobufWkt::Value::kBoolValue:
+    output.append(value.bool_value() ? "true" : "false");
+    break;
+
+  case ProtobufWkt::Value::kStructValue: {
+    output.push_back('{');
+    bool separate = false;
+    for (const auto& pair : value.struct_value().fields()) {
+      if (separate) {
+        output.push_back(',');
+      }
+      appendJsonString(pair.first, output);
+      output.push_back(':');
+      appendJsonValue(pair.second, output);
+      separate = true;
+    }
+    output.push_back('}');
+    break;
+  }
+
+  case ProtobufWkt::Value::kListValue: {
+    output.push_back('[');
+    bool separate = false;
+    for (const auto& element : value.list_value().values()) {
+      if (separate) {
+        output.push_back(',');
+      }
+      appendJsonValue(element, output);
+      separate = true;
+    }
+    output.push_back(']');
+    break;
+  }
 
-  const std::string log_line =
-      MessageUtil::getJsonStringFromMessageOrDie(output_struct, false, true);
-  return absl::StrCat(log_line, "\n");
+  default:
+    output.append("null");
+    break;
+  }
 }
 
 StructFormatter::StructFormatter(const ProtobufWkt::Struct& format_mapping, bool preserve_types,
@@ -241,14 +241,18 @@ private:
 
 using StructFormatterPtr = std::unique_ptr<StructFormatter>;
 
+/**
+ * A formatter for JSON log lines. The format is compiled into a flat layout of steps, with the keys
+ * already escaped, and every line is written straight into one string, without building a Struct
+ * proto and converting it to JSON. The output is the JSON the StructFormatter's output converts to,
+ * with the properties in the order of their keys.
+ */
 class JsonFormatterImpl : public Formatter {
 public:
   JsonFormatterImpl(const ProtobufWkt::Struct& format_mapping, bool preserve_types,
-                    bool omit_empty_values)
-      : struct_formatter_(format_mapping, preserve_types, omit_empty_values) {}
+                    bool omit_empty_values);
   JsonFormatterImpl(const ProtobufWkt::Struct& format_mapping, bool preserve_types,
-                    bool omit_empty_values, const std::vector<CommandParserPtr>& commands)
-      : struct_formatter_(format_mapping, preserve_types, omit_empty_values, commands) {}
+                    bool omit_empty_values, const std::vector<CommandParserPtr>& commands);
 
   // Formatter::format
   std::string format(const Http::RequestHeaderMap& request_headers,
@@ -257,8 +261,41 @@ public:
                      const StreamInfo::StreamInfo& stream_info,
                      absl::string_view local_reply_body) const override;
 
+  /**
+   * Appends a string to a JSON output, quoted and escaped as the protobuf JSON conversion escapes
+   * it.
+   */
+  static void appendJsonString(absl::string_view str, std::string& output);
+
+  /**
+   * Appends a value to a JSON output, as the protobuf JSON conversion writes it.
+   */
+  static void appendJsonValue(const ProtobufWkt::Value& value, std::string& output);
+
 private:
-  const StructFormatter struct_formatter_;
+  struct Step {
+    enum class Type { StartObject, EndObject, StartList, EndList, Value };
+
+    Type type_;
+    // The escaped key and colon, as in "key":, for the elements of objects. Empty otherwise.
+    std::string key_;
+    // The providers of a Value step.
+    std::vector<FormatterProviderPtr> providers_;
+  };
+
+  void compileObject(const ProtobufWkt::Struct& struct_format, std::string key,
+                     const std::vector<CommandParserPtr>& commands);
+  void compileList(const ProtobufWkt::ListValue& list_format, std::string key,
+                   const std::vector<CommandParserPtr>& commands);
+  void compileValue(const ProtobufWkt::Value& value_format, std::string key,
+                    const std::vector<CommandParserPtr>& commands);
+
+  const bool omit_empty_values_;
+  const bool preserve_types_;
+  const std::string empty_value_;
+  std::vector<Step> steps_;
+  // The output reserved for a line, from the size of the keys and the number of values.
+  size_t reserve_size_{};
 };
 
 /**
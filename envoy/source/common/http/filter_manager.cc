@@ -21,7 +21,7 @@ namespace Http {
 namespace {
 REGISTER_FACTORY(SkipActionFactory, Matcher::ActionFactory<Matching::HttpFilterActionContext>);
 
-template <class T> using FilterList = std::list<std::unique_ptr<T>>;
+template <class T> using FilterList = std::list<ArenaPtr<T>>;
 
 // Shared helper for recording the latest filter used.
 template <class T>
@@ -452,8 +452,8 @@ void ActiveStreamDecoderFilter::requestDataTooLarge() {
 void FilterManager::addStreamDecoderFilterWorker(StreamDecoderFilterSharedPtr filter,
                                                  FilterMatchStateSharedPtr match_state,
                                                  bool dual_filter) {
-  ActiveStreamDecoderFilterPtr wrapper(
-      new ActiveStreamDecoderFilter(*this, filter, match_state, dual_filter));
+  ActiveStreamDecoderFilterPtr wrapper =
+      arena_.makeUnique<ActiveStreamDecoderFilter>(*this, filter, match_state, dual_filter);
 
   // If we're a dual handling filter, have the encoding wrapper be the only thing registering itself
   // as the handling filter.
@@ -476,8 +476,8 @@ void FilterManager::addStreamDecoderFilterWorker(StreamDecoderFilterSharedPtr fi
 void FilterManager::addStreamEncoderFilterWorker(StreamEncoderFilterSharedPtr filter,
                                                  FilterMatchStateSharedPtr match_state,
                                                  bool dual_filter) {
-  ActiveStreamEncoderFilterPtr wrapper(
-      new ActiveStreamEncoderFilter(*this, filter, match_state, dual_filter));
+  ActiveStreamEncoderFilterPtr wrapper =
+      arena_.makeUnique<ActiveStreamEncoderFilter>(*this, filter, match_state, dual_filter);
 
   if (match_state) {
     match_state->filter_ = filter.get();
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "source/common/common/assert.h"
+#include "source/common/common/hash.h"
+
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * Index of the nodes of a header list by key, for maps with too many headers to scan.
+ *
+ * Every distinct key has a group in a dense array, holding the key's hash and its nodes in
+ * insertion order. The groups are found through an open addressing table with linear probing,
+ * whose slots hold group numbers. The hash of a key is computed once, when its group is created,
+ * so growing the table and deleting from it never hash a key again. Header keys are lowercase, so
+ * the hashes are case-insensitive. Both arrays are inline for maps with few distinct keys, and
+ * the index is updated as headers are added and removed instead of being rebuilt.
+ *
+ * Node is an iterator of the header list, and node->key() the key of the header.
+ */
+template <class Node> class HeaderIndex {
+public:
+  using NodeVector = absl::InlinedVector<Node, 1>;
+
+  /**
+   * Adds a node to the group of its key, after the nodes already there.
+   */
+  void add(Node node) {
+    const absl::string_view key = node->key().getStringView();
+    const uint64_t hash = HashUtil::xxHash64(key);
+    if ((groups_.size() + 1) * 2 > slots_.size()) {
+      grow();
+    }
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+      if (slots_[slot] == 0) {
+        groups_.push_back({hash, {node}});
+        slots_[slot] = groups_.size();
+        return;
+      }
+      Group& group = groups_[slots_[slot] - 1];
+      if (group.hash_ == hash && group.key() == key) {
+        group.nodes_.push_back(node);
+        return;
+      }
+    }
+  }
+
+  /**
+   * @return the nodes with the key, or nullptr if there are none.
+   */
+  const NodeVector* find(absl::string_view key) const {
+    const size_t slot = findSlot(key);
+    return slot == NotFound ? nullptr : &groups_[slots_[slot] - 1].nodes_;
+  }
+
+  /**
+   * Removes a key from the index.
+   * @return the nodes that had the key.
+   */
+  NodeVector remove(absl::string_view key) {
+    const size_t slot = findSlot(key);
+    if (slot == NotFound) {
+      return {};
+    }
+    const uint32_t group = slots_[slot] - 1;
+    NodeVector nodes = std::move(groups_[group].nodes_);
+    removeGroup(slot, group);
+    return nodes;
+  }
+
+  /**
+   * Removes the nodes for which predicate returns true. Groups that are left empty are removed.
+   */
+  template <class NodePredicate> void removeIf(NodePredicate predicate) {
+    for (uint32_t group = 0; group < groups_.size();) {
+      NodeVector& nodes = groups_[group].nodes_;
+      nodes.erase(std::remove_if(nodes.begin(), nodes.end(), predicate), nodes.end());
+      if (!nodes.empty()) {
+        group++;
+        continue;
+      }
+      // The last group is moved into this one, so it is looked at next.
+      removeGroup(slotOf(group), group);
+    }
+  }
+
+  /**
+   * Removes all keys. The memory of the index is kept.
+   */
+  void clear() {
+    groups_.clear();
+    std::fill(slots_.begin(), slots_.end(), 0);
+  }
+
+  bool empty() const { return groups_.empty(); }
+  // The number of distinct keys.
+  size_t size() const { return groups_.size(); }
+
+private:
+  struct Group {
+    absl::string_view key() const { return nodes_.front()->key().getStringView(); }
+
+    uint64_t hash_;
+    // Never empty.
+    NodeVector nodes_;
+  };
+
+  static constexpr size_t NotFound = SIZE_MAX;
+  static constexpr size_t InlineGroups = 8;
+
+  size_t findSlot(absl::string_view key) const {
+    if (groups_.empty()) {
+      return NotFound;
+    }
+    const uint64_t hash = HashUtil::xxHash64(key);
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = hash & mask; slots_[slot] != 0; slot = (slot + 1) & mask) {
+      const Group& group = groups_[slots_[slot] - 1];
+      if (group.hash_ == hash && group.key() == key) {
+        return slot;
+      }
+    }
+    return NotFound;
+  }
+
+  // Returns the slot that refers to a group.
+  size_t slotOf(uint32_t group) const {
+    const size_t mask = slots_.size() - 1;
+    size_t slot = groups_[group].hash_ & mask;
+    while (slots_[slot] != group + 1) {
+      ASSERT(slots_[slot] != 0);
+      slot = (slot + 1) & mask;
+    }
+    return slot;
+  }
+
+  // Removes a group and the slot that refers to it. The last group takes its place, so that the
+  // groups stay dense.
+  void removeGroup(size_t slot, uint32_t group) {
+    removeSlot(slot);
+    const uint32_t last = groups_.size() - 1;
+    if (group != last) {
+      slots_[slotOf(last)] = group + 1;
+      groups_[group] = std::move(groups_[last]);
+    }
+    groups_.pop_back();
+  }
+
+  // Empties a slot, and moves later slots of the same probe sequence back so that lookups don't
+  // stop early. This avoids the tombstones that would otherwise pile up as headers are removed.
+  void removeSlot(size_t slot) {
+    const size_t mask = slots_.size() - 1;
+    for (size_t next = (slot + 1) & mask; slots_[next] != 0; next = (next + 1) & mask) {
+      const size_t home = groups_[slots_[next] - 1].hash_ & mask;
+      // The entry in next can move to slot unless its home lies cyclically in (slot, next].
+      const bool stays =
+          slot <= next ? (slot < home && home <= next) : (slot < home || home <= next);
+      if (!stays) {
+        slots_[slot] = slots_[next];
+        slot = next;
+      }
+    }
+    slots_[slot] = 0;
+  }
+
+  void grow() {
+    const size_t size = std::max<size_t>(slots_.size() * 2, InlineGroups * 2);
+    slots_.assign(size, 0);
+    const size_t mask = size - 1;
+    for (uint32_t group = 0; group < groups_.size(); group++) {
+      size_t slot = groups_[group].hash_ & mask;
+      while (slots_[slot] != 0) {
+        slot = (slot + 1) & mask;
+      }
+      slots_[slot] = group + 1;
+    }
+  }
+
+  absl::InlinedVector<Group, InlineGroups> groups_;
+  // Group numbers plus one, 0 for empty slots. The size is a power of two, and at least twice the
+  // number of groups.
+  absl::InlinedVector<uint32_t, InlineGroups * 2> slots_;
+};
+
+} // namespace Http
+} // namespace Envoy
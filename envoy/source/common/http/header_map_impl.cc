@@ -195,33 +195,27 @@ template <> bool HeaderMapImpl::HeaderList::isPseudoHeader(const LowerCaseString
   return key.get().c_str()[0] == ':';
 }
 
-bool HeaderMapImpl::HeaderList::maybeMakeMap() {
-  if (lazy_map_.empty()) {
+bool HeaderMapImpl::HeaderList::maybeMakeIndex() {
+  if (!indexed_) {
     if (headers_.size() < lazy_map_min_size_) {
       return false;
     }
-    // Add all entries from the list into the map.
     for (auto node = headers_.begin(); node != headers_.end(); ++node) {
-      HeaderNodeVector& v = lazy_map_[node->key().getStringView()];
-      v.push_back(node);
+      index_.add(node);
     }
+    indexed_ = true;
   }
   return true;
 }
 
 size_t HeaderMapImpl::HeaderList::remove(absl::string_view key) {
   size_t removed_bytes = 0;
-  if (maybeMakeMap()) {
-    auto iter = lazy_map_.find(key);
-    if (iter != lazy_map_.end()) {
-      // Erase from the map, and all same key entries from the list.
-      HeaderNodeVector header_nodes = std::move(iter->second);
-      lazy_map_.erase(iter);
-      for (const HeaderNode& node : header_nodes) {
-        ASSERT(node->key() == key);
-        removed_bytes += node->key().size() + node->value().size();
-        erase(node, false /* remove_from_map */);
-      }
+  if (maybeMakeIndex()) {
+    // Erase from the index, and all same key entries from the list.
+    for (const HeaderNode& node : index_.remove(key)) {
+      ASSERT(node->key() == key);
+      removed_bytes += node->key().size() + node->value().size();
+      erase(node, false /* remove_from_map */);
     }
   } else {
     // Erase all same key entries from the list.
@@ -499,22 +493,21 @@ HeaderMap::NonConstGetResult HeaderMapImpl::getExisting(absl::string_view key) {
     return ret;
   }
 
-  // If the requested header is not an O(1) header try using the lazy map to
+  // If the requested header is not an O(1) header try using the index to
   // search for it instead of iterating the headers list.
-  if (headers_.maybeMakeMap()) {
-    HeaderList::HeaderLazyMap::iterator iter = headers_.mapFind(key);
-    if (iter != headers_.mapEnd()) {
-      const HeaderList::HeaderNodeVector& v = iter->second;
-      ASSERT(!v.empty()); // It's impossible to have a map entry with an empty vector as its value.
-      for (const auto& values_it : v) {
+  if (headers_.maybeMakeIndex()) {
+    const HeaderList::HeaderNodeVector* nodes = headers_.find(key);
+    if (nodes != nullptr) {
+      ASSERT(!nodes->empty()); // The index never holds a key without headers.
+      for (const auto& node : *nodes) {
         // Convert the iterated value to a HeaderEntry*.
-        ret.push_back(&(*values_it));
+        ret.push_back(&(*node));
       }
     }
     return ret;
   }
 
-  // If the requested header is not an O(1) header and the lazy map is not in use, we do a full
+  // If the requested header is not an O(1) header and the index is not in use, we do a full
   // scan. Doing the trie lookup is wasteful in the miss case, but is present for code consistency
   // with other functions that do similar things.
   for (HeaderEntryImpl& header : headers_) {
@@ -12,6 +12,7 @@
 
 #include "source/common/common/non_copyable.h"
 #include "source/common/common/utility.h"
+#include "source/common/http/header_index.h"
 #include "source/common/http/headers.h"
 #include "source/common/runtime/runtime_features.h"
 
@@ -181,10 +182,11 @@ protected:
   /**
    * List of HeaderEntryImpl that keeps the pseudo headers (key starting with ':') in the front
    * of the list (as required by nghttp2) and otherwise maintains insertion order.
-   * When the list size is greater or equal to the envoy.http.headermap.lazy_map_min_size runtime
-   * feature value (defaults to 3, if not set), all headers are added to a map, to allow
-   * fast access given a header key. Once the map is initialized, it will be used even if the number
-   * of headers decreases below the threshold.
+   * When a header key is looked up and the list size is greater or equal to the
+   * envoy.http.headermap.lazy_map_min_size runtime feature value (defaults to 3, if not set), all
+   * headers are added to a HeaderIndex, to allow fast access given a header key. From then on the
+   * index is updated as headers are added and removed, and it is used even if the number of headers
+   * decreases below the threshold.
    *
    * Note: the internal iterators held in fields make this unsafe to copy and move, since the
    * reference to end() is not preserved across a move (see Notes in
@@ -195,8 +197,7 @@ protected:
    */
   class HeaderList : NonCopyable {
   public:
-    using HeaderNodeVector = absl::InlinedVector<HeaderNode, 1>;
-    using HeaderLazyMap = absl::flat_hash_map<absl::string_view, HeaderNodeVector>;
+    using HeaderNodeVector = HeaderIndex<HeaderNode>::NodeVector;
 
     HeaderList()
         : pseudo_headers_end_(headers_.end()),
@@ -211,12 +212,12 @@ protected:
       const bool is_pseudo_header = isPseudoHeader(key);
       HeaderNode i = headers_.emplace(is_pseudo_header ? pseudo_headers_end_ : headers_.end(),
                                       std::forward<Key>(key), std::forward<Value>(value)...);
-      if (!lazy_map_.empty()) {
-        lazy_map_[i->key().getStringView()].push_back(i);
-      }
       if (!is_pseudo_header && pseudo_headers_end_ == headers_.end()) {
         pseudo_headers_end_ = i;
       }
+      if (indexed_) {
+        index_.add(i);
+      }
       return i;
     }
 
@@ -224,66 +225,50 @@ protected:
       if (pseudo_headers_end_ == i) {
         pseudo_headers_end_++;
       }
-      if (remove_from_map) {
-        lazy_map_.erase(i->key().getStringView());
+      if (remove_from_map && indexed_) {
+        index_.remove(i->key().getStringView());
       }
       return headers_.erase(i);
     }
 
     template <class UnaryPredicate> void removeIf(UnaryPredicate p) {
-      if (!lazy_map_.empty()) {
-        // Lazy map is used, iterate over its elements and remove those that satisfy the predicate
-        // from the map and from the list.
-        for (auto map_it = lazy_map_.begin(); map_it != lazy_map_.end();) {
-          auto& values_vec = map_it->second;
-          ASSERT(!values_vec.empty());
-          // The following call to std::remove_if removes the elements that satisfy the
-          // UnaryPredicate and shifts the vector elements, but does not resize the vector.
-          // The call to erase that follows erases the unneeded cells (from remove_pos to the
-          // end) and modifies the vector's size.
-          const auto remove_pos =
-              std::remove_if(values_vec.begin(), values_vec.end(), [&](HeaderNode it) {
-                if (p(*(it->entry_))) {
-                  // Remove the element from the list.
-                  if (pseudo_headers_end_ == it->entry_) {
-                    pseudo_headers_end_++;
-                  }
-                  headers_.erase(it);
-                  return true;
-                }
-                return false;
-              });
-          values_vec.erase(remove_pos, values_vec.end());
-
-          // If all elements were removed from the map entry, erase it.
-          if (values_vec.empty()) {
-            lazy_map_.erase(map_it++);
-          } else {
-            map_it++;
-          }
+      const auto remove = [&](const HeaderEntryImpl& entry) {
+        const bool to_remove = p(entry);
+        if (to_remove && pseudo_headers_end_ == entry.entry_) {
+          pseudo_headers_end_++;
         }
-      } else {
-        // The lazy map isn't used, iterate over the list elements and remove elements that satisfy
-        // the predicate.
-        headers_.remove_if([&](const HeaderEntryImpl& entry) {
-          const bool to_remove = p(entry);
-          if (to_remove) {
-            if (pseudo_headers_end_ == entry.entry_) {
-              pseudo_headers_end_++;
-            }
+        return to_remove;
+      };
+      if (indexed_) {
+        // Remove the nodes from the index as they are removed from the list.
+        index_.removeIf([&](HeaderNode node) {
+          if (remove(*node)) {
+            headers_.erase(node);
+            return true;
           }
-          return to_remove;
+          return false;
         });
+      } else {
+        headers_.remove_if(remove);
       }
     }
 
     /*
-     * Creates and populates a map if the number of headers is at least the
+     * Creates and populates the index if the number of headers is at least the
      * envoy.http.headermap.lazy_map_min_size runtime feature value.
      *
-     * @return if a map was created.
+     * @return whether the headers are indexed, in which case find() must be used instead of
+     * scanning the list.
      */
-    bool maybeMakeMap();
+    bool maybeMakeIndex();
+
+    /*
+     * @return the headers with the key. Only valid while the headers are indexed.
+     */
+    const HeaderNodeVector* find(absl::string_view key) const {
+      ASSERT(indexed_);
+      return index_.find(key);
+    }
 
     /*
      * Removes a given key and its values from the HeaderList.
@@ -298,22 +283,22 @@ protected:
     std::list<HeaderEntryImpl>::const_iterator end() const { return headers_.end(); }
     std::list<HeaderEntryImpl>::const_reverse_iterator rbegin() const { return headers_.rbegin(); }
     std::list<HeaderEntryImpl>::const_reverse_iterator rend() const { return headers_.rend(); }
-    HeaderLazyMap::iterator mapFind(absl::string_view key) { return lazy_map_.find(key); }
-    HeaderLazyMap::iterator mapEnd() { return lazy_map_.end(); }
     size_t size() const { return headers_.size(); }
     bool empty() const { return headers_.empty(); }
     void clear() {
       headers_.clear();
       pseudo_headers_end_ = headers_.end();
-      lazy_map_.clear();
+      index_.clear();
+      indexed_ = false;
     }
 
   private:
     std::list<HeaderEntryImpl> headers_;
     HeaderNode pseudo_headers_end_;
-    // The number of headers threshold for lazy map usage.
+    // The number of headers threshold for index usage.
     const uint32_t lazy_map_min_size_;
-    HeaderLazyMap lazy_map_;
+    bool indexed_{};
+    HeaderIndex<HeaderNode> index_;
   };
 
   void insertByKey(HeaderString&& key, HeaderString&& value);
@@ -0,0 +1,1054 @@
+#include "source/common/http/http1/simd_parser_impl.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "source/common/common/assert.h"
+#include "source/common/common/macros.h"
+
+#include "absl/base/macros.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_split.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+namespace {
+
+// Error codes, numbered like http_parser's so that a paused parser reports the same code and
+// error names match what operators are used to.
+// See https://github.com/nodejs/http-parser/blob/v2.9.4/http_parser.h#L244.
+enum ParserErrno : int {
+  HPE_OK = 0,
+  HPE_CB_message_begin = 1,
+  HPE_CB_url = 2,
+  HPE_CB_header_field = 3,
+  HPE_CB_header_value = 4,
+  HPE_CB_headers_complete = 5,
+  HPE_CB_message_complete = 7,
+  HPE_INVALID_EOF_STATE = 11,
+  HPE_CLOSED_CONNECTION = 13,
+  HPE_INVALID_VERSION = 14,
+  HPE_INVALID_STATUS = 15,
+  HPE_INVALID_METHOD = 16,
+  HPE_INVALID_URL = 17,
+  HPE_LF_EXPECTED = 23,
+  HPE_INVALID_HEADER_TOKEN = 24,
+  HPE_INVALID_CONTENT_LENGTH = 25,
+  HPE_UNEXPECTED_CONTENT_LENGTH = 26,
+  HPE_INVALID_CHUNK_SIZE = 27,
+  HPE_INVALID_CONSTANT = 28,
+  HPE_STRICT = 30,
+  HPE_PAUSED = 31,
+  HPE_INVALID_TRANSFER_ENCODING = 33,
+};
+
+// Return codes of the header callback, see ParserStatus.
+constexpr int NoBody = 1;
+constexpr int NoBodyData = 2;
+
+constexpr uint64_t ContentLengthUnset = std::numeric_limits<uint64_t>::max();
+
+// Methods in the order of http_parser's method map. A response parser reports the first one, like
+// http_parser does.
+constexpr absl::string_view Methods[] = {
+    "DELETE", "GET", "HEAD", "POST", "PUT", "CONNECT", "OPTIONS", "TRACE", "COPY", "LOCK", "MKCOL",
+    "MOVE", "PROPFIND", "PROPPATCH", "SEARCH", "UNLOCK", "BIND", "REBIND", "UNBIND", "ACL",
+    "REPORT", "MKACTIVITY", "CHECKOUT", "MERGE", "M-SEARCH", "NOTIFY", "SUBSCRIBE", "UNSUBSCRIBE",
+    "PATCH", "PURGE", "MKCALENDAR", "LINK", "UNLINK", "SOURCE"};
+constexpr uint8_t MethodConnect = 5;
+constexpr size_t MaxMethodLength = 11;
+
+constexpr absl::string_view HttpVersionPrefix = "HTTP/";
+// "HTTP/x.y"
+constexpr uint8_t HttpVersionLength = 8;
+
+struct CharTable {
+  bool contains(char c) const { return chars_[static_cast<uint8_t>(c)]; }
+
+  bool chars_[256];
+};
+
+// RFC 7230 tchar.
+constexpr CharTable tokenChars() {
+  CharTable table{};
+  for (int c = '0'; c <= '9'; c++) {
+    table.chars_[c] = true;
+  }
+  for (int c = 'a'; c <= 'z'; c++) {
+    table.chars_[c] = true;
+    table.chars_[c - 'a' + 'A'] = true;
+  }
+  constexpr char symbols[] = "!#$%&'*+-.^_`|~";
+  for (size_t i = 0; symbols[i] != '\0'; i++) {
+    table.chars_[static_cast<uint8_t>(symbols[i])] = true;
+  }
+  return table;
+}
+
+// Bytes that end a header name: anything that is not a tchar.
+constexpr CharTable nameDelimiters() {
+  CharTable table = tokenChars();
+  for (bool& entry : table.chars_) {
+    entry = !entry;
+  }
+  return table;
+}
+
+// Bytes that end the request target: whitespace, control characters and DEL.
+constexpr CharTable urlDelimiters() {
+  CharTable table{};
+  for (int c = 0; c <= ' '; c++) {
+    table.chars_[c] = true;
+  }
+  table.chars_[0x7f] = true;
+  return table;
+}
+
+// Bytes that end a header value or reason phrase: control characters other than HTAB, and DEL.
+// Only CR and LF end them without an error.
+constexpr CharTable valueDelimiters() {
+  CharTable table{};
+  for (int c = 0; c < ' '; c++) {
+    table.chars_[c] = c != '\t';
+  }
+  table.chars_[0x7f] = true;
+  return table;
+}
+
+constexpr CharTable TokenChars = tokenChars();
+constexpr CharTable NameDelimiters = nameDelimiters();
+constexpr CharTable UrlDelimiters = urlDelimiters();
+constexpr CharTable ValueDelimiters = valueDelimiters();
+
+const char* scalarFind(const char* p, const char* end, const CharTable& delimiters) {
+  while (p < end && !delimiters.contains(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+/**
+ * Functions that return the first delimiter in [p, end), or end if there is none.
+ */
+struct Scanner {
+  const char* (*url_end_)(const char* p, const char* end);
+  const char* (*name_end_)(const char* p, const char* end);
+  const char* (*value_end_)(const char* p, const char* end);
+};
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+// SSE4.2: PCMPESTRI finds the first byte that falls into one of up to 8 inclusive ranges. This is
+// the approach taken by picohttpparser.
+__attribute__((target("sse4.2"))) const char*
+sse42Find(const char* p, const char* end, const char* ranges, int ranges_size,
+          const CharTable& delimiters) {
+  const __m128i ranges16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ranges));
+  while (end - p >= 16) {
+    const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const int index = _mm_cmpestri(ranges16, ranges_size, data, 16,
+                                   _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES | _SIDD_UBYTE_OPS);
+    if (index == 16) {
+      p += 16;
+      continue;
+    }
+    p += index;
+    // The ranges may over-approximate the delimiters.
+    if (delimiters.contains(*p)) {
+      return p;
+    }
+    ++p;
+  }
+  return scalarFind(p, end, delimiters);
+}
+
+alignas(16) constexpr char Sse42UrlRanges[16] = "\x00\x20\x7f\x7f";
+alignas(16) constexpr char Sse42ValueRanges[16] = "\x00\x08\x0a\x1f\x7f\x7f";
+// The last range also covers '|' and '~', which are tchars but rare in header names.
+alignas(16) constexpr char Sse42NameRanges[16] = {'\x00', ' ', '"', '"', '(', ')', ',',    ',',
+                                                  '/',    '/', ':', '@', '[', ']', '{', '\xff'};
+
+const char* sse42UrlEnd(const char* p, const char* end) {
+  return sse42Find(p, end, Sse42UrlRanges, 4, UrlDelimiters);
+}
+
+const char* sse42NameEnd(const char* p, const char* end) {
+  return sse42Find(p, end, Sse42NameRanges, 16, NameDelimiters);
+}
+
+const char* sse42ValueEnd(const char* p, const char* end) {
+  return sse42Find(p, end, Sse42ValueRanges, 6, ValueDelimiters);
+}
+
+constexpr Scanner Sse42Scanner{sse42UrlEnd, sse42NameEnd, sse42ValueEnd};
+
+// AVX2: classify 32 bytes at a time with compares, and header name bytes with a nibble lookup.
+// Entry lo of the first table has bit h set if byte (h << 4 | lo) is a tchar, and entry h of
+// the second table is (1 << h), so a byte is a tchar iff the entries for its nibbles intersect.
+struct NibbleTables {
+  uint8_t low_[32];
+  uint8_t high_[32];
+};
+
+constexpr NibbleTables nibbleTables() {
+  NibbleTables tables{};
+  for (int c = 0; c < 0x80; c++) {
+    if (TokenChars.chars_[c]) {
+      tables.low_[c & 0xf] |= 1 << (c >> 4);
+      tables.low_[16 + (c & 0xf)] |= 1 << (c >> 4);
+    }
+  }
+  for (int high = 0; high < 8; high++) {
+    tables.high_[high] = 1 << high;
+    tables.high_[16 + high] = 1 << high;
+  }
+  return tables;
+}
+
+constexpr NibbleTables TokenNibbleTables = nibbleTables();
+
+__attribute__((target("avx2"))) const char* avx2UrlEnd(const char* p, const char* end) {
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  while (end - p >= 32) {
+    const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i controls = _mm256_cmpeq_epi8(_mm256_min_epu8(data, space), data);
+    const uint32_t mask = _mm256_movemask_epi8(
+        _mm256_or_si256(controls, _mm256_cmpeq_epi8(data, del)));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return scalarFind(p, end, UrlDelimiters);
+}
+
+__attribute__((target("avx2"))) const char* avx2NameEnd(const char* p, const char* end) {
+  const __m256i low_table =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(TokenNibbleTables.low_));
+  const __m256i high_table =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(TokenNibbleTables.high_));
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  while (end - p >= 32) {
+    const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(data, nibble));
+    const __m256i high = _mm256_shuffle_epi8(
+        high_table, _mm256_and_si256(_mm256_srli_epi16(data, 4), nibble));
+    const uint32_t mask = _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256()));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return scalarFind(p, end, NameDelimiters);
+}
+
+__attribute__((target("avx2"))) const char* avx2ValueEnd(const char* p, const char* end) {
+  const __m256i last_control = _mm256_set1_epi8(0x1f);
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i del = _mm256_set1_epi8(0x7f);
+  while (end - p >= 32) {
+    const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i controls = _mm256_andnot_si256(
+        _mm256_cmpeq_epi8(data, tab), _mm256_cmpeq_epi8(_mm256_min_epu8(data, last_control), data));
+    const uint32_t mask = _mm256_movemask_epi8(
+        _mm256_or_si256(controls, _mm256_cmpeq_epi8(data, del)));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return scalarFind(p, end, ValueDelimiters);
+}
+
+constexpr Scanner Avx2Scanner{avx2UrlEnd, avx2NameEnd, avx2ValueEnd};
+
+const Scanner* selectScanner() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return &Avx2Scanner;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return &Sse42Scanner;
+  }
+  return nullptr;
+}
+
+#else
+
+const Scanner* selectScanner() { return nullptr; }
+
+#endif
+
+const Scanner* activeScanner() {
+  static const Scanner* scanner = selectScanner();
+  return scanner;
+}
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c = absl::ascii_tolower(c);
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+} // namespace
+
+SimdHttpParserImpl::SimdHttpParserImpl(MessageType type, ParserCallbacks* callbacks)
+    : callbacks_(callbacks), type_(type), content_length_(ContentLengthUnset) {
+  RELEASE_ASSERT(isSupported(), "SIMD HTTP/1 parser is not supported on this CPU");
+}
+
+bool SimdHttpParserImpl::isSupported() { return activeScanner() != nullptr; }
+
+Parser::RcVal SimdHttpParserImpl::execute(const char* data, int len) {
+  if (errno_ != HPE_OK) {
+    return {0, errno_};
+  }
+  upgraded_ = false;
+
+  if (len == 0) {
+    // The connection was closed, which only completes a body that is delimited by it.
+    switch (state_) {
+    case State::BodyIdentityEof:
+      onMessageComplete();
+      return {0, errno_};
+    case State::MessageStart:
+    case State::Dead:
+      return {0, HPE_OK};
+    default:
+      setError(HPE_INVALID_EOF_STATE);
+      return {1, errno_};
+    }
+  }
+
+  const Scanner& scanner = *activeScanner();
+  const char* p = data;
+  const char* const end = data + len;
+  while (errno_ == HPE_OK && !upgraded_ && (p < end || state_ == State::HeadersDone)) {
+    switch (state_) {
+    case State::MessageStart:
+      if (*p == '\r' || *p == '\n') {
+        ++p;
+        break;
+      }
+      resetMessage();
+      state_ = type_ == MessageType::Request ? State::Method : State::ResponseVersion;
+      onMessageBegin();
+      break;
+
+    case State::Method:
+      while (p < end && ((*p >= 'A' && *p <= 'Z') || *p == '-') &&
+             token_length_ < MaxMethodLength) {
+        token_[token_length_++] = *p++;
+      }
+      if (p == end) {
+        break;
+      }
+      if (*p != ' ' || !parseMethod()) {
+        setError(HPE_INVALID_METHOD);
+        break;
+      }
+      ++p;
+      state_ = State::SpacesBeforeUrl;
+      break;
+
+    case State::SpacesBeforeUrl:
+      if (*p == ' ') {
+        ++p;
+      } else if (UrlDelimiters.contains(*p)) {
+        setError(HPE_INVALID_URL);
+      } else {
+        state_ = State::Url;
+      }
+      break;
+
+    case State::Url: {
+      const char* start = p;
+      p = scanner.url_end_(p, end);
+      if (p != start && !onUrl(start, p - start)) {
+        break;
+      }
+      if (p == end) {
+        break;
+      }
+      if (*p == ' ') {
+        ++p;
+        token_length_ = 0;
+        state_ = State::RequestVersion;
+      } else if (*p == '\r' || *p == '\n') {
+        // HTTP/0.9 request line without a version.
+        http_major_ = 0;
+        http_minor_ = 9;
+        state_ = State::StartLineAlmostDone;
+      } else {
+        setError(HPE_INVALID_URL);
+      }
+      break;
+    }
+
+    case State::RequestVersion:
+      if (token_length_ == 0 && *p == ' ') {
+        ++p;
+      } else if (token_length_ < HttpVersionLength) {
+        if (parseVersion(*p)) {
+          ++p;
+        }
+      } else if (*p == '\r' || *p == '\n') {
+        state_ = State::StartLineAlmostDone;
+      } else {
+        setError(HPE_INVALID_VERSION);
+      }
+      break;
+
+    case State::ResponseVersion:
+      if (token_length_ < HttpVersionLength) {
+        if (parseVersion(*p)) {
+          ++p;
+        }
+      } else if (*p == ' ') {
+        ++p;
+        token_length_ = 0;
+        state_ = State::StatusCode;
+      } else {
+        setError(HPE_INVALID_VERSION);
+      }
+      break;
+
+    case State::StatusCode:
+      if (token_length_ < 3) {
+        if (!absl::ascii_isdigit(*p)) {
+          setError(HPE_INVALID_STATUS);
+          break;
+        }
+        status_code_ = status_code_ * 10 + (*p++ - '0');
+        token_length_++;
+      } else if (*p == ' ') {
+        ++p;
+        state_ = State::ReasonPhrase;
+      } else if (*p == '\r' || *p == '\n') {
+        state_ = State::StartLineAlmostDone;
+      } else {
+        setError(HPE_INVALID_STATUS);
+      }
+      break;
+
+    case State::ReasonPhrase:
+      p = scanner.value_end_(p, end);
+      if (p == end) {
+        break;
+      }
+      if (*p == '\r' || *p == '\n') {
+        state_ = State::StartLineAlmostDone;
+      } else {
+        setError(HPE_INVALID_STATUS);
+      }
+      break;
+
+    case State::StartLineAlmostDone:
+    case State::HeaderLineAlmostDone:
+      // Either "\r\n" or a bare "\n" ends the line.
+      if (*p == '\r') {
+        if (std::exchange(line_cr_, true)) {
+          setError(HPE_LF_EXPECTED);
+        } else {
+          ++p;
+        }
+        break;
+      }
+      if (*p != '\n') {
+        setError(HPE_LF_EXPECTED);
+        break;
+      }
+      ++p;
+      line_cr_ = false;
+      state_ = State::HeaderFieldStart;
+      break;
+
+    case State::HeaderFieldStart:
+      if (*p == '\r' || *p == '\n') {
+        state_ = State::HeadersAlmostDone;
+      } else if (TokenChars.contains(*p)) {
+        token_length_ = 0;
+        state_ = State::HeaderField;
+      } else {
+        // This includes obsolete line folding.
+        setError(HPE_INVALID_HEADER_TOKEN);
+      }
+      break;
+
+    case State::HeaderField: {
+      const char* start = p;
+      p = scanner.name_end_(p, end);
+      // Keep enough of the name to recognize the headers that frame the message.
+      const size_t copy = std::min<size_t>(p - start, sizeof(token_) - token_length_);
+      memcpy(token_ + token_length_, start, copy);
+      token_length_ += copy;
+      if (p != start && !onHeaderField(start, p - start)) {
+        break;
+      }
+      if (p == end) {
+        break;
+      }
+      if (*p != ':') {
+        setError(HPE_INVALID_HEADER_TOKEN);
+        break;
+      }
+      ++p;
+      header_kind_ = trailers_ ? HeaderKind::Other : headerKind();
+      value_seen_ = false;
+      framing_value_.clear();
+      state_ = State::HeaderValueStart;
+      break;
+    }
+
+    case State::HeaderValueStart:
+      while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+      }
+      if (p != end) {
+        state_ = State::HeaderValue;
+      }
+      break;
+
+    case State::HeaderValue: {
+      const char* start = p;
+      p = scanner.value_end_(p, end);
+      if (p != start) {
+        value_seen_ = true;
+        if (header_kind_ != HeaderKind::Other) {
+          framing_value_.append(start, p - start);
+        }
+        if (!onHeaderValue(start, p - start)) {
+          break;
+        }
+      }
+      if (p == end) {
+        break;
+      }
+      if (*p != '\r' && *p != '\n') {
+        setError(HPE_INVALID_HEADER_TOKEN);
+        break;
+      }
+      state_ = State::HeaderLineAlmostDone;
+      onHeaderValueComplete(p);
+      break;
+    }
+
+    case State::HeadersAlmostDone:
+      if (*p == '\r') {
+        if (std::exchange(line_cr_, true)) {
+          setError(HPE_LF_EXPECTED);
+        } else {
+          ++p;
+        }
+        break;
+      }
+      if (*p != '\n') {
+        setError(HPE_LF_EXPECTED);
+        break;
+      }
+      ++p;
+      line_cr_ = false;
+      if (trailers_) {
+        onMessageComplete();
+        break;
+      }
+      state_ = State::HeadersDone;
+      onHeadersComplete();
+      break;
+
+    case State::HeadersDone:
+      startBody();
+      break;
+
+    case State::BodyIdentity:
+    case State::ChunkData: {
+      const uint64_t length = std::min<uint64_t>(remaining_, end - p);
+      const char* start = p;
+      p += length;
+      remaining_ -= length;
+      if (!onBody(start, length) || remaining_ > 0) {
+        break;
+      }
+      if (state_ == State::ChunkData) {
+        state_ = State::ChunkDataAlmostDone;
+      } else {
+        onMessageComplete();
+      }
+      break;
+    }
+
+    case State::BodyIdentityEof: {
+      const char* start = p;
+      p = end;
+      onBody(start, p - start);
+      break;
+    }
+
+    case State::ChunkSizeStart: {
+      const int value = hexValue(*p);
+      if (value < 0) {
+        setError(HPE_INVALID_CHUNK_SIZE);
+        break;
+      }
+      ++p;
+      remaining_ = value;
+      state_ = State::ChunkSize;
+      break;
+    }
+
+    case State::ChunkSize: {
+      const int value = hexValue(*p);
+      if (value >= 0) {
+        if (remaining_ > (std::numeric_limits<uint64_t>::max() >> 4)) {
+          setError(HPE_INVALID_CHUNK_SIZE);
+          break;
+        }
+        ++p;
+        remaining_ = (remaining_ << 4) | value;
+      } else if (*p == '\r') {
+        ++p;
+        state_ = State::ChunkSizeAlmostDone;
+      } else if (*p == ';' || *p == ' ') {
+        ++p;
+        state_ = State::ChunkExtensions;
+      } else {
+        setError(HPE_INVALID_CHUNK_SIZE);
+      }
+      break;
+    }
+
+    case State::ChunkExtensions:
+      // Extensions are ignored, but may not contain a line break other than the final CRLF.
+      p = scanner.value_end_(p, end);
+      if (p == end) {
+        break;
+      }
+      if (*p != '\r') {
+        setError(HPE_INVALID_CHUNK_SIZE);
+        break;
+      }
+      ++p;
+      state_ = State::ChunkSizeAlmostDone;
+      break;
+
+    case State::ChunkSizeAlmostDone:
+      if (*p != '\n') {
+        setError(HPE_LF_EXPECTED);
+        break;
+      }
+      ++p;
+      if (remaining_ == 0) {
+        // The last chunk is followed by trailers.
+        trailers_ = true;
+        state_ = State::HeaderFieldStart;
+      } else {
+        state_ = State::ChunkData;
+      }
+      onChunkHeader();
+      break;
+
+    case State::ChunkDataAlmostDone:
+      if (*p != '\r') {
+        setError(HPE_STRICT);
+        break;
+      }
+      ++p;
+      state_ = State::ChunkDataDone;
+      break;
+
+    case State::ChunkDataDone:
+      if (*p != '\n') {
+        setError(HPE_LF_EXPECTED);
+        break;
+      }
+      ++p;
+      state_ = State::ChunkSizeStart;
+      break;
+
+    case State::Dead:
+      // Only blank lines may follow the last message on a connection.
+      if (*p != '\r' && *p != '\n') {
+        setError(HPE_CLOSED_CONNECTION);
+        break;
+      }
+      ++p;
+      break;
+    }
+  }
+  return {static_cast<size_t>(p - data), errno_};
+}
+
+void SimdHttpParserImpl::resume() {
+  if (errno_ == HPE_PAUSED) {
+    errno_ = HPE_OK;
+  }
+}
+
+ParserStatus SimdHttpParserImpl::pause() {
+  if (errno_ == HPE_OK) {
+    errno_ = HPE_PAUSED;
+  }
+  // Like LegacyHttpParserImpl, the return value only tells the parser to continue, the pause takes
+  // effect through errno_.
+  return ParserStatus::Success;
+}
+
+ParserStatus SimdHttpParserImpl::getStatus() {
+  switch (errno_) {
+  case HPE_OK:
+    return ParserStatus::Success;
+  case HPE_PAUSED:
+    return ParserStatus::Paused;
+  default:
+    return ParserStatus::Error;
+  }
+}
+
+absl::optional<uint64_t> SimdHttpParserImpl::contentLength() const {
+  if (content_length_ == ContentLengthUnset) {
+    return absl::nullopt;
+  }
+  return content_length_;
+}
+
+absl::string_view SimdHttpParserImpl::methodName() const { return Methods[method_]; }
+
+absl::string_view SimdHttpParserImpl::errnoName(int rc) const {
+  switch (rc) {
+  case HPE_OK:
+    return "HPE_OK";
+  case HPE_CB_message_begin:
+    return "HPE_CB_message_begin";
+  case HPE_CB_url:
+    return "HPE_CB_url";
+  case HPE_CB_header_field:
+    return "HPE_CB_header_field";
+  case HPE_CB_header_value:
+    return "HPE_CB_header_value";
+  case HPE_CB_headers_complete:
+    return "HPE_CB_headers_complete";
+  case HPE_CB_message_complete:
+    return "HPE_CB_message_complete";
+  case HPE_INVALID_EOF_STATE:
+    return "HPE_INVALID_EOF_STATE";
+  case HPE_CLOSED_CONNECTION:
+    return "HPE_CLOSED_CONNECTION";
+  case HPE_INVALID_VERSION:
+    return "HPE_INVALID_VERSION";
+  case HPE_INVALID_STATUS:
+    return "HPE_INVALID_STATUS";
+  case HPE_INVALID_METHOD:
+    return "HPE_INVALID_METHOD";
+  case HPE_INVALID_URL:
+    return "HPE_INVALID_URL";
+  case HPE_LF_EXPECTED:
+    return "HPE_LF_EXPECTED";
+  case HPE_INVALID_HEADER_TOKEN:
+    return "HPE_INVALID_HEADER_TOKEN";
+  case HPE_INVALID_CONTENT_LENGTH:
+    return "HPE_INVALID_CONTENT_LENGTH";
+  case HPE_UNEXPECTED_CONTENT_LENGTH:
+    return "HPE_UNEXPECTED_CONTENT_LENGTH";
+  case HPE_INVALID_CHUNK_SIZE:
+    return "HPE_INVALID_CHUNK_SIZE";
+  case HPE_INVALID_CONSTANT:
+    return "HPE_INVALID_CONSTANT";
+  case HPE_STRICT:
+    return "HPE_STRICT";
+  case HPE_PAUSED:
+    return "HPE_PAUSED";
+  case HPE_INVALID_TRANSFER_ENCODING:
+    return "HPE_INVALID_TRANSFER_ENCODING";
+  default:
+    return "HPE_UNKNOWN";
+  }
+}
+
+int SimdHttpParserImpl::statusToInt(const ParserStatus code) const {
+  switch (code) {
+  case ParserStatus::Error:
+    return -1;
+  case ParserStatus::Success:
+    return 0;
+  case ParserStatus::NoBody:
+    return NoBody;
+  case ParserStatus::NoBodyData:
+    return NoBodyData;
+  case ParserStatus::Paused:
+    return HPE_PAUSED;
+  default:
+    NOT_REACHED_GCOVR_EXCL_LINE;
+  }
+}
+
+void SimdHttpParserImpl::resetMessage() {
+  method_ = 0;
+  status_code_ = 0;
+  http_major_ = 0;
+  http_minor_ = 0;
+  content_length_ = ContentLengthUnset;
+  chunked_ = false;
+  uses_transfer_encoding_ = false;
+  connection_close_ = false;
+  connection_keep_alive_ = false;
+  connection_upgrade_ = false;
+  upgrade_header_ = false;
+  upgrade_ = false;
+  skip_body_ = false;
+  trailers_ = false;
+  line_cr_ = false;
+  remaining_ = 0;
+  token_length_ = 0;
+}
+
+bool SimdHttpParserImpl::setError(int error) {
+  errno_ = error;
+  return false;
+}
+
+bool SimdHttpParserImpl::onMessageBegin() {
+  if (callbacks_->setAndCheckCallbackStatus(callbacks_->onMessageBegin()) != 0) {
+    return setError(HPE_CB_message_begin);
+  }
+  return errno_ == HPE_OK;
+}
+
+bool SimdHttpParserImpl::onUrl(const char* data, size_t length) {
+  if (callbacks_->setAndCheckCallbackStatus(callbacks_->onUrl(data, length)) != 0) {
+    return setError(HPE_CB_url);
+  }
+  return errno_ == HPE_OK;
+}
+
+bool SimdHttpParserImpl::onHeaderField(const char* data, size_t length) {
+  if (callbacks_->setAndCheckCallbackStatus(callbacks_->onHeaderField(data, length)) != 0) {
+    return setError(HPE_CB_header_field);
+  }
+  return errno_ == HPE_OK;
+}
+
+bool SimdHttpParserImpl::onHeaderValue(const char* data, size_t length) {
+  if (callbacks_->setAndCheckCallbackStatus(callbacks_->onHeaderValue(data, length)) != 0) {
+    return setError(HPE_CB_header_value);
+  }
+  return errno_ == HPE_OK;
+}
+
+bool SimdHttpParserImpl::onHeaderValueComplete(const char* at) {
+  // An empty value is reported as well, which is what tells the callbacks that the next field
+  // starts a new header.
+  if (!value_seen_ && !onHeaderValue(at, 0)) {
+    return false;
+  }
+  switch (header_kind_) {
+  case HeaderKind::Other:
+    return true;
+  case HeaderKind::ContentLength: {
+    if (content_length_ != ContentLengthUnset) {
+      return setError(HPE_UNEXPECTED_CONTENT_LENGTH);
+    }
+    const absl::string_view value = absl::StripTrailingAsciiWhitespace(framing_value_);
+    if (value.empty()) {
+      return setError(HPE_INVALID_CONTENT_LENGTH);
+    }
+    uint64_t content_length = 0;
+    for (const char c : value) {
+      if (!absl::ascii_isdigit(c) ||
+          content_length > (std::numeric_limits<uint64_t>::max() - 10) / 10) {
+        return setError(HPE_INVALID_CONTENT_LENGTH);
+      }
+      content_length = content_length * 10 + (c - '0');
+    }
+    content_length_ = content_length;
+    return true;
+  }
+  case HeaderKind::TransferEncoding: {
+    // The message is chunked if chunked is the final coding.
+    uses_transfer_encoding_ = true;
+    const size_t last_comma = framing_value_.rfind(',');
+    const absl::string_view last_coding = absl::StripAsciiWhitespace(
+        absl::string_view(framing_value_)
+            .substr(last_comma == std::string::npos ? 0 : last_comma + 1));
+    chunked_ = absl::EqualsIgnoreCase(last_coding, "chunked");
+    return true;
+  }
+  case HeaderKind::Connection:
+    for (absl::string_view option : absl::StrSplit(framing_value_, ',')) {
+      option = absl::StripAsciiWhitespace(option);
+      if (absl::EqualsIgnoreCase(option, "close")) {
+        connection_close_ = true;
+      } else if (absl::EqualsIgnoreCase(option, "keep-alive")) {
+        connection_keep_alive_ = true;
+      } else if (absl::EqualsIgnoreCase(option, "upgrade")) {
+        connection_upgrade_ = true;
+      }
+    }
+    return true;
+  case HeaderKind::Upgrade:
+    upgrade_header_ = true;
+    return true;
+  }
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
+bool SimdHttpParserImpl::onHeadersComplete() {
+  if (upgrade_header_ && connection_upgrade_) {
+    // For responses, the headers only announce support unless the status is 101.
+    upgrade_ = type_ == MessageType::Request || status_code_ == 101;
+  } else {
+    upgrade_ = type_ == MessageType::Request && method_ == MethodConnect;
+  }
+  switch (callbacks_->setAndCheckCallbackStatusOr(callbacks_->onHeadersComplete())) {
+  case 0:
+    break;
+  case NoBodyData:
+    upgrade_ = true;
+    FALLTHRU;
+  case NoBody:
+    skip_body_ = true;
+    break;
+  default:
+    return setError(HPE_CB_headers_complete);
+  }
+  return errno_ == HPE_OK;
+}
+
+bool SimdHttpParserImpl::onBody(const char* data, size_t length) {
+  callbacks_->bufferBody(data, length);
+  return errno_ == HPE_OK;
+}
+
+bool SimdHttpParserImpl::onChunkHeader() {
+  callbacks_->onChunkHeader(remaining_ == 0);
+  return errno_ == HPE_OK;
+}
+
+bool SimdHttpParserImpl::onMessageComplete() {
+  state_ = shouldKeepAlive() ? State::MessageStart : State::Dead;
+  // Whatever follows an upgrade is in a different protocol and not parsed.
+  upgraded_ = upgrade_;
+  if (callbacks_->setAndCheckCallbackStatusOr(callbacks_->onMessageComplete()) != 0) {
+    return setError(HPE_CB_message_complete);
+  }
+  return errno_ == HPE_OK;
+}
+
+bool SimdHttpParserImpl::parseMethod() {
+  const absl::string_view method(token_, token_length_);
+  for (size_t i = 0; i < ABSL_ARRAYSIZE(Methods); i++) {
+    if (Methods[i] == method) {
+      method_ = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SimdHttpParserImpl::parseVersion(char c) {
+  if (token_length_ < HttpVersionPrefix.size()) {
+    if (c != HttpVersionPrefix[token_length_]) {
+      return setError(HPE_INVALID_CONSTANT);
+    }
+  } else if (token_length_ == HttpVersionPrefix.size() + 1) {
+    if (c != '.') {
+      return setError(HPE_INVALID_VERSION);
+    }
+  } else {
+    if (!absl::ascii_isdigit(c)) {
+      return setError(HPE_INVALID_VERSION);
+    }
+    (token_length_ == HttpVersionPrefix.size() ? http_major_ : http_minor_) = c - '0';
+  }
+  token_length_++;
+  return true;
+}
+
+SimdHttpParserImpl::HeaderKind SimdHttpParserImpl::headerKind() const {
+  const absl::string_view name(token_, token_length_);
+  if (absl::EqualsIgnoreCase(name, "content-length")) {
+    return HeaderKind::ContentLength;
+  }
+  if (absl::EqualsIgnoreCase(name, "transfer-encoding")) {
+    return HeaderKind::TransferEncoding;
+  }
+  if (absl::EqualsIgnoreCase(name, "connection") ||
+      absl::EqualsIgnoreCase(name, "proxy-connection")) {
+    return HeaderKind::Connection;
+  }
+  if (absl::EqualsIgnoreCase(name, "upgrade")) {
+    return HeaderKind::Upgrade;
+  }
+  return HeaderKind::Other;
+}
+
+void SimdHttpParserImpl::startBody() {
+  const bool has_body =
+      chunked_ || (content_length_ > 0 && content_length_ != ContentLengthUnset);
+  if (upgrade_ && (method_ == MethodConnect || skip_body_ || !has_body)) {
+    onMessageComplete();
+  } else if (skip_body_) {
+    onMessageComplete();
+  } else if (chunked_) {
+    state_ = State::ChunkSizeStart;
+  } else if (uses_transfer_encoding_) {
+    // A request body that is not chunked has no defined length. A response body ends with the
+    // connection. See https://tools.ietf.org/html/rfc7230#section-3.3.3.
+    if (type_ == MessageType::Request) {
+      setError(HPE_INVALID_TRANSFER_ENCODING);
+    } else {
+      state_ = State::BodyIdentityEof;
+    }
+  } else if (content_length_ == 0) {
+    onMessageComplete();
+  } else if (content_length_ != ContentLengthUnset) {
+    remaining_ = content_length_;
+    state_ = State::BodyIdentity;
+  } else if (needsEof()) {
+    state_ = State::BodyIdentityEof;
+  } else {
+    onMessageComplete();
+  }
+}
+
+bool SimdHttpParserImpl::needsEof() const {
+  if (type_ == MessageType::Request) {
+    return false;
+  }
+  if (status_code_ / 100 == 1 || status_code_ == 204 || status_code_ == 304 || skip_body_) {
+    return false;
+  }
+  if (uses_transfer_encoding_ && !chunked_) {
+    return true;
+  }
+  return !chunked_ && content_length_ == ContentLengthUnset;
+}
+
+bool SimdHttpParserImpl::shouldKeepAlive() const {
+  if (http_major_ > 0 && http_minor_ > 0) {
+    if (connection_close_) {
+      return false;
+    }
+  } else if (!connection_keep_alive_) {
+    return false;
+  }
+  return !needsEof();
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
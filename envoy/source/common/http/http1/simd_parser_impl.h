@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "source/common/http/http1/parser.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * HTTP/1 parser that finds the end of the request target, header names, header values and reason
+ * phrases with SSE4.2 or AVX2 instead of stepping through them a byte at a time. Callbacks are
+ * invoked in the same order and with the same return code contract as LegacyHttpParserImpl, and
+ * error codes have the names http_parser gives them.
+ *
+ * The parser is stricter than http_parser in a few places where the latter is lenient:
+ * obsolete line folding in header values, whitespace in header names and anything but CRLF after
+ * a chunk are rejected.
+ */
+class SimdHttpParserImpl : public Parser {
+public:
+  SimdHttpParserImpl(MessageType type, ParserCallbacks* callbacks);
+
+  /**
+   * @return whether the CPU supports the instructions this parser scans with. If not,
+   *         LegacyHttpParserImpl should be used instead.
+   */
+  static bool isSupported();
+
+  // Http1::Parser
+  RcVal execute(const char* data, int len) override;
+  void resume() override;
+  ParserStatus pause() override;
+  ParserStatus getStatus() override;
+  uint16_t statusCode() const override { return status_code_; }
+  int httpMajor() const override { return http_major_; }
+  int httpMinor() const override { return http_minor_; }
+  absl::optional<uint64_t> contentLength() const override;
+  bool isChunked() const override { return chunked_; }
+  absl::string_view methodName() const override;
+  absl::string_view errnoName(int rc) const override;
+  int hasTransferEncoding() const override { return uses_transfer_encoding_; }
+  int statusToInt(const ParserStatus code) const override;
+
+private:
+  enum class State : uint8_t {
+    MessageStart,
+    Method,
+    SpacesBeforeUrl,
+    Url,
+    RequestVersion,
+    ResponseVersion,
+    StatusCode,
+    ReasonPhrase,
+    StartLineAlmostDone,
+    HeaderFieldStart,
+    HeaderField,
+    HeaderValueStart,
+    HeaderValue,
+    HeaderLineAlmostDone,
+    HeadersAlmostDone,
+    HeadersDone,
+    BodyIdentity,
+    BodyIdentityEof,
+    ChunkSizeStart,
+    ChunkSize,
+    ChunkExtensions,
+    ChunkSizeAlmostDone,
+    ChunkData,
+    ChunkDataAlmostDone,
+    ChunkDataDone,
+    Dead,
+  };
+
+  // Headers that change how the message is framed.
+  enum class HeaderKind : uint8_t { Other, ContentLength, TransferEncoding, Connection, Upgrade };
+
+  void resetMessage();
+  bool setError(int error);
+
+  // Each of the following runs a callback and returns false if parsing has to stop, either because
+  // of an error or because the callback paused the parser.
+  bool onMessageBegin();
+  bool onUrl(const char* data, size_t length);
+  bool onHeaderField(const char* data, size_t length);
+  bool onHeaderValue(const char* data, size_t length);
+  // Called at the end of each header value with a pointer to the byte that ended it.
+  bool onHeaderValueComplete(const char* at);
+  bool onHeadersComplete();
+  bool onBody(const char* data, size_t length);
+  bool onChunkHeader();
+  bool onMessageComplete();
+
+  // Looks up the method in token_.
+  bool parseMethod();
+  // Consumes byte token_length_ of "HTTP/x.y". Returns false on error.
+  bool parseVersion(char c);
+  HeaderKind headerKind() const;
+  // Decides how the body is delimited once the header callback has returned, following
+  // https://tools.ietf.org/html/rfc7230#section-3.3.3.
+  void startBody();
+  bool needsEof() const;
+  bool shouldKeepAlive() const;
+
+  ParserCallbacks* const callbacks_;
+  const MessageType type_;
+  State state_{State::MessageStart};
+  int errno_{};
+
+  // Message properties exposed through the Parser interface.
+  uint8_t method_{};
+  uint16_t status_code_{};
+  uint8_t http_major_{};
+  uint8_t http_minor_{};
+  uint64_t content_length_;
+  bool chunked_{};
+  bool uses_transfer_encoding_{};
+
+  // Framing state of the current message.
+  bool connection_close_{};
+  bool connection_keep_alive_{};
+  bool connection_upgrade_{};
+  bool upgrade_header_{};
+  bool upgrade_{};
+  bool skip_body_{};
+  bool trailers_{};
+  // Bytes left in the body or the current chunk.
+  uint64_t remaining_{};
+  // Set once the message that switched protocols is complete. Parsing stops there.
+  bool upgraded_{};
+
+  // Scratch state for the line being parsed. token_ holds the method or the start of a header
+  // name, which is enough to recognize the headers that frame the message.
+  uint8_t token_length_{};
+  char token_[20];
+  bool line_cr_{};
+  HeaderKind header_kind_{HeaderKind::Other};
+  bool value_seen_{};
+  std::string framing_value_;
+};
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -134,7 +134,7 @@ void ConnectionImpl::close(ConnectionCloseType type) {
     return;
   }
 
-  uint64_t data_to_write = write_buffer_->length();
+  uint64_t data_to_write = pendingWriteBytes();
   ENVOY_CONN_LOG(debug, "closing data_to_write={} type={}", *this, data_to_write, enumToInt(type));
   const bool delayed_close_timeout_set = delayed_close_timeout_.count() > 0;
   if (data_to_write == 0 || type == ConnectionCloseType::NoFlush ||
@@ -248,6 +248,7 @@ void ConnectionImpl::closeSocket(ConnectionEvent close_type) {
 
   ENVOY_CONN_LOG(debug, "closing socket: {}", *this, static_cast<uint32_t>(close_type));
   transport_socket_->closeSocket(close_type);
+  stopSplice();
 
   // Drain input and output buffers.
   updateReadBufferStats(0, 0);
@@ -258,6 +259,8 @@ void ConnectionImpl::closeSocket(ConnectionEvent close_type) {
   // counted buffer fragments, it helps avoid lifetime issues with the
   // connection outlasting the subscriber.
   write_buffer_->drain(write_buffer_->length());
+  read_pipe_ = nullptr;
+  write_pipe_ = nullptr;
 
   connection_stats_.reset();
 
@@ -615,6 +618,10 @@ void ConnectionImpl::onReadReady() {
   // reading from the transport if the read buffer is above high watermark at the start of the
   // method.
   transport_wants_read_ = false;
+  if (read_pipe_ != nullptr) {
+    onSpliceReadReady();
+    return;
+  }
   IoResult result = transport_socket_->doRead(*read_buffer_);
   uint64_t new_buffer_size = read_buffer_->length();
   updateReadBufferStats(result.bytes_processed_, new_buffer_size);
@@ -685,8 +692,18 @@ void ConnectionImpl::onWriteReady() {
     }
   }
 
-  IoResult result = transport_socket_->doWrite(*write_buffer_, write_end_stream_);
+  uint64_t bytes_spliced = 0;
+  if (write_pipe_ != nullptr && write_pipe_->length() > 0 && !spliceWrite(bytes_spliced)) {
+    return;
+  }
+
+  IoResult result{PostIoAction::KeepOpen, 0, false};
+  // The data in the write buffer, and end_stream, follow the spliced data.
+  if (write_pipe_ == nullptr || write_pipe_->length() == 0) {
+    result = transport_socket_->doWrite(*write_buffer_, write_end_stream_);
+  }
   ASSERT(!result.end_stream_read_); // The interface guarantees that only read operations set this.
+  result.bytes_processed_ += bytes_spliced;
   uint64_t new_buffer_size = write_buffer_->length();
   updateWriteBufferStats(result.bytes_processed_, new_buffer_size);
 
@@ -699,7 +716,7 @@ void ConnectionImpl::onWriteReady() {
     // write callback. This can happen if we manage to complete the SSL handshake in the write
     // callback, raise a connected event, and close the connection.
     closeSocket(ConnectionEvent::RemoteClose);
-  } else if ((inDelayedClose() && new_buffer_size == 0) || bothSidesHalfClosed()) {
+  } else if ((inDelayedClose() && pendingWriteBytes() == 0) || bothSidesHalfClosed()) {
     ENVOY_CONN_LOG(debug, "write flush complete", *this);
     if (delayed_close_state_ == DelayedCloseState::CloseAfterFlushAndWait) {
       ASSERT(delayed_close_timer_ != nullptr && delayed_close_timer_->enabled());
@@ -758,7 +775,134 @@ void ConnectionImpl::updateWriteBufferStats(uint64_t num_written, uint64_t new_s
 
 bool ConnectionImpl::bothSidesHalfClosed() {
   // If the write_buffer_ is not empty, then the end_stream has not been sent to the transport yet.
-  return read_end_stream_ && write_end_stream_ && write_buffer_->length() == 0;
+  return read_end_stream_ && write_end_stream_ && pendingWriteBytes() == 0;
+}
+
+uint64_t ConnectionImpl::pendingWriteBytes() const {
+  return write_buffer_->length() + (write_pipe_ != nullptr ? write_pipe_->length() : 0);
+}
+
+bool ConnectionImpl::startSplice(Connection& peer) {
+  ConnectionImpl* peer_impl = dynamic_cast<ConnectionImpl*>(&peer);
+  if (peer_impl == nullptr || peer_impl == this || &peer_impl->dispatcher_ != &dispatcher_ ||
+      !canSplice() || !peer_impl->canSplice()) {
+    return false;
+  }
+
+  SplicePipeSharedPtr to_peer = SplicePipe::create();
+  SplicePipeSharedPtr from_peer = SplicePipe::create();
+  if (to_peer == nullptr || from_peer == nullptr) {
+    return false;
+  }
+
+  ENVOY_CONN_LOG(debug, "splicing to connection {}", *this, peer_impl->id());
+  splice_peer_ = peer_impl;
+  read_pipe_ = to_peer;
+  write_pipe_ = from_peer;
+  peer_impl->splice_peer_ = this;
+  peer_impl->read_pipe_ = from_peer;
+  peer_impl->write_pipe_ = to_peer;
+  return true;
+}
+
+bool ConnectionImpl::canSplice() const {
+  // Data which has already been buffered, or which a filter may want to see or change, has to go
+  // through the filter chain.
+  return state() == State::Open && !connecting_ && splice_peer_ == nullptr &&
+         write_pipe_ == nullptr && !read_end_stream_ && !write_end_stream_ &&
+         ioHandle().supportsSplice() && transport_socket_->supportsSplice() &&
+         read_buffer_->length() == 0 && write_buffer_->length() == 0 &&
+         filter_manager_.numReadFilters() <= 1 && !filter_manager_.hasWriteFilters();
+}
+
+void ConnectionImpl::onSpliceReadReady() {
+  ASSERT(splice_peer_ != nullptr);
+  PostIoAction action = PostIoAction::KeepOpen;
+  uint64_t bytes_read = 0;
+  bool end_stream = false;
+  // The loop ends when the socket is drained or the pipe is full, which bounds the data in flight.
+  while (true) {
+    const Api::SysCallSizeResult result = read_pipe_->spliceIn(ioHandle().fdDoNotUse());
+    if (result.return_value_ > 0) {
+      bytes_read += result.return_value_;
+      continue;
+    }
+    if (result.return_value_ == 0) {
+      // Remote close.
+      end_stream = true;
+    } else if (result.errno_ != SOCKET_ERROR_AGAIN) {
+      ENVOY_CONN_LOG(trace, "splice read error: {}", *this, errorDetails(result.errno_));
+      action = PostIoAction::Close;
+    }
+    break;
+  }
+  ENVOY_CONN_LOG(trace, "spliced {} bytes, end_stream {}", *this, bytes_read, end_stream);
+
+  if (bytes_read > 0) {
+    updateReadBufferStats(bytes_read, read_buffer_->length());
+    stream_info_.addBytesReceived(bytes_read);
+    splice_peer_->ioHandle().activateFileEvents(Event::FileReadyType::Write);
+  }
+
+  // If this connection doesn't have half-close semantics, translate end_stream into
+  // a connection close.
+  if (!enable_half_close_ && end_stream) {
+    end_stream = false;
+    action = PostIoAction::Close;
+  }
+
+  read_end_stream_ |= end_stream;
+  if (end_stream) {
+    // The read filters only see the end of stream, so that they can half-close the peer once it
+    // has written the spliced data.
+    onRead(read_buffer_->length());
+  }
+
+  // The read callback may have already closed the connection.
+  if (action == PostIoAction::Close || bothSidesHalfClosed()) {
+    ENVOY_CONN_LOG(debug, "remote close", *this);
+    closeSocket(ConnectionEvent::RemoteClose);
+  }
+}
+
+bool ConnectionImpl::spliceWrite(uint64_t& bytes_written) {
+  uint64_t bytes_spliced = 0;
+  while (write_pipe_->length() > 0) {
+    const Api::SysCallSizeResult result = write_pipe_->spliceOut(ioHandle().fdDoNotUse());
+    if (result.return_value_ > 0) {
+      bytes_spliced += result.return_value_;
+      continue;
+    }
+    if (result.return_value_ < 0 && result.errno_ != SOCKET_ERROR_AGAIN) {
+      ENVOY_CONN_LOG(debug, "splice write error: {}", *this, errorDetails(result.errno_));
+      closeSocket(ConnectionEvent::RemoteClose);
+      return false;
+    }
+    break;
+  }
+  ENVOY_CONN_LOG(trace, "spliced {} bytes, {} left", *this, bytes_spliced, write_pipe_->length());
+
+  if (bytes_spliced > 0) {
+    stream_info_.addBytesSent(bytes_spliced);
+    // Now that there is room in the pipe, have the peer resume reading if it stopped for lack of
+    // it.
+    if (write_pipe_->takeSourceBlocked() && splice_peer_ != nullptr) {
+      splice_peer_->setTransportSocketIsReadable();
+    }
+  }
+  bytes_written += bytes_spliced;
+  return true;
+}
+
+void ConnectionImpl::stopSplice() {
+  if (splice_peer_ == nullptr) {
+    return;
+  }
+
+  // The peer keeps its write pipe, but reads from its socket as usual from now on.
+  splice_peer_->splice_peer_ = nullptr;
+  splice_peer_->read_pipe_ = nullptr;
+  splice_peer_ = nullptr;
 }
 
 absl::string_view ConnectionImpl::transportFailureReason() const {
@@ -12,6 +12,7 @@
 #include "source/common/buffer/watermark_buffer.h"
 #include "source/common/event/libevent.h"
 #include "source/common/network/connection_impl_base.h"
+#include "source/common/network/splice_pipe.h"
 #include "source/common/stream_info/stream_info_impl.h"
 
 #include "absl/types/optional.h"
@@ -95,6 +96,7 @@ public:
   absl::string_view transportFailureReason() const override;
   bool startSecureTransport() override { return transport_socket_->startSecureTransport(); }
   absl::optional<std::chrono::milliseconds> lastRoundTripTime() const override;
+  bool startSplice(Connection& peer) override;
 
   // Network::FilterManagerConnection
   void rawWrite(Buffer::Instance& data, bool end_stream) override;
@@ -188,6 +190,18 @@ private:
   // Returns true iff end of stream has been both written and read.
   bool bothSidesHalfClosed();
 
+  // Returns true if the data of this connection can be spliced, see Connection::startSplice().
+  bool canSplice() const;
+  // Splices the data available on the socket into read_pipe_.
+  void onSpliceReadReady();
+  // Splices the data in write_pipe_ into the socket, adding the number of bytes written to
+  // bytes_written. Returns false if the connection was closed.
+  bool spliceWrite(uint64_t& bytes_written);
+  // Detaches this connection and splice_peer_ from each other, as this connection is closing.
+  void stopSplice();
+  // Returns the number of bytes waiting to be written to the socket.
+  uint64_t pendingWriteBytes() const;
+
   static std::atomic<uint64_t> next_global_id_;
 
   std::list<BytesSentCb> bytes_sent_callbacks_;
@@ -197,6 +211,13 @@ private:
   uint64_t last_read_buffer_size_{};
   uint64_t last_write_buffer_size_{};
   Buffer::Instance* current_write_buffer_{};
+  // The connection which this connection is spliced to, until either of them closes.
+  ConnectionImpl* splice_peer_{};
+  // The pipe which the data read from the socket is spliced into, for splice_peer_ to write.
+  SplicePipeSharedPtr read_pipe_;
+  // The pipe which splice_peer_ splices its data into, for this connection to write. It is kept
+  // after splice_peer_ closes, so that a flushing close still writes the data left in it.
+  SplicePipeSharedPtr write_pipe_;
   uint32_t read_disable_count_{0};
   bool write_buffer_above_high_watermark_ : 1;
   bool detect_early_close_ : 1;
@@ -37,6 +37,16 @@ void FilterManagerImpl::removeReadFilter(ReadFilterSharedPtr filter_to_remove) {
   }
 }
 
+uint64_t FilterManagerImpl::numReadFilters() const {
+  uint64_t num_filters = 0;
+  for (const auto& filter : upstream_filters_) {
+    if (filter->filter_ != nullptr) {
+      num_filters++;
+    }
+  }
+  return num_filters;
+}
+
 bool FilterManagerImpl::initializeReadFilters() {
   if (upstream_filters_.empty()) {
     return false;
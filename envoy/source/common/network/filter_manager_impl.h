@@ -111,6 +111,9 @@ public:
   bool initializeReadFilters();
   void onRead();
   FilterStatus onWrite();
+  // Returns the number of read filters which have not been removed.
+  uint64_t numReadFilters() const;
+  bool hasWriteFilters() const { return !downstream_filters_.empty(); }
 
 private:
   struct ActiveReadFilter : public ReadFilterCallbacks, LinkedObject<ActiveReadFilter> {
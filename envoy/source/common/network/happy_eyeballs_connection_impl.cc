@@ -237,6 +237,15 @@ bool HappyEyeballsConnectionImpl::aboveHighWatermark() const {
   return connections_[0]->aboveHighWatermark();
 }
 
+bool HappyEyeballsConnectionImpl::startSplice(Connection& peer) {
+  if (!connect_finished_) {
+    // There is no socket to splice until the final connection has been determined.
+    return false;
+  }
+
+  return connections_[0]->startSplice(peer);
+}
+
 const ConnectionSocket::OptionsSharedPtr& HappyEyeballsConnectionImpl::socketOptions() const {
   // Note, this might change before connect finishes.
   return connections_[0]->socketOptions();
@@ -94,6 +94,7 @@ public:
   void close(ConnectionCloseType type) override;
   bool readEnabled() const override;
   bool aboveHighWatermark() const override;
+  bool startSplice(Connection& peer) override;
   void hashKey(std::vector<uint8_t>& hash_key) const override;
   void dumpState(std::ostream& os, int indent_level) const override;
 
@@ -22,6 +22,7 @@ public:
   IoResult doWrite(Buffer::Instance& buffer, bool end_stream) override;
   Ssl::ConnectionInfoConstSharedPtr ssl() const override { return nullptr; }
   bool startSecureTransport() override { return false; }
+  bool supportsSplice() const override { return true; }
 
 private:
   TransportSocketCallbacks* callbacks_{};
@@ -0,0 +1,81 @@
+#include "source/common/network/splice_pipe.h"
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/common/macros.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+
+#include "source/common/api/os_sys_calls_impl_linux.h"
+#endif
+
+namespace Envoy {
+namespace Network {
+
+SplicePipe::~SplicePipe() {
+  auto& os_sys_calls = Api::OsSysCallsSingleton::get();
+  os_sys_calls.close(read_fd_);
+  os_sys_calls.close(write_fd_);
+}
+
+SplicePipeSharedPtr SplicePipe::create() {
+#if defined(__linux__)
+  int fds[2];
+  if (Api::LinuxOsSysCallsSingleton::get().pipe2(fds, O_NONBLOCK | O_CLOEXEC).return_value_ != 0) {
+    return nullptr;
+  }
+  return SplicePipeSharedPtr(new SplicePipe(fds[0], fds[1]));
+#else
+  return nullptr;
+#endif
+}
+
+Api::SysCallSizeResult SplicePipe::spliceIn(os_fd_t fd) {
+#if defined(__linux__)
+  if (length_ >= MaxLength) {
+    source_blocked_ = true;
+    return {-1, SOCKET_ERROR_AGAIN};
+  }
+
+  const Api::SysCallSizeResult result = Api::LinuxOsSysCallsSingleton::get().splice(
+      fd, write_fd_, MaxLength - length_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (result.return_value_ > 0) {
+    length_ += result.return_value_;
+  } else if (result.return_value_ < 0 && result.errno_ == SOCKET_ERROR_AGAIN && length_ > 0) {
+    // A pipe may run out of slots before it holds MaxLength bytes, and splice(2) doesn't tell a
+    // full pipe apart from an empty socket. Assume the former, at the cost of one spurious read
+    // once the pipe has been drained.
+    source_blocked_ = true;
+  }
+  return result;
+#else
+  UNREFERENCED_PARAMETER(fd);
+  NOT_REACHED_GCOVR_EXCL_LINE;
+#endif
+}
+
+Api::SysCallSizeResult SplicePipe::spliceOut(os_fd_t fd) {
+#if defined(__linux__)
+  ASSERT(length_ > 0);
+  const Api::SysCallSizeResult result = Api::LinuxOsSysCallsSingleton::get().splice(
+      read_fd_, fd, length_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (result.return_value_ > 0) {
+    ASSERT(static_cast<uint64_t>(result.return_value_) <= length_);
+    length_ -= result.return_value_;
+  }
+  return result;
+#else
+  UNREFERENCED_PARAMETER(fd);
+  NOT_REACHED_GCOVR_EXCL_LINE;
+#endif
+}
+
+bool SplicePipe::takeSourceBlocked() {
+  const bool source_blocked = source_blocked_;
+  source_blocked_ = false;
+  return source_blocked;
+}
+
+} // namespace Network
+} // namespace Envoy
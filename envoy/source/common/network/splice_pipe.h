@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "envoy/api/os_sys_calls_common.h"
+#include "envoy/common/platform.h"
+
+namespace Envoy {
+namespace Network {
+
+class SplicePipe;
+using SplicePipeSharedPtr = std::shared_ptr<SplicePipe>;
+
+/**
+ * A kernel pipe that carries the data of one direction of a spliced pair of connections. The
+ * source connection splices the data it reads from its socket into the pipe, and the sink
+ * connection splices it out of the pipe into its own socket, so that the data is never copied
+ * to user space. The number of bytes in the pipe is bounded, which applies back pressure to the
+ * source in place of the read and write buffer watermarks.
+ */
+class SplicePipe {
+public:
+  ~SplicePipe();
+
+  /**
+   * @return a new pipe, or nullptr if the platform does not support splice(2) or the pipe could
+   *         not be created.
+   */
+  static SplicePipeSharedPtr create();
+
+  /**
+   * Moves data from a socket into the pipe.
+   * @param fd supplies the socket to read.
+   * @return the number of bytes moved, 0 at end of stream, or -1 with the errno. EAGAIN is returned
+   *         both when the socket has no data and when the pipe is full; in the latter case the pipe
+   *         is marked as blocking its source, see takeSourceBlocked().
+   */
+  Api::SysCallSizeResult spliceIn(os_fd_t fd);
+
+  /**
+   * Moves data from the pipe into a socket.
+   * @param fd supplies the socket to write.
+   * @return the number of bytes moved, or -1 with the errno.
+   */
+  Api::SysCallSizeResult spliceOut(os_fd_t fd);
+
+  /**
+   * @return the number of bytes in the pipe.
+   */
+  uint64_t length() const { return length_; }
+
+  /**
+   * @return whether the source stopped reading because the pipe was full, in which case it needs
+   *         to be told to resume reading once data has been moved out. Clears the flag.
+   */
+  bool takeSourceBlocked();
+
+  // The most data that the pipe holds. This is the default capacity of a Linux pipe.
+  static constexpr uint64_t MaxLength = 64 * 1024;
+
+private:
+  SplicePipe(os_fd_t read_fd, os_fd_t write_fd) : read_fd_(read_fd), write_fd_(write_fd) {}
+
+  const os_fd_t read_fd_;
+  const os_fd_t write_fd_;
+  uint64_t length_{};
+  bool source_blocked_{};
+};
+
+} // namespace Network
+} // namespace Envoy
@@ -115,6 +115,7 @@ public:
   bool startSecureTransport() override { return false; }
   // TODO(#2557) Implement this.
   absl::optional<std::chrono::milliseconds> lastRoundTripTime() const override { return {}; }
+  bool startSplice(Network::Connection&) override { return false; }
 
   // Network::FilterManagerConnection
   void rawWrite(Buffer::Instance& data, bool end_stream) override;
@@ -0,0 +1,105 @@
+#include "source/common/router/compiled_route_matcher.h"
+
+#include <algorithm>
+
+#include "source/common/http/path_utility.h"
+
+#include "absl/strings/ascii.h"
+
+namespace Envoy {
+namespace Router {
+
+void CompiledRouteMatcher::addExactPath(uint32_t index, absl::string_view path,
+                                        bool case_sensitive) {
+  if (case_sensitive) {
+    case_sensitive_.addExactPath(index, std::string(path));
+  } else {
+    case_insensitive_.addExactPath(index, absl::AsciiStrToLower(path));
+  }
+}
+
+void CompiledRouteMatcher::addPrefix(uint32_t index, absl::string_view prefix,
+                                     bool case_sensitive) {
+  if (case_sensitive) {
+    case_sensitive_.addPrefix(index, prefix);
+  } else {
+    case_insensitive_.addPrefix(index, absl::AsciiStrToLower(prefix));
+  }
+}
+
+void CompiledRouteMatcher::addUnindexed(uint32_t index) { unindexed_.push_back(index); }
+
+CompiledRouteMatcher::Candidates CompiledRouteMatcher::candidates(absl::string_view path) const {
+  // Path matchers ignore the query string and fragment.
+  path = Http::PathUtil::removeQueryAndFragment(path);
+
+  Candidates candidates(unindexed_.begin(), unindexed_.end());
+  case_sensitive_.lookup(path, candidates);
+  if (!case_insensitive_.empty()) {
+    case_insensitive_.lookup(absl::AsciiStrToLower(path), candidates);
+  }
+  // Every route is in exactly one of the lists, so there are no duplicates to remove.
+  std::sort(candidates.begin(), candidates.end());
+  return candidates;
+}
+
+void CompiledRouteMatcher::PathIndex::addExactPath(uint32_t index, std::string path) {
+  exact_paths_[std::move(path)].push_back(index);
+}
+
+void CompiledRouteMatcher::PathIndex::addPrefix(uint32_t index, absl::string_view prefix) {
+  uint32_t current = 0;
+  for (const uint8_t c : prefix) {
+    auto& children = nodes_[current].children_;
+    auto it = std::lower_bound(children.begin(), children.end(), c,
+                               [](const std::pair<uint8_t, uint32_t>& child, uint8_t c) {
+                                 return child.first < c;
+                               });
+    if (it == children.end() || it->first != c) {
+      const uint32_t next = nodes_.size();
+      children.insert(it, {c, next});
+      // May reallocate nodes_, which invalidates children.
+      nodes_.emplace_back();
+      current = next;
+    } else {
+      current = it->second;
+    }
+  }
+  nodes_[current].routes_.push_back(index);
+}
+
+const CompiledRouteMatcher::PathIndex::Node*
+CompiledRouteMatcher::PathIndex::child(const Node& node, uint8_t c) const {
+  auto it = std::lower_bound(node.children_.begin(), node.children_.end(), c,
+                             [](const std::pair<uint8_t, uint32_t>& child, uint8_t c) {
+                               return child.first < c;
+                             });
+  if (it == node.children_.end() || it->first != c) {
+    return nullptr;
+  }
+  return &nodes_[it->second];
+}
+
+void CompiledRouteMatcher::PathIndex::lookup(absl::string_view path,
+                                             Candidates& candidates) const {
+  if (!exact_paths_.empty()) {
+    auto it = exact_paths_.find(path);
+    if (it != exact_paths_.end()) {
+      candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+    }
+  }
+
+  // Every node on the way down is a prefix of the path.
+  const Node* node = &nodes_[0];
+  for (const uint8_t c : path) {
+    candidates.insert(candidates.end(), node->routes_.begin(), node->routes_.end());
+    node = child(*node, c);
+    if (node == nullptr) {
+      return;
+    }
+  }
+  candidates.insert(candidates.end(), node->routes_.begin(), node->routes_.end());
+}
+
+} // namespace Router
+} // namespace Envoy
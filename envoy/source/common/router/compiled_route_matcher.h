@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * Index over the path specifiers of a virtual host's routes, used to skip the routes whose path
+ * can't match a request instead of evaluating every route in order.
+ *
+ * Routes are identified by their position in the virtual host. Exact path routes are looked up
+ * in a hash table and prefix routes by walking a trie along the request path. Routes whose path
+ * specifier isn't indexed, e.g. regex and CONNECT routes, are candidates for every request. The
+ * candidates are returned in route order so that evaluating them one by one selects the same
+ * route as evaluating all routes. Everything else a route matches on, such as headers and query
+ * parameters, is left to the route itself.
+ */
+class CompiledRouteMatcher {
+public:
+  using Candidates = absl::InlinedVector<uint32_t, 8>;
+
+  /**
+   * Add a route that matches paths equal to path.
+   */
+  void addExactPath(uint32_t index, absl::string_view path, bool case_sensitive);
+
+  /**
+   * Add a route that matches paths starting with prefix.
+   */
+  void addPrefix(uint32_t index, absl::string_view prefix, bool case_sensitive);
+
+  /**
+   * Add a route that has to be evaluated for every request.
+   */
+  void addUnindexed(uint32_t index);
+
+  /**
+   * @param path supplies the request path, including any query string and fragment.
+   * @return the indexes of the routes whose path specifier may match the path, in increasing
+   *         order.
+   */
+  Candidates candidates(absl::string_view path) const;
+
+private:
+  // Exact paths and prefixes of either the case sensitive routes, or of the case insensitive
+  // routes in lower case.
+  class PathIndex {
+  public:
+    PathIndex() : nodes_(1) {}
+
+    void addExactPath(uint32_t index, std::string path);
+    void addPrefix(uint32_t index, absl::string_view prefix);
+    void lookup(absl::string_view path, Candidates& candidates) const;
+    bool empty() const {
+      return exact_paths_.empty() && nodes_.size() == 1 && nodes_[0].routes_.empty();
+    }
+
+  private:
+    struct Node {
+      // Sorted by byte, pointing into nodes_.
+      std::vector<std::pair<uint8_t, uint32_t>> children_;
+      // Prefix routes ending at this node.
+      std::vector<uint32_t> routes_;
+    };
+
+    const Node* child(const Node& node, uint8_t c) const;
+
+    absl::flat_hash_map<std::string, std::vector<uint32_t>> exact_paths_;
+    // Trie of the prefixes, with the empty prefix at the root. Nodes refer to each other by
+    // position so that the trie stays a single allocation as it grows.
+    std::vector<Node> nodes_;
+  };
+
+  PathIndex case_sensitive_;
+  PathIndex case_insensitive_;
+  std::vector<uint32_t> unindexed_;
+};
+
+} // namespace Router
+} // namespace Envoy
@@ -1257,7 +1257,29 @@ VirtualHostImpl::VirtualHostImpl(
     hedge_policy_ = virtual_host.hedge_policy();
   }
 
+  std::unique_ptr<CompiledRouteMatcher> compiled_route_matcher;
+  if (virtual_host.compile_route_matcher()) {
+    compiled_route_matcher = std::make_unique<CompiledRouteMatcher>();
+  }
+
   for (const auto& route : virtual_host.routes()) {
+    if (compiled_route_matcher != nullptr) {
+      const uint32_t index = routes_.size();
+      const bool case_sensitive =
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(route.match(), case_sensitive, true);
+      switch (route.match().path_specifier_case()) {
+      case envoy::config::route::v3::RouteMatch::PathSpecifierCase::kPrefix:
+        compiled_route_matcher->addPrefix(index, route.match().prefix(), case_sensitive);
+        break;
+      case envoy::config::route::v3::RouteMatch::PathSpecifierCase::kPath:
+        compiled_route_matcher->addExactPath(index, route.match().path(), case_sensitive);
+        break;
+      default:
+        compiled_route_matcher->addUnindexed(index);
+        break;
+      }
+    }
+
     switch (route.match().path_specifier_case()) {
     case envoy::config::route::v3::RouteMatch::PathSpecifierCase::kPrefix: {
       routes_.emplace_back(new PrefixRouteEntryImpl(*this, route, optional_http_filters,
@@ -1295,6 +1317,8 @@ VirtualHostImpl::VirtualHostImpl(
     }
   }
 
+  compiled_route_matcher_ = std::move(compiled_route_matcher);
+
   for (const auto& virtual_cluster : virtual_host.virtual_clusters()) {
     virtual_clusters_.push_back(
         VirtualClusterEntry(virtual_cluster, *vcluster_scope_,
@@ -1416,37 +1440,59 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const RouteCallback& cb
   }
 
   // Check for a route that matches the request.
-  for (auto route = routes_.begin(); route != routes_.end(); ++route) {
-    if (!headers.Path() && !(*route)->supportsPathlessHeaders()) {
-      continue;
+  if (compiled_route_matcher_ != nullptr && headers.Path() != nullptr) {
+    // Only the routes whose path specifier can match need to be evaluated.
+    for (const uint32_t index : compiled_route_matcher_->candidates(headers.getPathValue())) {
+      absl::optional<RouteConstSharedPtr> route =
+          evaluateRoute(index, cb, headers, stream_info, random_value);
+      if (route.has_value()) {
+        return std::move(route.value());
+      }
     }
+    return nullptr;
+  }
 
-    RouteConstSharedPtr route_entry = (*route)->matches(headers, stream_info, random_value);
-    if (nullptr == route_entry) {
+  for (size_t index = 0; index < routes_.size(); index++) {
+    if (!headers.Path() && !routes_[index]->supportsPathlessHeaders()) {
       continue;
     }
-
-    if (cb) {
-      RouteEvalStatus eval_status = (std::next(route) == routes_.end())
-                                        ? RouteEvalStatus::NoMoreRoutes
-                                        : RouteEvalStatus::HasMoreRoutes;
-      RouteMatchStatus match_status = cb(route_entry, eval_status);
-      if (match_status == RouteMatchStatus::Accept) {
-        return route_entry;
-      }
-      if (match_status == RouteMatchStatus::Continue &&
-          eval_status == RouteEvalStatus::NoMoreRoutes) {
-        return nullptr;
-      }
-      continue;
+    absl::optional<RouteConstSharedPtr> route =
+        evaluateRoute(index, cb, headers, stream_info, random_value);
+    if (route.has_value()) {
+      return std::move(route.value());
     }
-
-    return route_entry;
   }
 
   return nullptr;
 }
 
+absl::optional<RouteConstSharedPtr>
+VirtualHostImpl::evaluateRoute(size_t index, const RouteCallback& cb,
+                               const Http::RequestHeaderMap& headers,
+                               const StreamInfo::StreamInfo& stream_info,
+                               uint64_t random_value) const {
+  RouteConstSharedPtr route_entry = routes_[index]->matches(headers, stream_info, random_value);
+  if (nullptr == route_entry) {
+    return absl::nullopt;
+  }
+
+  if (cb) {
+    RouteEvalStatus eval_status = (index + 1 == routes_.size()) ? RouteEvalStatus::NoMoreRoutes
+                                                                : RouteEvalStatus::HasMoreRoutes;
+    RouteMatchStatus match_status = cb(route_entry, eval_status);
+    if (match_status == RouteMatchStatus::Accept) {
+      return route_entry;
+    }
+    if (match_status == RouteMatchStatus::Continue &&
+        eval_status == RouteEvalStatus::NoMoreRoutes) {
+      return RouteConstSharedPtr(nullptr);
+    }
+    return absl::nullopt;
+  }
+
+  return route_entry;
+}
+
 const VirtualHostImpl* RouteMatcher::findVirtualHost(const Http::RequestHeaderMap& headers) const {
   // Fast path the case where we only have a default virtual host.
   if (virtual_hosts_.empty() && wildcard_virtual_host_suffixes_.empty() &&
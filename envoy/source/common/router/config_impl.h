@@ -23,6 +23,7 @@
 #include "source/common/config/metadata.h"
 #include "source/common/http/hash_policy.h"
 #include "source/common/http/header_utility.h"
+#include "source/common/router/compiled_route_matcher.h"
 #include "source/common/router/config_utility.h"
 #include "source/common/router/header_formatter.h"
 #include "source/common/router/header_parser.h"
@@ -224,6 +225,13 @@ public:
   uint32_t retryShadowBufferLimit() const override { return retry_shadow_buffer_limit_; }
 
 private:
+  // Evaluates the route at the given position. Returns the result of the lookup if it ends at this
+  // route, or absl::nullopt to continue with the next route.
+  absl::optional<RouteConstSharedPtr> evaluateRoute(size_t index, const RouteCallback& cb,
+                                                    const Http::RequestHeaderMap& headers,
+                                                    const StreamInfo::StreamInfo& stream_info,
+                                                    uint64_t random_value) const;
+
   enum class SslRequirements { None, ExternalOnly, All };
 
   struct StatNameProvider {
@@ -266,6 +274,8 @@ private:
   const Stats::StatNameManagedStorage stat_name_storage_;
   Stats::ScopePtr vcluster_scope_;
   std::vector<RouteEntryImplBaseConstSharedPtr> routes_;
+  // Set if the virtual host has compile_route_matcher enabled.
+  std::unique_ptr<const CompiledRouteMatcher> compiled_route_matcher_;
   std::vector<VirtualClusterEntry> virtual_clusters_;
   SslRequirements ssl_requirements_;
   const RateLimitPolicyImpl rate_limit_policy_;
@@ -125,6 +125,8 @@ constexpr const char* disabled_runtime_features[] = {
     // CacheOption is CacheWhenRuntimeEnabled.
     // Caller that use AlwaysCache option will always cache, unaffected by this runtime.
     "envoy.reloadable_features.enable_grpc_async_client_cache",
+    // Parses HTTP/1 with SimdHttpParserImpl on CPUs that support it.
+    "envoy.reloadable_features.http1_use_simd_parser",
 };
 
 RuntimeFeatures::RuntimeFeatures() {
@@ -23,6 +23,16 @@ namespace Stats {
 
 const char AllocatorImpl::DecrementToZeroSyncPoint[] = "decrement-zero";
 
+template <> AllocatorImpl::ChangedStats<Counter>& AllocatorImpl::changedStats<Counter>() {
+  return changed_counters_;
+}
+template <> AllocatorImpl::ChangedStats<Gauge>& AllocatorImpl::changedStats<Gauge>() {
+  return changed_gauges_;
+}
+template <> AllocatorImpl::ChangedStats<TextReadout>& AllocatorImpl::changedStats<TextReadout>() {
+  return changed_text_readouts_;
+}
+
 AllocatorImpl::~AllocatorImpl() {
   ASSERT(counters_.empty());
   ASSERT(gauges_.empty());
@@ -105,12 +115,32 @@ public:
     if (--ref_count_ == 0) {
       alloc_.sync().syncPoint(AllocatorImpl::DecrementToZeroSyncPoint);
       removeFromSetLockHeld();
+      if (alloc_.changedStats<BaseClass>().tracking_) {
+        Thread::LockGuard changed_lock(alloc_.changed_mutex_);
+        if (flags_ & Metric::Flags::Changed) {
+          alloc_.changedStats<BaseClass>().stats_.erase(this);
+        }
+      }
       return true;
     }
     return false;
   }
   uint32_t use_count() const override { return ref_count_; }
 
+  /**
+   * Adds the stat to the allocator's changed stats, if it tracks changes to this kind of stat. Only
+   * the first change after forEachChanged*() visited the stat takes a lock.
+   */
+  void markChanged() {
+    if (!(flags_ & Metric::Flags::Changed) && alloc_.changedStats<BaseClass>().tracking_) {
+      Thread::LockGuard lock(alloc_.changed_mutex_);
+      if (!(flags_.fetch_or(Metric::Flags::Changed) & Metric::Flags::Changed)) {
+        alloc_.changedStats<BaseClass>().stats_.insert(this);
+      }
+    }
+  }
+  void clearChanged() { flags_ &= ~Metric::Flags::Changed; }
+
   /**
    * We must atomically remove the counter/gauges from the allocator's sets when
    * our ref-count decrement hits zero. The counters and gauges are held in
@@ -153,10 +183,14 @@ public:
     value_ += amount;
     pending_increment_ += amount;
     flags_ |= Flags::Used;
+    markChanged();
   }
   void inc() override { add(1); }
   uint64_t latch() override { return pending_increment_.exchange(0); }
-  void reset() override { value_ = 0; }
+  void reset() override {
+    value_ = 0;
+    markChanged();
+  }
   uint64_t value() const override { return value_; }
 
 private:
@@ -164,6 +198,51 @@ private:
   std::atomic<uint64_t> pending_increment_{0};
 };
 
+// A counter whose increments go to a slot in the calling thread's shard of alloc_.counter_shards_,
+// rather than to atomics shared by all threads. Reading it sums the slots.
+class ShardedCounterImpl : public StatsSharedImpl<Counter> {
+public:
+  ShardedCounterImpl(StatName name, AllocatorImpl& alloc, StatName tag_extracted_name,
+                     const StatNameTagVector& stat_name_tags, CounterShards& shards,
+                     uint32_t slot)
+      : StatsSharedImpl(name, alloc, tag_extracted_name, stat_name_tags), shards_(shards),
+        slot_(slot) {}
+  ~ShardedCounterImpl() override { shards_.freeSlot(slot_); }
+
+  void removeFromSetLockHeld() ABSL_EXCLUSIVE_LOCKS_REQUIRED(alloc_.mutex_) override {
+    const size_t count = alloc_.counters_.erase(statName());
+    ASSERT(count == 1);
+  }
+
+  // Stats::Counter
+  void add(uint64_t amount) override {
+    shards_.add(slot_, amount);
+    // Only written once, so that the flags stay in every core's cache.
+    if (!(flags_.load(std::memory_order_relaxed) & Flags::Used)) {
+      flags_ |= Flags::Used;
+    }
+    markChanged();
+  }
+  void inc() override { add(1); }
+  uint64_t latch() override {
+    const uint64_t sum = shards_.sum(slot_);
+    return sum - latched_sum_.exchange(sum);
+  }
+  void reset() override {
+    reset_sum_ = shards_.sum(slot_);
+    markChanged();
+  }
+  uint64_t value() const override { return shards_.sum(slot_) - reset_sum_; }
+
+private:
+  CounterShards& shards_;
+  const uint32_t slot_;
+  // The sums as of the last latch() and reset(). As with CounterImpl, reset() doesn't affect the
+  // increments that are pending latch().
+  std::atomic<uint64_t> latched_sum_{0};
+  std::atomic<uint64_t> reset_sum_{0};
+};
+
 class GaugeImpl : public StatsSharedImpl<Gauge> {
 public:
   GaugeImpl(StatName name, AllocatorImpl& alloc, StatName tag_extracted_name,
@@ -194,17 +273,20 @@ public:
   void add(uint64_t amount) override {
     child_value_ += amount;
     flags_ |= Flags::Used;
+    markChanged();
   }
   void dec() override { sub(1); }
   void inc() override { add(1); }
   void set(uint64_t value) override {
     child_value_ = value;
     flags_ |= Flags::Used;
+    markChanged();
   }
   void sub(uint64_t amount) override {
     ASSERT(child_value_ >= amount);
     ASSERT(used() || amount == 0);
     child_value_ -= amount;
+    markChanged();
   }
   uint64_t value() const override { return child_value_ + parent_value_; }
 
@@ -240,11 +322,15 @@ public:
       parent_value_ = 0;
       flags_ &= ~Flags::Used;
       flags_ |= Flags::NeverImport;
+      markChanged();
       break;
     }
   }
 
-  void setParentValue(uint64_t value) override { parent_value_ = value; }
+  void setParentValue(uint64_t value) override {
+    parent_value_ = value;
+    markChanged();
+  }
 
 private:
   std::atomic<uint64_t> parent_value_{0};
@@ -265,8 +351,11 @@ public:
   // Stats::TextReadout
   void set(absl::string_view value) override {
     std::string value_copy(value);
-    absl::MutexLock lock(&mutex_);
-    value_ = std::move(value_copy);
+    {
+      absl::MutexLock lock(&mutex_);
+      value_ = std::move(value_copy);
+    }
+    markChanged();
   }
   std::string value() const override {
     absl::MutexLock lock(&mutex_);
@@ -331,8 +420,22 @@ bool AllocatorImpl::isMutexLockedForTest() {
   return !locked;
 }
 
+void AllocatorImpl::setCounterShards(uint32_t shards) {
+  Thread::LockGuard lock(mutex_);
+  if (shards > 1 && counter_shards_ == nullptr) {
+    counter_shards_ = std::make_unique<CounterShards>(shards);
+  }
+}
+
 Counter* AllocatorImpl::makeCounterInternal(StatName name, StatName tag_extracted_name,
                                             const StatNameTagVector& stat_name_tags) {
+  if (counter_shards_ != nullptr) {
+    const absl::optional<uint32_t> slot = counter_shards_->allocateSlot();
+    if (slot.has_value()) {
+      return new ShardedCounterImpl(name, *this, tag_extracted_name, stat_name_tags,
+                                    *counter_shards_, *slot);
+    }
+  }
   return new CounterImpl(name, *this, tag_extracted_name, stat_name_tags);
 }
 
@@ -369,6 +472,59 @@ void AllocatorImpl::forEachTextReadout(std::function<void(std::size_t)> f_size,
   }
 }
 
+void AllocatorImpl::forEachChangedCounter(std::function<void(std::size_t)> f_size,
+                                          std::function<void(Stats::Counter&)> f_stat) {
+  Thread::LockGuard lock(mutex_);
+  forEachChangedLockHeld(counters_, f_size, f_stat);
+}
+
+void AllocatorImpl::forEachChangedGauge(std::function<void(std::size_t)> f_size,
+                                        std::function<void(Stats::Gauge&)> f_stat) {
+  Thread::LockGuard lock(mutex_);
+  forEachChangedLockHeld(gauges_, f_size, f_stat);
+}
+
+void AllocatorImpl::forEachChangedTextReadout(std::function<void(std::size_t)> f_size,
+                                              std::function<void(Stats::TextReadout&)> f_stat) {
+  Thread::LockGuard lock(mutex_);
+  forEachChangedLockHeld(text_readouts_, f_size, f_stat);
+}
+
+template <class StatType>
+void AllocatorImpl::forEachChangedLockHeld(const StatSet<StatType>& stats,
+                                           std::function<void(std::size_t)> f_size,
+                                           std::function<void(StatType&)> f_stat) {
+  // mutex_ is held throughout, so that the changed stats can't be freed before they are visited.
+  ChangedStats<StatType>& changed = changedStats<StatType>();
+  absl::flat_hash_set<StatsSharedImpl<StatType>*> changed_stats;
+  bool tracking;
+  {
+    Thread::LockGuard changed_lock(changed_mutex_);
+    tracking = changed.tracking_.exchange(true);
+    changed_stats.swap(changed.stats_);
+  }
+
+  if (!tracking) {
+    // Changes weren't tracked until now, so any stat may have changed.
+    if (f_size != nullptr) {
+      f_size(stats.size());
+    }
+    for (StatType* stat : stats) {
+      f_stat(*stat);
+    }
+    return;
+  }
+
+  if (f_size != nullptr) {
+    f_size(changed_stats.size());
+  }
+  for (StatsSharedImpl<StatType>* stat : changed_stats) {
+    // The flag is cleared before the visit, so that a change during the visit marks the stat again.
+    stat->clearChanged();
+    f_stat(*stat);
+  }
+}
+
 void AllocatorImpl::markCounterForDeletion(const CounterSharedPtr& counter) {
   Thread::LockGuard lock(mutex_);
   auto iter = counters_.find(counter->statName());
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <vector>
 
 #include "envoy/stats/allocator.h"
@@ -7,6 +8,7 @@
 #include "envoy/stats/symbol_table.h"
 
 #include "source/common/common/thread_synchronizer.h"
+#include "source/common/stats/counter_shards.h"
 #include "source/common/stats/metric_impl.h"
 
 #include "absl/container/flat_hash_set.h"
@@ -15,6 +17,8 @@
 namespace Envoy {
 namespace Stats {
 
+template <class BaseClass> class StatsSharedImpl;
+
 class AllocatorImpl : public Allocator {
 public:
   static const char DecrementToZeroSyncPoint[];
@@ -32,6 +36,7 @@ public:
                                        const StatNameTagVector& stat_name_tags) override;
   SymbolTable& symbolTable() override { return symbol_table_; }
   const SymbolTable& constSymbolTable() const override { return symbol_table_; }
+  void setCounterShards(uint32_t shards) override;
 
   void forEachCounter(std::function<void(std::size_t)>,
                       std::function<void(Stats::Counter&)>) const override;
@@ -42,6 +47,15 @@ public:
   void forEachTextReadout(std::function<void(std::size_t)>,
                           std::function<void(Stats::TextReadout&)>) const override;
 
+  void forEachChangedCounter(std::function<void(std::size_t)>,
+                             std::function<void(Stats::Counter&)>) override;
+
+  void forEachChangedGauge(std::function<void(std::size_t)>,
+                           std::function<void(Stats::Gauge&)>) override;
+
+  void forEachChangedTextReadout(std::function<void(std::size_t)>,
+                                 std::function<void(Stats::TextReadout&)>) override;
+
 #ifndef ENVOY_CONFIG_COVERAGE
   void debugPrint();
 #endif
@@ -67,10 +81,26 @@ protected:
 private:
   template <class BaseClass> friend class StatsSharedImpl;
   friend class CounterImpl;
+  friend class ShardedCounterImpl;
   friend class GaugeImpl;
   friend class TextReadoutImpl;
   friend class NotifyingAllocatorImpl;
 
+  // The stats of one kind that changed since forEachChanged*() last visited them. The stats are
+  // guarded by changed_mutex_; the annotation can't name it from here.
+  template <class StatType> struct ChangedStats {
+    // Set by the first forEachChanged*() call for the kind of stat, and never reset.
+    std::atomic<bool> tracking_{false};
+    absl::flat_hash_set<StatsSharedImpl<StatType>*> stats_;
+  };
+
+  template <class StatType> ChangedStats<StatType>& changedStats();
+  template <class StatType>
+  void forEachChangedLockHeld(const StatSet<StatType>& stats,
+                              std::function<void(std::size_t)> f_size,
+                              std::function<void(StatType&)> f_stat)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   // A mutex is needed here to protect both the stats_ object from both
   // alloc() and free() operations. Although alloc() operations are called under existing locking,
   // free() operations are made from the destructors of the individual stat objects, which are not
@@ -93,7 +123,17 @@ private:
   std::vector<GaugeSharedPtr> deleted_gauges_ ABSL_GUARDED_BY(mutex_);
   std::vector<TextReadoutSharedPtr> deleted_text_readouts_ ABSL_GUARDED_BY(mutex_);
 
+  // Guards the stats in the ChangedStats. Stats mark themselves changed without holding mutex_, but
+  // mutex_ is acquired first when both are held.
+  Thread::MutexBasicLockable changed_mutex_;
+  ChangedStats<Counter> changed_counters_;
+  ChangedStats<Gauge> changed_gauges_;
+  ChangedStats<TextReadout> changed_text_readouts_;
+
   SymbolTable& symbol_table_;
+  // Set once counters are sharded, and never reset, as the sharded counters refer to it. Written
+  // and read with mutex_ held; it isn't annotated as such because makeCounterInternal() isn't.
+  CounterShardsPtr counter_shards_;
 
   Thread::ThreadSynchronizer sync_;
 };
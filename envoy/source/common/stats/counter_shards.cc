@@ -0,0 +1,63 @@
+#include "source/common/stats/counter_shards.h"
+
+#include <algorithm>
+
+#include "source/common/common/assert.h"
+#include "source/common/common/lock_guard.h"
+
+#include "absl/numeric/bits.h"
+
+namespace Envoy {
+namespace Stats {
+
+CounterShards::CounterShards(uint32_t shards)
+    : shard_mask_(absl::bit_ceil(std::min(shards, MaxShards)) - 1) {
+  ASSERT(shards > 0);
+}
+
+CounterShards::~CounterShards() {
+  for (std::atomic<Chunk*>& chunks : chunk_groups_) {
+    delete[] chunks.load();
+  }
+}
+
+absl::optional<uint32_t> CounterShards::allocateSlot() {
+  Thread::LockGuard lock(mutex_);
+  if (!free_slots_.empty()) {
+    const uint32_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    Chunk* chunks = chunk_groups_[slot / SlotsPerChunk].load();
+    for (uint32_t shard = 0; shard < shards(); shard++) {
+      chunks[shard].slots_[slot % SlotsPerChunk].store(0, std::memory_order_relaxed);
+    }
+    return slot;
+  }
+
+  if (next_slot_ == MaxSlots) {
+    return absl::nullopt;
+  }
+  const uint32_t slot = next_slot_++;
+  if (slot % SlotsPerChunk == 0) {
+    // Slots that have never been used are zero, as new chunks are zeroed.
+    chunk_groups_[slot / SlotsPerChunk].store(new Chunk[shards()](), std::memory_order_release);
+  }
+  return slot;
+}
+
+void CounterShards::freeSlot(uint32_t slot) {
+  Thread::LockGuard lock(mutex_);
+  ASSERT(slot < next_slot_);
+  free_slots_.push_back(slot);
+}
+
+uint64_t CounterShards::sum(uint32_t slot) const {
+  const Chunk* chunks = chunk_groups_[slot / SlotsPerChunk].load(std::memory_order_acquire);
+  uint64_t sum = 0;
+  for (uint32_t shard = 0; shard < shards(); shard++) {
+    sum += chunks[shard].slots_[slot % SlotsPerChunk].load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+} // namespace Stats
+} // namespace Envoy
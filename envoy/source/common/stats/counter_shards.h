@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "source/common/common/non_copyable.h"
+#include "source/common/common/thread.h"
+
+#include "absl/base/thread_annotations.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * Storage for sharded counters. Every counter has a slot in each of a fixed number of shards, and
+ * each thread increments the slot in its own shard. Reading a counter sums its slots.
+ *
+ * The slots of a shard are laid out contiguously. The same counter's slots in different shards
+ * are therefore on different cache lines, so threads that increment the same counter don't
+ * contend for a cache line as they do with a single atomic. Threads are spread over the shards
+ * round robin, in the order they first increment a sharded counter. With at least as many shards
+ * as threads, every thread has a shard of its own. Each shard costs 8 bytes per counter, so the
+ * number of shards is capped at MaxShards.
+ */
+class CounterShards : NonCopyable {
+public:
+  /**
+   * @param shards the number of shards, rounded up to a power of two and capped at MaxShards.
+   */
+  explicit CounterShards(uint32_t shards);
+  ~CounterShards();
+
+  /**
+   * @return a zeroed slot, or nullopt if all slots are in use.
+   */
+  absl::optional<uint32_t> allocateSlot();
+
+  /**
+   * Returns a slot for reuse. The slot's counter must no longer be incremented.
+   */
+  void freeSlot(uint32_t slot);
+
+  void add(uint32_t slot, uint64_t amount) {
+    Chunk* chunks = chunk_groups_[slot / SlotsPerChunk].load(std::memory_order_acquire);
+    chunks[threadIndex() & shard_mask_].slots_[slot % SlotsPerChunk].fetch_add(
+        amount, std::memory_order_relaxed);
+  }
+
+  /**
+   * @return the sum of a slot over all shards.
+   */
+  uint64_t sum(uint32_t slot) const;
+
+  uint32_t shards() const { return shard_mask_ + 1; }
+
+  // The number of slots the shards can hold.
+  static constexpr uint32_t MaxSlots = 1 << 22;
+  // Threads beyond this many share shards, which bounds a counter at 512 bytes.
+  static constexpr uint32_t MaxShards = 64;
+
+private:
+  static constexpr uint32_t SlotsPerChunk = 512;
+  static constexpr uint32_t MaxChunkGroups = MaxSlots / SlotsPerChunk;
+
+  // The slots of one shard for SlotsPerChunk consecutive counters. Chunks are cache-line aligned,
+  // so no line holds slots of two shards.
+  struct alignas(64) Chunk {
+    std::array<std::atomic<uint64_t>, SlotsPerChunk> slots_;
+  };
+
+  // An index for the calling thread, assigned on its first call.
+  static uint32_t threadIndex() {
+    static std::atomic<uint32_t> next_index{0};
+    static thread_local const uint32_t index = next_index++;
+    return index;
+  }
+
+  const uint32_t shard_mask_;
+  // Chunk group g holds one chunk per shard for the slots of chunk g. The groups are allocated as
+  // slots are, and are never moved, so add() can read them without a lock.
+  std::array<std::atomic<Chunk*>, MaxChunkGroups> chunk_groups_{};
+
+  Thread::MutexBasicLockable mutex_;
+  uint32_t next_slot_ ABSL_GUARDED_BY(mutex_){};
+  std::vector<uint32_t> free_slots_ ABSL_GUARDED_BY(mutex_);
+};
+
+using CounterShardsPtr = std::unique_ptr<CounterShards>;
+
+} // namespace Stats
+} // namespace Envoy
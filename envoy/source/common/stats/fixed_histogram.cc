@@ -0,0 +1,83 @@
+#include "source/common/stats/fixed_histogram.h"
+
+#include "absl/numeric/int128.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <emmintrin.h>
+#endif
+
+namespace Envoy {
+namespace Stats {
+
+namespace {
+
+// The first value above the circllhist bin of value, which has two significant decimal digits.
+uint64_t circllhistBinEnd(uint64_t value) {
+  uint64_t width = 1;
+  while (value >= 100) {
+    value /= 10;
+    width *= 10;
+  }
+  return (value + 1) * width;
+}
+
+} // namespace
+
+void FixedHistogram::add(const FixedHistogram& other) {
+  if (!other.used_) {
+    return;
+  }
+  for (uint32_t group_index = 0; group_index < NumGroups; group_index++) {
+    if (other.slots_[group_index] == 0) {
+      continue;
+    }
+    const Group& from = other.groups_[other.slots_[group_index] - 1];
+    Group& to = group(group_index);
+#if defined(__x86_64__) && defined(__GNUC__)
+    // SSE2 is part of x86-64, so it needs no CPU check. Groups are 64-byte aligned.
+    static_assert(SubBuckets % 4 == 0);
+    for (uint32_t index = 0; index < SubBuckets; index += 4) {
+      __m128i* to_counts = reinterpret_cast<__m128i*>(&to.counts_[index]);
+      const __m128i* from_counts = reinterpret_cast<const __m128i*>(&from.counts_[index]);
+      _mm_store_si128(to_counts,
+                      _mm_add_epi32(_mm_load_si128(to_counts), _mm_load_si128(from_counts)));
+    }
+#else
+    for (uint32_t index = 0; index < SubBuckets; index++) {
+      to.counts_[index] += from.counts_[index];
+    }
+#endif
+  }
+  used_ = true;
+}
+
+void FixedHistogram::clear() {
+  if (used_) {
+    for (Group& group : groups_) {
+      group.counts_.fill(0);
+    }
+    used_ = false;
+  }
+}
+
+void FixedHistogram::insertInto(histogram_t* target) const {
+  forEachBucket([target](uint32_t index, uint64_t count) {
+    const uint64_t lower = bucketLowerBound(index);
+    const uint64_t width = bucketWidth(index);
+    uint64_t inserted = 0;
+    for (uint64_t value = lower; value < lower + width;) {
+      const uint64_t bin_end = std::min(lower + width, circllhistBinEnd(value));
+      // The count up to the end of the bin, rounded down, so that the bins add up to count.
+      const uint64_t cumulative =
+          absl::Uint128Low64(absl::uint128(count) * (bin_end - lower) / width);
+      if (cumulative > inserted) {
+        hist_insert_intscale(target, static_cast<int64_t>(value), 0, cumulative - inserted);
+        inserted = cumulative;
+      }
+      value = bin_end;
+    }
+  });
+}
+
+} // namespace Stats
+} // namespace Envoy
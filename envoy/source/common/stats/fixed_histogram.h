@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "absl/numeric/bits.h"
+#include "circllhist.h"
+
+namespace Envoy {
+namespace Stats {
+
+/**
+ * A log-linear histogram with a fixed set of buckets, for recording on workers. Every power of two
+ * is split into SubBuckets buckets of equal width, so a bucket is at most 1/SubBuckets of its
+ * values wide (6%), and values below 2 * SubBuckets are counted exactly. Values of 2^MaxValueBits
+ * and above are counted in the last bucket.
+ *
+ * The bucket of a value is computed with a few arithmetic instructions and no branches. The counts
+ * of each power of two form a 64-byte group that is allocated the first time a value falls in it,
+ * so a histogram only pays for the range of values it records, and merging histograms adds their
+ * groups element-wise, with SSE2 on x86-64.
+ *
+ * Counts are 32 bits. A histogram is expected to be merged and cleared every stats flush, long
+ * before a bucket could overflow.
+ */
+class FixedHistogram {
+public:
+  static constexpr uint32_t SubBucketBits = 4;
+  static constexpr uint32_t SubBuckets = 1 << SubBucketBits;
+  static constexpr uint32_t MaxValueBits = 40;
+  static constexpr uint64_t MaxValue = (uint64_t(1) << MaxValueBits) - 1;
+  static constexpr uint32_t NumGroups = MaxValueBits + 1 - SubBucketBits;
+  static constexpr uint32_t NumBuckets = NumGroups * SubBuckets;
+
+  static uint32_t bucketIndex(uint64_t value) {
+    value = std::min(value, MaxValue);
+    // The position of the highest set bit. Values below SubBuckets are their own bucket, and the
+    // buckets above keep the SubBucketBits bits below the highest one.
+    const uint32_t msb = 63 - absl::countl_zero(value | 1);
+    const uint32_t shift = std::max(msb, SubBucketBits) - SubBucketBits;
+    return (shift << SubBucketBits) + static_cast<uint32_t>(value >> shift);
+  }
+
+  // The smallest value in a bucket.
+  static uint64_t bucketLowerBound(uint32_t index) {
+    const uint32_t shift = index < 2 * SubBuckets ? 0 : (index >> SubBucketBits) - 1;
+    return static_cast<uint64_t>(index - (shift << SubBucketBits)) << shift;
+  }
+
+  // The number of values in a bucket.
+  static uint64_t bucketWidth(uint32_t index) {
+    const uint32_t shift = index < 2 * SubBuckets ? 0 : (index >> SubBucketBits) - 1;
+    return uint64_t(1) << shift;
+  }
+
+  void recordValue(uint64_t value) {
+    const uint32_t index = bucketIndex(value);
+    group(index >> SubBucketBits).counts_[index & (SubBuckets - 1)]++;
+    used_ = true;
+  }
+
+  /**
+   * Adds the counts of other to this histogram.
+   */
+  void add(const FixedHistogram& other);
+
+  /**
+   * Zeroes the counts. The groups stay allocated, as the next interval's values usually fall in
+   * the same ones.
+   */
+  void clear();
+
+  // Whether a value was recorded or added since the histogram was last cleared.
+  bool used() const { return used_; }
+
+  // The number of bytes allocated for counts.
+  uint64_t allocatedBytes() const { return groups_.capacity() * sizeof(Group); }
+
+  /**
+   * Calls f(index, count) for every bucket with a non-zero count, in increasing index order.
+   */
+  template <class F> void forEachBucket(F f) const {
+    for (uint32_t group_index = 0; group_index < NumGroups; group_index++) {
+      if (slots_[group_index] == 0) {
+        continue;
+      }
+      const Group& group = groups_[slots_[group_index] - 1];
+      for (uint32_t sub_bucket = 0; sub_bucket < SubBuckets; sub_bucket++) {
+        if (group.counts_[sub_bucket] != 0) {
+          f((group_index << SubBucketBits) + sub_bucket, group.counts_[sub_bucket]);
+        }
+      }
+    }
+  }
+
+  /**
+   * Adds the counts to a circllhist. circllhist bins have two significant decimal digits, so a
+   * bucket can overlap several bins. Its count is spread over them in proportion to the overlap,
+   * as if the bucket's values were uniform, rather than all put in the bin of its midpoint.
+   */
+  void insertInto(histogram_t* target) const;
+
+private:
+  struct alignas(64) Group {
+    std::array<uint32_t, SubBuckets> counts_{};
+  };
+
+  Group& group(uint32_t group_index) {
+    uint8_t& slot = slots_[group_index];
+    if (slot == 0) {
+      groups_.emplace_back();
+      slot = groups_.size();
+    }
+    return groups_[slot - 1];
+  }
+
+  // One plus the position in groups_ of the counts of each power of two, or 0 if they have not
+  // been allocated.
+  std::array<uint8_t, NumGroups> slots_{};
+  std::vector<Group> groups_;
+  bool used_{};
+};
+
+} // namespace Stats
+} // namespace Envoy
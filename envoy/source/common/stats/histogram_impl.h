@@ -24,6 +24,7 @@ public:
 
   // HistogramSettings
   const ConstSupportedBuckets& buckets(absl::string_view stat_name) const override;
+  bool fixedBucketRecording() const override { return fixed_bucket_recording_; }
 
   static ConstSupportedBuckets& defaultBuckets();
 
@@ -31,6 +32,7 @@ private:
   using Config = std::pair<Matchers::StringMatcherImpl<envoy::type::matcher::v3::StringMatcher>,
                            ConstSupportedBuckets>;
   const std::vector<Config> configs_{};
+  const bool fixed_bucket_recording_{};
 };
 
 /**
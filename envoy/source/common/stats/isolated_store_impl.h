@@ -229,6 +229,21 @@ public:
     text_readouts_.forEachStat(f_size, f_stat);
   }
 
+  void forEachChangedCounter(std::function<void(std::size_t)> f_size,
+                             std::function<void(Stats::Counter&)> f_stat) override {
+    alloc_.forEachChangedCounter(f_size, f_stat);
+  }
+
+  void forEachChangedGauge(std::function<void(std::size_t)> f_size,
+                           std::function<void(Stats::Gauge&)> f_stat) override {
+    alloc_.forEachChangedGauge(f_size, f_stat);
+  }
+
+  void forEachChangedTextReadout(std::function<void(std::size_t)> f_size,
+                                 std::function<void(Stats::TextReadout&)> f_stat) override {
+    alloc_.forEachChangedTextReadout(f_size, f_stat);
+  }
+
 private:
   IsolatedStoreImpl(std::unique_ptr<SymbolTable>&& symbol_table);
 
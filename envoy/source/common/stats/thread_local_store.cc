@@ -1,15 +1,18 @@
 #include "source/common/stats/thread_local_store.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/stats/allocator.h"
 #include "envoy/stats/histogram.h"
 #include "envoy/stats/sink.h"
 #include "envoy/stats/stats.h"
+#include "envoy/thread/thread.h"
 
 #include "source/common/common/lock_guard.h"
 #include "source/common/stats/histogram_impl.h"
@@ -243,14 +246,107 @@ void ThreadLocalStoreImpl::mergeHistograms(PostMergeCb merge_complete_cb) {
 
 void ThreadLocalStoreImpl::mergeInternal(PostMergeCb merge_complete_cb) {
   if (!shutting_down_) {
-    for (const ParentHistogramSharedPtr& histogram : histograms()) {
-      histogram->merge();
+    const std::vector<ParentHistogramSharedPtr> all_histograms = histograms();
+    if (merge_threads_ > 1 && all_histograms.size() > MergeBatchSize) {
+      mergeInParallel(all_histograms);
+    } else {
+      for (const ParentHistogramSharedPtr& histogram : all_histograms) {
+        histogram->merge();
+      }
     }
     merge_complete_cb();
     merge_in_progress_ = false;
   }
 }
 
+void ThreadLocalStoreImpl::setHistogramMergeThreads(uint32_t threads,
+                                                    Thread::ThreadFactory& thread_factory) {
+  merge_thread_pool_.reset();
+  merge_threads_ = threads;
+  if (threads > 1) {
+    merge_thread_pool_ = std::make_unique<MergeThreadPool>(threads - 1, thread_factory);
+  }
+}
+
+void ThreadLocalStoreImpl::mergeInParallel(
+    const std::vector<ParentHistogramSharedPtr>& histograms) {
+  // The threads take batches of histograms from a shared cursor until there are none left, so a
+  // thread that merges busy histograms takes fewer batches. The main thread takes part, and isn't
+  // back in its event loop until every merge is done, so nothing reads a histogram mid-merge.
+  std::atomic<size_t> next_batch{0};
+  merge_thread_pool_->run([&histograms, &next_batch]() {
+    for (size_t begin = next_batch.fetch_add(MergeBatchSize); begin < histograms.size();
+         begin = next_batch.fetch_add(MergeBatchSize)) {
+      const size_t end = std::min(begin + MergeBatchSize, histograms.size());
+      for (size_t i = begin; i < end; i++) {
+        histograms[i]->merge();
+      }
+    }
+  });
+}
+
+ThreadLocalStoreImpl::MergeThreadPool::MergeThreadPool(uint32_t helpers,
+                                                       Thread::ThreadFactory& thread_factory) {
+  helpers_.reserve(helpers);
+  for (uint32_t i = 0; i < helpers; i++) {
+    helpers_.push_back(
+        thread_factory.createThread([this]() { helperLoop(); }, Thread::Options{"stats_merge"}));
+  }
+}
+
+ThreadLocalStoreImpl::MergeThreadPool::~MergeThreadPool() {
+  {
+    Thread::LockGuard lock(mutex_);
+    stopping_ = true;
+    work_ready_.notifyAll();
+  }
+  for (Thread::ThreadPtr& helper : helpers_) {
+    helper->join();
+  }
+}
+
+void ThreadLocalStoreImpl::MergeThreadPool::run(const std::function<void()>& work) {
+  {
+    Thread::LockGuard lock(mutex_);
+    ASSERT(running_ == 0);
+    work_ = &work;
+    generation_++;
+    running_ = static_cast<uint32_t>(helpers_.size());
+    work_ready_.notifyAll();
+  }
+  work();
+  Thread::LockGuard lock(mutex_);
+  while (running_ > 0) {
+    work_done_.wait(mutex_);
+  }
+  work_ = nullptr;
+}
+
+void ThreadLocalStoreImpl::MergeThreadPool::helperLoop() {
+  // Nothing can have run before the pool was constructed, so a helper that starts late still sees
+  // the first run.
+  uint64_t done_generation = 0;
+  while (true) {
+    const std::function<void()>* work;
+    {
+      Thread::LockGuard lock(mutex_);
+      while (!stopping_ && generation_ == done_generation) {
+        work_ready_.wait(mutex_);
+      }
+      if (stopping_) {
+        return;
+      }
+      done_generation = generation_;
+      work = work_;
+    }
+    (*work)();
+    Thread::LockGuard lock(mutex_);
+    if (--running_ == 0) {
+      work_done_.notifyOne();
+    }
+  }
+}
+
 ThreadLocalStoreImpl::CentralCacheEntry::~CentralCacheEntry() {
   // Assert that the symbol-table is valid, so we get good test coverage of
   // the validity of the symbol table at the time this destructor runs. This
@@ -673,9 +769,10 @@ Histogram& ThreadLocalStoreImpl::ScopeImpl::histogramFromStatNameWithTags(
       if (iter != parent_.histogram_set_.end()) {
         stat = RefcountPtr<ParentHistogramImpl>(*iter);
       } else {
-        stat = new ParentHistogramImpl(final_stat_name, unit, parent_,
-                                       tag_helper.tagExtractedName(), tag_helper.statNameTags(),
-                                       *buckets, parent_.next_histogram_id_++);
+        stat = new ParentHistogramImpl(
+            final_stat_name, unit, parent_, tag_helper.tagExtractedName(),
+            tag_helper.statNameTags(), *buckets,
+            parent_.histogram_settings_->fixedBucketRecording(), parent_.next_histogram_id_++);
         if (!parent_.shutting_down_) {
           parent_.histogram_set_.insert(stat.get());
         }
@@ -766,9 +863,9 @@ Histogram& ThreadLocalStoreImpl::tlsHistogram(ParentHistogramImpl& parent, uint6
 
   StatNameTagHelper tag_helper(*this, parent.statName(), absl::nullopt);
 
-  TlsHistogramSharedPtr hist_tls_ptr(
-      new ThreadLocalHistogramImpl(parent.statName(), parent.unit(), tag_helper.tagExtractedName(),
-                                   tag_helper.statNameTags(), symbolTable()));
+  TlsHistogramSharedPtr hist_tls_ptr(new ThreadLocalHistogramImpl(
+      parent.statName(), parent.unit(), tag_helper.tagExtractedName(), tag_helper.statNameTags(),
+      symbolTable(), parent.fixedBuckets()));
 
   parent.addTlsHistogram(hist_tls_ptr);
 
@@ -782,40 +879,67 @@ Histogram& ThreadLocalStoreImpl::tlsHistogram(ParentHistogramImpl& parent, uint6
 ThreadLocalHistogramImpl::ThreadLocalHistogramImpl(StatName name, Histogram::Unit unit,
                                                    StatName tag_extracted_name,
                                                    const StatNameTagVector& stat_name_tags,
-                                                   SymbolTable& symbol_table)
+                                                   SymbolTable& symbol_table, bool fixed_buckets)
     : HistogramImplHelper(name, tag_extracted_name, stat_name_tags, symbol_table), unit_(unit),
       current_active_(0), used_(false), created_thread_id_(std::this_thread::get_id()),
       symbol_table_(symbol_table) {
-  histograms_[0] = hist_alloc();
-  histograms_[1] = hist_alloc();
+  if (fixed_buckets) {
+    fixed_histograms_[0] = std::make_unique<FixedHistogram>();
+    fixed_histograms_[1] = std::make_unique<FixedHistogram>();
+  } else {
+    histograms_[0] = hist_alloc();
+    histograms_[1] = hist_alloc();
+  }
 }
 
 ThreadLocalHistogramImpl::~ThreadLocalHistogramImpl() {
   MetricImpl::clear(symbol_table_);
-  hist_free(histograms_[0]);
-  hist_free(histograms_[1]);
+  if (histograms_[0] != nullptr) {
+    hist_free(histograms_[0]);
+    hist_free(histograms_[1]);
+  }
 }
 
 void ThreadLocalHistogramImpl::recordValue(uint64_t value) {
   ASSERT(std::this_thread::get_id() == created_thread_id_);
-  hist_insert_intscale(histograms_[current_active_], value, 0, 1);
+  if (fixed_histograms_[0] != nullptr) {
+    fixed_histograms_[current_active_]->recordValue(value);
+  } else {
+    hist_insert_intscale(histograms_[current_active_], value, 0, 1);
+  }
   used_ = true;
 }
 
-void ThreadLocalHistogramImpl::merge(histogram_t* target) {
+bool ThreadLocalHistogramImpl::merge(histogram_t* target) {
   histogram_t** other_histogram = &histograms_[otherHistogramIndex()];
+  if (hist_num_buckets(*other_histogram) == 0) {
+    return false;
+  }
   hist_accumulate(target, other_histogram, 1);
   hist_clear(*other_histogram);
+  return true;
+}
+
+bool ThreadLocalHistogramImpl::merge(FixedHistogram& target) {
+  FixedHistogram& other_histogram = *fixed_histograms_[otherHistogramIndex()];
+  if (!other_histogram.used()) {
+    return false;
+  }
+  target.add(other_histogram);
+  other_histogram.clear();
+  return true;
 }
 
 ParentHistogramImpl::ParentHistogramImpl(StatName name, Histogram::Unit unit,
                                          ThreadLocalStoreImpl& thread_local_store,
                                          StatName tag_extracted_name,
                                          const StatNameTagVector& stat_name_tags,
-                                         ConstSupportedBuckets& supported_buckets, uint64_t id)
+                                         ConstSupportedBuckets& supported_buckets,
+                                         bool fixed_buckets, uint64_t id)
     : MetricImpl(name, tag_extracted_name, stat_name_tags, thread_local_store.symbolTable()),
       unit_(unit), thread_local_store_(thread_local_store), interval_histogram_(hist_alloc()),
       cumulative_histogram_(hist_alloc()),
+      fixed_interval_histogram_(fixed_buckets ? std::make_unique<FixedHistogram>() : nullptr),
       interval_statistics_(interval_histogram_, supported_buckets),
       cumulative_statistics_(cumulative_histogram_, supported_buckets), merged_(false), id_(id) {}
 
@@ -891,17 +1015,32 @@ void ParentHistogramImpl::merge() {
   Thread::ReleasableLockGuard lock(merge_lock_);
   if (merged_ || usedLockHeld()) {
     hist_clear(interval_histogram_);
+    bool recorded = false;
     // Here we could copy all the pointers to TLS histograms in the tls_histogram_ list,
     // then release the lock before we do the actual merge. However it is not a big deal
     // because the tls_histogram merge is not that expensive as it is a single histogram
     // merge and adding TLS histograms is rare.
-    for (const TlsHistogramSharedPtr& tls_histogram : tls_histograms_) {
-      tls_histogram->merge(interval_histogram_);
+    if (fixed_interval_histogram_ != nullptr) {
+      for (const TlsHistogramSharedPtr& tls_histogram : tls_histograms_) {
+        recorded |= tls_histogram->merge(*fixed_interval_histogram_);
+      }
+      lock.release();
+      // The interval's buckets are fed into circllhist once, rather than once per worker.
+      fixed_interval_histogram_->insertInto(interval_histogram_);
+      fixed_interval_histogram_->clear();
+    } else {
+      for (const TlsHistogramSharedPtr& tls_histogram : tls_histograms_) {
+        recorded |= tls_histogram->merge(interval_histogram_);
+      }
+      // Since TLS merge is done, we can release the lock here.
+      lock.release();
+    }
+    // Without values in the interval the cumulative statistics, the costly part of a merge, are
+    // unchanged.
+    if (recorded || !merged_) {
+      hist_accumulate(cumulative_histogram_, &interval_histogram_, 1);
+      cumulative_statistics_.refresh(cumulative_histogram_);
     }
-    // Since TLS merge is done, we can release the lock here.
-    lock.release();
-    hist_accumulate(cumulative_histogram_, &interval_histogram_, 1);
-    cumulative_statistics_.refresh(cumulative_histogram_);
     interval_statistics_.refresh(interval_histogram_);
     merged_ = true;
   }
@@ -972,5 +1111,23 @@ void ThreadLocalStoreImpl::forEachTextReadout(
   alloc_.forEachTextReadout(f_size, f_stat);
 }
 
+void ThreadLocalStoreImpl::forEachChangedCounter(std::function<void(std::size_t)> f_size,
+                                                 std::function<void(Stats::Counter&)> f_stat) {
+  Thread::LockGuard lock(lock_);
+  alloc_.forEachChangedCounter(f_size, f_stat);
+}
+
+void ThreadLocalStoreImpl::forEachChangedGauge(std::function<void(std::size_t)> f_size,
+                                               std::function<void(Stats::Gauge&)> f_stat) {
+  Thread::LockGuard lock(lock_);
+  alloc_.forEachChangedGauge(f_size, f_stat);
+}
+
+void ThreadLocalStoreImpl::forEachChangedTextReadout(
+    std::function<void(std::size_t)> f_size, std::function<void(Stats::TextReadout&)> f_stat) {
+  Thread::LockGuard lock(lock_);
+  alloc_.forEachChangedTextReadout(f_size, f_stat);
+}
+
 } // namespace Stats
 } // namespace Envoy
@@ -3,6 +3,7 @@
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <memory>
 #include <string>
@@ -11,8 +12,10 @@
 #include "envoy/thread_local/thread_local.h"
 
 #include "source/common/common/hash.h"
+#include "source/common/common/thread.h"
 #include "source/common/common/thread_synchronizer.h"
 #include "source/common/stats/allocator_impl.h"
+#include "source/common/stats/fixed_histogram.h"
 #include "source/common/stats/histogram_impl.h"
 #include "source/common/stats/null_counter.h"
 #include "source/common/stats/null_gauge.h"
@@ -34,11 +37,20 @@ namespace Stats {
  */
 class ThreadLocalHistogramImpl : public HistogramImplHelper {
 public:
+  /**
+   * @param fixed_buckets whether to record into FixedHistograms rather than circllhists.
+   */
   ThreadLocalHistogramImpl(StatName name, Histogram::Unit unit, StatName tag_extracted_name,
-                           const StatNameTagVector& stat_name_tags, SymbolTable& symbol_table);
+                           const StatNameTagVector& stat_name_tags, SymbolTable& symbol_table,
+                           bool fixed_buckets);
   ~ThreadLocalHistogramImpl() override;
 
-  void merge(histogram_t* target);
+  /**
+   * Merges the values recorded before the last beginMerge() into target.
+   * @return whether any values were recorded.
+   */
+  bool merge(histogram_t* target);
+  bool merge(FixedHistogram& target);
 
   /**
    * Called in the beginning of merge process. Swaps the histogram used for collection so that we do
@@ -66,7 +78,9 @@ private:
   Histogram::Unit unit_;
   uint64_t otherHistogramIndex() const { return 1 - current_active_; }
   uint64_t current_active_;
-  histogram_t* histograms_[2];
+  // Only one of these pairs is allocated.
+  histogram_t* histograms_[2]{};
+  std::unique_ptr<FixedHistogram> fixed_histograms_[2];
   std::atomic<bool> used_;
   std::thread::id created_thread_id_;
   SymbolTable& symbol_table_;
@@ -83,10 +97,11 @@ class ParentHistogramImpl : public MetricImpl<ParentHistogram> {
 public:
   ParentHistogramImpl(StatName name, Histogram::Unit unit, ThreadLocalStoreImpl& parent,
                       StatName tag_extracted_name, const StatNameTagVector& stat_name_tags,
-                      ConstSupportedBuckets& supported_buckets, uint64_t id);
+                      ConstSupportedBuckets& supported_buckets, bool fixed_buckets, uint64_t id);
   ~ParentHistogramImpl() override;
 
   void addTlsHistogram(const TlsHistogramSharedPtr& hist_ptr);
+  bool fixedBuckets() const { return fixed_interval_histogram_ != nullptr; }
 
   // Stats::Histogram
   Histogram::Unit unit() const override;
@@ -127,6 +142,8 @@ private:
   ThreadLocalStoreImpl& thread_local_store_;
   histogram_t* interval_histogram_;
   histogram_t* cumulative_histogram_;
+  // Where the TLS histograms are merged when they use fixed buckets, before interval_histogram_.
+  std::unique_ptr<FixedHistogram> fixed_interval_histogram_;
   HistogramStatisticsImpl interval_statistics_;
   HistogramStatisticsImpl cumulative_statistics_;
   mutable Thread::MutexBasicLockable merge_lock_;
@@ -253,6 +270,15 @@ public:
   void forEachTextReadout(std::function<void(std::size_t)> f_size,
                           std::function<void(Stats::TextReadout&)> f_stat) const override;
 
+  void forEachChangedCounter(std::function<void(std::size_t)> f_size,
+                             std::function<void(Stats::Counter&)> f_stat) override;
+
+  void forEachChangedGauge(std::function<void(std::size_t)> f_size,
+                           std::function<void(Stats::Gauge&)> f_stat) override;
+
+  void forEachChangedTextReadout(std::function<void(std::size_t)> f_size,
+                                 std::function<void(Stats::TextReadout&)> f_stat) override;
+
   // Stats::StoreRoot
   void addSink(Sink& sink) override { timer_sinks_.push_back(sink); }
   void setTagProducer(TagProducerPtr&& tag_producer) override {
@@ -260,6 +286,8 @@ public:
   }
   void setStatsMatcher(StatsMatcherPtr&& stats_matcher) override;
   void setHistogramSettings(HistogramSettingsConstPtr&& histogram_settings) override;
+  void setCounterShards(uint32_t shards) override { alloc_.setCounterShards(shards); }
+  void setHistogramMergeThreads(uint32_t threads, Thread::ThreadFactory& thread_factory) override;
   void initializeThreading(Event::Dispatcher& main_thread_dispatcher,
                            ThreadLocal::Instance& tls) override;
   void shutdownThreading() override;
@@ -486,6 +514,31 @@ private:
   void clearHistogramsFromCaches();
   void releaseScopeCrossThread(ScopeImpl* scope);
   void mergeInternal(PostMergeCb merge_cb);
+  void mergeInParallel(const std::vector<ParentHistogramSharedPtr>& histograms);
+
+  // Threads that help the main thread merge histograms. They are started when the number of merge
+  // threads is set, and wait for work between merges.
+  class MergeThreadPool {
+  public:
+    MergeThreadPool(uint32_t helpers, Thread::ThreadFactory& thread_factory);
+    ~MergeThreadPool();
+
+    // Runs work on the calling thread and on every helper, and returns once all of them are done.
+    void run(const std::function<void()>& work);
+
+  private:
+    void helperLoop();
+
+    Thread::MutexBasicLockable mutex_;
+    Thread::CondVar work_ready_;
+    Thread::CondVar work_done_;
+    const std::function<void()>* work_ ABSL_GUARDED_BY(mutex_){};
+    // Bumped for each run, so that each helper runs the work once.
+    uint64_t generation_ ABSL_GUARDED_BY(mutex_){};
+    uint32_t running_ ABSL_GUARDED_BY(mutex_){};
+    bool stopping_ ABSL_GUARDED_BY(mutex_){};
+    std::vector<Thread::ThreadPtr> helpers_;
+  };
   bool slowRejects(StatsMatcher::FastResult fast_reject_result, StatName name) const;
   bool rejects(StatName name) const { return stats_matcher_->rejects(name); }
   StatsMatcher::FastResult fastRejects(StatName name) const;
@@ -514,6 +567,10 @@ private:
   std::atomic<bool> threading_ever_initialized_{};
   std::atomic<bool> shutting_down_{};
   std::atomic<bool> merge_in_progress_{};
+  // The number of histograms a merge thread takes at a time.
+  static constexpr size_t MergeBatchSize = 256;
+  uint32_t merge_threads_{1};
+  std::unique_ptr<MergeThreadPool> merge_thread_pool_;
   AllocatorImpl heap_allocator_;
   OptRef<ThreadLocal::Instance> tls_;
 
@@ -85,6 +85,7 @@ Config::SharedConfig::SharedConfig(
 Config::Config(const envoy::extensions::filters::network::tcp_proxy::v3::TcpProxy& config,
                Server::Configuration::FactoryContext& context)
     : max_connect_attempts_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_connect_attempts, 1)),
+      use_splice_(config.use_splice()),
       upstream_drain_manager_slot_(context.threadLocal().allocateSlot()),
       shared_config_(std::make_shared<SharedConfig>(config, context)),
       random_generator_(context.api().randomGenerator()) {
@@ -619,6 +620,15 @@ void Filter::onUpstreamConnection() {
       });
     }
   }
+
+  // Once spliced, the data no longer passes through onData() and onUpstreamData(). The
+  // connections still count the spliced bytes in their stats and stream info, and the bytes sent
+  // callbacks above still reset the idle timer. Splicing is refused if the downstream connection
+  // has read filters other than this one, as they would no longer see the data.
+  if (config_->useSplice() && upstream_ && upstream_->startSplice(read_callbacks_->connection())) {
+    ENVOY_CONN_LOG(debug, "splicing to the upstream connection", read_callbacks_->connection());
+    config_->stats().downstream_cx_splice_total_.inc();
+  }
 }
 
 void Filter::onIdleTimeout() {
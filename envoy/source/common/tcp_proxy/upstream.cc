@@ -57,6 +57,10 @@ TcpUpstream::onDownstreamEvent(Network::ConnectionEvent event) {
   return nullptr;
 }
 
+bool TcpUpstream::startSplice(Network::Connection& downstream) {
+  return upstream_conn_data_->connection().startSplice(downstream);
+}
+
 HttpUpstream::HttpUpstream(Tcp::ConnectionPool::UpstreamCallbacks& callbacks,
                            const TunnelingConfig& config)
     : config_(config), response_decoder_(*this), upstream_callbacks_(callbacks) {
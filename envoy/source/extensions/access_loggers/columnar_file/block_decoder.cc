@@ -0,0 +1,141 @@
+#include "source/extensions/access_loggers/columnar_file/block_decoder.h"
+
+#include "envoy/common/exception.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/fmt.h"
+#include "source/extensions/compression/brotli/decompressor/brotli_decompressor_impl.h"
+#include "source/extensions/compression/gzip/decompressor/zlib_decompressor_impl.h"
+
+#include "absl/strings/match.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace ColumnarFile {
+
+namespace {
+
+// Matches the window of the block encoder's gzip compressor, plus the gzip header flag.
+constexpr int64_t GzipWindowBits = 15 | 16;
+constexpr uint32_t DecompressorChunkSize = 4096;
+
+uint64_t readField(absl::string_view& input, absl::string_view field) {
+  const absl::optional<uint64_t> value = readVarint(input);
+  if (!value.has_value()) {
+    throw EnvoyException(fmt::format("columnar access log: invalid or truncated {}", field));
+  }
+  return value.value();
+}
+
+absl::string_view readBytes(absl::string_view& input, uint64_t size, absl::string_view field) {
+  if (size > input.size()) {
+    throw EnvoyException(fmt::format("columnar access log: truncated {}", field));
+  }
+  const absl::string_view bytes = input.substr(0, size);
+  input.remove_prefix(size);
+  return bytes;
+}
+
+} // namespace
+
+DecodedBlock BlockDecoder::decode(absl::string_view& data) {
+  absl::string_view input = data;
+  if (!absl::StartsWith(input, BlockMagic)) {
+    throw EnvoyException("columnar access log: data doesn't start with a block");
+  }
+  input.remove_prefix(BlockMagic.size());
+
+  const uint64_t version = readField(input, "version");
+  if (version != BlockFormatVersion) {
+    throw EnvoyException(fmt::format("columnar access log: unsupported version {}", version));
+  }
+
+  DecodedBlock block;
+  const uint64_t compression = readField(input, "compression");
+  if (compression > static_cast<uint64_t>(BlockCompression::Brotli)) {
+    throw EnvoyException(fmt::format("columnar access log: unknown compression {}", compression));
+  }
+  block.compression_ = static_cast<BlockCompression>(compression);
+
+  const uint64_t records = readField(input, "record count");
+  const uint64_t columns = readField(input, "column count");
+  if (columns == 0) {
+    throw EnvoyException("columnar access log: block has no columns");
+  }
+  // Every column takes at least two bytes.
+  if (columns > input.size() / 2) {
+    throw EnvoyException("columnar access log: truncated columns");
+  }
+  block.schema_.reserve(columns);
+  for (uint64_t column = 0; column < columns; column++) {
+    const uint64_t name_size = readField(input, "column name size");
+    const absl::string_view name = readBytes(input, name_size, "column name");
+    const uint64_t type = readField(input, "column type");
+    if (type > static_cast<uint64_t>(ColumnType::Integer)) {
+      throw EnvoyException(fmt::format("columnar access log: unknown column type {}", type));
+    }
+    block.schema_.push_back({std::string(name), static_cast<ColumnType>(type)});
+  }
+
+  const uint64_t uncompressed_size = readField(input, "payload size");
+  const uint64_t payload_size = readField(input, "compressed payload size");
+  absl::string_view payload = readBytes(input, payload_size, "payload");
+  std::string decompressed;
+  if (block.compression_ != BlockCompression::None) {
+    decompressed = decompress(block.compression_, payload);
+    payload = decompressed;
+  }
+  if (payload.size() != uncompressed_size) {
+    throw EnvoyException(
+        fmt::format("columnar access log: payload is {} bytes rather than {} bytes",
+                    payload.size(), uncompressed_size));
+  }
+  // Every value takes at least a byte, which also bounds the memory the records take.
+  if (records > payload.size() / columns) {
+    throw EnvoyException("columnar access log: payload is too small for its records");
+  }
+
+  block.records_.resize(records, std::vector<DecodedValue>(columns));
+  for (uint64_t column = 0; column < columns; column++) {
+    const bool is_string = block.schema_[column].type_ == ColumnType::String;
+    for (uint64_t record = 0; record < records; record++) {
+      const uint64_t value = readField(payload, "value");
+      if (value == 0) {
+        continue;
+      }
+      if (is_string) {
+        block.records_[record][column] = std::string(readBytes(payload, value - 1, "value"));
+      } else {
+        block.records_[record][column] = value - 1;
+      }
+    }
+  }
+  if (!payload.empty()) {
+    throw EnvoyException("columnar access log: payload has bytes past its values");
+  }
+
+  data = input;
+  return block;
+}
+
+std::string BlockDecoder::decompress(BlockCompression compression, absl::string_view payload) {
+  Buffer::OwnedImpl input(payload);
+  Buffer::OwnedImpl output;
+  if (compression == BlockCompression::Gzip) {
+    Compression::Gzip::Decompressor::ZlibDecompressorImpl decompressor(
+        stats_store_, "columnar_file.", DecompressorChunkSize);
+    decompressor.init(GzipWindowBits);
+    decompressor.decompress(input, output);
+  } else {
+    Compression::Brotli::Decompressor::BrotliDecompressorImpl decompressor(
+        stats_store_, "columnar_file.", DecompressorChunkSize, false);
+    decompressor.decompress(input, output);
+  }
+  return output.toString();
+}
+
+} // namespace ColumnarFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "source/common/stats/isolated_store_impl.h"
+#include "source/extensions/access_loggers/columnar_file/block_format.h"
+
+#include "absl/strings/string_view.h"
+#include "absl/types/variant.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace ColumnarFile {
+
+// A value of a decoded record: absent, a string or an integer.
+using DecodedValue = absl::variant<absl::monostate, std::string, uint64_t>;
+
+struct DecodedBlock {
+  Schema schema_;
+  BlockCompression compression_;
+  // The values of each record, in column order.
+  std::vector<std::vector<DecodedValue>> records_;
+};
+
+/**
+ * Decodes the blocks written by the columnar file access log, for offline tools and tests.
+ */
+class BlockDecoder {
+public:
+  /**
+   * Decodes the block at the front of data, and removes it from data.
+   * @throw EnvoyException if data doesn't start with a complete, valid block.
+   */
+  DecodedBlock decode(absl::string_view& data);
+
+private:
+  std::string decompress(BlockCompression compression, absl::string_view payload);
+
+  // The decompressors count their errors in stats, which the decoder has no use for.
+  Stats::IsolatedStoreImpl stats_store_;
+};
+
+} // namespace ColumnarFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
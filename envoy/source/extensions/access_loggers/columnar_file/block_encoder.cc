@@ -0,0 +1,133 @@
+#include "source/extensions/access_loggers/columnar_file/block_encoder.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/assert.h"
+#include "source/extensions/compression/brotli/compressor/brotli_compressor_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace ColumnarFile {
+
+namespace {
+
+// The brotli compressor uses the brotli compression extension's defaults. The gzip compressor
+// uses zlib's own defaults, which allow it a larger window and more memory than the gzip
+// extension's, as a block is compressed in one go and is larger than a typical HTTP response.
+constexpr int64_t GzipWindowBits = 15;
+// Makes zlib write a gzip header and trailer.
+constexpr int64_t GzipHeaderValue = 16;
+constexpr uint64_t GzipMemoryLevel = 8;
+constexpr uint32_t BrotliQuality = 3;
+constexpr uint32_t BrotliWindowBits = 18;
+constexpr uint32_t BrotliInputBlockBits = 24;
+constexpr uint32_t CompressorChunkSize = 4096;
+
+using ZlibCompressorImpl = Compression::Gzip::Compressor::ZlibCompressorImpl;
+using BrotliCompressorImpl = Compression::Brotli::Compressor::BrotliCompressorImpl;
+
+} // namespace
+
+BlockEncoder::BlockEncoder(const Schema& schema, BlockCompression compression)
+    : schema_(schema), compression_(compression), columns_(schema.size()) {
+  ASSERT(!schema_.empty());
+}
+
+void BlockEncoder::appendString(absl::string_view value) {
+  ASSERT(schema_[column_].type_ == ColumnType::String);
+  std::string& column = columns_[column_++];
+  const size_t old_size = column.size();
+  appendVarint(column, value.size() + 1);
+  column.append(value.data(), value.size());
+  size_ += column.size() - old_size;
+}
+
+void BlockEncoder::appendInteger(uint64_t value) {
+  ASSERT(schema_[column_].type_ == ColumnType::Integer);
+  // Adding one would wrap around to the encoding of an absent value.
+  ASSERT(value != UINT64_MAX);
+  std::string& column = columns_[column_++];
+  const size_t old_size = column.size();
+  appendVarint(column, value + 1);
+  size_ += column.size() - old_size;
+}
+
+void BlockEncoder::appendAbsent() {
+  columns_[column_++].push_back('\0');
+  size_++;
+}
+
+void BlockEncoder::endRecord() {
+  ASSERT(column_ == columns_.size());
+  column_ = 0;
+  records_++;
+}
+
+void BlockEncoder::finish(std::string& output) {
+  ASSERT(column_ == 0);
+  if (records_ == 0) {
+    return;
+  }
+
+  output.append(BlockMagic.data(), BlockMagic.size());
+  appendVarint(output, BlockFormatVersion);
+  appendVarint(output, static_cast<uint64_t>(compression_));
+  appendVarint(output, records_);
+  appendVarint(output, schema_.size());
+  for (const ColumnSchema& column : schema_) {
+    appendVarint(output, column.name_.size());
+    output.append(column.name_);
+    appendVarint(output, static_cast<uint64_t>(column.type_));
+  }
+  appendVarint(output, size_);
+
+  if (compression_ == BlockCompression::None) {
+    appendVarint(output, size_);
+    for (std::string& column : columns_) {
+      output.append(column);
+      column.clear();
+    }
+  } else {
+    Buffer::OwnedImpl payload;
+    for (std::string& column : columns_) {
+      payload.add(column);
+      column.clear();
+    }
+    compressor().compress(payload, Envoy::Compression::Compressor::State::Finish);
+    appendVarint(output, payload.length());
+    output.reserve(output.size() + payload.length());
+    for (const Buffer::RawSlice& slice : payload.getRawSlices()) {
+      output.append(static_cast<const char*>(slice.mem_), slice.len_);
+    }
+  }
+  records_ = 0;
+  size_ = 0;
+}
+
+Envoy::Compression::Compressor::Compressor& BlockEncoder::compressor() {
+  switch (compression_) {
+  case BlockCompression::Gzip:
+    if (gzip_compressor_ == nullptr) {
+      gzip_compressor_ = std::make_unique<ZlibCompressorImpl>(CompressorChunkSize);
+      gzip_compressor_->init(ZlibCompressorImpl::CompressionLevel::Standard,
+                             ZlibCompressorImpl::CompressionStrategy::Standard,
+                             GzipWindowBits | GzipHeaderValue, GzipMemoryLevel);
+    } else {
+      gzip_compressor_->reset();
+    }
+    return *gzip_compressor_;
+  case BlockCompression::Brotli:
+    brotli_compressor_ = std::make_unique<BrotliCompressorImpl>(
+        BrotliQuality, BrotliWindowBits, BrotliInputBlockBits, false,
+        BrotliCompressorImpl::EncoderMode::Default, CompressorChunkSize);
+    return *brotli_compressor_;
+  case BlockCompression::None:
+    break;
+  }
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
+} // namespace ColumnarFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
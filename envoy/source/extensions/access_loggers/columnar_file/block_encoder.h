@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/compression/compressor/compressor.h"
+
+#include "source/extensions/access_loggers/columnar_file/block_format.h"
+#include "source/extensions/compression/gzip/compressor/zlib_compressor_impl.h"
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace ColumnarFile {
+
+/**
+ * Collects records into a block of the columnar access log format. Each record has one value per
+ * column of the schema, appended in column order, and is completed with endRecord(). The values
+ * of each column are kept in a buffer of their own, and the buffers are concatenated when the
+ * block is finished. An encoder is used by a single thread.
+ */
+class BlockEncoder {
+public:
+  BlockEncoder(const Schema& schema, BlockCompression compression);
+
+  void appendString(absl::string_view value);
+  void appendInteger(uint64_t value);
+  void appendAbsent();
+  void endRecord();
+
+  // The number of complete records in the block.
+  uint64_t records() const { return records_; }
+
+  // The size of the block's values before compression.
+  uint64_t size() const { return size_; }
+
+  /**
+   * Appends the block to output, and starts a new, empty block. Does nothing if the block has no
+   * records.
+   */
+  void finish(std::string& output);
+
+private:
+  Envoy::Compression::Compressor::Compressor& compressor();
+
+  const Schema schema_;
+  const BlockCompression compression_;
+  // The values of each column, in record order.
+  std::vector<std::string> columns_;
+  // The column of the next value.
+  size_t column_{};
+  uint64_t records_{};
+  uint64_t size_{};
+  // The gzip compressor is reset and reused for every block. Brotli encoders cannot be reset, so
+  // a brotli compressor is created per block.
+  std::unique_ptr<Compression::Gzip::Compressor::ZlibCompressorImpl> gzip_compressor_;
+  Envoy::Compression::Compressor::CompressorPtr brotli_compressor_;
+};
+
+} // namespace ColumnarFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,36 @@
+#include "source/extensions/access_loggers/columnar_file/block_format.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace ColumnarFile {
+
+void appendVarint(std::string& output, uint64_t value) {
+  while (value >= 0x80) {
+    output.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
+absl::optional<uint64_t> readVarint(absl::string_view& input) {
+  uint64_t value = 0;
+  // A 64 bit value takes at most 10 bytes, and the 10th holds only its top bit.
+  for (size_t i = 0; i < input.size() && i < 10; i++) {
+    const uint8_t byte = static_cast<uint8_t>(input[i]);
+    if (i == 9 && byte > 1) {
+      return absl::nullopt;
+    }
+    value |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      input.remove_prefix(i + 1);
+      return value;
+    }
+  }
+  return absl::nullopt;
+}
+
+} // namespace ColumnarFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
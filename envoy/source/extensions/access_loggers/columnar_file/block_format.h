@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace ColumnarFile {
+
+/**
+ * Definitions shared by the block encoder and decoder. The layout of a block is documented in
+ * the ColumnarFileAccessLog API proto. The numeric values of the enums are part of the format.
+ */
+
+// The bytes every block starts with.
+constexpr absl::string_view BlockMagic = "EALB";
+constexpr uint64_t BlockFormatVersion = 1;
+
+enum class ColumnType : uint64_t { String = 0, Integer = 1 };
+
+enum class BlockCompression : uint64_t { None = 0, Gzip = 1, Brotli = 2 };
+
+struct ColumnSchema {
+  std::string name_;
+  ColumnType type_;
+};
+
+using Schema = std::vector<ColumnSchema>;
+
+/**
+ * Appends value to output as an unsigned base 128 varint.
+ */
+void appendVarint(std::string& output, uint64_t value);
+
+/**
+ * Reads a varint from the front of input and removes it.
+ * @return the value, or nullopt if input ends before the varint does or the varint is longer
+ *         than 64 bits. input is unchanged in that case.
+ */
+absl::optional<uint64_t> readVarint(absl::string_view& input);
+
+} // namespace ColumnarFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,167 @@
+#include "source/extensions/access_loggers/columnar_file/columnar_file_access_log_impl.h"
+
+#include <cmath>
+
+#include "envoy/common/exception.h"
+
+#include "source/common/protobuf/utility.h"
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/numbers.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace ColumnarFile {
+
+namespace {
+
+using ProtoConfig =
+    envoy::extensions::access_loggers::columnar_file::v3alpha::ColumnarFileAccessLog;
+
+constexpr uint64_t DefaultBlockSize = 64 * 1024;
+constexpr uint64_t DefaultBlockFlushIntervalMs = 1000;
+
+// The value of an integer column, if value is an integer that the format can encode.
+absl::optional<uint64_t> toInteger(const ProtobufWkt::Value& value) {
+  switch (value.kind_case()) {
+  case ProtobufWkt::Value::kNumberValue: {
+    const double number = value.number_value();
+    // 2^64 is the first double above the largest encodable integer, 2^64 - 2.
+    if (number >= 0 && number < 18446744073709551616.0 && std::floor(number) == number) {
+      return static_cast<uint64_t>(number);
+    }
+    return absl::nullopt;
+  }
+  case ProtobufWkt::Value::kStringValue: {
+    uint64_t integer;
+    if (absl::SimpleAtoi(value.string_value(), &integer) && integer != UINT64_MAX) {
+      return integer;
+    }
+    return absl::nullopt;
+  }
+  default:
+    return absl::nullopt;
+  }
+}
+
+} // namespace
+
+ColumnarFileAccessLog::ThreadLocalBlock::ThreadLocalBlock(ConfigConstSharedPtr config,
+                                                          Event::Dispatcher& dispatcher)
+    : config_(std::move(config)), encoder_(config_->schema_, config_->compression_),
+      flush_timer_(dispatcher.createTimer([this]() { flush(); })) {}
+
+ColumnarFileAccessLog::ThreadLocalBlock::~ThreadLocalBlock() { flush(); }
+
+void ColumnarFileAccessLog::ThreadLocalBlock::flush() {
+  // The block is written with a single write so that it is not interleaved with other workers'
+  // blocks. The buffer keeps its capacity for the next block.
+  block_.clear();
+  encoder_.finish(block_);
+  if (!block_.empty()) {
+    config_->log_file_->write(block_);
+  }
+  flush_timer_->disableTimer();
+}
+
+ColumnarFileAccessLog::ColumnarFileAccessLog(const ProtoConfig& config,
+                                             AccessLog::FilterPtr&& filter,
+                                             AccessLog::AccessLogManager& log_manager,
+                                             ThreadLocal::SlotAllocator& tls)
+    : ImplBase(std::move(filter)), config_(createConfig(config, log_manager)), tls_slot_(tls) {
+  tls_slot_.set([config = config_](Event::Dispatcher& dispatcher) {
+    return std::make_shared<ThreadLocalBlock>(config, dispatcher);
+  });
+}
+
+ColumnarFileAccessLog::ConfigConstSharedPtr
+ColumnarFileAccessLog::createConfig(const ProtoConfig& config,
+                                    AccessLog::AccessLogManager& log_manager) {
+  auto result = std::make_shared<Config>();
+  absl::flat_hash_set<std::string> names;
+  for (const auto& column_config : config.columns()) {
+    if (!names.insert(column_config.name()).second) {
+      throw EnvoyException(
+          fmt::format("columnar access log: duplicate column '{}'", column_config.name()));
+    }
+    Column column;
+    column.type_ = column_config.type() == ProtoConfig::Column::INTEGER ? ColumnType::Integer
+                                                                         : ColumnType::String;
+    std::vector<Formatter::FormatterProviderPtr> providers =
+        Formatter::SubstitutionFormatParser::parse(column_config.format());
+    if (providers.size() == 1) {
+      column.provider_ = std::move(providers[0]);
+    } else if (column.type_ == ColumnType::Integer) {
+      throw EnvoyException(fmt::format(
+          "columnar access log: the format of integer column '{}' must be a single command "
+          "operator",
+          column_config.name()));
+    } else {
+      column.formatter_ = std::make_unique<Formatter::FormatterImpl>(column_config.format());
+    }
+    result->columns_.push_back(std::move(column));
+    result->schema_.push_back({column_config.name(), result->columns_.back().type_});
+  }
+
+  switch (config.compression()) {
+  case ProtoConfig::GZIP:
+    result->compression_ = BlockCompression::Gzip;
+    break;
+  case ProtoConfig::BROTLI:
+    result->compression_ = BlockCompression::Brotli;
+    break;
+  default:
+    result->compression_ = BlockCompression::None;
+    break;
+  }
+  result->block_size_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, block_size_bytes, DefaultBlockSize);
+  result->block_flush_interval_ = std::chrono::milliseconds(
+      PROTOBUF_GET_MS_OR_DEFAULT(config, block_flush_interval, DefaultBlockFlushIntervalMs));
+  result->log_file_ =
+      log_manager.createAccessLog({Filesystem::DestinationType::File, config.path()});
+  return result;
+}
+
+void ColumnarFileAccessLog::emitLog(const Http::RequestHeaderMap& request_headers,
+                                    const Http::ResponseHeaderMap& response_headers,
+                                    const Http::ResponseTrailerMap& response_trailers,
+                                    const StreamInfo::StreamInfo& stream_info) {
+  ThreadLocalBlock& block = *tls_slot_;
+  BlockEncoder& encoder = block.encoder_;
+  for (const Column& column : config_->columns_) {
+    if (column.formatter_ != nullptr) {
+      encoder.appendString(column.formatter_->format(request_headers, response_headers,
+                                                     response_trailers, stream_info,
+                                                     absl::string_view()));
+    } else if (column.type_ == ColumnType::Integer) {
+      const absl::optional<uint64_t> value = toInteger(column.provider_->formatValue(
+          request_headers, response_headers, response_trailers, stream_info, absl::string_view()));
+      if (value.has_value()) {
+        encoder.appendInteger(value.value());
+      } else {
+        encoder.appendAbsent();
+      }
+    } else {
+      const absl::optional<std::string> value = column.provider_->format(
+          request_headers, response_headers, response_trailers, stream_info, absl::string_view());
+      if (value.has_value()) {
+        encoder.appendString(value.value());
+      } else {
+        encoder.appendAbsent();
+      }
+    }
+  }
+  encoder.endRecord();
+
+  if (encoder.size() >= config_->block_size_) {
+    block.flush();
+  } else if (encoder.records() == 1) {
+    block.flush_timer_->enableTimer(config_->block_flush_interval_);
+  }
+}
+
+} // namespace ColumnarFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/access_log/access_log.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/extensions/access_loggers/columnar_file/v3alpha/columnar_file.pb.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "source/common/formatter/substitution_formatter.h"
+#include "source/extensions/access_loggers/columnar_file/block_encoder.h"
+#include "source/extensions/access_loggers/common/access_log_base.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace ColumnarFile {
+
+/**
+ * Access log Instance that writes log entries to a file in blocks of the columnar format. Each
+ * worker encodes its entries into a block of its own, without locking, and writes the block to
+ * the file when it reaches the configured size, or when the flush interval has passed since the
+ * block's first entry.
+ */
+class ColumnarFileAccessLog : public Common::ImplBase {
+public:
+  ColumnarFileAccessLog(
+      const envoy::extensions::access_loggers::columnar_file::v3alpha::ColumnarFileAccessLog&
+          config,
+      AccessLog::FilterPtr&& filter, AccessLog::AccessLogManager& log_manager,
+      ThreadLocal::SlotAllocator& tls);
+
+private:
+  struct Column {
+    ColumnType type_;
+    // Set if the column's format is a single command operator or a plain string.
+    Formatter::FormatterProviderPtr provider_;
+    // Set otherwise, for string columns.
+    Formatter::FormatterPtr formatter_;
+  };
+
+  // The configuration of the log. It is shared with the workers' blocks, which may be destroyed
+  // after the log.
+  struct Config {
+    std::vector<Column> columns_;
+    Schema schema_;
+    BlockCompression compression_;
+    uint64_t block_size_;
+    std::chrono::milliseconds block_flush_interval_;
+    AccessLog::AccessLogFileSharedPtr log_file_;
+  };
+  using ConfigConstSharedPtr = std::shared_ptr<const Config>;
+
+  struct ThreadLocalBlock : public ThreadLocal::ThreadLocalObject {
+    ThreadLocalBlock(ConfigConstSharedPtr config, Event::Dispatcher& dispatcher);
+    // Writes the block's entries, so none are lost when the log is removed.
+    ~ThreadLocalBlock() override;
+
+    void flush();
+
+    const ConfigConstSharedPtr config_;
+    BlockEncoder encoder_;
+    std::string block_;
+    const Event::TimerPtr flush_timer_;
+  };
+
+  static ConfigConstSharedPtr createConfig(
+      const envoy::extensions::access_loggers::columnar_file::v3alpha::ColumnarFileAccessLog&
+          config,
+      AccessLog::AccessLogManager& log_manager);
+
+  // Common::ImplBase
+  void emitLog(const Http::RequestHeaderMap& request_headers,
+               const Http::ResponseHeaderMap& response_headers,
+               const Http::ResponseTrailerMap& response_trailers,
+               const StreamInfo::StreamInfo& stream_info) override;
+
+  const ConfigConstSharedPtr config_;
+  ThreadLocal::TypedSlot<ThreadLocalBlock> tls_slot_;
+};
+
+} // namespace ColumnarFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,45 @@
+#include "source/extensions/access_loggers/columnar_file/config.h"
+
+#include <memory>
+
+#include "envoy/extensions/access_loggers/columnar_file/v3alpha/columnar_file.pb.h"
+#include "envoy/extensions/access_loggers/columnar_file/v3alpha/columnar_file.pb.validate.h"
+#include "envoy/registry/registry.h"
+#include "envoy/server/filter_config.h"
+
+#include "source/common/protobuf/protobuf.h"
+#include "source/extensions/access_loggers/columnar_file/columnar_file_access_log_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace ColumnarFile {
+
+AccessLog::InstanceSharedPtr ColumnarFileAccessLogFactory::createAccessLogInstance(
+    const Protobuf::Message& config, AccessLog::FilterPtr&& filter,
+    Server::Configuration::CommonFactoryContext& context) {
+  const auto& proto_config = MessageUtil::downcastAndValidate<
+      const envoy::extensions::access_loggers::columnar_file::v3alpha::ColumnarFileAccessLog&>(
+      config, context.messageValidationVisitor());
+  return std::make_shared<ColumnarFileAccessLog>(proto_config, std::move(filter),
+                                                 context.accessLogManager(), context.threadLocal());
+}
+
+ProtobufTypes::MessagePtr ColumnarFileAccessLogFactory::createEmptyConfigProto() {
+  return std::make_unique<
+      envoy::extensions::access_loggers::columnar_file::v3alpha::ColumnarFileAccessLog>();
+}
+
+std::string ColumnarFileAccessLogFactory::name() const {
+  return "envoy.access_loggers.columnar_file";
+}
+
+/**
+ * Static registration for the columnar file access log. @see RegisterFactory.
+ */
+REGISTER_FACTORY(ColumnarFileAccessLogFactory, Server::Configuration::AccessLogInstanceFactory);
+
+} // namespace ColumnarFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
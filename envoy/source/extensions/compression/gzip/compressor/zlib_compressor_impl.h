@@ -82,6 +82,12 @@ public:
   void init(CompressionLevel level, CompressionStrategy strategy, int64_t window_bits,
             uint64_t memory_level);
 
+  /**
+   * Starts a new stream with the parameters given to init, discarding any data compressed but not
+   * yet finished. This reuses the compressor's memory, which is cheaper than creating a new one.
+   */
+  void reset();
+
   // Compression::Compressor::Compressor
   void compress(Buffer::Instance& buffer, Envoy::Compression::Compressor::State state) override;
 
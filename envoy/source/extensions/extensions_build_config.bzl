@@ -4,6 +4,7 @@ EXTENSIONS = {
     # Access loggers
     #
 
+    "envoy.access_loggers.columnar_file":               "//source/extensions/access_loggers/columnar_file:config",
     "envoy.access_loggers.file":                        "//source/extensions/access_loggers/file:config",
     "envoy.access_loggers.http_grpc":                   "//source/extensions/access_loggers/grpc:http_config",
     "envoy.access_loggers.tcp_grpc":                    "//source/extensions/access_loggers/grpc:tcp_config",
@@ -214,6 +215,8 @@ EXTENSIONS = {
     #
     # CacheFilter plugins
     #
+    "envoy.cache.disk_http_cache":                      "//source/extensions/filters/http/cache/disk_http_cache:config",
+    "envoy.cache.memory_http_cache":                    "//source/extensions/filters/http/cache/memory_http_cache:config",
     "envoy.cache.simple_http_cache":                    "//source/extensions/filters/http/cache/simple_http_cache:config",
 
     #
@@ -257,6 +260,7 @@ EXTENSIONS = {
     # IO socket
     #
 
+    "envoy.io_socket.io_uring":                         "//source/extensions/io_socket/io_uring:config",
     "envoy.io_socket.user_space":                       "//source/extensions/io_socket/user_space:config",
 
     #
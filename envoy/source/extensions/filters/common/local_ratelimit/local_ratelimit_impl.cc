@@ -13,22 +13,16 @@ LocalRateLimiterImpl::LocalRateLimiterImpl(
     const uint32_t tokens_per_fill, Event::Dispatcher& dispatcher,
     const Protobuf::RepeatedPtrField<
         envoy::extensions::common::ratelimit::v3::LocalRateLimitDescriptor>& descriptors)
-    : fill_timer_(fill_interval > std::chrono::milliseconds(0)
-                      ? dispatcher.createTimer([this] { onFillTimer(); })
-                      : nullptr),
-      time_source_(dispatcher.timeSource()) {
-  if (fill_timer_ && fill_interval < std::chrono::milliseconds(50)) {
+    : time_source_(dispatcher.timeSource()), start_time_(time_source_.monotonicTime()),
+      tokens_(max_tokens) {
+  if (fill_interval > std::chrono::milliseconds(0) &&
+      fill_interval < std::chrono::milliseconds(50)) {
     throw EnvoyException("local rate limit token bucket fill timer must be >= 50ms");
   }
 
   token_bucket_.max_tokens_ = max_tokens;
   token_bucket_.tokens_per_fill_ = tokens_per_fill;
   token_bucket_.fill_interval_ = absl::FromChrono(fill_interval);
-  tokens_.tokens_ = max_tokens;
-
-  if (fill_timer_) {
-    fill_timer_->enableTimer(fill_interval);
-  }
 
   for (const auto& descriptor : descriptors) {
     LocalDescriptorImpl new_descriptor;
@@ -46,11 +40,7 @@ LocalRateLimiterImpl::LocalRateLimiterImpl(
     token_bucket.tokens_per_fill_ =
         PROTOBUF_GET_WRAPPED_OR_DEFAULT(descriptor.token_bucket(), tokens_per_fill, 1);
     new_descriptor.token_bucket_ = token_bucket;
-
-    auto token_state = std::make_unique<TokenState>();
-    token_state->tokens_ = token_bucket.max_tokens_;
-    token_state->fill_time_ = time_source_.monotonicTime();
-    new_descriptor.token_state_ = std::move(token_state);
+    new_descriptor.token_state_ = std::make_unique<TokenState>(token_bucket.max_tokens_);
 
     auto result = descriptors_.emplace(std::move(new_descriptor));
     if (!result.second) {
@@ -60,66 +50,52 @@ LocalRateLimiterImpl::LocalRateLimiterImpl(
   }
 }
 
-LocalRateLimiterImpl::~LocalRateLimiterImpl() {
-  if (fill_timer_ != nullptr) {
-    fill_timer_->disableTimer();
+uint32_t LocalRateLimiterImpl::fillIndex(const RateLimit::TokenBucket& bucket) const {
+  // A bucket without a fill interval is never refilled.
+  if (bucket.fill_interval_ == absl::ZeroDuration()) {
+    return 0;
   }
+  const auto elapsed = absl::FromChrono(time_source_.monotonicTime() - start_time_);
+  // The index wraps around, which requestAllowedHelper() allows for.
+  return static_cast<uint32_t>(elapsed / bucket.fill_interval_);
 }
 
-void LocalRateLimiterImpl::onFillTimer() {
-  onFillTimerHelper(tokens_, token_bucket_);
-  onFillTimerDescriptorHelper();
-  fill_timer_->enableTimer(absl::ToChronoMilliseconds(token_bucket_.fill_interval_));
-}
+bool LocalRateLimiterImpl::requestAllowedHelper(const TokenState& tokens,
+                                                const RateLimit::TokenBucket& bucket) const {
+  // A thread may read the time before another thread that then updates the bucket first, in which
+  // case the bucket's fill index is slightly ahead of the thread's. Differences of up to this many
+  // intervals are taken to be such races rather than a wrapped around index.
+  static constexpr uint32_t MaxStaleFillIntervals = 1024;
 
-void LocalRateLimiterImpl::onFillTimerHelper(const TokenState& tokens,
-                                             const RateLimit::TokenBucket& bucket) {
+  const uint32_t fill_index = fillIndex(bucket);
   // Relaxed consistency is used for all operations because we don't care about ordering, just the
   // final atomic correctness.
-  uint32_t expected_tokens = tokens.tokens_.load(std::memory_order_relaxed);
-  uint32_t new_tokens_value;
+  uint64_t expected_state = tokens.state_.load(std::memory_order_relaxed);
+  uint64_t new_state;
   do {
-    // expected_tokens is either initialized above or reloaded during the CAS failure below.
-    new_tokens_value = std::min(bucket.max_tokens_, expected_tokens + bucket.tokens_per_fill_);
-
-    // Testing hook.
-    synchronizer_.syncPoint("on_fill_timer_pre_cas");
-
-    // Loop while the weak CAS fails trying to update the tokens value.
-  } while (!tokens.tokens_.compare_exchange_weak(expected_tokens, new_tokens_value,
-                                                 std::memory_order_relaxed));
-}
-
-void LocalRateLimiterImpl::onFillTimerDescriptorHelper() {
-  auto current_time = time_source_.monotonicTime();
-  for (const auto& descriptor : descriptors_) {
-    if (std::chrono::duration_cast<std::chrono::milliseconds>(
-            current_time - descriptor.token_state_->fill_time_) >=
-        absl::ToChronoMilliseconds(descriptor.token_bucket_.fill_interval_)) {
-      onFillTimerHelper(*descriptor.token_state_, descriptor.token_bucket_);
-      descriptor.token_state_->fill_time_ = current_time;
+    // expected_state is either initialized above or reloaded during the CAS failure below.
+    uint64_t available_tokens = expected_state >> 32;
+    uint32_t state_fill_index = static_cast<uint32_t>(expected_state);
+    const uint32_t fills = fill_index - state_fill_index;
+    if (fills != 0 && fills <= UINT32_MAX - MaxStaleFillIntervals) {
+      // Both factors fit in 32 bits, so neither this nor the sum overflows.
+      const uint64_t added_tokens = static_cast<uint64_t>(fills) * bucket.tokens_per_fill_;
+      available_tokens = std::min<uint64_t>(bucket.max_tokens_, available_tokens + added_tokens);
+      state_fill_index = fill_index;
     }
-  }
-}
-
-bool LocalRateLimiterImpl::requestAllowedHelper(const TokenState& tokens) const {
-  // Relaxed consistency is used for all operations because we don't care about ordering, just the
-  // final atomic correctness.
-  uint32_t expected_tokens = tokens.tokens_.load(std::memory_order_relaxed);
-  do {
-    // expected_tokens is either initialized above or reloaded during the CAS failure below.
-    if (expected_tokens == 0) {
+    if (available_tokens == 0) {
       return false;
     }
+    new_state = packTokenState(available_tokens - 1, state_fill_index);
 
     // Testing hook.
     synchronizer_.syncPoint("allowed_pre_cas");
 
-    // Loop while the weak CAS fails trying to subtract 1 from expected.
-  } while (!tokens.tokens_.compare_exchange_weak(expected_tokens, expected_tokens - 1,
-                                                 std::memory_order_relaxed));
+    // Loop while the weak CAS fails trying to take a token, and possibly refill the bucket.
+  } while (!tokens.state_.compare_exchange_weak(expected_state, new_state,
+                                                std::memory_order_relaxed));
 
-  // We successfully decremented the counter by 1.
+  // We successfully took a token.
   return true;
 }
 
@@ -129,11 +105,11 @@ bool LocalRateLimiterImpl::requestAllowed(
     for (const auto& request_descriptor : request_descriptors) {
       auto it = descriptors_.find(request_descriptor);
       if (it != descriptors_.end()) {
-        return requestAllowedHelper(*it->token_state_);
+        return requestAllowedHelper(*it->token_state_, it->token_bucket_);
       }
     }
   }
-  return requestAllowedHelper(tokens_);
+  return requestAllowedHelper(tokens_, token_bucket_);
 }
 
 } // namespace LocalRateLimit
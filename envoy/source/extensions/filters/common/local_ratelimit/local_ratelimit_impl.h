@@ -2,8 +2,8 @@
 
 #include <chrono>
 
+#include "envoy/common/time.h"
 #include "envoy/event/dispatcher.h"
-#include "envoy/event/timer.h"
 #include "envoy/extensions/common/ratelimit/v3/ratelimit.pb.h"
 #include "envoy/ratelimit/ratelimit.h"
 
@@ -16,6 +16,11 @@ namespace Filters {
 namespace Common {
 namespace LocalRateLimit {
 
+/**
+ * Token bucket rate limiter, shared by all the threads that use it. Buckets are refilled lazily
+ * by the first request after each fill interval, rather than by a timer, so idle descriptors cost
+ * nothing and a request takes and refills tokens with a single compare-and-swap.
+ */
 class LocalRateLimiterImpl {
 public:
   LocalRateLimiterImpl(
@@ -23,14 +28,17 @@ public:
       const uint32_t tokens_per_fill, Event::Dispatcher& dispatcher,
       const Protobuf::RepeatedPtrField<
           envoy::extensions::common::ratelimit::v3::LocalRateLimitDescriptor>& descriptors);
-  ~LocalRateLimiterImpl();
 
   bool requestAllowed(absl::Span<const RateLimit::LocalDescriptor> request_descriptors) const;
 
 private:
+  // The tokens of a bucket in the upper 32 bits, and in the lower 32 bits the index of the fill
+  // interval, counted from the limiter's creation, that the tokens were last filled in. Keeping
+  // both in one word lets a request refill the bucket and take a token in the same CAS.
   struct TokenState {
-    mutable std::atomic<uint32_t> tokens_;
-    MonotonicTime fill_time_;
+    explicit TokenState(uint32_t tokens) : state_(packTokenState(tokens, 0)) {}
+
+    mutable std::atomic<uint64_t> state_;
   };
   struct LocalDescriptorImpl : public RateLimit::LocalDescriptor {
     std::unique_ptr<TokenState> token_state_;
@@ -58,14 +66,15 @@ private:
     }
   };
 
-  void onFillTimer();
-  void onFillTimerHelper(const TokenState& state, const RateLimit::TokenBucket& bucket);
-  void onFillTimerDescriptorHelper();
-  bool requestAllowedHelper(const TokenState& tokens) const;
+  static uint64_t packTokenState(uint32_t tokens, uint32_t fill_index) {
+    return (static_cast<uint64_t>(tokens) << 32) | fill_index;
+  }
+  uint32_t fillIndex(const RateLimit::TokenBucket& bucket) const;
+  bool requestAllowedHelper(const TokenState& tokens, const RateLimit::TokenBucket& bucket) const;
 
   RateLimit::TokenBucket token_bucket_;
-  const Event::TimerPtr fill_timer_;
   TimeSource& time_source_;
+  const MonotonicTime start_time_;
   TokenState tokens_;
   absl::flat_hash_set<LocalDescriptorImpl, LocalDescriptorHash, LocalDescriptorEqual> descriptors_;
   mutable Thread::ThreadSynchronizer synchronizer_; // Used for testing only.
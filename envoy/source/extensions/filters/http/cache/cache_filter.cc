@@ -2,6 +2,7 @@
 
 #include "envoy/http/header_map.h"
 
+#include "source/common/buffer/buffer_impl.h"
 #include "source/common/common/enum_to_int.h"
 #include "source/common/http/headers.h"
 #include "source/common/http/utility.h"
@@ -31,12 +32,20 @@ using CacheResponseCodeDetails = ConstSingleton<CacheResponseCodeDetailValues>;
 
 CacheFilter::CacheFilter(
     const envoy::extensions::filters::http::cache::v3alpha::CacheConfig& config, const std::string&,
-    Stats::Scope&, TimeSource& time_source, HttpCache& http_cache)
+    Stats::Scope&, TimeSource& time_source, HttpCache& http_cache,
+    CollapsedForwarderSharedPtr collapsed_forwarder)
     : time_source_(time_source), cache_(http_cache),
-      vary_allow_list_(config.allowed_vary_headers()) {}
+      vary_allow_list_(config.allowed_vary_headers()),
+      collapsed_forwarder_(std::move(collapsed_forwarder)) {}
 
 void CacheFilter::onDestroy() {
   filter_state_ = FilterState::Destroyed;
+  if (filler_response_) {
+    finishFilling(/*abandon=*/true);
+  }
+  if (followed_response_) {
+    stopFollowing();
+  }
   if (lookup_) {
     lookup_->onDestroy();
   }
@@ -65,6 +74,10 @@ Http::FilterHeadersStatus CacheFilter::decodeHeaders(Http::RequestHeaderMap& hea
   LookupRequest lookup_request(headers, time_source_.systemTime(), vary_allow_list_);
   request_allows_inserts_ = !lookup_request.requestCacheControl().no_store_;
   is_head_request_ = headers.getMethodValue() == Http::Headers::get().MethodValues.Head;
+  if (collapsed_forwarder_ && request_allows_inserts_ && !is_head_request_ &&
+      headers.get(Http::Headers::get().Range).empty()) {
+    collapse_key_ = lookup_request.key().SerializeAsString();
+  }
   lookup_ = cache_.makeLookupContext(std::move(lookup_request));
 
   ASSERT(lookup_);
@@ -101,14 +114,27 @@ Http::FilterHeadersStatus CacheFilter::encodeHeaders(Http::ResponseHeaderMap& he
 
   // Either a cache miss or a cache entry that is no longer valid.
   // Check if the new response can be cached.
-  if (request_allows_inserts_ && !is_head_request_ &&
-      CacheabilityUtils::isCacheableResponse(headers, vary_allow_list_)) {
+  const bool cacheable = request_allows_inserts_ && !is_head_request_ &&
+                         CacheabilityUtils::isCacheableResponse(headers, vary_allow_list_);
+  if (cacheable) {
     ENVOY_STREAM_LOG(debug, "CacheFilter::encodeHeaders inserting headers", *encoder_callbacks_);
     insert_ = cache_.makeInsertContext(std::move(lookup_));
     // Add metadata associated with the cached response. Right now this is only response_time;
     const ResponseMetadata metadata = {time_source_.systemTime()};
     insert_->insertHeaders(headers, metadata, end_stream);
   }
+  if (filler_response_) {
+    // Followers only share responses that could have been served to them from cache. Responses
+    // that vary would have to be matched against each follower's request headers.
+    if (!cacheable || VaryHeaderUtils::hasVary(headers)) {
+      finishFilling(/*abandon=*/true);
+    } else {
+      filler_response_->publishHeaders(headers, end_stream);
+      if (end_stream) {
+        finishFilling(/*abandon=*/false);
+      }
+    }
+  }
   return Http::FilterHeadersStatus::Continue;
 }
 
@@ -128,9 +154,31 @@ Http::FilterDataStatus CacheFilter::encodeData(Buffer::Instance& data, bool end_
     insert_->insertBody(
         data, [](bool) {}, end_stream);
   }
+  if (filler_response_) {
+    if (filler_response_->publishBody(data, end_stream)) {
+      // Requests that arrive from now on couldn't be served the start of the body, so they have to
+      // be forwarded on their own.
+      ENVOY_STREAM_LOG(debug, "CacheFilter::encodeData collapsed response buffer is full",
+                       *encoder_callbacks_);
+      collapsed_forwarder_->stats().buffer_overflow_.inc();
+      collapsed_forwarder_->release(collapse_key_, *filler_response_);
+    }
+    if (end_stream) {
+      finishFilling(/*abandon=*/false);
+    }
+  }
   return Http::FilterDataStatus::Continue;
 }
 
+Http::FilterTrailersStatus CacheFilter::encodeTrailers(Http::ResponseTrailerMap&) {
+  if (filler_response_) {
+    // Trailers are not cached, so followers end their response without them.
+    filler_response_->publishBody(Buffer::OwnedImpl(), true);
+    finishFilling(/*abandon=*/false);
+  }
+  return Http::FilterTrailersStatus::Continue;
+}
+
 void CacheFilter::getHeaders(Http::RequestHeaderMap& request_headers) {
   ASSERT(lookup_, "CacheFilter is trying to call getHeaders with no LookupContext");
 
@@ -290,6 +338,10 @@ void CacheFilter::onHeaders(LookupResult&& result, Http::RequestHeaderMap& reque
     // No need to continue the decoding stream as a cached response is already being served.
     return;
   }
+  if (collapse()) {
+    // The request waits for the response of another request for the same key.
+    return;
+  }
   // decodeHeaders returned StopIteration waiting for this callback -- continue decoding
   decoder_callbacks_->continueDecoding();
 }
@@ -391,6 +443,12 @@ void CacheFilter::processSuccessfulValidation(Http::ResponseHeaderMap& response_
     cache_.updateHeaders(*lookup_, response_headers, metadata);
   }
 
+  if (filler_response_) {
+    // Followers that are validating the same cached response serve it with the same headers.
+    filler_response_->publishValidated(response_headers);
+    finishFilling(/*abandon=*/false);
+  }
+
   // A cache entry was successfully validated -> encode cached body and trailers.
   encodeCachedResponse();
 }
@@ -493,6 +551,163 @@ void CacheFilter::finalizeEncodingCachedResponse() {
   filter_state_ = FilterState::ResponseServedFromCache;
 }
 
+bool CacheFilter::collapse() {
+  if (collapse_key_.empty() ||
+      (lookup_result_ && VaryHeaderUtils::hasVary(*lookup_result_->headers_))) {
+    return false;
+  }
+  auto [response, is_filler] = collapsed_forwarder_->join(collapse_key_);
+  if (is_filler) {
+    ENVOY_STREAM_LOG(debug, "CacheFilter::collapse forwarding for collapsed requests",
+                     *decoder_callbacks_);
+    filler_response_ = std::move(response);
+    return false;
+  }
+
+  ENVOY_STREAM_LOG(debug, "CacheFilter::collapse waiting for collapsed response",
+                   *decoder_callbacks_);
+  collapsed_forwarder_->stats().collapsed_.inc();
+  followed_response_ = std::move(response);
+  // The response may be published on another worker, so the notification is posted to this
+  // filter's dispatcher. As with cache callbacks, the filter may be gone by the time it runs.
+  follower_id_ = followed_response_->subscribe(decoder_callbacks_->dispatcher(),
+                                               collapsedResponseUpdateCallback());
+  decoder_callbacks_->addDownstreamWatermarkCallbacks(*this);
+  collapsed_wait_timer_ =
+      decoder_callbacks_->dispatcher().createTimer([this]() { onCollapsedWaitTimeout(); });
+  collapsed_wait_timer_->enableTimer(collapsed_forwarder_->waitTimeout());
+  // The response may have arrived already.
+  onCollapsedResponseUpdate();
+  return true;
+}
+
+std::function<void()> CacheFilter::collapsedResponseUpdateCallback() {
+  CacheFilterWeakPtr self = weak_from_this();
+  return [self]() {
+    if (CacheFilterSharedPtr cache_filter = self.lock()) {
+      cache_filter->onCollapsedResponseUpdate();
+    }
+  };
+}
+
+void CacheFilter::onAboveWriteBufferHighWatermark() { collapsed_high_watermark_calls_++; }
+
+void CacheFilter::onBelowWriteBufferLowWatermark() {
+  ASSERT(collapsed_high_watermark_calls_ > 0);
+  collapsed_high_watermark_calls_--;
+  if (collapsed_high_watermark_calls_ == 0 && followed_response_) {
+    // Serve what arrived while the downstream was backed up. This is called while the connection
+    // is writing, so the body is not encoded right away.
+    decoder_callbacks_->dispatcher().post(collapsedResponseUpdateCallback());
+  }
+}
+
+void CacheFilter::onCollapsedResponseUpdate() {
+  if (filter_state_ == FilterState::Destroyed || !followed_response_) {
+    return;
+  }
+  if (collapsed_headers_served_ && collapsed_high_watermark_calls_ > 0) {
+    // The rest of the response stays with the filler until the downstream has drained.
+    return;
+  }
+  CollapsedResponse::Update update =
+      followed_response_->read(follower_id_, !collapsed_headers_served_);
+  switch (update.state_) {
+  case CollapsedResponse::State::Pending:
+    return;
+  case CollapsedResponse::State::Abandoned:
+    stopFollowing();
+    if (collapsed_headers_served_) {
+      // Part of the response has been served already, so the request can't be retried.
+      decoder_callbacks_->resetStream();
+      return;
+    }
+    ENVOY_STREAM_LOG(debug, "CacheFilter::onCollapsedResponseUpdate collapsed response abandoned",
+                     *decoder_callbacks_);
+    collapsed_forwarder_->stats().abandoned_.inc();
+    decoder_callbacks_->continueDecoding();
+    return;
+  case CollapsedResponse::State::Validated:
+    stopFollowing();
+    if (filter_state_ != FilterState::ValidatingCachedResponse) {
+      // The request has no cached response of its own to serve.
+      decoder_callbacks_->continueDecoding();
+      return;
+    }
+    lookup_result_->headers_ = std::move(update.headers_);
+    filter_state_ = FilterState::DecodeServingFromCache;
+    encodeCachedResponse();
+    return;
+  case CollapsedResponse::State::Streaming:
+  case CollapsedResponse::State::Complete:
+    break;
+  }
+
+  const bool complete = update.state_ == CollapsedResponse::State::Complete;
+  if (complete) {
+    stopFollowing();
+  }
+  if (!collapsed_headers_served_) {
+    ASSERT(update.headers_);
+    collapsed_headers_served_ = true;
+    if (collapsed_wait_timer_) {
+      collapsed_wait_timer_->disableTimer();
+    }
+    filter_state_ = FilterState::DecodeServingFromCache;
+    decoder_callbacks_->streamInfo().setResponseFlag(
+        StreamInfo::ResponseFlag::ResponseFromCacheFilter);
+    decoder_callbacks_->streamInfo().setResponseCodeDetails(
+        CacheResponseCodeDetails::get().ResponseFromCacheFilter);
+    const bool end_stream = complete && update.body_->length() == 0;
+    decoder_callbacks_->encodeHeaders(std::move(update.headers_), end_stream,
+                                      CacheResponseCodeDetails::get().ResponseFromCacheFilter);
+    if (filter_state_ == FilterState::Destroyed) {
+      return;
+    }
+    if (end_stream) {
+      filter_state_ = FilterState::ResponseServedFromCache;
+      return;
+    }
+  }
+  if (update.body_->length() > 0 || complete) {
+    decoder_callbacks_->encodeData(*update.body_, complete);
+  }
+  if (complete && filter_state_ != FilterState::Destroyed) {
+    filter_state_ = FilterState::ResponseServedFromCache;
+  }
+}
+
+void CacheFilter::onCollapsedWaitTimeout() {
+  if (!followed_response_ || collapsed_headers_served_) {
+    return;
+  }
+  ENVOY_STREAM_LOG(debug, "CacheFilter::onCollapsedWaitTimeout forwarding collapsed request",
+                   *decoder_callbacks_);
+  stopFollowing();
+  collapsed_forwarder_->stats().wait_timeout_.inc();
+  decoder_callbacks_->continueDecoding();
+}
+
+void CacheFilter::stopFollowing() {
+  ASSERT(followed_response_);
+  followed_response_->unsubscribe(follower_id_);
+  followed_response_.reset();
+  decoder_callbacks_->removeDownstreamWatermarkCallbacks(*this);
+  collapsed_high_watermark_calls_ = 0;
+  if (collapsed_wait_timer_) {
+    collapsed_wait_timer_->disableTimer();
+  }
+}
+
+void CacheFilter::finishFilling(bool abandon) {
+  ASSERT(filler_response_);
+  collapsed_forwarder_->release(collapse_key_, *filler_response_);
+  if (abandon) {
+    filler_response_->abandon();
+  }
+  filler_response_.reset();
+}
+
 } // namespace Cache
 } // namespace HttpFilters
 } // namespace Extensions
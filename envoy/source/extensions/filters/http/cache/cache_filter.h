@@ -9,6 +9,7 @@
 
 #include "source/common/common/logger.h"
 #include "source/extensions/filters/http/cache/cache_headers_utils.h"
+#include "source/extensions/filters/http/cache/collapsed_forwarding.h"
 #include "source/extensions/filters/http/cache/http_cache.h"
 #include "source/extensions/filters/http/common/pass_through_filter.h"
 
@@ -21,12 +22,13 @@ namespace Cache {
  * A filter that caches responses and attempts to satisfy requests from cache.
  */
 class CacheFilter : public Http::PassThroughFilter,
+                    public Http::DownstreamWatermarkCallbacks,
                     public Logger::Loggable<Logger::Id::cache_filter>,
                     public std::enable_shared_from_this<CacheFilter> {
 public:
   CacheFilter(const envoy::extensions::filters::http::cache::v3alpha::CacheConfig& config,
               const std::string& stats_prefix, Stats::Scope& scope, TimeSource& time_source,
-              HttpCache& http_cache);
+              HttpCache& http_cache, CollapsedForwarderSharedPtr collapsed_forwarder = nullptr);
   // Http::StreamFilterBase
   void onDestroy() override;
   // Http::StreamDecoderFilter
@@ -36,6 +38,10 @@ public:
   Http::FilterHeadersStatus encodeHeaders(Http::ResponseHeaderMap& headers,
                                           bool end_stream) override;
   Http::FilterDataStatus encodeData(Buffer::Instance& buffer, bool end_stream) override;
+  Http::FilterTrailersStatus encodeTrailers(Http::ResponseTrailerMap& trailers) override;
+  // Http::DownstreamWatermarkCallbacks
+  void onAboveWriteBufferHighWatermark() override;
+  void onBelowWriteBufferLowWatermark() override;
 
 private:
   // Utility functions; make any necessary checks and call the corresponding lookup_ functions
@@ -74,6 +80,24 @@ private:
   // Updates filter_state_ and continues the encoding stream if necessary.
   void finalizeEncodingCachedResponse();
 
+  // Called when the cache lookup didn't find a usable response. Makes the request a follower of
+  // the response another request for the same key is fetching, or the filler of a new one.
+  // Returns true if the request is a follower, in which case it must not be forwarded upstream.
+  bool collapse();
+
+  // Serves the part of the followed response that hasn't been served yet, or forwards the request
+  // upstream if the response can't be shared. Doesn't serve more of the body while the downstream
+  // is above its write buffer high watermark.
+  void onCollapsedResponseUpdate();
+  // Returns a callback that calls onCollapsedResponseUpdate() unless the filter is gone.
+  std::function<void()> collapsedResponseUpdateCallback();
+  void onCollapsedWaitTimeout();
+  void stopFollowing();
+
+  // Precondition: the filter is the filler of a collapsed response.
+  // Removes the response from the CollapsedForwarder, abandoning it first if requested.
+  void finishFilling(bool abandon);
+
   TimeSource& time_source_;
   HttpCache& cache_;
   LookupContextPtr lookup_;
@@ -99,13 +123,30 @@ private:
   // https://httpwg.org/specs/rfc7234.html#response.cacheability
   bool request_allows_inserts_ = false;
 
+  // Set if collapsed forwarding is configured.
+  const CollapsedForwarderSharedPtr collapsed_forwarder_;
+  // The serialized key of the lookup, if the request may be collapsed.
+  std::string collapse_key_;
+  // Set while the request is the filler of a collapsed response.
+  CollapsedResponseSharedPtr filler_response_;
+  // Set while the request is a follower of a collapsed response.
+  CollapsedResponseSharedPtr followed_response_;
+  uint64_t follower_id_ = 0;
+  Event::TimerPtr collapsed_wait_timer_;
+  // True once the followed response's headers have been served.
+  bool collapsed_headers_served_ = false;
+  // The number of downstream high watermark calls not yet matched by low watermark calls, while
+  // the request is a follower.
+  uint32_t collapsed_high_watermark_calls_ = 0;
+
   enum class FilterState {
     Initial,
 
     // Cache lookup found a cached response that requires validation
     ValidatingCachedResponse,
 
-    // Cache lookup found a fresh cached response and it is being added to the encoding stream.
+    // Cache lookup found a fresh cached response, or a collapsed response has arrived, and it is
+    // being added to the encoding stream.
     DecodeServingFromCache,
 
     // A cached response was successfully validated and it is being added to the encoding stream
@@ -0,0 +1,164 @@
+#include "source/extensions/filters/http/cache/collapsed_forwarding.h"
+
+#include <algorithm>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/http/header_map_impl.h"
+#include "source/common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+// Serves the end of a body chunk without copying it. The fragment keeps the chunk alive until the
+// buffer it was added to is done with it.
+class ChunkFragment : public Buffer::BufferFragment {
+public:
+  ChunkFragment(std::shared_ptr<const std::string> chunk, uint64_t begin)
+      : chunk_(std::move(chunk)), begin_(begin) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return chunk_->data() + begin_; }
+  size_t size() const override { return chunk_->size() - begin_; }
+  void done() override { delete this; }
+
+private:
+  const std::shared_ptr<const std::string> chunk_;
+  const uint64_t begin_;
+};
+
+} // namespace
+
+void CollapsedResponse::publishHeaders(const Http::ResponseHeaderMap& headers, bool end_stream) {
+  absl::MutexLock lock(&mutex_);
+  ASSERT(state_ == State::Pending);
+  headers_ = Http::createHeaderMap<Http::ResponseHeaderMapImpl>(headers);
+  update(end_stream ? State::Complete : State::Streaming);
+}
+
+bool CollapsedResponse::publishBody(const Buffer::Instance& data, bool end_stream) {
+  absl::MutexLock lock(&mutex_);
+  ASSERT(state_ == State::Streaming);
+  if (data.length() > 0) {
+    body_.push_back({body_end_, std::make_shared<const std::string>(data.toString())});
+    body_end_ += data.length();
+  }
+  const bool overflowed = !overflowed_ && body_end_ > max_body_bytes_;
+  overflowed_ = overflowed_ || overflowed;
+  if (overflowed_) {
+    trimBody();
+  }
+  update(end_stream ? State::Complete : State::Streaming);
+  return overflowed;
+}
+
+void CollapsedResponse::publishValidated(const Http::ResponseHeaderMap& headers) {
+  absl::MutexLock lock(&mutex_);
+  ASSERT(state_ == State::Pending);
+  headers_ = Http::createHeaderMap<Http::ResponseHeaderMapImpl>(headers);
+  update(State::Validated);
+}
+
+void CollapsedResponse::abandon() {
+  absl::MutexLock lock(&mutex_);
+  update(State::Abandoned);
+}
+
+void CollapsedResponse::update(State state) {
+  state_ = state;
+  for (const auto& subscriber : subscribers_) {
+    subscriber.second.dispatcher_.post(subscriber.second.notify_);
+  }
+}
+
+void CollapsedResponse::trimBody() {
+  uint64_t start = body_end_;
+  for (auto& [id, subscriber] : subscribers_) {
+    if (subscriber.dropped_) {
+      continue;
+    }
+    if (body_end_ - subscriber.body_offset_ > max_body_bytes_) {
+      subscriber.dropped_ = true;
+      continue;
+    }
+    start = std::min(start, subscriber.body_offset_);
+  }
+  while (!body_.empty() && body_.front().offset_ + body_.front().data_->size() <= start) {
+    body_.pop_front();
+  }
+  body_start_ = body_.empty() ? body_end_ : body_.front().offset_;
+}
+
+uint64_t CollapsedResponse::subscribe(Event::Dispatcher& dispatcher,
+                                      std::function<void()> notify) {
+  absl::MutexLock lock(&mutex_);
+  const uint64_t id = next_subscriber_id_++;
+  // A follower that joins after the start of the body has been dropped can't be served.
+  subscribers_.emplace(id, Subscriber{dispatcher, std::move(notify), 0, body_start_ > 0});
+  return id;
+}
+
+void CollapsedResponse::unsubscribe(uint64_t id) {
+  absl::MutexLock lock(&mutex_);
+  subscribers_.erase(id);
+}
+
+CollapsedResponse::Update CollapsedResponse::read(uint64_t id, bool headers) {
+  absl::MutexLock lock(&mutex_);
+  auto it = subscribers_.find(id);
+  ASSERT(it != subscribers_.end());
+  Subscriber& subscriber = it->second;
+  if (subscriber.dropped_) {
+    return {State::Abandoned, nullptr, std::make_unique<Buffer::OwnedImpl>()};
+  }
+  Update update{state_, nullptr, std::make_unique<Buffer::OwnedImpl>()};
+  if (headers && headers_ != nullptr) {
+    update.headers_ = Http::createHeaderMap<Http::ResponseHeaderMapImpl>(*headers_);
+  }
+  ASSERT(subscriber.body_offset_ >= body_start_);
+  for (const BodyChunk& chunk : body_) {
+    const uint64_t chunk_end = chunk.offset_ + chunk.data_->size();
+    if (chunk_end <= subscriber.body_offset_) {
+      continue;
+    }
+    const uint64_t begin = std::max(subscriber.body_offset_, chunk.offset_) - chunk.offset_;
+    update.body_->addBufferFragment(*new ChunkFragment(chunk.data_, begin));
+  }
+  subscriber.body_offset_ = body_end_;
+  return update;
+}
+
+CollapsedForwarder::CollapsedForwarder(
+    const envoy::extensions::filters::http::cache::v3alpha::CacheConfig::CollapsedForwarding&
+        config,
+    const std::string& stats_prefix, Stats::Scope& scope)
+    : wait_timeout_(PROTOBUF_GET_MS_OR_DEFAULT(config, wait_timeout, 5000)),
+      max_buffered_bytes_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_buffered_bytes, 1024 * 1024)),
+      stats_({ALL_COLLAPSED_FORWARDING_STATS(
+          POOL_COUNTER_PREFIX(scope, stats_prefix + "cache.collapsed_forwarding."))}) {}
+
+std::pair<CollapsedResponseSharedPtr, bool> CollapsedForwarder::join(const std::string& key) {
+  absl::MutexLock lock(&mutex_);
+  auto [it, inserted] = responses_.try_emplace(key);
+  if (inserted) {
+    it->second = std::make_shared<CollapsedResponse>(max_buffered_bytes_);
+  }
+  return {it->second, inserted};
+}
+
+void CollapsedForwarder::release(const std::string& key, const CollapsedResponse& response) {
+  absl::MutexLock lock(&mutex_);
+  auto it = responses_.find(key);
+  if (it != responses_.end() && it->second.get() == &response) {
+    responses_.erase(it);
+  }
+}
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
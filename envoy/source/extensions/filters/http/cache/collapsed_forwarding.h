@@ -0,0 +1,180 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "envoy/buffer/buffer.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/extensions/filters/http/cache/v3alpha/cache.pb.h"
+#include "envoy/http/header_map.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * All collapsed forwarding stats. @see stats_macros.h
+ */
+#define ALL_COLLAPSED_FORWARDING_STATS(COUNTER)                                                    \
+  COUNTER(collapsed)                                                                               \
+  COUNTER(abandoned)                                                                               \
+  COUNTER(buffer_overflow)                                                                         \
+  COUNTER(wait_timeout)
+
+/**
+ * Struct definition for collapsed forwarding stats. @see stats_macros.h
+ */
+struct CollapsedForwardingStats {
+  ALL_COLLAPSED_FORWARDING_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * A response that one request (the filler) is fetching from upstream, and that other requests for
+ * the same key (the followers) wait for instead of going upstream themselves. The filler publishes
+ * the response as it arrives. Followers may be on other workers, so they are notified on their own
+ * dispatchers, and then read whatever they haven't seen yet.
+ *
+ * The body is kept from the start, so that followers that join late can be served all of it, until
+ * it grows larger than max_body_bytes. After that no new followers may join, and only the chunks
+ * of the body that some follower hasn't finished reading are kept. Followers that fall more than
+ * max_body_bytes behind are dropped, so that a slow follower can't make the body grow without
+ * bound.
+ */
+class CollapsedResponse {
+public:
+  explicit CollapsedResponse(uint64_t max_body_bytes) : max_body_bytes_(max_body_bytes) {}
+
+  enum class State {
+    // The filler is waiting for the response headers.
+    Pending,
+    // The response headers have arrived, and the body is arriving.
+    Streaming,
+    // The whole response has arrived.
+    Complete,
+    // The filler's cached response was validated, and the headers are those it is served with.
+    Validated,
+    // The response can't be shared, or the follower fell too far behind. Followers that haven't
+    // started their response yet have to be forwarded upstream.
+    Abandoned
+  };
+
+  // The part of the response a follower hasn't seen yet.
+  struct Update {
+    State state_;
+    // A copy of the response headers, if they were asked for and have arrived.
+    Http::ResponseHeaderMapPtr headers_;
+    // The body the follower hasn't read yet. It refers to the published body rather than copying
+    // it.
+    Buffer::InstancePtr body_;
+  };
+
+  // Called by the filler, on its worker.
+  void publishHeaders(const Http::ResponseHeaderMap& headers, bool end_stream);
+  // Returns true if the data made the body larger than max_body_bytes. From then on the response
+  // may not take new followers.
+  bool publishBody(const Buffer::Instance& data, bool end_stream);
+  void publishValidated(const Http::ResponseHeaderMap& headers);
+  void abandon();
+
+  /**
+   * Registers a follower.
+   * @param dispatcher the follower's dispatcher, which notify is posted to.
+   * @param notify called whenever the response has made progress.
+   * @return an id for read() and unsubscribe().
+   */
+  uint64_t subscribe(Event::Dispatcher& dispatcher, std::function<void()> notify);
+  void unsubscribe(uint64_t id);
+
+  /**
+   * Returns the part of the response the follower hasn't read yet.
+   * @param id the follower's id.
+   * @param headers whether to include the response headers.
+   */
+  Update read(uint64_t id, bool headers);
+
+private:
+  // Moves to state and notifies the followers.
+  void update(State state) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Drops the chunks every follower has read, and the followers that are too far behind.
+  void trimBody() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  struct Subscriber {
+    Event::Dispatcher& dispatcher_;
+    std::function<void()> notify_;
+    // The number of body bytes the follower has read.
+    uint64_t body_offset_ = 0;
+    // Set if part of the body the follower hasn't read has been dropped.
+    bool dropped_ = false;
+  };
+
+  const uint64_t max_body_bytes_;
+  absl::Mutex mutex_;
+  State state_ ABSL_GUARDED_BY(mutex_) = State::Pending;
+  Http::ResponseHeaderMapPtr headers_ ABSL_GUARDED_BY(mutex_);
+  // A piece of the body as the filler published it. It is copied once, and shared by every follower
+  // that reads it.
+  struct BodyChunk {
+    uint64_t offset_;
+    std::shared_ptr<const std::string> data_;
+  };
+  // The body, starting at body_start_ and ending at body_end_.
+  std::deque<BodyChunk> body_ ABSL_GUARDED_BY(mutex_);
+  uint64_t body_start_ ABSL_GUARDED_BY(mutex_) = 0;
+  uint64_t body_end_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Set once the body has grown larger than max_body_bytes_.
+  bool overflowed_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::flat_hash_map<uint64_t, Subscriber> subscribers_ ABSL_GUARDED_BY(mutex_);
+  uint64_t next_subscriber_id_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+using CollapsedResponseSharedPtr = std::shared_ptr<CollapsedResponse>;
+
+/**
+ * The responses that are being fetched by fillers, by key. Shared by all workers.
+ */
+class CollapsedForwarder {
+public:
+  CollapsedForwarder(
+      const envoy::extensions::filters::http::cache::v3alpha::CacheConfig::CollapsedForwarding&
+          config,
+      const std::string& stats_prefix, Stats::Scope& scope);
+
+  /**
+   * Joins the response that is being fetched for key, or starts a new one.
+   * @return the response, and whether the caller is its filler.
+   */
+  std::pair<CollapsedResponseSharedPtr, bool> join(const std::string& key);
+
+  /**
+   * Called by the filler once its response no longer takes new followers. Requests for key that
+   * arrive later start a new response.
+   */
+  void release(const std::string& key, const CollapsedResponse& response);
+
+  std::chrono::milliseconds waitTimeout() const { return wait_timeout_; }
+  CollapsedForwardingStats& stats() { return stats_; }
+
+private:
+  const std::chrono::milliseconds wait_timeout_;
+  const uint64_t max_buffered_bytes_;
+  CollapsedForwardingStats stats_;
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, CollapsedResponseSharedPtr> responses_ ABSL_GUARDED_BY(mutex_);
+};
+
+using CollapsedForwarderSharedPtr = std::shared_ptr<CollapsedForwarder>;
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
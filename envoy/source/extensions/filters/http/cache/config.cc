@@ -18,11 +18,16 @@ Http::FilterFactoryCb CacheFilterFactory::createFilterFactoryFromProtoTyped(
         fmt::format("Didn't find a registered implementation for type: '{}'", type));
   }
 
-  return [config, stats_prefix, &context,
-          http_cache_factory](Http::FilterChainFactoryCallbacks& callbacks) -> void {
-    callbacks.addStreamFilter(std::make_shared<CacheFilter>(config, stats_prefix, context.scope(),
-                                                            context.timeSource(),
-                                                            http_cache_factory->getCache(config)));
+  HttpCacheSharedPtr cache = http_cache_factory->getCache(config, context);
+  CollapsedForwarderSharedPtr collapsed_forwarder;
+  if (config.has_collapsed_forwarding()) {
+    collapsed_forwarder = std::make_shared<CollapsedForwarder>(config.collapsed_forwarding(),
+                                                               stats_prefix, context.scope());
+  }
+  return [config, stats_prefix, &context, cache,
+          collapsed_forwarder](Http::FilterChainFactoryCallbacks& callbacks) {
+    callbacks.addStreamFilter(std::make_shared<CacheFilter>(
+        config, stats_prefix, context.scope(), context.timeSource(), *cache, collapsed_forwarder));
   };
 }
 
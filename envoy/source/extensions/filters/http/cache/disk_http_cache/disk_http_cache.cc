@@ -0,0 +1,872 @@
+#include "source/extensions/filters/http/cache/disk_http_cache/disk_http_cache.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#include "envoy/common/exception.h"
+#include "envoy/registry/registry.h"
+#include "envoy/singleton/manager.h"
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/fmt.h"
+#include "source/common/common/lock_guard.h"
+#include "source/common/common/utility.h"
+#include "source/common/filesystem/directory.h"
+#include "source/common/http/header_map_impl.h"
+#include "source/common/protobuf/protobuf.h"
+#include "source/common/protobuf/utility.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "zlib.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+constexpr uint64_t DefaultMaxSizeBytes = 1024 * 1024 * 1024;
+constexpr uint32_t DefaultSegmentSizeBytes = 64 * 1024 * 1024;
+constexpr uint32_t DefaultIndexEntries = 1024 * 1024;
+constexpr uint32_t DefaultIoThreads = 4;
+
+constexpr absl::string_view SegmentPrefix = "segment-";
+// The size of the first read of a lookup, which usually covers the key and the headers.
+constexpr uint64_t PrefixReadBytes = 4096;
+// The most a single getBody() call reads.
+constexpr uint64_t MaxBodyReadBytes = 1024 * 1024;
+// The most that is held in memory while a record is copied or verified.
+constexpr uint64_t ChunkBytes = 1024 * 1024;
+
+// Every record starts with this header, followed by the serialized key, the encoded response
+// headers, the body and a RecordTrailer.
+struct RecordHeader {
+  uint32_t magic_;
+  uint32_t key_size_;
+  uint32_t headers_size_;
+  uint32_t body_size_;
+  int64_t response_time_us_;
+};
+constexpr uint32_t RecordMagic = 0x52434845; // "EHCR"
+
+struct RecordTrailer {
+  // The size of the record up to the trailer.
+  uint32_t size_;
+  // The CRC-32 of the record up to the trailer.
+  uint32_t crc_;
+};
+
+uint32_t updateCrc(uint32_t crc, const void* data, uint64_t size) {
+  return crc32(crc, static_cast<const Bytef*>(data), static_cast<uInt>(size));
+}
+
+// Encodes headers as NUL terminated names and values. Neither may contain a NUL.
+std::string encodeHeaders(const Http::ResponseHeaderMap& headers) {
+  std::string encoded;
+  headers.iterate([&encoded](const Http::HeaderEntry& header) -> Http::HeaderMap::Iterate {
+    absl::StrAppend(&encoded, header.key().getStringView(), absl::string_view("\0", 1),
+                    header.value().getStringView(), absl::string_view("\0", 1));
+    return Http::HeaderMap::Iterate::Continue;
+  });
+  return encoded;
+}
+
+Http::ResponseHeaderMapPtr decodeHeaders(absl::string_view encoded) {
+  Http::ResponseHeaderMapPtr headers = Http::ResponseHeaderMapImpl::create();
+  while (!encoded.empty()) {
+    const size_t name_end = encoded.find('\0');
+    const size_t value_end = encoded.find('\0', name_end + 1);
+    if (name_end == absl::string_view::npos || value_end == absl::string_view::npos) {
+      return nullptr;
+    }
+    headers->addCopy(Http::LowerCaseString(encoded.substr(0, name_end)),
+                     encoded.substr(name_end + 1, value_end - name_end - 1));
+    encoded.remove_prefix(value_end + 1);
+  }
+  return headers;
+}
+
+bool preadFully(int fd, void* data, uint64_t size, uint64_t offset) {
+  auto* position = static_cast<uint8_t*>(data);
+  while (size > 0) {
+    const ssize_t rc = ::pread(fd, position, size, offset);
+    if (rc <= 0) {
+      if (rc < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    position += rc;
+    size -= rc;
+    offset += rc;
+  }
+  return true;
+}
+
+bool pwriteFully(int fd, const void* data, uint64_t size, uint64_t offset) {
+  const auto* position = static_cast<const uint8_t*>(data);
+  while (size > 0) {
+    const ssize_t rc = ::pwrite(fd, position, size, offset);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    position += rc;
+    size -= rc;
+    offset += rc;
+  }
+  return true;
+}
+
+// Returns the size of the part of the first size bytes of the segment that holds complete records.
+// Records are appended, so everything after the first one that is incomplete or corrupt is dropped
+// as well. Returns nullopt if cancelled returns true before all records have been checked.
+absl::optional<uint64_t> verifiedSize(const Segment& segment, uint64_t size,
+                                      const std::function<bool()>& cancelled) {
+  std::string chunk;
+  uint64_t offset = 0;
+  while (offset < size) {
+    if (cancelled()) {
+      return absl::nullopt;
+    }
+    RecordHeader header;
+    RecordTrailer trailer;
+    if (size - offset < sizeof(header) + sizeof(trailer) ||
+        !preadFully(segment.fd_, &header, sizeof(header), offset) ||
+        header.magic_ != RecordMagic) {
+      break;
+    }
+    const uint64_t record_size = sizeof(header) + uint64_t(header.key_size_) +
+                                 uint64_t(header.headers_size_) + uint64_t(header.body_size_);
+    if (size - offset < record_size + sizeof(trailer) ||
+        !preadFully(segment.fd_, &trailer, sizeof(trailer), offset + record_size) ||
+        trailer.size_ != record_size) {
+      break;
+    }
+    uint32_t crc = updateCrc(0, &header, sizeof(header));
+    for (uint64_t verified = sizeof(header); verified < record_size;) {
+      const uint64_t length = std::min(record_size - verified, ChunkBytes);
+      chunk.resize(length);
+      if (!preadFully(segment.fd_, chunk.data(), length, offset + verified)) {
+        return offset;
+      }
+      crc = updateCrc(crc, chunk.data(), length);
+      verified += length;
+    }
+    if (crc != trailer.crc_) {
+      break;
+    }
+    offset += record_size + sizeof(trailer);
+  }
+  return offset;
+}
+
+std::string createDirectory(const std::string& path) {
+  if (::mkdir(path.c_str(), 0700) != 0 && errno != EEXIST) {
+    throw EnvoyException(
+        fmt::format("unable to create cache directory {}: {}", path, errorDetails(errno)));
+  }
+  return path;
+}
+
+// State of a lookup that is shared with the I/O jobs it starts, as those may outlive the context.
+struct LookupState {
+  explicit LookupState(LookupRequest&& request) : request_(std::move(request)) {}
+
+  // The request refers to the filter's vary allow list, so after the lookup context has been
+  // destroyed it may only be used for the key.
+  const LookupRequest request_;
+  // Set by the getHeaders() job. The filter only reads the body or updates the headers after that
+  // job has invoked its callback.
+  absl::optional<DiskHttpCache::Record> record_;
+  Thread::MutexBasicLockable mutex_;
+  // Set once the lookup context is destroyed. No more callbacks may be invoked after that.
+  bool cancelled_ ABSL_GUARDED_BY(mutex_){};
+};
+using LookupStateSharedPtr = std::shared_ptr<LookupState>;
+
+// Returns the key of the variant of the response that matches the request, or nullopt if the
+// response may not be varied on the headers it varies on.
+absl::optional<Key> variedKey(const LookupRequest& request,
+                              const Http::ResponseHeaderMap& response_headers) {
+  const absl::btree_set<absl::string_view> vary_header_values =
+      VaryHeaderUtils::getVaryValues(response_headers);
+  ASSERT(!vary_header_values.empty());
+  const absl::optional<std::string> vary_identifier = VaryHeaderUtils::createVaryIdentifier(
+      request.varyAllowList(), vary_header_values, request.requestHeaders());
+  if (!vary_identifier.has_value()) {
+    return absl::nullopt;
+  }
+  Key varied_key = request.key();
+  varied_key.add_custom_fields(vary_identifier.value());
+  return varied_key;
+}
+
+class DiskLookupContext : public LookupContext {
+public:
+  DiskLookupContext(DiskHttpCache& cache, LookupRequest&& request)
+      : cache_(cache), state_(std::make_shared<LookupState>(std::move(request))) {}
+
+  void getHeaders(LookupHeadersCallback&& cb) override {
+    cache_.post([&cache = cache_, state = state_, cb = std::move(cb)]() {
+      absl::optional<DiskHttpCache::Record> record = cache.lookup(state->request_.key());
+      if (record.has_value() && VaryHeaderUtils::hasVary(*record->response_headers_)) {
+        absl::optional<Key> varied_key;
+        {
+          Thread::LockGuard lock(state->mutex_);
+          if (state->cancelled_) {
+            return;
+          }
+          varied_key = variedKey(state->request_, *record->response_headers_);
+        }
+        record = varied_key.has_value() ? cache.lookup(varied_key.value()) : absl::nullopt;
+      }
+
+      Thread::LockGuard lock(state->mutex_);
+      if (state->cancelled_) {
+        return;
+      }
+      state->record_ = std::move(record);
+      if (!state->record_.has_value()) {
+        cb(LookupResult{});
+        return;
+      }
+      const DiskHttpCache::Record& found = state->record_.value();
+      cb(state->request_.makeLookupResult(
+          Http::createHeaderMap<Http::ResponseHeaderMapImpl>(*found.response_headers_),
+          ResponseMetadata{found.metadata_}, found.body_size_));
+    });
+  }
+
+  void getBody(const AdjustedByteRange& range, LookupBodyCallback&& cb) override {
+    ASSERT(state_->record_.has_value());
+    ASSERT(range.end() <= state_->record_->body_size_, "Attempt to read past end of body.");
+    cache_.post([&cache = cache_, state = state_, range, cb = std::move(cb)]() {
+      Buffer::InstancePtr body = cache.readBody(state->record_.value(), range.begin(),
+                                                std::min(range.length(), MaxBodyReadBytes));
+      Thread::LockGuard lock(state->mutex_);
+      if (!state->cancelled_) {
+        cb(std::move(body));
+      }
+    });
+  }
+
+  void getTrailers(LookupTrailersCallback&&) override {
+    // Trailers are never stored, so lookups never report any for the filter to ask for.
+    NOT_IMPLEMENTED_GCOVR_EXCL_LINE;
+  }
+
+  void onDestroy() override {
+    // Waits for a callback that is being invoked to return.
+    Thread::LockGuard lock(state_->mutex_);
+    state_->cancelled_ = true;
+  }
+
+  const LookupStateSharedPtr& state() const { return state_; }
+
+private:
+  DiskHttpCache& cache_;
+  const LookupStateSharedPtr state_;
+};
+
+// A record that is waiting for an I/O thread to write it.
+struct PendingWrite {
+  PendingWrite(const Key& key, Http::ResponseHeaderMapPtr&& response_headers,
+               const ResponseMetadata& metadata)
+      : key_(key), response_headers_(std::move(response_headers)), metadata_(metadata) {}
+
+  const Key key_;
+  const Http::ResponseHeaderMapPtr response_headers_;
+  const ResponseMetadata metadata_;
+  Buffer::OwnedImpl body_;
+};
+using PendingWriteSharedPtr = std::shared_ptr<PendingWrite>;
+
+class DiskInsertContext : public InsertContext {
+public:
+  DiskInsertContext(LookupContext& lookup_context, DiskHttpCache& cache)
+      : state_(dynamic_cast<DiskLookupContext&>(lookup_context).state()), cache_(cache) {}
+
+  void insertHeaders(const Http::ResponseHeaderMap& response_headers,
+                     const ResponseMetadata& metadata, bool end_stream) override {
+    ASSERT(!committed_);
+    response_headers_ = Http::createHeaderMap<Http::ResponseHeaderMapImpl>(response_headers);
+    metadata_ = metadata;
+    if (end_stream) {
+      commit();
+    }
+  }
+
+  void insertBody(const Buffer::Instance& chunk, InsertCallback ready_for_next_chunk,
+                  bool end_stream) override {
+    ASSERT(!committed_);
+    ASSERT(ready_for_next_chunk || end_stream);
+
+    if (aborted_) {
+      return;
+    }
+    body_.add(chunk);
+    if (body_.length() > cache_.maxBodySizeBytes()) {
+      // The response would not fit into a segment, so stop buffering it.
+      aborted_ = true;
+      body_.drain(body_.length());
+      if (ready_for_next_chunk) {
+        ready_for_next_chunk(false);
+      }
+      return;
+    }
+    if (end_stream) {
+      commit();
+    } else {
+      ready_for_next_chunk(true);
+    }
+  }
+
+  void insertTrailers(const Http::ResponseTrailerMap&) override {
+    // The filter doesn't insert trailers.
+    NOT_IMPLEMENTED_GCOVR_EXCL_LINE;
+  }
+
+  void onDestroy() override {}
+
+private:
+  void commit() {
+    committed_ = true;
+    const LookupRequest& request = state_->request_;
+    Key key = request.key();
+    if (VaryHeaderUtils::hasVary(*response_headers_)) {
+      absl::optional<Key> varied_key = variedKey(request, *response_headers_);
+      if (!varied_key.has_value()) {
+        // Skip the insert if we are unable to create a vary key.
+        return;
+      }
+      // Add a special record to flag that this request generates varied responses.
+      Http::ResponseHeaderMapPtr vary_only_map =
+          Http::createHeaderMap<Http::ResponseHeaderMapImpl>({});
+      const absl::btree_set<absl::string_view> vary_header_values =
+          VaryHeaderUtils::getVaryValues(*response_headers_);
+      vary_only_map->setCopy(Http::CustomHeaders::get().Vary,
+                             absl::StrJoin(vary_header_values, ","));
+      post(std::make_shared<PendingWrite>(key, std::move(vary_only_map), ResponseMetadata{}));
+      key = std::move(varied_key.value());
+    }
+    auto write = std::make_shared<PendingWrite>(key, std::move(response_headers_), metadata_);
+    write->body_.move(body_);
+    post(std::move(write));
+  }
+
+  void post(PendingWriteSharedPtr&& write) {
+    cache_.post([&cache = cache_, write = std::move(write)]() {
+      cache.write(write->key_, *write->response_headers_, write->metadata_, write->body_);
+    });
+  }
+
+  const LookupStateSharedPtr state_;
+  DiskHttpCache& cache_;
+  Http::ResponseHeaderMapPtr response_headers_;
+  ResponseMetadata metadata_;
+  Buffer::OwnedImpl body_;
+  bool committed_ = false;
+  bool aborted_ = false;
+};
+
+} // namespace
+
+Segment::~Segment() { Api::OsSysCallsSingleton::get().close(fd_); }
+
+DiskHttpCache::DiskHttpCache(
+    const envoy::extensions::cache::disk_http_cache::v3alpha::DiskHttpCacheConfig& config,
+    Thread::ThreadFactory& thread_factory)
+    : path_(createDirectory(config.path())),
+      max_size_bytes_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_size_bytes, DefaultMaxSizeBytes)),
+      segment_size_bytes_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, segment_size_bytes, DefaultSegmentSizeBytes)),
+      index_(absl::StrCat(path_, "/index"),
+             PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, index_entries, DefaultIndexEntries)) {
+  std::vector<SegmentSharedPtr> loaded;
+  {
+    absl::MutexLock lock(&mutex_);
+    loadSegments();
+    for (const auto& segment : segments_) {
+      loaded.push_back(segment.second);
+    }
+  }
+  const uint32_t io_threads = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, io_threads, DefaultIoThreads);
+  for (uint32_t i = 0; i < io_threads; i++) {
+    io_threads_.push_back(thread_factory.createThread([this]() { ioThreadRoutine(); },
+                                                      Thread::Options{"CacheIo"}));
+  }
+  // Checking every record may take minutes for a large cache, so it is left to the I/O threads.
+  // The cache misses on the records of a segment until it has been checked.
+  for (SegmentSharedPtr& segment : loaded) {
+    post([this, segment = std::move(segment)]() { verifySegment(segment); });
+  }
+}
+
+DiskHttpCache::~DiskHttpCache() {
+  {
+    Thread::LockGuard lock(jobs_lock_);
+    shutdown_ = true;
+  }
+  jobs_event_.notifyAll();
+  for (Thread::ThreadPtr& thread : io_threads_) {
+    thread->join();
+  }
+}
+
+void DiskHttpCache::post(std::function<void()> job) {
+  {
+    Thread::LockGuard lock(jobs_lock_);
+    jobs_.push_back(std::move(job));
+  }
+  jobs_event_.notifyOne();
+}
+
+void DiskHttpCache::ioThreadRoutine() {
+  while (true) {
+    std::function<void()> job;
+    {
+      Thread::LockGuard lock(jobs_lock_);
+      while (jobs_.empty() && !shutdown_) {
+        // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
+        jobs_event_.wait(jobs_lock_);
+      }
+      // Finish queued writes before shutting down. Lookups have been cancelled by then.
+      if (jobs_.empty()) {
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    job();
+  }
+}
+
+bool DiskHttpCache::shuttingDown() {
+  Thread::LockGuard lock(jobs_lock_);
+  return shutdown_;
+}
+
+void DiskHttpCache::loadSegments() {
+  uint32_t next_segment = index_.nextSegment();
+  for (const Filesystem::DirectoryEntry& entry : Filesystem::Directory(path_)) {
+    uint32_t id;
+    if (entry.type_ != Filesystem::FileType::Regular ||
+        !absl::StartsWith(entry.name_, SegmentPrefix) ||
+        !absl::SimpleAtoi(absl::string_view(entry.name_).substr(SegmentPrefix.size()), &id)) {
+      continue;
+    }
+    const std::string path = absl::StrCat(path_, "/", entry.name_);
+    auto& os_sys_calls = Api::OsSysCallsSingleton::get();
+    struct stat stat_buf;
+    const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0 || os_sys_calls.stat(path.c_str(), &stat_buf).return_value_ != 0) {
+      ENVOY_LOG(warn, "unable to open cache segment {}: {}", path, errorDetails(errno));
+      if (fd >= 0) {
+        os_sys_calls.close(fd);
+      }
+      continue;
+    }
+    segments_.emplace(id, std::make_shared<Segment>(id, path, fd, stat_buf.st_size));
+    size_bytes_ += stat_buf.st_size;
+    next_segment = std::max(next_segment, id + 1);
+  }
+  if (index_.reset()) {
+    // The records in the segments can't be found without the index they were written with.
+    for (const auto& segment : segments_) {
+      ::unlink(segment.second->path_.c_str());
+    }
+    segments_.clear();
+    size_bytes_ = 0;
+  }
+  index_.setNextSegment(next_segment);
+  evictSegments();
+  ENVOY_LOG(info, "opened cache in {} with {} segments taking up {} bytes", path_,
+            segments_.size(), size_bytes_);
+}
+
+void DiskHttpCache::verifySegment(const SegmentSharedPtr& segment) {
+  uint64_t size;
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    // Nothing is appended to the segment until it has been verified, so its size doesn't change.
+    size = segment->size_;
+  }
+  // Records are indexed without waiting for them to reach the disk, so after a crash the index
+  // may refer to records that were not completely written.
+  const absl::optional<uint64_t> verified =
+      verifiedSize(*segment, size, [this]() { return shuttingDown(); });
+  if (!verified.has_value()) {
+    // The segment is checked again the next time the cache is opened.
+    return;
+  }
+
+  absl::MutexLock lock(&mutex_);
+  auto iter = segments_.find(segment->id_);
+  if (iter == segments_.end() || iter->second != segment) {
+    // The segment has been evicted in the meantime.
+    return;
+  }
+  if (verified.value() < size) {
+    ENVOY_LOG(warn, "dropping {} bytes of incomplete or corrupt records from cache segment {}",
+              size - verified.value(), segment->path_);
+    index_.erase(segment->id_, static_cast<uint32_t>(verified.value()));
+    // New records go where the dropped ones were. If the segment can't be truncated, new records
+    // must not be appended after the dropped ones, so it stays unverified until it is evicted.
+    const Api::SysCallIntResult result =
+        Api::OsSysCallsSingleton::get().ftruncate(segment->fd_, verified.value());
+    if (result.return_value_ != 0) {
+      ENVOY_LOG(warn, "unable to truncate cache segment {}: {}", segment->path_,
+                errorDetails(result.errno_));
+      return;
+    }
+    size_bytes_ -= size - verified.value();
+    segment->size_ = verified.value();
+  }
+  segment->verified_ = true;
+}
+
+SegmentSharedPtr DiskHttpCache::createSegment() {
+  const uint32_t id = index_.nextSegment();
+  const std::string path = absl::StrCat(path_, "/", SegmentPrefix, id);
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    ENVOY_LOG(warn, "unable to create cache segment {}: {}", path, errorDetails(errno));
+    return nullptr;
+  }
+  index_.setNextSegment(id + 1);
+  auto segment = std::make_shared<Segment>(id, path, fd, 0);
+  segment->verified_ = true;
+  segments_.emplace(id, segment);
+  return segment;
+}
+
+SegmentSharedPtr DiskHttpCache::reserve(uint64_t size, uint64_t& offset) {
+  SegmentSharedPtr segment = segments_.empty() ? nullptr : segments_.rbegin()->second;
+  if (segment == nullptr || !segment->verified_ || segment->size_ + size > segment_size_bytes_) {
+    segment = createSegment();
+    if (segment == nullptr) {
+      return nullptr;
+    }
+  }
+  offset = segment->size_;
+  segment->size_ += size;
+  size_bytes_ += size;
+  evictSegments();
+  return segment;
+}
+
+void DiskHttpCache::evictSegments() {
+  // The newest segment is never deleted, as writes may be going into it.
+  while (size_bytes_ > max_size_bytes_ && segments_.size() > 1) {
+    const SegmentSharedPtr& oldest = segments_.begin()->second;
+    ENVOY_LOG(debug, "deleting cache segment {}", oldest->path_);
+    ::unlink(oldest->path_.c_str());
+    size_bytes_ -= oldest->size_;
+    segments_.erase(segments_.begin());
+  }
+}
+
+uint32_t DiskHttpCache::oldestSegment() const {
+  return segments_.empty() ? index_.nextSegment() : segments_.begin()->first;
+}
+
+absl::optional<DiskHttpCache::Record> DiskHttpCache::lookup(const Key& key) {
+  SegmentSharedPtr segment;
+  DiskIndex::Location location;
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    const absl::optional<DiskIndex::Location> found =
+        index_.find(stableHashKey(key), oldestSegment());
+    if (!found.has_value()) {
+      return absl::nullopt;
+    }
+    auto iter = segments_.find(found->segment_);
+    if (iter == segments_.end() || !iter->second->verified_) {
+      return absl::nullopt;
+    }
+    segment = iter->second;
+    location = found.value();
+  }
+
+  std::string prefix(std::min<uint64_t>(location.size_, PrefixReadBytes), '\0');
+  RecordHeader header;
+  if (prefix.size() < sizeof(header) ||
+      !preadFully(segment->fd_, prefix.data(), prefix.size(), location.offset_)) {
+    ENVOY_LOG(debug, "unable to read cache record in {}", segment->path_);
+    return absl::nullopt;
+  }
+  memcpy(&header, prefix.data(), sizeof(header));
+  const uint64_t body_offset =
+      sizeof(header) + uint64_t(header.key_size_) + uint64_t(header.headers_size_);
+  if (header.magic_ != RecordMagic ||
+      body_offset + header.body_size_ + sizeof(RecordTrailer) != location.size_) {
+    ENVOY_LOG(debug, "found corrupt cache record in {}", segment->path_);
+    return absl::nullopt;
+  }
+  if (prefix.size() < body_offset) {
+    const uint64_t read = prefix.size();
+    prefix.resize(body_offset);
+    if (!preadFully(segment->fd_, prefix.data() + read, body_offset - read,
+                    location.offset_ + read)) {
+      ENVOY_LOG(debug, "unable to read cache record in {}", segment->path_);
+      return absl::nullopt;
+    }
+  }
+  const absl::string_view record(prefix);
+  // The index only has hashes of the keys.
+  if (record.substr(sizeof(header), header.key_size_) != key.SerializeAsString()) {
+    return absl::nullopt;
+  }
+  Http::ResponseHeaderMapPtr response_headers =
+      decodeHeaders(record.substr(sizeof(header) + header.key_size_, header.headers_size_));
+  if (response_headers == nullptr) {
+    ENVOY_LOG(debug, "found corrupt cache record in {}", segment->path_);
+    return absl::nullopt;
+  }
+  return Record{std::move(segment), location.offset_ + body_offset, header.body_size_,
+                std::move(response_headers),
+                ResponseMetadata{SystemTime(std::chrono::microseconds(header.response_time_us_))}};
+}
+
+void DiskHttpCache::write(const Key& key, const Http::ResponseHeaderMap& response_headers,
+                          const ResponseMetadata& metadata, const Buffer::Instance& body) {
+  writeRecord(key, response_headers, metadata, body.length(),
+              [&body](int fd, uint64_t offset, uint32_t& crc) {
+                for (const Buffer::RawSlice& slice : body.getRawSlices()) {
+                  if (!pwriteFully(fd, slice.mem_, slice.len_, offset)) {
+                    return false;
+                  }
+                  crc = updateCrc(crc, slice.mem_, slice.len_);
+                  offset += slice.len_;
+                }
+                return true;
+              });
+}
+
+void DiskHttpCache::rewrite(const Key& key, const Http::ResponseHeaderMap& response_headers,
+                            const ResponseMetadata& metadata, const Record& record) {
+  writeRecord(key, response_headers, metadata, record.body_size_,
+              [&record](int fd, uint64_t offset, uint32_t& crc) {
+                std::string chunk(std::min<uint64_t>(record.body_size_, ChunkBytes), '\0');
+                for (uint64_t copied = 0; copied < record.body_size_;) {
+                  const uint64_t length =
+                      std::min<uint64_t>(record.body_size_ - copied, ChunkBytes);
+                  if (!preadFully(record.segment_->fd_, chunk.data(), length,
+                                  record.body_offset_ + copied) ||
+                      !pwriteFully(fd, chunk.data(), length, offset + copied)) {
+                    return false;
+                  }
+                  crc = updateCrc(crc, chunk.data(), length);
+                  copied += length;
+                }
+                return true;
+              });
+}
+
+void DiskHttpCache::writeRecord(const Key& key, const Http::ResponseHeaderMap& response_headers,
+                                const ResponseMetadata& metadata, uint64_t body_size,
+                                const BodyWriter& write_body) {
+  const std::string serialized_key = key.SerializeAsString();
+  const std::string encoded_headers = encodeHeaders(response_headers);
+  const RecordHeader header{
+      RecordMagic, static_cast<uint32_t>(serialized_key.size()),
+      static_cast<uint32_t>(encoded_headers.size()), static_cast<uint32_t>(body_size),
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          metadata.response_time_.time_since_epoch())
+          .count()};
+  const uint64_t body_offset = sizeof(header) + serialized_key.size() + encoded_headers.size();
+  const uint64_t size = body_offset + body_size + sizeof(RecordTrailer);
+  if (size > segment_size_bytes_) {
+    return;
+  }
+
+  SegmentSharedPtr segment;
+  uint64_t offset;
+  {
+    absl::MutexLock lock(&mutex_);
+    segment = reserve(size, offset);
+  }
+  if (segment == nullptr) {
+    return;
+  }
+  std::string prefix(reinterpret_cast<const char*>(&header), sizeof(header));
+  absl::StrAppend(&prefix, serialized_key, encoded_headers);
+  uint32_t crc = updateCrc(0, prefix.data(), prefix.size());
+  bool written = pwriteFully(segment->fd_, prefix.data(), prefix.size(), offset) &&
+                 write_body(segment->fd_, offset + body_offset, crc);
+  const RecordTrailer trailer{static_cast<uint32_t>(body_offset + body_size), crc};
+  written = written && pwriteFully(segment->fd_, &trailer, sizeof(trailer),
+                                   offset + body_offset + body_size);
+  if (!written) {
+    ENVOY_LOG(warn, "unable to write to cache segment {}: {}", segment->path_,
+              errorDetails(errno));
+    return;
+  }
+
+  absl::MutexLock lock(&mutex_);
+  index_.insert(stableHashKey(key),
+                {segment->id_, static_cast<uint32_t>(offset), static_cast<uint32_t>(size)},
+                oldestSegment());
+}
+
+Buffer::InstancePtr DiskHttpCache::readBody(const Record& record, uint64_t offset,
+                                            uint64_t length) {
+  ASSERT(offset + length <= record.body_size_);
+  auto body = std::make_unique<Buffer::OwnedImpl>();
+  if (length == 0) {
+    return body;
+  }
+  Buffer::ReservationSingleSlice reservation = body->reserveSingleSlice(length);
+  if (!preadFully(record.segment_->fd_, reservation.slice().mem_, length,
+                  record.body_offset_ + offset)) {
+    ENVOY_LOG(debug, "unable to read cache record body in {}", record.segment_->path_);
+    return nullptr;
+  }
+  reservation.commit(length);
+  return body;
+}
+
+LookupContextPtr DiskHttpCache::makeLookupContext(LookupRequest&& request) {
+  return std::make_unique<DiskLookupContext>(*this, std::move(request));
+}
+
+InsertContextPtr DiskHttpCache::makeInsertContext(LookupContextPtr&& lookup_context) {
+  ASSERT(lookup_context != nullptr);
+  return std::make_unique<DiskInsertContext>(*lookup_context, *this);
+}
+
+void DiskHttpCache::updateHeaders(const LookupContext& lookup_context,
+                                  const Http::ResponseHeaderMap& response_headers,
+                                  const ResponseMetadata& metadata) {
+  const LookupStateSharedPtr& state = static_cast<const DiskLookupContext&>(lookup_context).state();
+  if (!state->record_.has_value()) {
+    return;
+  }
+  Key key = state->request_.key();
+  const Http::ResponseHeaderMap& cached_headers = *state->record_->response_headers_;
+  if (VaryHeaderUtils::hasVary(cached_headers)) {
+    // The record is the variant the request was served, which is stored under its varied key. If
+    // the response now varies on other headers, its variants would be keyed differently, so it is
+    // left for the next insert to replace.
+    if (VaryHeaderUtils::getVaryValues(response_headers) !=
+        VaryHeaderUtils::getVaryValues(cached_headers)) {
+      return;
+    }
+    absl::optional<Key> varied_key = variedKey(state->request_, cached_headers);
+    if (!varied_key.has_value()) {
+      return;
+    }
+    key = std::move(varied_key.value());
+  }
+  auto update = std::make_shared<PendingWrite>(
+      key, Http::createHeaderMap<Http::ResponseHeaderMapImpl>(response_headers), metadata);
+  post([this, state, update]() {
+    // Records are never modified, so write a new record with the new headers and the old body.
+    rewrite(update->key_, *update->response_headers_, update->metadata_, state->record_.value());
+  });
+}
+
+size_t DiskHttpCache::segmentCount() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return segments_.size();
+}
+
+uint64_t DiskHttpCache::sizeBytes() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return size_bytes_;
+}
+
+size_t DiskHttpCache::unverifiedSegmentCount() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return std::count_if(segments_.begin(), segments_.end(),
+                       [](const auto& segment) { return !segment.second->verified_; });
+}
+
+constexpr absl::string_view Name = "envoy.extensions.http.cache.disk";
+
+CacheInfo DiskHttpCache::cacheInfo() const {
+  CacheInfo cache_info;
+  cache_info.name_ = Name;
+  return cache_info;
+}
+
+SINGLETON_MANAGER_REGISTRATION(disk_http_cache_registry);
+
+// The caches that are open, by directory. Filters that are configured with the same directory
+// share a cache, which is closed once the last of them is destroyed.
+class DiskHttpCacheRegistry : public Singleton::Instance,
+                              public std::enable_shared_from_this<DiskHttpCacheRegistry> {
+public:
+  std::shared_ptr<DiskHttpCache>
+  getCache(const envoy::extensions::cache::disk_http_cache::v3alpha::DiskHttpCacheConfig& config,
+           Thread::ThreadFactory& thread_factory) {
+    ActiveCache& active = caches_[config.path()];
+    std::shared_ptr<DiskHttpCache> cache = active.cache_.lock();
+    if (cache != nullptr) {
+      if (!Protobuf::util::MessageDifferencer::Equivalent(config, active.config_)) {
+        throw EnvoyException(
+            fmt::format("config specified disk cache '{}' with different settings", config.path()));
+      }
+      return cache;
+    }
+    // Open caches keep the registry alive, so that a directory is never opened by two caches.
+    cache = std::shared_ptr<DiskHttpCache>(
+        new DiskHttpCache(config, thread_factory),
+        [registry = shared_from_this()](DiskHttpCache* cache) { delete cache; });
+    active = ActiveCache{config, cache};
+    return cache;
+  }
+
+private:
+  struct ActiveCache {
+    envoy::extensions::cache::disk_http_cache::v3alpha::DiskHttpCacheConfig config_;
+    std::weak_ptr<DiskHttpCache> cache_;
+  };
+
+  absl::flat_hash_map<std::string, ActiveCache> caches_;
+};
+
+class DiskHttpCacheFactory : public HttpCacheFactory {
+public:
+  // From UntypedFactory
+  std::string name() const override { return std::string(Name); }
+  // From TypedFactory
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return std::make_unique<
+        envoy::extensions::cache::disk_http_cache::v3alpha::DiskHttpCacheConfig>();
+  }
+  // From HttpCacheFactory
+  HttpCacheSharedPtr
+  getCache(const envoy::extensions::filters::http::cache::v3alpha::CacheConfig& config,
+           Server::Configuration::FactoryContext& context) override {
+    std::shared_ptr<DiskHttpCacheRegistry> registry =
+        context.singletonManager().getTyped<DiskHttpCacheRegistry>(
+            SINGLETON_MANAGER_REGISTERED_NAME(disk_http_cache_registry),
+            [] { return std::make_shared<DiskHttpCacheRegistry>(); });
+    return registry->getCache(
+        MessageUtil::anyConvertAndValidate<
+            envoy::extensions::cache::disk_http_cache::v3alpha::DiskHttpCacheConfig>(
+            config.typed_config(), context.messageValidationVisitor()),
+        context.api().threadFactory());
+  }
+};
+
+static Registry::RegisterFactory<DiskHttpCacheFactory, HttpCacheFactory> register_;
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/extensions/cache/disk_http_cache/v3alpha/config.pb.h"
+#include "envoy/extensions/cache/disk_http_cache/v3alpha/config.pb.validate.h"
+#include "envoy/thread/thread.h"
+
+#include "source/common/common/logger.h"
+#include "source/common/common/thread.h"
+#include "source/extensions/filters/http/cache/disk_http_cache/disk_index.h"
+#include "source/extensions/filters/http/cache/http_cache.h"
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+// An append-only file that records are written to. Segments are numbered in the order they are
+// created. A deleted segment stays readable until the last lookup that uses it is done.
+struct Segment {
+  Segment(uint32_t id, std::string path, int fd, uint64_t size)
+      : id_(id), path_(std::move(path)), fd_(fd), size_(size) {}
+  ~Segment();
+
+  const uint32_t id_;
+  const std::string path_;
+  const int fd_;
+  // Includes space that has been handed out to writes that are still in progress. Guarded by the
+  // cache's mutex.
+  uint64_t size_;
+  // Whether the records in the segment are known to be complete. Segments left by a previous run
+  // are checked in the background, and until then no lookup finds their records and no records
+  // are appended to them. Guarded by the cache's mutex.
+  bool verified_{};
+};
+using SegmentSharedPtr = std::shared_ptr<Segment>;
+
+// Cache that stores responses in segment files in a directory, and finds them with a DiskIndex
+// that is kept in the same directory. Every record holds the key, the response headers and the
+// body of one response, followed by its length and CRC. Records are appended to the newest
+// segment, and once the segments take up more than the configured size, the oldest one is
+// deleted. Both survive restarts, so the cache starts out with what it had before. Records are
+// not synced to disk before they are indexed, so when the cache is opened the I/O threads check
+// the CRC of every record and drop the ones a crash left incomplete. Opening the cache doesn't
+// wait for that.
+//
+// Lookups, reads and writes run on a pool of I/O threads, which invoke the LookupContext callbacks
+// as they finish. The calling worker never waits for the disk.
+class DiskHttpCache : public HttpCache, Logger::Loggable<Logger::Id::cache_filter> {
+public:
+  // A record found by a lookup.
+  struct Record {
+    SegmentSharedPtr segment_;
+    uint64_t body_offset_;
+    uint32_t body_size_;
+    Http::ResponseHeaderMapPtr response_headers_;
+    ResponseMetadata metadata_;
+  };
+
+  // Opens the cache in the configured directory, creating it if needed. Throws EnvoyException if
+  // the directory or the index can't be opened.
+  DiskHttpCache(
+      const envoy::extensions::cache::disk_http_cache::v3alpha::DiskHttpCacheConfig& config,
+      Thread::ThreadFactory& thread_factory);
+  ~DiskHttpCache() override;
+
+  // HttpCache
+  LookupContextPtr makeLookupContext(LookupRequest&& request) override;
+  InsertContextPtr makeInsertContext(LookupContextPtr&& lookup_context) override;
+  void updateHeaders(const LookupContext& lookup_context,
+                     const Http::ResponseHeaderMap& response_headers,
+                     const ResponseMetadata& metadata) override;
+  CacheInfo cacheInfo() const override;
+
+  // Runs job on one of the I/O threads.
+  void post(std::function<void()> job);
+
+  // The following block on the disk, so they are only called from the I/O threads.
+
+  // Returns the record stored under the key.
+  absl::optional<Record> lookup(const Key& key);
+  // Appends a record to the newest segment and adds it to the index.
+  void write(const Key& key, const Http::ResponseHeaderMap& response_headers,
+             const ResponseMetadata& metadata, const Buffer::Instance& body);
+  // Appends a record with new headers and the body of an existing record, which is copied a chunk
+  // at a time rather than read into memory.
+  void rewrite(const Key& key, const Http::ResponseHeaderMap& response_headers,
+               const ResponseMetadata& metadata, const Record& record);
+  // Reads up to length bytes of a record's body, starting at offset. Returns nullptr on failure.
+  Buffer::InstancePtr readBody(const Record& record, uint64_t offset, uint64_t length);
+
+  // Responses whose body is larger than this are not cached, as they would not fit into a segment.
+  uint64_t maxBodySizeBytes() const { return segment_size_bytes_; }
+
+  // The number of segments and the space they take up.
+  size_t segmentCount() const;
+  uint64_t sizeBytes() const;
+  // The number of segments left by a previous run that haven't been checked yet.
+  size_t unverifiedSegmentCount() const;
+
+private:
+  // Writes body_size bytes of body at the given offset of a segment, and adds them to the CRC.
+  using BodyWriter = std::function<bool(int fd, uint64_t offset, uint32_t& crc)>;
+
+  void writeRecord(const Key& key, const Http::ResponseHeaderMap& response_headers,
+                   const ResponseMetadata& metadata, uint64_t body_size,
+                   const BodyWriter& write_body);
+  // Returns the segment a record of size bytes should be written to, at *offset.
+  SegmentSharedPtr reserve(uint64_t size, uint64_t& offset) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  SegmentSharedPtr createSegment() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void loadSegments() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Checks the records of a segment left by a previous run, and drops the ones after the first
+  // that is incomplete or corrupt. Runs on an I/O thread.
+  void verifySegment(const SegmentSharedPtr& segment);
+  bool shuttingDown();
+  void evictSegments() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  uint32_t oldestSegment() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void ioThreadRoutine();
+
+  const std::string path_;
+  const uint64_t max_size_bytes_;
+  const uint64_t segment_size_bytes_;
+
+  mutable absl::Mutex mutex_;
+  DiskIndex index_ ABSL_GUARDED_BY(mutex_);
+  // All segments, by id. The last one is the one records are written to.
+  std::map<uint32_t, SegmentSharedPtr> segments_ ABSL_GUARDED_BY(mutex_);
+  uint64_t size_bytes_ ABSL_GUARDED_BY(mutex_){};
+
+  Thread::MutexBasicLockable jobs_lock_;
+  Thread::CondVar jobs_event_;
+  std::deque<std::function<void()>> jobs_ ABSL_GUARDED_BY(jobs_lock_);
+  bool shutdown_ ABSL_GUARDED_BY(jobs_lock_){};
+  std::vector<Thread::ThreadPtr> io_threads_;
+};
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
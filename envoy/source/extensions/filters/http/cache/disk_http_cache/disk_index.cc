@@ -0,0 +1,127 @@
+#include "source/extensions/filters/http/cache/disk_http_cache/disk_index.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cstring>
+
+#include "envoy/common/exception.h"
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/common/fmt.h"
+#include "source/common/common/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+constexpr char Magic[8] = {'E', 'N', 'V', 'O', 'Y', 'H', 'C', 'I'};
+// Version 2 records end with a length and CRC trailer.
+constexpr uint32_t Version = 2;
+
+} // namespace
+
+DiskIndex::DiskIndex(const std::string& path, uint32_t entry_count)
+    : entry_count_(entry_count), size_(sizeof(Header) + uint64_t(entry_count) * sizeof(Entry)) {
+  ASSERT(entry_count_ > 0);
+  auto& os_sys_calls = Api::OsSysCallsSingleton::get();
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd_ < 0) {
+    throw EnvoyException(
+        fmt::format("unable to open cache index {}: {}", path, errorDetails(errno)));
+  }
+  struct stat stat_buf;
+  const bool size_matches = os_sys_calls.stat(path.c_str(), &stat_buf).return_value_ == 0 &&
+                            static_cast<uint64_t>(stat_buf.st_size) == size_;
+  if (!size_matches) {
+    const Api::SysCallIntResult result = os_sys_calls.ftruncate(fd_, size_);
+    if (result.return_value_ != 0) {
+      os_sys_calls.close(fd_);
+      throw EnvoyException(
+          fmt::format("unable to size cache index {}: {}", path, errorDetails(result.errno_)));
+    }
+  }
+  const Api::SysCallPtrResult result =
+      os_sys_calls.mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (result.return_value_ == MAP_FAILED) {
+    os_sys_calls.close(fd_);
+    throw EnvoyException(
+        fmt::format("unable to map cache index {}: {}", path, errorDetails(result.errno_)));
+  }
+  memory_ = result.return_value_;
+  entries_ = reinterpret_cast<Entry*>(static_cast<uint8_t*>(memory_) + sizeof(Header));
+
+  if (!size_matches || memcmp(header().magic_, Magic, sizeof(Magic)) != 0 ||
+      header().version_ != Version || header().entry_count_ != entry_count_) {
+    memset(memory_, 0, size_);
+    memcpy(header().magic_, Magic, sizeof(Magic));
+    header().version_ = Version;
+    header().entry_count_ = entry_count_;
+    header().next_segment_ = 1;
+    reset_ = true;
+  }
+}
+
+DiskIndex::~DiskIndex() {
+  ::munmap(memory_, size_);
+  Api::OsSysCallsSingleton::get().close(fd_);
+}
+
+uint32_t DiskIndex::nextSegment() const { return header().next_segment_; }
+
+void DiskIndex::setNextSegment(uint32_t segment) { header().next_segment_ = segment; }
+
+absl::optional<DiskIndex::Location> DiskIndex::find(uint64_t hash, uint32_t oldest_segment) const {
+  hash = slotHash(hash);
+  for (uint32_t probe = 0; probe < MaxProbes; probe++) {
+    const Entry& entry = entries_[(hash + probe) % entry_count_];
+    if (entry.hash_ == hash && entry.segment_ >= oldest_segment) {
+      return Location{entry.segment_, entry.offset_, entry.size_};
+    }
+  }
+  return absl::nullopt;
+}
+
+void DiskIndex::insert(uint64_t hash, const Location& location, uint32_t oldest_segment) {
+  hash = slotHash(hash);
+  const auto is_free = [oldest_segment](const Entry& entry) {
+    return entry.hash_ == 0 || entry.segment_ < oldest_segment;
+  };
+  // Prefer the slot of the previous record for the key, then a free slot, then the slot with the
+  // oldest record.
+  Entry* target = nullptr;
+  for (uint32_t probe = 0; probe < MaxProbes; probe++) {
+    Entry& entry = entries_[(hash + probe) % entry_count_];
+    if (entry.hash_ == hash) {
+      target = &entry;
+      break;
+    }
+    if (target == nullptr || (is_free(entry) && !is_free(*target)) ||
+        (!is_free(*target) && entry.segment_ < target->segment_)) {
+      target = &entry;
+    }
+  }
+  target->hash_ = hash;
+  target->segment_ = location.segment_;
+  target->offset_ = location.offset_;
+  target->size_ = location.size_;
+}
+
+void DiskIndex::erase(uint32_t segment, uint32_t offset) {
+  // Lookups check every slot a hash may go into, so entries can be cleared without tombstones.
+  for (uint32_t i = 0; i < entry_count_; i++) {
+    Entry& entry = entries_[i];
+    if (entry.hash_ != 0 && entry.segment_ == segment && entry.offset_ >= offset) {
+      entry = Entry{};
+    }
+  }
+}
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
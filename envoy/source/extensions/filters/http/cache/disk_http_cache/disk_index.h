@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+// Hash index of the records in a DiskHttpCache's segment files. It lives in a file that is memory
+// mapped, so that it survives restarts. The index is a fixed size open addressing table keyed by
+// stableHashKey(). Records are identified by the number of the segment they are in, and segment
+// numbers only grow, so an entry whose segment is older than the oldest one left is stale and can
+// be reused. If all slots a hash may go into are in use, the entry with the oldest record is
+// replaced.
+//
+// The index only stores hashes, so callers have to check that the record they find has the key
+// they looked for. Not thread-safe.
+class DiskIndex {
+public:
+  struct Location {
+    uint32_t segment_;
+    uint32_t offset_;
+    uint32_t size_;
+  };
+
+  // Maps the index in the file at path. The file is created if it doesn't exist, and reset if it
+  // was written by an incompatible version or has a different number of entries. Throws
+  // EnvoyException if the file can't be mapped.
+  DiskIndex(const std::string& path, uint32_t entry_count);
+  ~DiskIndex();
+
+  // Returns where the record with the hash is stored, unless it is in a segment older than
+  // oldest_segment.
+  absl::optional<Location> find(uint64_t hash, uint32_t oldest_segment) const;
+  void insert(uint64_t hash, const Location& location, uint32_t oldest_segment);
+  // Removes the entries of records in the segment that start at or after offset.
+  void erase(uint32_t segment, uint32_t offset);
+
+  // The number the next segment gets. Stored in the index, so that segments created after a
+  // restart never have the number of a deleted segment the index may still refer to.
+  uint32_t nextSegment() const;
+  void setNextSegment(uint32_t segment);
+
+  // Whether the index was created or reset instead of reused.
+  bool reset() const { return reset_; }
+
+private:
+  struct Header {
+    char magic_[8];
+    uint32_t version_;
+    uint32_t entry_count_;
+    uint32_t next_segment_;
+    uint32_t reserved_;
+  };
+  struct Entry {
+    // 0 for slots that have never been used.
+    uint64_t hash_;
+    uint32_t segment_;
+    uint32_t offset_;
+    uint32_t size_;
+    uint32_t reserved_;
+  };
+  static_assert(sizeof(Entry) == 24, "The size of index entries is part of the file format");
+
+  // The number of slots, starting at the one the hash maps to, that an entry may go into.
+  static constexpr uint32_t MaxProbes = 8;
+
+  Header& header() const { return *static_cast<Header*>(memory_); }
+  static uint64_t slotHash(uint64_t hash) { return hash == 0 ? 1 : hash; }
+
+  const uint32_t entry_count_;
+  int fd_{-1};
+  uint64_t size_{};
+  void* memory_{};
+  Entry* entries_{};
+  bool reset_{};
+};
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
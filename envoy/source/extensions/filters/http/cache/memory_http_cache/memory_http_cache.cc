@@ -0,0 +1,443 @@
+#include "source/extensions/filters/http/cache/memory_http_cache/memory_http_cache.h"
+
+#include <utility>
+
+#include "envoy/common/exception.h"
+#include "envoy/extensions/cache/memory_http_cache/v3alpha/config.pb.h"
+#include "envoy/extensions/cache/memory_http_cache/v3alpha/config.pb.validate.h"
+#include "envoy/registry/registry.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/fmt.h"
+#include "source/common/http/header_map_impl.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_join.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+constexpr uint64_t DefaultMaxSizeBytes = 256 * 1024 * 1024;
+constexpr uint32_t DefaultShardCount = 32;
+
+// Serves a range of a cached body without copying it. The fragment keeps the body alive until the
+// buffer it was added to is done with it.
+class BodyFragment : public Buffer::BufferFragment {
+public:
+  BodyFragment(std::shared_ptr<const std::string> body, const AdjustedByteRange& range)
+      : body_(std::move(body)), range_(range) {}
+
+  // Buffer::BufferFragment
+  const void* data() const override { return body_->data() + range_.begin(); }
+  size_t size() const override { return range_.length(); }
+  void done() override { delete this; }
+
+private:
+  const std::shared_ptr<const std::string> body_;
+  const AdjustedByteRange range_;
+};
+
+class MemoryLookupContext : public LookupContext {
+public:
+  MemoryLookupContext(MemoryHttpCache& cache, LookupRequest&& request)
+      : cache_(cache), request_(std::move(request)) {}
+
+  void getHeaders(LookupHeadersCallback&& cb) override {
+    entry_ = cache_.lookup(request_);
+    if (entry_ == nullptr) {
+      cb(LookupResult{});
+      return;
+    }
+    cb(request_.makeLookupResult(
+        Http::createHeaderMap<Http::ResponseHeaderMapImpl>(*entry_->response_headers_),
+        ResponseMetadata{entry_->metadata_}, entry_->body_->size()));
+  }
+
+  void getBody(const AdjustedByteRange& range, LookupBodyCallback&& cb) override {
+    ASSERT(entry_ != nullptr);
+    ASSERT(range.end() <= entry_->body_->size(), "Attempt to read past end of body.");
+    auto buffer = std::make_unique<Buffer::OwnedImpl>();
+    buffer->addBufferFragment(*new BodyFragment(entry_->body_, range));
+    cb(std::move(buffer));
+  }
+
+  void getTrailers(LookupTrailersCallback&&) override {
+    // Trailers are never stored, so lookups never report any for the filter to ask for.
+    NOT_IMPLEMENTED_GCOVR_EXCL_LINE;
+  }
+
+  const LookupRequest& request() const { return request_; }
+  void onDestroy() override {}
+
+private:
+  MemoryHttpCache& cache_;
+  const LookupRequest request_;
+  MemoryHttpCache::EntrySharedPtr entry_;
+};
+
+class MemoryInsertContext : public InsertContext {
+public:
+  MemoryInsertContext(LookupContext& lookup_context, MemoryHttpCache& cache)
+      : key_(dynamic_cast<MemoryLookupContext&>(lookup_context).request().key()),
+        request_headers_(
+            dynamic_cast<MemoryLookupContext&>(lookup_context).request().requestHeaders()),
+        vary_allow_list_(
+            dynamic_cast<MemoryLookupContext&>(lookup_context).request().varyAllowList()),
+        cache_(cache) {}
+
+  void insertHeaders(const Http::ResponseHeaderMap& response_headers,
+                     const ResponseMetadata& metadata, bool end_stream) override {
+    ASSERT(!committed_);
+    response_headers_ = Http::createHeaderMap<Http::ResponseHeaderMapImpl>(response_headers);
+    metadata_ = metadata;
+    if (end_stream) {
+      commit();
+    }
+  }
+
+  void insertBody(const Buffer::Instance& chunk, InsertCallback ready_for_next_chunk,
+                  bool end_stream) override {
+    ASSERT(!committed_);
+    ASSERT(ready_for_next_chunk || end_stream);
+
+    if (aborted_) {
+      return;
+    }
+    body_.add(chunk);
+    if (body_.length() > cache_.maxBodySizeBytes()) {
+      // The response would not fit into the cache, so stop buffering it.
+      aborted_ = true;
+      body_.drain(body_.length());
+      if (ready_for_next_chunk) {
+        ready_for_next_chunk(false);
+      }
+      return;
+    }
+    if (end_stream) {
+      commit();
+    } else {
+      ready_for_next_chunk(true);
+    }
+  }
+
+  void insertTrailers(const Http::ResponseTrailerMap&) override {
+    // The filter doesn't insert trailers.
+    NOT_IMPLEMENTED_GCOVR_EXCL_LINE;
+  }
+
+  void onDestroy() override {}
+
+private:
+  void commit() {
+    committed_ = true;
+    const bool has_vary = VaryHeaderUtils::hasVary(*response_headers_);
+    auto entry = std::make_shared<const MemoryHttpCache::Entry>(
+        std::move(response_headers_), metadata_,
+        std::make_shared<const std::string>(body_.toString()));
+    if (has_vary) {
+      cache_.varyInsert(key_, std::move(entry), request_headers_, vary_allow_list_);
+    } else {
+      cache_.insert(key_, std::move(entry));
+    }
+  }
+
+  Key key_;
+  const Http::RequestHeaderMap& request_headers_;
+  const VaryAllowList& vary_allow_list_;
+  Http::ResponseHeaderMapPtr response_headers_;
+  ResponseMetadata metadata_;
+  MemoryHttpCache& cache_;
+  Buffer::OwnedImpl body_;
+  bool committed_ = false;
+  bool aborted_ = false;
+};
+
+uint64_t entrySizeBytes(const Key& key, const MemoryHttpCache::Entry& entry) {
+  return sizeof(MemoryHttpCache::Entry) + key.ByteSizeLong() +
+         entry.response_headers_->byteSize() + entry.body_->size();
+}
+
+// Returns the key of the variant of the response that matches the request, or nullopt if the
+// response may not be varied on the headers it varies on.
+absl::optional<Key> variedKey(const LookupRequest& request,
+                              const Http::ResponseHeaderMap& response_headers) {
+  const absl::btree_set<absl::string_view> vary_header_values =
+      VaryHeaderUtils::getVaryValues(response_headers);
+  ASSERT(!vary_header_values.empty());
+  const absl::optional<std::string> vary_identifier = VaryHeaderUtils::createVaryIdentifier(
+      request.varyAllowList(), vary_header_values, request.requestHeaders());
+  if (!vary_identifier.has_value()) {
+    return absl::nullopt;
+  }
+  Key varied_key = request.key();
+  varied_key.add_custom_fields(vary_identifier.value());
+  return varied_key;
+}
+
+} // namespace
+
+MemoryHttpCache::EntrySharedPtr MemoryHttpCache::Shard::find(const Key& key) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  auto iter = slots_.find(key);
+  if (iter == slots_.end()) {
+    return nullptr;
+  }
+  const Entry& entry = *iter->second.entry_;
+  // Avoid writing to the entry's cache line if it is already marked, as it is on hot keys.
+  if (!entry.referenced_.load(std::memory_order_relaxed)) {
+    entry.referenced_.store(true, std::memory_order_relaxed);
+  }
+  return iter->second.entry_;
+}
+
+void MemoryHttpCache::Shard::insert(const Key& key, EntrySharedPtr&& entry) {
+  absl::MutexLock lock(&mutex_);
+  insertLocked(key, std::move(entry));
+}
+
+void MemoryHttpCache::Shard::insertIfAbsent(const Key& key, EntrySharedPtr&& entry) {
+  absl::MutexLock lock(&mutex_);
+  if (!slots_.contains(key)) {
+    insertLocked(key, std::move(entry));
+  }
+}
+
+void MemoryHttpCache::Shard::insertLocked(const Key& key, EntrySharedPtr&& entry) {
+  const uint64_t size_bytes = entrySizeBytes(key, *entry);
+  if (size_bytes > max_size_bytes_) {
+    return;
+  }
+  auto result = slots_.try_emplace(key);
+  Slot& slot = result.first->second;
+  if (result.second) {
+    slot.clock_position_ = clock_.insert(hand_, &result.first->first);
+  } else {
+    // Treat the replacement like a new entry, so that it isn't the next one to be evicted.
+    if (slot.clock_position_ == hand_) {
+      ++hand_;
+    }
+    clock_.splice(hand_, clock_, slot.clock_position_);
+    size_bytes_ -= slot.size_bytes_;
+  }
+  slot.entry_ = std::move(entry);
+  slot.size_bytes_ = size_bytes;
+  size_bytes_ += size_bytes;
+
+  while (size_bytes_ > max_size_bytes_) {
+    evictLocked();
+  }
+}
+
+void MemoryHttpCache::Shard::evictLocked() {
+  // Entries that have been looked up since the hand last passed them get a second chance. Bound
+  // the number of chances, so that lookups racing with the scan can't keep it going forever.
+  uint64_t second_chances = clock_.size();
+  while (true) {
+    if (hand_ == clock_.end()) {
+      hand_ = clock_.begin();
+    }
+    auto iter = slots_.find(**hand_);
+    ASSERT(iter != slots_.end());
+    if (second_chances > 0 && iter->second.entry_->referenced_.exchange(false)) {
+      second_chances--;
+      ++hand_;
+      continue;
+    }
+    size_bytes_ -= iter->second.size_bytes_;
+    hand_ = clock_.erase(hand_);
+    slots_.erase(iter);
+    return;
+  }
+}
+
+uint64_t MemoryHttpCache::Shard::sizeBytes() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return size_bytes_;
+}
+
+uint64_t MemoryHttpCache::Shard::entryCount() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return slots_.size();
+}
+
+MemoryHttpCache::MemoryHttpCache(uint64_t max_size_bytes, uint32_t shard_count)
+    : max_shard_size_bytes_(max_size_bytes / shard_count) {
+  ASSERT(shard_count > 0 && shard_count <= max_size_bytes);
+  shards_.reserve(shard_count);
+  for (uint32_t i = 0; i < shard_count; i++) {
+    shards_.push_back(std::make_unique<Shard>(max_shard_size_bytes_));
+  }
+}
+
+MemoryHttpCache::Shard& MemoryHttpCache::shardFor(const Key& key) {
+  // The shards' maps use the low bits of the same hash, so pick the shard with the high bits.
+  return *shards_[(MessageUtil::hash(key) >> 32) % shards_.size()];
+}
+
+LookupContextPtr MemoryHttpCache::makeLookupContext(LookupRequest&& request) {
+  return std::make_unique<MemoryLookupContext>(*this, std::move(request));
+}
+
+InsertContextPtr MemoryHttpCache::makeInsertContext(LookupContextPtr&& lookup_context) {
+  ASSERT(lookup_context != nullptr);
+  return std::make_unique<MemoryInsertContext>(*lookup_context, *this);
+}
+
+void MemoryHttpCache::updateHeaders(const LookupContext& lookup_context,
+                                    const Http::ResponseHeaderMap& response_headers,
+                                    const ResponseMetadata& metadata) {
+  const LookupRequest& request = static_cast<const MemoryLookupContext&>(lookup_context).request();
+  Key key = request.key();
+  EntrySharedPtr entry = shardFor(key).find(key);
+  if (entry != nullptr && VaryHeaderUtils::hasVary(*entry->response_headers_)) {
+    // The entry only marks that the responses vary, so update the variant the request was served.
+    // If the response now varies on other headers, its variants would be keyed differently, so it
+    // is left for the next insert to replace.
+    if (VaryHeaderUtils::getVaryValues(response_headers) !=
+        VaryHeaderUtils::getVaryValues(*entry->response_headers_)) {
+      return;
+    }
+    absl::optional<Key> varied_key = variedKey(request, *entry->response_headers_);
+    if (!varied_key.has_value()) {
+      return;
+    }
+    key = std::move(varied_key.value());
+    entry = shardFor(key).find(key);
+  }
+  if (entry == nullptr) {
+    return;
+  }
+  // Entries are immutable, so replace the entry with one that has the new headers and shares the
+  // body. See SimpleHttpCache::updateHeaders() for why replacing the headers is good enough.
+  shardFor(key).insert(key, std::make_shared<const Entry>(
+                        Http::createHeaderMap<Http::ResponseHeaderMapImpl>(response_headers),
+                        metadata, entry->body_));
+}
+
+MemoryHttpCache::EntrySharedPtr MemoryHttpCache::lookup(const LookupRequest& request) {
+  EntrySharedPtr entry = shardFor(request.key()).find(request.key());
+  if (entry == nullptr || !VaryHeaderUtils::hasVary(*entry->response_headers_)) {
+    return entry;
+  }
+
+  const absl::optional<Key> varied_key = variedKey(request, *entry->response_headers_);
+  if (!varied_key.has_value()) {
+    // The vary allow list has changed and has made the vary header of this
+    // cached value not cacheable.
+    return nullptr;
+  }
+  return shardFor(varied_key.value()).find(varied_key.value());
+}
+
+void MemoryHttpCache::insert(const Key& key, EntrySharedPtr&& entry) {
+  shardFor(key).insert(key, std::move(entry));
+}
+
+void MemoryHttpCache::varyInsert(const Key& request_key, EntrySharedPtr&& entry,
+                                 const Http::RequestHeaderMap& request_headers,
+                                 const VaryAllowList& vary_allow_list) {
+  absl::btree_set<absl::string_view> vary_header_values =
+      VaryHeaderUtils::getVaryValues(*entry->response_headers_);
+  ASSERT(!vary_header_values.empty());
+
+  const absl::optional<std::string> vary_identifier =
+      VaryHeaderUtils::createVaryIdentifier(vary_allow_list, vary_header_values, request_headers);
+  if (!vary_identifier.has_value()) {
+    // Skip the insert if we are unable to create a vary key.
+    return;
+  }
+
+  // Add a special entry to flag that this request generates varied responses. It is inserted
+  // first, as vary_header_values points into the headers of the varied response.
+  Http::ResponseHeaderMapPtr vary_only_map =
+      Http::createHeaderMap<Http::ResponseHeaderMapImpl>({});
+  vary_only_map->setCopy(Http::CustomHeaders::get().Vary, absl::StrJoin(vary_header_values, ","));
+  shardFor(request_key)
+      .insertIfAbsent(request_key, std::make_shared<const Entry>(
+                                       std::move(vary_only_map), ResponseMetadata{},
+                                       std::make_shared<const std::string>()));
+
+  // Insert the varied response.
+  Key varied_request_key = request_key;
+  varied_request_key.add_custom_fields(vary_identifier.value());
+  shardFor(varied_request_key).insert(varied_request_key, std::move(entry));
+}
+
+uint64_t MemoryHttpCache::sizeBytes() const {
+  uint64_t size_bytes = 0;
+  for (const auto& shard : shards_) {
+    size_bytes += shard->sizeBytes();
+  }
+  return size_bytes;
+}
+
+uint64_t MemoryHttpCache::entryCount() const {
+  uint64_t count = 0;
+  for (const auto& shard : shards_) {
+    count += shard->entryCount();
+  }
+  return count;
+}
+
+constexpr absl::string_view Name = "envoy.extensions.http.cache.memory";
+
+CacheInfo MemoryHttpCache::cacheInfo() const {
+  CacheInfo cache_info;
+  cache_info.name_ = Name;
+  return cache_info;
+}
+
+class MemoryHttpCacheFactory : public HttpCacheFactory {
+public:
+  // From UntypedFactory
+  std::string name() const override { return std::string(Name); }
+  // From TypedFactory
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return std::make_unique<
+        envoy::extensions::cache::memory_http_cache::v3alpha::MemoryHttpCacheConfig>();
+  }
+  // From HttpCacheFactory
+  HttpCacheSharedPtr
+  getCache(const envoy::extensions::filters::http::cache::v3alpha::CacheConfig& config,
+           Server::Configuration::FactoryContext& context) override {
+    const auto proto = MessageUtil::anyConvertAndValidate<
+        envoy::extensions::cache::memory_http_cache::v3alpha::MemoryHttpCacheConfig>(
+        config.typed_config(), context.messageValidationVisitor());
+    const uint64_t max_size_bytes =
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto, max_size_bytes, DefaultMaxSizeBytes);
+    const uint32_t shard_count =
+        PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto, shard_count, DefaultShardCount);
+    if (max_size_bytes < shard_count) {
+      throw EnvoyException(fmt::format(
+          "memory cache max_size_bytes ({}) must be at least its shard_count ({})",
+          max_size_bytes, shard_count));
+    }
+    // Filters configured with the same sizes share a cache, which lives as long as any of them.
+    const CacheKey key{max_size_bytes, shard_count};
+    absl::MutexLock lock(&mutex_);
+    std::weak_ptr<MemoryHttpCache>& weak_cache = caches_[key];
+    std::shared_ptr<MemoryHttpCache> cache = weak_cache.lock();
+    if (cache == nullptr) {
+      cache = std::make_shared<MemoryHttpCache>(max_size_bytes, shard_count);
+      weak_cache = cache;
+    }
+    return cache;
+  }
+
+private:
+  // max_size_bytes and shard_count.
+  using CacheKey = std::pair<uint64_t, uint32_t>;
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<CacheKey, std::weak_ptr<MemoryHttpCache>> caches_ ABSL_GUARDED_BY(mutex_);
+};
+
+static Registry::RegisterFactory<MemoryHttpCacheFactory, HttpCacheFactory> register_;
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "source/common/protobuf/utility.h"
+#include "source/extensions/filters/http/cache/http_cache.h"
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/synchronization/mutex.h"
+
+// included to make code_format happy
+#include "envoy/extensions/cache/memory_http_cache/v3alpha/config.pb.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+// In-memory cache that is split into shards by key. Entries are immutable once inserted and are
+// shared with lookups instead of being copied, so a lookup only holds its shard's lock for reading,
+// and only while it finds the entry. Bodies are served as buffer fragments that point into the
+// cached body.
+//
+// Each shard evicts entries once it holds more than its share of the memory budget. Eviction
+// approximates LRU with the CLOCK algorithm: a hit only marks the entry as referenced, so hits
+// never take the shard's lock for writing.
+class MemoryHttpCache : public HttpCache {
+public:
+  struct Entry {
+    Entry(Http::ResponseHeaderMapPtr&& response_headers, const ResponseMetadata& metadata,
+          std::shared_ptr<const std::string> body)
+        : response_headers_(std::move(response_headers)), metadata_(metadata),
+          body_(std::move(body)) {}
+
+    const Http::ResponseHeaderMapPtr response_headers_;
+    const ResponseMetadata metadata_;
+    // Shared with any entry that replaces this one in updateHeaders(), and with the buffers that
+    // lookups have handed out.
+    const std::shared_ptr<const std::string> body_;
+    // Set by lookups and cleared by the eviction scan.
+    mutable std::atomic<bool> referenced_{false};
+  };
+  using EntrySharedPtr = std::shared_ptr<const Entry>;
+
+  // shard_count must be at least 1 and at most max_size_bytes.
+  MemoryHttpCache(uint64_t max_size_bytes, uint32_t shard_count);
+
+  // HttpCache
+  LookupContextPtr makeLookupContext(LookupRequest&& request) override;
+  InsertContextPtr makeInsertContext(LookupContextPtr&& lookup_context) override;
+  void updateHeaders(const LookupContext& lookup_context,
+                     const Http::ResponseHeaderMap& response_headers,
+                     const ResponseMetadata& metadata) override;
+  CacheInfo cacheInfo() const override;
+
+  // Returns the entry stored for the request, following the entry of a response that varies to
+  // the variant matching the request headers. Returns nullptr if there is none.
+  EntrySharedPtr lookup(const LookupRequest& request);
+  void insert(const Key& key, EntrySharedPtr&& entry);
+
+  // Inserts a response that has been varied on certain headers.
+  void varyInsert(const Key& request_key, EntrySharedPtr&& entry,
+                  const Http::RequestHeaderMap& request_headers,
+                  const VaryAllowList& vary_allow_list);
+
+  // Responses whose body is larger than this are not cached, as they would not fit into a shard.
+  uint64_t maxBodySizeBytes() const { return max_shard_size_bytes_; }
+
+  // The memory taken up by all entries, and their number.
+  uint64_t sizeBytes() const;
+  uint64_t entryCount() const;
+
+private:
+  class Shard {
+  public:
+    explicit Shard(uint64_t max_size_bytes) : max_size_bytes_(max_size_bytes) {}
+
+    EntrySharedPtr find(const Key& key) const;
+    // Stores entry under key, replacing any existing entry, and evicts entries until the shard
+    // fits into its budget again.
+    void insert(const Key& key, EntrySharedPtr&& entry);
+    // Stores entry under key, unless there already is an entry.
+    void insertIfAbsent(const Key& key, EntrySharedPtr&& entry);
+    uint64_t sizeBytes() const;
+    uint64_t entryCount() const;
+
+  private:
+    struct Slot {
+      EntrySharedPtr entry_;
+      uint64_t size_bytes_;
+      std::list<const Key*>::iterator clock_position_;
+    };
+    using SlotMap = absl::node_hash_map<Key, Slot, MessageUtil, MessageUtil>;
+
+    void insertLocked(const Key& key, EntrySharedPtr&& entry)
+        ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+    void evictLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+    const uint64_t max_size_bytes_;
+    mutable absl::Mutex mutex_;
+    // Node based, so that clock_ can point at the keys.
+    SlotMap slots_ ABSL_GUARDED_BY(mutex_);
+    // The keys of all entries, in insertion order. New keys are inserted right behind the hand,
+    // which is where the eviction scan continues from.
+    std::list<const Key*> clock_ ABSL_GUARDED_BY(mutex_);
+    std::list<const Key*>::iterator hand_ ABSL_GUARDED_BY(mutex_){clock_.end()};
+    uint64_t size_bytes_ ABSL_GUARDED_BY(mutex_){};
+  };
+
+  Shard& shardFor(const Key& key);
+
+  const uint64_t max_shard_size_bytes_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -261,13 +261,13 @@ public:
         envoy::extensions::cache::simple_http_cache::v3alpha::SimpleHttpCacheConfig>();
   }
   // From HttpCacheFactory
-  HttpCache&
-  getCache(const envoy::extensions::filters::http::cache::v3alpha::CacheConfig&) override {
+  HttpCacheSharedPtr getCache(const envoy::extensions::filters::http::cache::v3alpha::CacheConfig&,
+                              Server::Configuration::FactoryContext&) override {
     return cache_;
   }
 
 private:
-  SimpleHttpCache cache_;
+  const std::shared_ptr<SimpleHttpCache> cache_ = std::make_shared<SimpleHttpCache>();
 };
 
 static Registry::RegisterFactory<SimpleHttpCacheFactory, HttpCacheFactory> register_;
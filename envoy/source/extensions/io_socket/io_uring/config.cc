@@ -0,0 +1,74 @@
+#include "source/extensions/io_socket/io_uring/config.h"
+
+#include "envoy/registry/registry.h"
+
+#include "source/common/protobuf/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+Server::BootstrapExtensionPtr IoUringSocketInterface::createBootstrapExtension(
+    const Protobuf::Message& message, Server::Configuration::ServerFactoryContext& context) {
+  const auto& proto_config = MessageUtil::downcastAndValidate<
+      const envoy::extensions::network::socket_interface::v3::IoUringSocketInterface&>(
+      message, context.messageValidationVisitor());
+
+  IoUringConfig config;
+  config.ring_size_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, ring_size, config.ring_size_);
+  config.read_buffer_size_ =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, read_buffer_size, config.read_buffer_size_);
+  config.registered_buffer_count_ = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
+      proto_config, registered_buffer_count, config.registered_buffer_count_);
+  config.write_buffer_limit_ =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(proto_config, write_buffer_limit, config.write_buffer_limit_);
+  config.close_flush_timeout_ = std::chrono::milliseconds(PROTOBUF_GET_MS_OR_DEFAULT(
+      proto_config, close_flush_timeout, config.close_flush_timeout_.count()));
+  return std::make_unique<IoUringSocketInterfaceExtension>(*this, config, context.threadLocal());
+}
+
+ProtobufTypes::MessagePtr IoUringSocketInterface::createEmptyConfigProto() {
+  return std::make_unique<
+      envoy::extensions::network::socket_interface::v3::IoUringSocketInterface>();
+}
+
+OptRef<IoUringWorker>
+IoUringSocketInterface::workerForDispatcher(Event::Dispatcher& dispatcher) const {
+  ThreadLocal::TypedSlot<IoUringWorker>* workers = workers_.load();
+  if (workers == nullptr || !workers->currentThreadRegistered()) {
+    return {};
+  }
+  OptRef<IoUringWorker> worker = workers->get();
+  // Sockets may be set up from another thread than the one running their dispatcher, e.g. in
+  // tests. Those stay off the ring, which only serves its own thread.
+  if (!worker.has_value() || !worker->enabled() || &worker->dispatcher() != &dispatcher) {
+    return {};
+  }
+  return worker;
+}
+
+Network::IoHandlePtr IoUringSocketInterface::makeSocket(int socket_fd, bool socket_v6only,
+                                                        absl::optional<int> domain) const {
+  return std::make_unique<IoUringSocketHandleImpl>(*this, socket_fd, socket_v6only, domain);
+}
+
+IoUringSocketInterfaceExtension::~IoUringSocketInterfaceExtension() {
+  ioUringSocketInterface().setWorkers(nullptr);
+}
+
+void IoUringSocketInterfaceExtension::onServerInitialized() {
+  // The workers have registered with thread local storage by now, but haven't started running.
+  workers_ = ThreadLocal::TypedSlot<IoUringWorker>::makeUnique(tls_);
+  workers_->set([config = config_](Event::Dispatcher& dispatcher) {
+    return std::make_shared<IoUringWorker>(config, dispatcher);
+  });
+  ioUringSocketInterface().setWorkers(workers_.get());
+}
+
+REGISTER_FACTORY(IoUringSocketInterface, Server::Configuration::BootstrapExtensionFactory);
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+
+#include "envoy/extensions/network/socket_interface/v3/io_uring_socket_interface.pb.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "source/common/network/socket_interface.h"
+#include "source/common/network/socket_interface_impl.h"
+#include "source/extensions/io_socket/io_uring/io_handle_impl.h"
+#include "source/extensions/io_socket/io_uring/io_uring_worker.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+/**
+ * Socket interface whose connected stream sockets do their reads and writes through a per-thread
+ * io_uring. Sockets created before the server has initialized, or on threads without a usable
+ * ring, behave exactly like those of the default socket interface.
+ */
+class IoUringSocketInterface : public Network::SocketInterfaceImpl, public IoUringWorkerProvider {
+public:
+  // Server::Configuration::BootstrapExtensionFactory
+  Server::BootstrapExtensionPtr
+  createBootstrapExtension(const Protobuf::Message& config,
+                           Server::Configuration::ServerFactoryContext& context) override;
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+  std::string name() const override { return "envoy.io_socket.io_uring"; }
+
+  // IoUringWorkerProvider
+  OptRef<IoUringWorker> workerForDispatcher(Event::Dispatcher& dispatcher) const override;
+
+  // Set by the bootstrap extension while it owns the per-thread workers.
+  void setWorkers(ThreadLocal::TypedSlot<IoUringWorker>* workers) { workers_ = workers; }
+
+protected:
+  Network::IoHandlePtr makeSocket(int socket_fd, bool socket_v6only,
+                                  absl::optional<int> domain) const override;
+
+private:
+  std::atomic<ThreadLocal::TypedSlot<IoUringWorker>*> workers_{};
+};
+
+class IoUringSocketInterfaceExtension : public Network::SocketInterfaceExtension {
+public:
+  IoUringSocketInterfaceExtension(IoUringSocketInterface& sock_interface,
+                                  const IoUringConfig& config, ThreadLocal::SlotAllocator& tls)
+      : Network::SocketInterfaceExtension(sock_interface), config_(config), tls_(tls) {}
+  ~IoUringSocketInterfaceExtension() override;
+
+  // Server::BootstrapExtension
+  void onServerInitialized() override;
+
+private:
+  IoUringSocketInterface& ioUringSocketInterface() {
+    return static_cast<IoUringSocketInterface&>(sock_interface_);
+  }
+
+  const IoUringConfig config_;
+  ThreadLocal::SlotAllocator& tls_;
+  ThreadLocal::TypedSlotPtr<IoUringWorker> workers_;
+};
+
+DECLARE_FACTORY(IoUringSocketInterface);
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
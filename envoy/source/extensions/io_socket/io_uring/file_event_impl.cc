@@ -0,0 +1,63 @@
+#include "source/extensions/io_socket/io_uring/file_event_impl.h"
+
+#include "source/extensions/io_socket/io_uring/io_handle_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+FileEventImpl::FileEventImpl(Event::Dispatcher& dispatcher, Event::FileReadyCb cb,
+                             uint32_t events, IoUringSocketHandleImpl& handle)
+    : cb_(cb), handle_(handle), schedulable_(dispatcher.createSchedulableCallback([this]() {
+        const uint32_t events = std::exchange(injected_events_, 0);
+        ENVOY_LOG(trace, "io_uring event {} invokes callbacks on events = {}",
+                  static_cast<void*>(this), events);
+        cb_(events);
+      })) {
+  setEnabled(events);
+}
+
+void FileEventImpl::activate(uint32_t events) {
+  ASSERT((events & (Event::FileReadyType::Read | Event::FileReadyType::Write |
+                    Event::FileReadyType::Closed)) == events);
+  injected_events_ |= events;
+  schedulable_->scheduleCallbackCurrentIteration();
+}
+
+void FileEventImpl::setEnabled(uint32_t events) {
+  ASSERT((events & (Event::FileReadyType::Read | Event::FileReadyType::Write |
+                    Event::FileReadyType::Closed)) == events);
+  // Align with Event::FileEventImpl and drop pending events that may no longer be relevant.
+  injected_events_ = 0;
+  enabled_events_ = events;
+  handle_.onEventsEnabled(events);
+
+  uint32_t events_to_notify = 0;
+  if ((events & Event::FileReadyType::Read) && handle_.isReadable()) {
+    events_to_notify |= Event::FileReadyType::Read;
+  }
+  if ((events & Event::FileReadyType::Write) && handle_.isWritable()) {
+    events_to_notify |= Event::FileReadyType::Write;
+  }
+  if ((events & Event::FileReadyType::Closed) && handle_.isPeerClosed()) {
+    events_to_notify |= Event::FileReadyType::Closed;
+  }
+  if (events_to_notify != 0) {
+    activate(events_to_notify);
+  } else {
+    schedulable_->cancel();
+  }
+}
+
+void FileEventImpl::activateIfEnabled(uint32_t events) {
+  const uint32_t filtered_events = events & enabled_events_;
+  if (filtered_events != 0) {
+    activate(filtered_events);
+  }
+}
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
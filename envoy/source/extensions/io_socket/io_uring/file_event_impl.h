@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/file_event.h"
+
+#include "source/common/common/assert.h"
+#include "source/common/common/logger.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+class IoUringSocketHandleImpl;
+
+/**
+ * FileEvent for a socket whose reads and writes complete on a ring. There is nothing for the
+ * kernel to report readiness on; instead the handle activates this event when a completion makes
+ * it readable or writable, and the event callback runs from the dispatcher in the same loop
+ * iteration. Events behave as edge triggered regardless of the requested trigger type.
+ */
+class FileEventImpl final : public Event::FileEvent, Logger::Loggable<Logger::Id::io> {
+public:
+  FileEventImpl(Event::Dispatcher& dispatcher, Event::FileReadyCb cb, uint32_t events,
+                IoUringSocketHandleImpl& handle);
+
+  // Event::FileEvent
+  void activate(uint32_t events) override;
+  void setEnabled(uint32_t events) override;
+  void unregisterEventIfEmulatedEdge(uint32_t) override { NOT_IMPLEMENTED_GCOVR_EXCL_LINE; }
+  void registerEventIfEmulatedEdge(uint32_t) override { NOT_IMPLEMENTED_GCOVR_EXCL_LINE; }
+
+  // Activate the given events if they are enabled.
+  void activateIfEnabled(uint32_t events);
+  uint32_t enabledEvents() const { return enabled_events_; }
+
+private:
+  Event::FileReadyCb cb_;
+  IoUringSocketHandleImpl& handle_;
+  Event::SchedulableCallbackPtr schedulable_;
+  // The events set by setEnabled().
+  uint32_t enabled_events_{};
+  // The events to deliver on the next callback.
+  uint32_t injected_events_{};
+};
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
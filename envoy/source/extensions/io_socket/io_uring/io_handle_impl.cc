@@ -0,0 +1,447 @@
+#include "source/extensions/io_socket/io_uring/io_handle_impl.h"
+
+#include <poll.h>
+
+#include "envoy/api/os_sys_calls.h"
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/network/io_socket_error_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+namespace {
+
+// Reads shorter than this are copied into the read buffer so that the read buffer they landed in
+// can be reused right away. Longer reads are handed over without copying.
+constexpr uint64_t CopyReadThreshold = 4096;
+
+Api::IoCallUint64Result ioCallResult(uint64_t length) {
+  return {length, Api::IoErrorPtr(nullptr, Network::IoSocketError::deleteIoError)};
+}
+
+Api::IoCallUint64Result eagainResult() {
+  return {0, Api::IoErrorPtr(Network::IoSocketError::getIoSocketEagainInstance(),
+                             Network::IoSocketError::deleteIoError)};
+}
+
+} // namespace
+
+IoUringSocketHandleImpl::~IoUringSocketHandleImpl() {
+  if (SOCKET_VALID(fd_)) {
+    IoUringSocketHandleImpl::close();
+  }
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::close() {
+  if (worker_ == nullptr) {
+    return IoSocketHandleImpl::close();
+  }
+
+  file_event_.reset();
+  IoUringWorker& worker = *std::exchange(worker_, nullptr);
+  worker.removeHandle(*this);
+  if (read_req_ != nullptr) {
+    worker.cancel(*std::exchange(read_req_, nullptr));
+  }
+  if (connect_poll_req_ != nullptr) {
+    worker.cancel(*std::exchange(connect_poll_req_, nullptr));
+  }
+
+  if (write_error_ == 0 && pendingWriteBytes() > 0 && !resetOnClose()) {
+    // Hand the queued data over to the worker, which closes the file descriptor once it has been
+    // written or the close flush timeout has passed.
+    Request* request = std::exchange(write_req_, nullptr);
+    if (request == nullptr) {
+      request = &worker.createRequest(Request::Type::Write, nullptr, fd_);
+      request->data_.move(write_buf_);
+      worker.submit(*request);
+    } else {
+      request->handle_ = nullptr;
+      request->pending_.move(write_buf_);
+    }
+    request->shutdown_how_ = shutdown_how_;
+    worker.closeAfterWrite(*request);
+    SET_SOCKET_INVALID(fd_);
+    return ioCallResult(0);
+  }
+
+  // Nothing is left to write, or the socket is reset on close, in which case the queued data is
+  // dropped as the kernel drops its send buffer.
+  if (write_req_ != nullptr) {
+    worker.cancel(*std::exchange(write_req_, nullptr));
+  }
+  write_buf_.drain(write_buf_.length());
+  return IoSocketHandleImpl::close();
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::readv(uint64_t max_length,
+                                                       Buffer::RawSlice* slices,
+                                                       uint64_t num_slice) {
+  if (worker_ == nullptr) {
+    return IoSocketHandleImpl::readv(max_length, slices, num_slice);
+  }
+  if (read_buf_.length() == 0) {
+    return emptyReadResult();
+  }
+
+  uint64_t bytes_read = 0;
+  for (uint64_t i = 0; i < num_slice && bytes_read < max_length && read_buf_.length() > 0; i++) {
+    const uint64_t length =
+        std::min({static_cast<uint64_t>(slices[i].len_), max_length - bytes_read,
+                  read_buf_.length()});
+    read_buf_.copyOut(0, length, slices[i].mem_);
+    read_buf_.drain(length);
+    bytes_read += length;
+  }
+  maybeSubmitRead();
+  return ioCallResult(bytes_read);
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::read(Buffer::Instance& buffer,
+                                                      absl::optional<uint64_t> max_length) {
+  if (worker_ == nullptr) {
+    return IoSocketHandleImpl::read(buffer, max_length);
+  }
+  if (read_buf_.length() == 0) {
+    return emptyReadResult();
+  }
+
+  const uint64_t length = std::min(read_buf_.length(), max_length.value_or(UINT64_MAX));
+  buffer.move(read_buf_, length);
+  maybeSubmitRead();
+  return ioCallResult(length);
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::recv(void* buffer, size_t length, int flags) {
+  if (worker_ == nullptr) {
+    return IoSocketHandleImpl::recv(buffer, length, flags);
+  }
+  if (read_buf_.length() == 0) {
+    return emptyReadResult();
+  }
+
+  const uint64_t bytes_read = std::min<uint64_t>(read_buf_.length(), length);
+  read_buf_.copyOut(0, bytes_read, buffer);
+  if ((flags & MSG_PEEK) == 0) {
+    read_buf_.drain(bytes_read);
+    maybeSubmitRead();
+  }
+  return ioCallResult(bytes_read);
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::emptyReadResult() {
+  if (read_error_ != 0) {
+    return errorResult(read_error_);
+  }
+  if (read_eof_) {
+    return ioCallResult(0);
+  }
+  maybeSubmitRead();
+  return eagainResult();
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::errorResult(int error) {
+  return {0, Api::IoErrorPtr(new Network::IoSocketError(error),
+                             Network::IoSocketError::deleteIoError)};
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::writev(const Buffer::RawSlice* slices,
+                                                        uint64_t num_slice) {
+  if (worker_ == nullptr) {
+    return IoSocketHandleImpl::writev(slices, num_slice);
+  }
+  Buffer::OwnedImpl buffer;
+  for (uint64_t i = 0; i < num_slice; i++) {
+    if (slices[i].mem_ != nullptr && slices[i].len_ != 0) {
+      buffer.add(slices[i].mem_, slices[i].len_);
+    }
+  }
+  return write(buffer);
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::write(Buffer::Instance& buffer) {
+  if (worker_ == nullptr) {
+    return IoSocketHandleImpl::write(buffer);
+  }
+  if (write_error_ != 0) {
+    return errorResult(write_error_);
+  }
+
+  const uint64_t limit = worker_->config().write_buffer_limit_;
+  const uint64_t pending = pendingWriteBytes();
+  if (pending >= limit) {
+    write_blocked_ = true;
+    return eagainResult();
+  }
+  const uint64_t length = std::min(buffer.length(), limit - pending);
+  write_buf_.move(buffer, length);
+  maybeSubmitWrite();
+  return ioCallResult(length);
+}
+
+Network::IoHandlePtr IoUringSocketHandleImpl::accept(struct sockaddr* addr, socklen_t* addrlen) {
+  auto result = Api::OsSysCallsSingleton::get().accept(fd_, addr, addrlen);
+  if (SOCKET_INVALID(result.return_value_)) {
+    return nullptr;
+  }
+
+  auto handle = std::make_unique<IoUringSocketHandleImpl>(provider_, result.return_value_,
+                                                          socket_v6only_, domain_);
+  handle->connection_ = true;
+  handle->writable_ = true;
+  return handle;
+}
+
+Api::SysCallIntResult
+IoUringSocketHandleImpl::connect(Network::Address::InstanceConstSharedPtr address) {
+  int type = 0;
+  socklen_t type_len = sizeof(type);
+  const bool stream =
+      getOption(SOL_SOCKET, SO_TYPE, &type, &type_len).return_value_ == 0 && type == SOCK_STREAM;
+  const Api::SysCallIntResult result = IoSocketHandleImpl::connect(address);
+  if (!stream || (result.return_value_ != 0 && result.errno_ != SOCKET_ERROR_IN_PROGRESS)) {
+    return result;
+  }
+
+  connection_ = true;
+  if (worker_ != nullptr) {
+    // The file event is typically set up before connect(), when there was nothing to read or to
+    // wait for yet.
+    maybeSubmitRead();
+    if (result.return_value_ == 0) {
+      writable_ = true;
+      activateIfEnabled(Event::FileReadyType::Write);
+    } else if (file_event_ != nullptr) {
+      maybeSubmitConnectPoll(static_cast<FileEventImpl*>(file_event_.get())->enabledEvents());
+    }
+  }
+  return result;
+}
+
+void IoUringSocketHandleImpl::initializeFileEvent(Event::Dispatcher& dispatcher,
+                                                  Event::FileReadyCb cb,
+                                                  Event::FileTriggerType trigger,
+                                                  uint32_t events) {
+  if (worker_ == nullptr && (connection_ || isClientStreamSocket())) {
+    OptRef<IoUringWorker> worker = provider_.workerForDispatcher(dispatcher);
+    if (worker.has_value()) {
+      worker_ = &worker.ref();
+      worker_->addHandle(*this);
+    }
+  }
+  if (worker_ == nullptr) {
+    IoSocketHandleImpl::initializeFileEvent(dispatcher, cb, trigger, events);
+    return;
+  }
+
+  ASSERT(file_event_ == nullptr, "Attempting to initialize two `file_event_` for the same "
+                                 "file descriptor. This is not allowed.");
+  ASSERT(&worker_->dispatcher() == &dispatcher);
+  file_event_ = std::make_unique<FileEventImpl>(dispatcher, cb, events, *this);
+}
+
+Api::SysCallIntResult IoUringSocketHandleImpl::shutdown(int how) {
+  if (worker_ != nullptr && how != ENVOY_SHUT_RD && pendingWriteBytes() > 0) {
+    // Shutting down now would cut off the queued data. Do it once the queue has been written.
+    shutdown_how_ = how;
+    return {0, 0};
+  }
+  return IoSocketHandleImpl::shutdown(how);
+}
+
+void IoUringSocketHandleImpl::onEventsEnabled(uint32_t events) {
+  if (events & Event::FileReadyType::Read) {
+    maybeSubmitRead();
+  }
+  maybeSubmitConnectPoll(events);
+}
+
+void IoUringSocketHandleImpl::maybeSubmitConnectPoll(uint32_t events) {
+  if (!(events & Event::FileReadyType::Write) || !connection_ || writable_ ||
+      connect_poll_req_ != nullptr) {
+    return;
+  }
+  // A non-blocking connect() is complete once the socket becomes writable.
+  connect_poll_req_ = &worker_->createRequest(Request::Type::Poll, this, fd_);
+  connect_poll_req_->poll_events_ = POLLOUT;
+  worker_->submit(*connect_poll_req_);
+}
+
+bool IoUringSocketHandleImpl::isReadable() const {
+  return read_buf_.length() > 0 || read_eof_ || read_error_ != 0;
+}
+
+bool IoUringSocketHandleImpl::isWritable() const {
+  return writable_ &&
+         (write_error_ != 0 || pendingWriteBytes() < worker_->config().write_buffer_limit_);
+}
+
+bool IoUringSocketHandleImpl::isClientStreamSocket() {
+  int value = 0;
+  socklen_t length = sizeof(value);
+  if (getOption(SOL_SOCKET, SO_TYPE, &value, &length).return_value_ != 0 ||
+      value != SOCK_STREAM) {
+    return false;
+  }
+  length = sizeof(value);
+  return getOption(SOL_SOCKET, SO_ACCEPTCONN, &value, &length).return_value_ == 0 && value == 0;
+}
+
+bool IoUringSocketHandleImpl::resetOnClose() {
+  struct linger linger {};
+  socklen_t length = sizeof(linger);
+  return getOption(SOL_SOCKET, SO_LINGER, &linger, &length).return_value_ == 0 &&
+         linger.l_onoff != 0 && linger.l_linger == 0;
+}
+
+uint64_t IoUringSocketHandleImpl::pendingWriteBytes() const {
+  return write_buf_.length() + (write_req_ != nullptr ? write_req_->data_.length() : 0);
+}
+
+void IoUringSocketHandleImpl::maybeSubmitRead() {
+  if (worker_ == nullptr || !connection_ || read_req_ != nullptr || read_eof_ ||
+      read_error_ != 0 || read_buf_.length() >= worker_->config().read_buffer_size_) {
+    return;
+  }
+  read_req_ = &worker_->createRequest(Request::Type::Read, this, fd_);
+  worker_->submit(*read_req_);
+}
+
+void IoUringSocketHandleImpl::maybeSubmitWrite() {
+  if (write_req_ != nullptr || write_buf_.length() == 0) {
+    return;
+  }
+  write_req_ = &worker_->createRequest(Request::Type::Write, this, fd_);
+  write_req_->data_.move(write_buf_);
+  worker_->submit(*write_req_);
+}
+
+void IoUringSocketHandleImpl::appendReadData(Request& request, uint64_t length) {
+  if (length < CopyReadThreshold) {
+    read_buf_.add(request.buf_, length);
+    return;
+  }
+
+  // Hand the buffer over to read_buf_ without copying. It goes back to where it came from once
+  // the data has been drained, wherever that happens.
+  Buffer::BufferFragmentImpl* fragment;
+  if (request.buf_index_ >= 0) {
+    fragment = new Buffer::BufferFragmentImpl(
+        request.buf_, length,
+        [pool = std::move(request.pool_), index = std::exchange(request.buf_index_, -1)](
+            const void*, size_t, const Buffer::BufferFragmentImpl* fragment) {
+          pool->release(index);
+          delete fragment;
+        });
+  } else {
+    fragment = new Buffer::BufferFragmentImpl(
+        request.buf_, length,
+        [storage = request.storage_.release(), capacity = request.buf_size_](
+            const void*, size_t, const Buffer::BufferFragmentImpl* fragment) {
+          Buffer::SliceStoragePool::release(Buffer::SliceStoragePool::StoragePtr(storage),
+                                            capacity);
+          delete fragment;
+        });
+  }
+  read_buf_.addBufferFragment(*fragment);
+}
+
+void IoUringSocketHandleImpl::onReadCompleted(Request& request, int32_t result) {
+  ASSERT(&request == read_req_);
+  if (result == -EAGAIN) {
+    // Older kernels don't wait for data on non-blocking sockets. Wait for it with a poll.
+    worker_->submit(request, true);
+    return;
+  }
+
+  read_req_ = nullptr;
+  if (result > 0) {
+    appendReadData(request, result);
+  } else if (result == 0) {
+    read_eof_ = true;
+  } else {
+    read_error_ = -result;
+  }
+  worker_->release(request);
+
+  // Keep a read outstanding while the data that just arrived is processed.
+  maybeSubmitRead();
+  activateIfEnabled(Event::FileReadyType::Read |
+                    (read_eof_ || read_error_ != 0 ? Event::FileReadyType::Closed : 0));
+}
+
+void IoUringSocketHandleImpl::onWriteCompleted(Request& request, int32_t result) {
+  ASSERT(&request == write_req_);
+  if (result == -EAGAIN) {
+    worker_->submit(request, true);
+    return;
+  }
+  if (result < 0) {
+    ENVOY_LOG(debug, "io_uring write on fd {} failed: {}", fd_, errorDetails(-result));
+    write_error_ = -result;
+    write_req_ = nullptr;
+    worker_->release(request);
+    write_buf_.drain(write_buf_.length());
+    activateIfEnabled(Event::FileReadyType::Write);
+    return;
+  }
+
+  writable_ = true;
+  request.data_.drain(result);
+  if (request.data_.length() > 0) {
+    worker_->submit(request);
+    return;
+  }
+  write_req_ = nullptr;
+  worker_->release(request);
+  maybeSubmitWrite();
+
+  if (write_req_ == nullptr && shutdown_how_.has_value()) {
+    IoSocketHandleImpl::shutdown(shutdown_how_.value());
+    shutdown_how_.reset();
+  }
+  if (write_blocked_ && pendingWriteBytes() < worker_->config().write_buffer_limit_) {
+    write_blocked_ = false;
+    activateIfEnabled(Event::FileReadyType::Write);
+  }
+}
+
+void IoUringSocketHandleImpl::onPollCompleted(Request& request, int32_t result) {
+  ASSERT(&request == connect_poll_req_);
+  connect_poll_req_ = nullptr;
+  worker_->release(request);
+  // On failure the connection error, if any, is picked up through SO_ERROR once the owner
+  // handles the write event.
+  if (result < 0) {
+    ENVOY_LOG(debug, "io_uring poll on fd {} failed: {}", fd_, errorDetails(-result));
+  }
+  writable_ = true;
+  activateIfEnabled(Event::FileReadyType::Write);
+}
+
+void IoUringSocketHandleImpl::onWorkerDestroyed() {
+  // The worker detaches and cancels the requests itself. End the stream rather than continuing it
+  // with system calls, which could reorder data with what the ring has already read or written.
+  worker_ = nullptr;
+  read_req_ = nullptr;
+  write_req_ = nullptr;
+  connect_poll_req_ = nullptr;
+  file_event_.reset();
+  if (SOCKET_VALID(fd_)) {
+    IoSocketHandleImpl::shutdown(ENVOY_SHUT_RDWR);
+  }
+}
+
+void IoUringSocketHandleImpl::activateIfEnabled(uint32_t events) {
+  if (file_event_ != nullptr) {
+    static_cast<FileEventImpl*>(file_event_.get())->activateIfEnabled(events);
+  }
+}
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
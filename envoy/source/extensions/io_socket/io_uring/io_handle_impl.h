@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+
+#include "envoy/common/optref.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/network/io_handle.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/network/io_socket_handle_impl.h"
+#include "source/extensions/io_socket/io_uring/file_event_impl.h"
+#include "source/extensions/io_socket/io_uring/io_uring_worker.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+/**
+ * Looks up the ring of the thread that runs a dispatcher.
+ */
+class IoUringWorkerProvider {
+public:
+  virtual ~IoUringWorkerProvider() = default;
+
+  /**
+   * @return the worker for the dispatcher, if it runs on the calling thread and has a usable ring.
+   */
+  virtual OptRef<IoUringWorker> workerForDispatcher(Event::Dispatcher& dispatcher) const PURE;
+};
+
+/**
+ * IoHandle for sockets whose reads and writes are submitted to the ring of the thread they run on.
+ *
+ * Only stream sockets that are not listening use the ring, i.e. those returned by accept() and
+ * client sockets, and only once initializeFileEvent() is called on a thread with a worker. A client
+ * socket may set up its file event before connect(); it starts reading and reports writability
+ * once the connect has completed. Everything else, including listening and datagram sockets,
+ * behaves exactly like IoSocketHandleImpl.
+ *
+ * While on the ring, the socket keeps one read outstanding whenever its read buffer is below one
+ * read buffer size, and read()/readv()/recv() are served from what has completed. write() and
+ * writev() move data into a per-socket queue, bounded by write_buffer_limit_, that is written
+ * out in the order it was accepted. Data that is still queued when the socket is closed is
+ * written out before the file descriptor is closed, for at most the worker's close flush timeout.
+ * A socket set to reset on close (SO_LINGER with a zero timeout) drops the queued data and closes
+ * right away.
+ */
+class IoUringSocketHandleImpl final : public Network::IoSocketHandleImpl {
+public:
+  IoUringSocketHandleImpl(const IoUringWorkerProvider& provider, os_fd_t fd = INVALID_SOCKET,
+                          bool socket_v6only = false, absl::optional<int> domain = absl::nullopt)
+      : Network::IoSocketHandleImpl(fd, socket_v6only, domain), provider_(provider) {}
+  ~IoUringSocketHandleImpl() override;
+
+  // Network::IoHandle
+  Api::IoCallUint64Result close() override;
+  Api::IoCallUint64Result readv(uint64_t max_length, Buffer::RawSlice* slices,
+                                uint64_t num_slice) override;
+  Api::IoCallUint64Result read(Buffer::Instance& buffer,
+                               absl::optional<uint64_t> max_length) override;
+  Api::IoCallUint64Result writev(const Buffer::RawSlice* slices, uint64_t num_slice) override;
+  Api::IoCallUint64Result write(Buffer::Instance& buffer) override;
+  Api::IoCallUint64Result recv(void* buffer, size_t length, int flags) override;
+  Network::IoHandlePtr accept(struct sockaddr* addr, socklen_t* addrlen) override;
+  Api::SysCallIntResult connect(Network::Address::InstanceConstSharedPtr address) override;
+  void initializeFileEvent(Event::Dispatcher& dispatcher, Event::FileReadyCb cb,
+                           Event::FileTriggerType trigger, uint32_t events) override;
+  Api::SysCallIntResult shutdown(int how) override;
+  // The data of a socket on the ring is read and written by the ring, so the file descriptor
+  // must not be spliced.
+  bool supportsSplice() const override { return false; }
+
+  // Called by FileEventImpl.
+  void onEventsEnabled(uint32_t events);
+  bool isReadable() const;
+  bool isWritable() const;
+  bool isPeerClosed() const { return read_eof_; }
+
+  // Called by IoUringWorker.
+  void onReadCompleted(Request& request, int32_t result);
+  void onWriteCompleted(Request& request, int32_t result);
+  void onPollCompleted(Request& request, int32_t result);
+  void onWorkerDestroyed();
+
+private:
+  bool isClientStreamSocket();
+  bool resetOnClose();
+  uint64_t pendingWriteBytes() const;
+  void maybeSubmitConnectPoll(uint32_t events);
+  void maybeSubmitRead();
+  void maybeSubmitWrite();
+  void appendReadData(Request& request, uint64_t length);
+  void activateIfEnabled(uint32_t events);
+  Api::IoCallUint64Result emptyReadResult();
+  Api::IoCallUint64Result errorResult(int error);
+
+  const IoUringWorkerProvider& provider_;
+  // Set for accepted sockets and stream sockets that connect(). Sockets on the ring only read, and
+  // wait for the connect to complete, once this is set.
+  bool connection_{};
+  // Set while the ring drives this socket.
+  IoUringWorker* worker_{};
+
+  Request* read_req_{};
+  Buffer::OwnedImpl read_buf_;
+  bool read_eof_{};
+  int read_error_{};
+
+  Request* write_req_{};
+  Buffer::OwnedImpl write_buf_;
+  int write_error_{};
+  // Set once the socket is known to be connected.
+  bool writable_{};
+  // Set when write() was refused because the queue was full.
+  bool write_blocked_{};
+  // A shutdown() that has to wait until the queue has been written.
+  absl::optional<int> shutdown_how_;
+
+  // Poll that detects completion of a non-blocking connect().
+  Request* connect_poll_req_{};
+};
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
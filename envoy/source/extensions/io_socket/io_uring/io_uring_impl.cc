@@ -0,0 +1,259 @@
+#include "source/extensions/io_socket/io_uring/io_uring_impl.h"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "source/common/common/assert.h"
+#include "source/common/common/utility.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+namespace {
+
+template <typename T> T* ringPointer(void* ring, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+} // namespace
+
+IoUringImpl::IoUringImpl(uint32_t entries) {
+  const int ring_fd = syscall(__NR_io_uring_setup, entries, &params_);
+  if (ring_fd < 0) {
+    ENVOY_LOG(warn, "io_uring_setup failed: {}", errorDetails(errno));
+    return;
+  }
+  ring_fd_ = ring_fd;
+
+  sq_ring_size_ = params_.sq_off.array + params_.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ = params_.cq_off.cqes + params_.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single_mmap = (params_.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    ENVOY_LOG(warn, "failed to map io_uring submission ring: {}", errorDetails(errno));
+    close();
+    return;
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      ENVOY_LOG(warn, "failed to map io_uring completion ring: {}", errorDetails(errno));
+      close();
+      return;
+    }
+  }
+  sqes_size_ = params_.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    ENVOY_LOG(warn, "failed to map io_uring submission entries: {}", errorDetails(errno));
+    close();
+    return;
+  }
+  sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+  sq_head_ = ringPointer<uint32_t>(sq_ring_, params_.sq_off.head);
+  sq_tail_ptr_ = ringPointer<uint32_t>(sq_ring_, params_.sq_off.tail);
+  sq_mask_ = ringPointer<uint32_t>(sq_ring_, params_.sq_off.ring_mask);
+  sq_array_ = ringPointer<uint32_t>(sq_ring_, params_.sq_off.array);
+  cq_head_ = ringPointer<uint32_t>(cq_ring_, params_.cq_off.head);
+  cq_tail_ = ringPointer<uint32_t>(cq_ring_, params_.cq_off.tail);
+  cq_mask_ = ringPointer<uint32_t>(cq_ring_, params_.cq_off.ring_mask);
+  cqes_ = ringPointer<struct io_uring_cqe>(cq_ring_, params_.cq_off.cqes);
+  sq_tail_ = submitted_tail_ = *sq_tail_ptr_;
+
+  event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd_ < 0 ||
+      syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_EVENTFD, &event_fd_, 1) != 0) {
+    ENVOY_LOG(warn, "failed to register io_uring eventfd: {}", errorDetails(errno));
+    close();
+    return;
+  }
+}
+
+IoUringImpl::~IoUringImpl() { close(); }
+
+void IoUringImpl::close() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+  if (event_fd_ >= 0) {
+    ::close(event_fd_);
+    event_fd_ = -1;
+  }
+  if (ring_fd_ >= 0) {
+    ::close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
+
+bool IoUringImpl::registerBuffers(const std::vector<struct iovec>& buffers) {
+  ASSERT(isOpen());
+  if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, buffers.data(),
+              buffers.size()) != 0) {
+    ENVOY_LOG(warn, "failed to register {} io_uring buffers: {}", buffers.size(),
+              errorDetails(errno));
+    return false;
+  }
+  return true;
+}
+
+struct io_uring_sqe* IoUringImpl::getSqe() {
+  ASSERT(isOpen());
+  const uint32_t head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (sq_tail_ - head >= params_.sq_entries) {
+    return nullptr;
+  }
+  const uint32_t index = sq_tail_ & *sq_mask_;
+  struct io_uring_sqe* sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  sq_tail_++;
+  return sqe;
+}
+
+bool IoUringImpl::prepareRead(os_fd_t fd, uint8_t* buf, uint32_t len, uint64_t user_data) {
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(buf);
+  sqe->len = len;
+  sqe->user_data = user_data;
+  return true;
+}
+
+bool IoUringImpl::prepareReadFixed(os_fd_t fd, uint8_t* buf, uint32_t len, uint16_t buf_index,
+                                   uint64_t user_data) {
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_READ_FIXED;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(buf);
+  sqe->len = len;
+  sqe->buf_index = buf_index;
+  sqe->user_data = user_data;
+  return true;
+}
+
+bool IoUringImpl::prepareWritev(os_fd_t fd, const struct iovec* iovecs, uint32_t num_vecs,
+                                uint64_t user_data) {
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_WRITEV;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(iovecs);
+  sqe->len = num_vecs;
+  sqe->user_data = user_data;
+  return true;
+}
+
+bool IoUringImpl::preparePollAdd(os_fd_t fd, uint32_t events, uint64_t user_data, bool link) {
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = events;
+  sqe->user_data = user_data;
+  if (link) {
+    sqe->flags |= IOSQE_IO_LINK;
+  }
+  return true;
+}
+
+bool IoUringImpl::prepareCancel(uint64_t target_user_data, uint64_t user_data) {
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = target_user_data;
+  sqe->user_data = user_data;
+  return true;
+}
+
+int IoUringImpl::submit() { return submitAndWait(0); }
+
+int IoUringImpl::submitAndWait(uint32_t min_complete) {
+  ASSERT(isOpen());
+  const uint32_t to_submit = sq_tail_ - submitted_tail_;
+  if (to_submit == 0 && min_complete == 0) {
+    return 0;
+  }
+  __atomic_store_n(sq_tail_ptr_, sq_tail_, __ATOMIC_RELEASE);
+  const uint32_t flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+  int rc;
+  do {
+    rc = syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0);
+  } while (rc < 0 && errno == EINTR);
+  if (rc < 0) {
+    return -errno;
+  }
+  // The kernel may take fewer entries than offered, e.g. while the completion queue is
+  // overflowing. The rest stay queued for the next call.
+  submitted_tail_ += rc;
+  return rc;
+}
+
+void IoUringImpl::forEveryCompletion(const CompletionCb& cb) {
+  ASSERT(isOpen());
+  uint64_t value;
+  // A single read resets the eventfd counter. Completions posted after this point will make it
+  // readable again, so nothing is missed by draining the ring below.
+  while (::read(event_fd_, &value, sizeof(value)) < 0 && errno == EINTR) {
+  }
+
+  uint32_t head = *cq_head_;
+  while (true) {
+    const uint32_t tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      break;
+    }
+    const struct io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+    const uint64_t user_data = cqe.user_data;
+    const int32_t result = cqe.res;
+    // Release the entry before the callback so that it can prepare and submit more operations.
+    __atomic_store_n(cq_head_, ++head, __ATOMIC_RELEASE);
+    cb(user_data, result);
+  }
+}
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "envoy/common/platform.h"
+
+#include "source/common/common/logger.h"
+#include "source/common/common/non_copyable.h"
+
+#include "linux/io_uring.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+/**
+ * Thin wrapper around an io_uring instance, set up with the raw io_uring_setup(2),
+ * io_uring_enter(2) and io_uring_register(2) system calls so no extra library is needed.
+ *
+ * Operations are queued with the prepare*() methods and only handed to the kernel by submit(),
+ * which lets the caller batch everything queued during a dispatcher loop iteration into one
+ * system call. Completions are posted to an eventfd, which the caller polls with the dispatcher,
+ * and drained with forEveryCompletion().
+ *
+ * Not thread safe; each worker owns its own instance.
+ */
+class IoUringImpl : NonCopyable, protected Logger::Loggable<Logger::Id::io> {
+public:
+  using CompletionCb = std::function<void(uint64_t user_data, int32_t result)>;
+
+  /**
+   * @param entries supplies the number of submission queue entries. The kernel rounds it up to a
+   *        power of two.
+   */
+  explicit IoUringImpl(uint32_t entries);
+  ~IoUringImpl();
+
+  /**
+   * @return true if the ring was set up. False if the kernel doesn't support io_uring or it is
+   *         blocked, in which case none of the other methods may be called.
+   */
+  bool isOpen() const { return ring_fd_ >= 0; }
+
+  /**
+   * @return the eventfd that becomes readable when completions are posted.
+   */
+  os_fd_t eventFd() const { return event_fd_; }
+
+  /**
+   * Register buffers for IORING_OP_READ_FIXED.
+   * @return true on success. On failure (typically RLIMIT_MEMLOCK) fixed reads can't be used.
+   */
+  bool registerBuffers(const std::vector<struct iovec>& buffers);
+
+  /**
+   * Each prepare method returns false if the submission queue is full. The caller should then
+   * submit() and try again.
+   */
+  bool prepareRead(os_fd_t fd, uint8_t* buf, uint32_t len, uint64_t user_data);
+  bool prepareReadFixed(os_fd_t fd, uint8_t* buf, uint32_t len, uint16_t buf_index,
+                        uint64_t user_data);
+  bool prepareWritev(os_fd_t fd, const struct iovec* iovecs, uint32_t num_vecs,
+                     uint64_t user_data);
+  // If link is true, the operation prepared next only starts once the poll has fired.
+  bool preparePollAdd(os_fd_t fd, uint32_t events, uint64_t user_data, bool link);
+  bool prepareCancel(uint64_t target_user_data, uint64_t user_data);
+
+  /**
+   * @return the number of submission queue entries.
+   */
+  uint32_t entries() const { return params_.sq_entries; }
+
+  /**
+   * @return the number of operations that have been prepared but not submitted yet.
+   */
+  uint32_t pending() const { return sq_tail_ - submitted_tail_; }
+
+  /**
+   * Hand all prepared operations to the kernel.
+   * @return the number of operations submitted, or a negative errno.
+   */
+  int submit();
+
+  /**
+   * Like submit(), but also blocks until at least min_complete completions are available.
+   */
+  int submitAndWait(uint32_t min_complete);
+
+  /**
+   * Clear the eventfd and invoke cb for every completion that has been posted.
+   */
+  void forEveryCompletion(const CompletionCb& cb);
+
+private:
+  struct io_uring_sqe* getSqe();
+  void close();
+
+  os_fd_t ring_fd_{-1};
+  os_fd_t event_fd_{-1};
+  struct io_uring_params params_ {};
+
+  void* sq_ring_{};
+  size_t sq_ring_size_{};
+  void* cq_ring_{};
+  size_t cq_ring_size_{};
+  struct io_uring_sqe* sqes_{};
+  size_t sqes_size_{};
+
+  // Pointers into the shared submission ring.
+  uint32_t* sq_head_{};
+  uint32_t* sq_tail_ptr_{};
+  uint32_t* sq_mask_{};
+  uint32_t* sq_array_{};
+  // Pointers into the shared completion ring.
+  uint32_t* cq_head_{};
+  uint32_t* cq_tail_{};
+  uint32_t* cq_mask_{};
+  struct io_uring_cqe* cqes_{};
+
+  // Local copy of the submission tail, published to the kernel by submit().
+  uint32_t sq_tail_{};
+  uint32_t submitted_tail_{};
+};
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,416 @@
+#include "source/extensions/io_socket/io_uring/io_uring_worker.h"
+
+#include <poll.h>
+
+#include <algorithm>
+
+#include "envoy/api/os_sys_calls.h"
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/common/lock_guard.h"
+#include "source/common/common/utility.h"
+#include "source/extensions/io_socket/io_uring/io_handle_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+namespace {
+
+// Requests are heap allocated and so at least 8 byte aligned. The low bit of the user data tags
+// the poll that is linked in front of a request after it failed with EAGAIN. Cancel operations
+// use a user data of 0.
+constexpr uint64_t LinkedPollTag = 1;
+
+uint64_t userData(const Request& request) { return reinterpret_cast<uint64_t>(&request); }
+
+} // namespace
+
+RegisteredBufferPool::RegisteredBufferPool(uint32_t count, uint32_t buffer_size)
+    : count_(count), buffer_size_(buffer_size),
+      memory_(new uint8_t[static_cast<uint64_t>(count) * buffer_size]) {
+  free_.reserve(count);
+  for (int32_t index = count - 1; index >= 0; index--) {
+    free_.push_back(index);
+  }
+}
+
+std::vector<struct iovec> RegisteredBufferPool::iovecs() const {
+  std::vector<struct iovec> iovecs(count_);
+  for (uint32_t index = 0; index < count_; index++) {
+    iovecs[index].iov_base = memory_.get() + static_cast<uint64_t>(index) * buffer_size_;
+    iovecs[index].iov_len = buffer_size_;
+  }
+  return iovecs;
+}
+
+int32_t RegisteredBufferPool::acquire() {
+  Thread::LockGuard lock(mutex_);
+  if (free_.empty()) {
+    return -1;
+  }
+  const int32_t index = free_.back();
+  free_.pop_back();
+  return index;
+}
+
+void RegisteredBufferPool::release(int32_t index) {
+  Thread::LockGuard lock(mutex_);
+  free_.push_back(index);
+}
+
+Request::~Request() {
+  if (buf_index_ >= 0) {
+    pool_->release(buf_index_);
+  }
+  if (storage_ != nullptr) {
+    Buffer::SliceStoragePool::release(std::move(storage_), buf_size_);
+  }
+}
+
+IoUringWorker::IoUringWorker(const IoUringConfig& config, Event::Dispatcher& dispatcher)
+    : config_(config), dispatcher_(dispatcher), ring_(config.ring_size_) {
+  if (!ring_.isOpen()) {
+    ENVOY_LOG(warn, "io_uring is not available, sockets fall back to readiness based I/O");
+    return;
+  }
+  if (config_.registered_buffer_count_ > 0) {
+    auto pool = std::make_shared<RegisteredBufferPool>(config_.registered_buffer_count_,
+                                                       config_.read_buffer_size_);
+    if (ring_.registerBuffers(pool->iovecs())) {
+      pool_ = std::move(pool);
+    }
+  }
+  file_event_ = dispatcher_.createFileEvent(
+      ring_.eventFd(), [this](uint32_t) { onCompletions(); }, Event::PlatformDefaultTriggerType,
+      Event::FileReadyType::Read);
+  submit_cb_ = dispatcher_.createSchedulableCallback([this]() { flush(); });
+}
+
+IoUringWorker::~IoUringWorker() {
+  if (!ring_.isOpen()) {
+    return;
+  }
+  file_event_.reset();
+  submit_cb_.reset();
+
+  for (IoUringSocketHandleImpl* handle : handles_) {
+    handle->onWorkerDestroyed();
+  }
+  handles_.clear();
+
+  // Deferred operations never reached the kernel.
+  for (const DeferredPrepare& deferred : deferred_) {
+    if (deferred.request_ != nullptr) {
+      deferred.request_->in_flight_ = false;
+    }
+  }
+  deferred_.clear();
+
+  // The kernel may still write into the memory of reads that are in flight, so cancel everything
+  // and wait for the completions before that memory is freed.
+  for (auto& entry : requests_) {
+    Request& request = *entry.second;
+    request.handle_ = nullptr;
+    request.close_timer_.reset();
+    if (!request.in_flight_) {
+      continue;
+    }
+    for (const uint64_t user_data : {userData(request), userData(request) | LinkedPollTag}) {
+      if (!ring_.prepareCancel(user_data, 0)) {
+        ring_.submit();
+        ring_.prepareCancel(user_data, 0);
+      }
+    }
+  }
+  while (true) {
+    bool in_flight = false;
+    for (const auto& entry : requests_) {
+      in_flight |= entry.second->in_flight_;
+    }
+    if (!in_flight) {
+      break;
+    }
+    if (ring_.submitAndWait(1) < 0) {
+      break;
+    }
+    ring_.forEveryCompletion([this](uint64_t user_data, int32_t) {
+      if (user_data == 0 || (user_data & LinkedPollTag) != 0) {
+        return;
+      }
+      auto it = requests_.find(reinterpret_cast<Request*>(user_data));
+      if (it != requests_.end()) {
+        it->second->in_flight_ = false;
+      }
+    });
+  }
+  for (auto& entry : requests_) {
+    if (entry.second->close_on_drain_) {
+      closeOrphanedSocket(*entry.second);
+    }
+  }
+}
+
+Request& IoUringWorker::createRequest(Request::Type type, IoUringSocketHandleImpl* handle,
+                                      os_fd_t fd) {
+  auto request = std::make_unique<Request>(type, handle, fd);
+  if (type == Request::Type::Read) {
+    const int32_t index = pool_ != nullptr ? pool_->acquire() : -1;
+    if (index >= 0) {
+      request->buf_index_ = index;
+      request->pool_ = pool_;
+      request->buf_ = pool_->buffer(index);
+    } else {
+      request->storage_ = Buffer::SliceStoragePool::allocate(config_.read_buffer_size_);
+      request->buf_ = request->storage_.get();
+    }
+    request->buf_size_ = config_.read_buffer_size_;
+  }
+  Request& ref = *request;
+  requests_.emplace(&ref, std::move(request));
+  return ref;
+}
+
+void IoUringWorker::prepare(Request* request, std::function<bool()> prepare_cb,
+                            uint32_t entries) {
+  // Linked operations must be handed to the kernel in the same submission, so make room for all
+  // of them up front.
+  if (deferred_.empty() && ring_.pending() + entries > ring_.entries()) {
+    flush();
+  }
+  if (!deferred_.empty() || ring_.pending() + entries > ring_.entries()) {
+    // The kernel didn't take enough entries, e.g. because the completion queue is backed up. Keep
+    // the operations, behind any deferred earlier, until flush() finds room for them.
+    deferred_.push_back({request, std::move(prepare_cb), entries});
+  } else {
+    const bool prepared = prepare_cb();
+    ASSERT(prepared);
+  }
+  if (!submit_cb_->enabled()) {
+    submit_cb_->scheduleCallbackCurrentIteration();
+  }
+}
+
+void IoUringWorker::submit(Request& request, bool poll_first) {
+  ASSERT(!request.in_flight_);
+  request.in_flight_ = true;
+  const uint64_t user_data = userData(request);
+
+  switch (request.type_) {
+  case Request::Type::Read:
+    prepare(
+        &request,
+        [this, &request, user_data, poll_first]() {
+          if (poll_first &&
+              !ring_.preparePollAdd(request.fd_, POLLIN, user_data | LinkedPollTag, true)) {
+            return false;
+          }
+          return request.buf_index_ >= 0
+                     ? ring_.prepareReadFixed(request.fd_, request.buf_, request.buf_size_,
+                                              request.buf_index_, user_data)
+                     : ring_.prepareRead(request.fd_, request.buf_, request.buf_size_, user_data);
+        },
+        poll_first ? 2 : 1);
+    break;
+  case Request::Type::Write: {
+    request.iovecs_.clear();
+    for (const Buffer::RawSlice& slice : request.data_.getRawSlices(Request::MaxIovecs)) {
+      request.iovecs_.push_back({slice.mem_, slice.len_});
+    }
+    prepare(
+        &request,
+        [this, &request, user_data, poll_first]() {
+          if (poll_first &&
+              !ring_.preparePollAdd(request.fd_, POLLOUT, user_data | LinkedPollTag, true)) {
+            return false;
+          }
+          return ring_.prepareWritev(request.fd_, request.iovecs_.data(), request.iovecs_.size(),
+                                     user_data);
+        },
+        poll_first ? 2 : 1);
+    break;
+  }
+  case Request::Type::Poll:
+    prepare(
+        &request,
+        [this, &request, user_data]() {
+          return ring_.preparePollAdd(request.fd_, request.poll_events_, user_data, false);
+        },
+        1);
+    break;
+  }
+}
+
+void IoUringWorker::release(Request& request) {
+  ASSERT(!request.in_flight_);
+  requests_.erase(&request);
+}
+
+void IoUringWorker::cancel(Request& request) {
+  request.handle_ = nullptr;
+  if (removeDeferred(request)) {
+    // The kernel never saw the request.
+    request.in_flight_ = false;
+  }
+  if (!request.in_flight_) {
+    release(request);
+    return;
+  }
+  prepareCancel(request);
+  // Cancellation is typically followed by closing the file descriptor. Hand everything queued to
+  // the kernel now, so that no queued operation can end up on a socket that reuses the number.
+  flush();
+}
+
+void IoUringWorker::closeAfterWrite(Request& request) {
+  ASSERT(request.type_ == Request::Type::Write && request.handle_ == nullptr &&
+         request.in_flight_);
+  request.close_on_drain_ = true;
+  request.close_timer_ =
+      dispatcher_.createTimer([this, &request]() { onOrphanedWriteTimeout(request); });
+  request.close_timer_->enableTimer(config_.close_flush_timeout_);
+}
+
+void IoUringWorker::prepareCancel(const Request& request) {
+  // Cancel both the operation and the poll that may be linked in front of it.
+  for (const uint64_t user_data : {userData(request), userData(request) | LinkedPollTag}) {
+    prepare(nullptr, [this, user_data]() { return ring_.prepareCancel(user_data, 0); }, 1);
+  }
+}
+
+bool IoUringWorker::removeDeferred(Request& request) {
+  const auto it = std::remove_if(
+      deferred_.begin(), deferred_.end(),
+      [&request](const DeferredPrepare& deferred) { return deferred.request_ == &request; });
+  const bool removed = it != deferred_.end();
+  deferred_.erase(it, deferred_.end());
+  return removed;
+}
+
+void IoUringWorker::flush() {
+  while (true) {
+    const int rc = ring_.submit();
+    if (rc < 0) {
+      ENVOY_LOG(warn, "io_uring submission failed: {}", errorDetails(-rc));
+      break;
+    }
+    // Prepare deferred operations in the room the kernel has made, and submit those too.
+    bool prepared_deferred = false;
+    while (!deferred_.empty() &&
+           ring_.pending() + deferred_.front().entries_ <= ring_.entries()) {
+      const bool prepared = deferred_.front().prepare_cb_();
+      ASSERT(prepared);
+      deferred_.pop_front();
+      prepared_deferred = true;
+    }
+    if (!prepared_deferred) {
+      break;
+    }
+  }
+  if (ring_.pending() > 0 || !deferred_.empty()) {
+    // The kernel didn't take everything, e.g. because the completion queue is backed up. Try again
+    // once this iteration's completions have been processed.
+    submit_cb_->scheduleCallbackNextIteration();
+  }
+}
+
+void IoUringWorker::onCompletions() {
+  ring_.forEveryCompletion(
+      [this](uint64_t user_data, int32_t result) { onCompletion(user_data, result); });
+}
+
+void IoUringWorker::onCompletion(uint64_t user_data, int32_t result) {
+  // Cancellations and linked polls carry no state. If a linked poll fails, the operation behind
+  // it completes with -ECANCELED and handles the failure.
+  if (user_data == 0 || (user_data & LinkedPollTag) != 0) {
+    return;
+  }
+  auto it = requests_.find(reinterpret_cast<Request*>(user_data));
+  ASSERT(it != requests_.end());
+  if (it == requests_.end()) {
+    return;
+  }
+  Request& request = *it->second;
+  request.in_flight_ = false;
+
+  if (request.handle_ != nullptr) {
+    // The handle either resubmits the request or releases it.
+    switch (request.type_) {
+    case Request::Type::Read:
+      request.handle_->onReadCompleted(request, result);
+      break;
+    case Request::Type::Write:
+      request.handle_->onWriteCompleted(request, result);
+      break;
+    case Request::Type::Poll:
+      request.handle_->onPollCompleted(request, result);
+      break;
+    }
+    return;
+  }
+
+  if (request.type_ == Request::Type::Write && request.close_on_drain_) {
+    onOrphanedWriteCompleted(request, result);
+    return;
+  }
+  release(request);
+}
+
+void IoUringWorker::onOrphanedWriteCompleted(Request& request, int32_t result) {
+  if (request.close_flush_expired_) {
+    closeOrphanedSocket(request);
+    release(request);
+    return;
+  }
+  if (result == -EAGAIN) {
+    submit(request, true);
+    return;
+  }
+  if (result < 0) {
+    ENVOY_LOG(debug, "dropping {} bytes queued on closed socket: {}",
+              request.data_.length() + request.pending_.length(), errorDetails(-result));
+    closeOrphanedSocket(request);
+    release(request);
+    return;
+  }
+  request.data_.drain(result);
+  if (request.data_.length() == 0) {
+    request.data_.move(request.pending_);
+  }
+  if (request.data_.length() > 0) {
+    submit(request);
+    return;
+  }
+  if (request.shutdown_how_.has_value()) {
+    Api::OsSysCallsSingleton::get().shutdown(request.fd_, request.shutdown_how_.value());
+  }
+  closeOrphanedSocket(request);
+  release(request);
+}
+
+void IoUringWorker::onOrphanedWriteTimeout(Request& request) {
+  ASSERT(request.in_flight_);
+  ENVOY_LOG(debug, "dropping {} bytes queued on closed socket: close flush timeout",
+            request.data_.length() + request.pending_.length());
+  if (removeDeferred(request)) {
+    request.in_flight_ = false;
+    closeOrphanedSocket(request);
+    release(request);
+    return;
+  }
+  // The socket is closed once the kernel is done with the write.
+  request.close_flush_expired_ = true;
+  prepareCancel(request);
+}
+
+void IoUringWorker::closeOrphanedSocket(Request& request) {
+  ASSERT(request.close_on_drain_);
+  request.close_on_drain_ = false;
+  Api::OsSysCallsSingleton::get().close(request.fd_);
+}
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
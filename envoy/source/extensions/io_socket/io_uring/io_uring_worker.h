@@ -0,0 +1,206 @@
+#pragma once
+
+#include <sys/uio.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "envoy/common/platform.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/file_event.h"
+#include "envoy/event/schedulable_cb.h"
+#include "envoy/event/timer.h"
+#include "envoy/thread_local/thread_local_object.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/buffer/slice_storage_pool.h"
+#include "source/common/common/logger.h"
+#include "source/common/common/thread.h"
+#include "source/extensions/io_socket/io_uring/io_uring_impl.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+class IoUringSocketHandleImpl;
+
+struct IoUringConfig {
+  uint32_t ring_size_{1024};
+  uint32_t read_buffer_size_{16384};
+  uint32_t registered_buffer_count_{256};
+  uint32_t write_buffer_limit_{65536};
+  std::chrono::milliseconds close_flush_timeout_{1000};
+};
+
+/**
+ * Fixed set of equally sized read buffers registered with a ring, so that reads into them skip
+ * the per-operation page pinning of a regular read. Buffers handed to a Buffer::Instance as
+ * fragments may be released from any thread, and may outlive the worker.
+ */
+class RegisteredBufferPool {
+public:
+  RegisteredBufferPool(uint32_t count, uint32_t buffer_size);
+
+  std::vector<struct iovec> iovecs() const;
+  uint32_t bufferSize() const { return buffer_size_; }
+  uint8_t* buffer(int32_t index) {
+    return memory_.get() + static_cast<uint64_t>(index) * buffer_size_;
+  }
+
+  /**
+   * @return the index of a free buffer, or -1 if all are in use.
+   */
+  int32_t acquire();
+  void release(int32_t index);
+
+private:
+  const uint32_t count_;
+  const uint32_t buffer_size_;
+  std::unique_ptr<uint8_t[]> memory_;
+  Thread::MutexBasicLockable mutex_;
+  std::vector<int32_t> free_ ABSL_GUARDED_BY(mutex_);
+};
+
+using RegisteredBufferPoolSharedPtr = std::shared_ptr<RegisteredBufferPool>;
+
+/**
+ * An operation on a worker's ring. The worker owns it from creation until its last completion.
+ */
+struct Request {
+  enum class Type { Read, Write, Poll };
+
+  static constexpr uint32_t MaxIovecs = 16;
+
+  Request(Type type, IoUringSocketHandleImpl* handle, os_fd_t fd)
+      : type_(type), handle_(handle), fd_(fd) {}
+  ~Request();
+
+  const Type type_;
+  // Null once the handle has been closed. Completions are then only used for cleanup, except that
+  // writes keep going until the data queued before close() has been sent.
+  IoUringSocketHandleImpl* handle_;
+  const os_fd_t fd_;
+  // Whether the kernel currently has this request.
+  bool in_flight_{};
+
+  // Read: the memory being read into, either a registered buffer or storage_.
+  uint8_t* buf_{};
+  uint32_t buf_size_{};
+  int32_t buf_index_{-1};
+  RegisteredBufferPoolSharedPtr pool_;
+  Buffer::SliceStoragePool::StoragePtr storage_;
+
+  // Write: the bytes being written, and the iovecs the kernel reads them through.
+  Buffer::OwnedImpl data_;
+  absl::InlinedVector<struct iovec, MaxIovecs> iovecs_;
+  // Write, once the handle has closed: bytes queued behind data_, and what to do with the
+  // socket once everything has been written.
+  Buffer::OwnedImpl pending_;
+  absl::optional<int> shutdown_how_;
+  bool close_on_drain_{};
+  // Bounds the time spent writing after close. Once it fires, close_flush_expired_ is set and the
+  // socket is closed on the next completion.
+  Event::TimerPtr close_timer_;
+  bool close_flush_expired_{};
+
+  // Poll: the poll(2) events to wait for.
+  uint32_t poll_events_{};
+};
+
+/**
+ * Per-thread owner of a ring. Operations queued by the sockets of this thread during a dispatcher
+ * loop iteration are submitted together at the end of the iteration, and completions are
+ * delivered back to the sockets from the ring's eventfd.
+ */
+class IoUringWorker : public ThreadLocal::ThreadLocalObject,
+                      protected Logger::Loggable<Logger::Id::io> {
+public:
+  IoUringWorker(const IoUringConfig& config, Event::Dispatcher& dispatcher);
+  ~IoUringWorker() override;
+
+  /**
+   * @return false if the ring couldn't be set up, in which case sockets must not use the worker.
+   */
+  bool enabled() const { return ring_.isOpen(); }
+  Event::Dispatcher& dispatcher() { return dispatcher_; }
+  const IoUringConfig& config() const { return config_; }
+  const RegisteredBufferPoolSharedPtr& bufferPool() const { return pool_; }
+
+  void addHandle(IoUringSocketHandleImpl& handle) { handles_.insert(&handle); }
+  void removeHandle(IoUringSocketHandleImpl& handle) { handles_.erase(&handle); }
+
+  /**
+   * Create a request owned by this worker. Read requests come with a buffer to read into.
+   */
+  Request& createRequest(Request::Type type, IoUringSocketHandleImpl* handle, os_fd_t fd);
+
+  /**
+   * Queue a request for submission at the end of the current loop iteration.
+   * @param poll_first supplies whether to wait for the socket to become ready before the read or
+   *        write is attempted, which is needed after an operation failed with EAGAIN.
+   */
+  void submit(Request& request, bool poll_first = false);
+
+  /**
+   * Destroy a request that is not in flight.
+   */
+  void release(Request& request);
+
+  /**
+   * Detach a request from its handle and ask the kernel to cancel it. The request is destroyed
+   * once the kernel is done with it.
+   */
+  void cancel(Request& request);
+
+  /**
+   * Take over a write whose handle has been closed. The data queued on it is written out and the
+   * file descriptor closed afterwards, or once the close flush timeout has passed, whichever
+   * comes first.
+   */
+  void closeAfterWrite(Request& request);
+
+private:
+  // Operations that didn't fit in the submission queue. They are prepared by flush(), in order,
+  // once the kernel has taken enough entries.
+  struct DeferredPrepare {
+    // The request the operations belong to, if any, so that they can be dropped on cancel.
+    Request* request_;
+    std::function<bool()> prepare_cb_;
+    uint32_t entries_;
+  };
+
+  void prepare(Request* request, std::function<bool()> prepare_cb, uint32_t entries);
+  void prepareCancel(const Request& request);
+  bool removeDeferred(Request& request);
+  void flush();
+  void onCompletions();
+  void onCompletion(uint64_t user_data, int32_t result);
+  void onOrphanedWriteCompleted(Request& request, int32_t result);
+  void onOrphanedWriteTimeout(Request& request);
+  void closeOrphanedSocket(Request& request);
+
+  const IoUringConfig config_;
+  Event::Dispatcher& dispatcher_;
+  RegisteredBufferPoolSharedPtr pool_;
+  absl::flat_hash_map<Request*, std::unique_ptr<Request>> requests_;
+  absl::flat_hash_set<IoUringSocketHandleImpl*> handles_;
+  std::deque<DeferredPrepare> deferred_;
+  // Declared after requests_ so that the ring is torn down while their memory is still valid.
+  IoUringImpl ring_;
+  Event::FileEventPtr file_event_;
+  Event::SchedulableCallbackPtr submit_cb_;
+};
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
@@ -25,6 +25,7 @@
 
 #include "source/common/api/api_impl.h"
 #include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/buffer/slice_storage_pool.h"
 #include "source/common/common/enum_to_int.h"
 #include "source/common/common/mutex_tracer_impl.h"
 #include "source/common/common/utility.h"
@@ -165,38 +166,52 @@ void InstanceImpl::failHealthcheck(bool fail) {
   server_stats_->live_.set(live_.load());
 }
 
-MetricSnapshotImpl::MetricSnapshotImpl(Stats::Store& store, TimeSource& time_source) {
-  store.forEachCounter([this](std::size_t size) mutable { counters_.reserve(size); },
-                       [this](Stats::Counter& counter) mutable {
-                         counters_.push_back({counter.latch(), counter});
-                       });
-
-  store.forEachGauge([this](std::size_t size) mutable { gauges_.reserve(size); },
-                     [this](Stats::Gauge& gauge) mutable {
-                       ASSERT(gauge.importMode() != Stats::Gauge::ImportMode::Uninitialized);
-                       gauges_.push_back(gauge);
-                     });
+MetricSnapshotImpl::MetricSnapshotImpl(Stats::Store& store, TimeSource& time_source,
+                                       bool changed_only) {
+  auto counters_size = [this](std::size_t size) mutable { counters_.reserve(size); };
+  auto add_counter = [this](Stats::Counter& counter) mutable {
+    counters_.push_back({counter.latch(), counter});
+  };
+  auto gauges_size = [this](std::size_t size) mutable { gauges_.reserve(size); };
+  auto add_gauge = [this](Stats::Gauge& gauge) mutable {
+    ASSERT(gauge.importMode() != Stats::Gauge::ImportMode::Uninitialized);
+    gauges_.push_back(gauge);
+  };
+  auto text_readouts_size = [this](std::size_t size) mutable { text_readouts_.reserve(size); };
+  auto add_text_readout = [this](Stats::TextReadout& text_readout) {
+    text_readouts_.push_back(text_readout);
+  };
+
+  if (changed_only) {
+    // Counters that didn't change have nothing pending, so latching only the changed ones
+    // latches every counter as well.
+    store.forEachChangedCounter(counters_size, add_counter);
+    store.forEachChangedGauge(gauges_size, add_gauge);
+    store.forEachChangedTextReadout(text_readouts_size, add_text_readout);
+  } else {
+    store.forEachCounter(counters_size, add_counter);
+    store.forEachGauge(gauges_size, add_gauge);
+    store.forEachTextReadout(text_readouts_size, add_text_readout);
+  }
 
   snapped_histograms_ = store.histograms();
   histograms_.reserve(snapped_histograms_.size());
   for (const auto& histogram : snapped_histograms_) {
-    histograms_.push_back(*histogram);
+    if (!changed_only || histogram->intervalStatistics().sampleCount() > 0) {
+      histograms_.push_back(*histogram);
+    }
   }
 
-  store.forEachTextReadout(
-      [this](std::size_t size) mutable { text_readouts_.reserve(size); },
-      [this](Stats::TextReadout& text_readout) { text_readouts_.push_back(text_readout); });
-
   snapshot_time_ = time_source.systemTime();
 }
 
 void InstanceUtil::flushMetricsToSinks(const std::list<Stats::SinkPtr>& sinks, Stats::Store& store,
-                                       TimeSource& time_source) {
+                                       TimeSource& time_source, bool changed_only) {
   // Create a snapshot and flush to all sinks.
   // NOTE: Even if there are no sinks, creating the snapshot has the important property that it
   //       latches all counters on a periodic basis. The hot restart code assumes this is being
   //       done so this should not be removed.
-  MetricSnapshotImpl snapshot(store, time_source);
+  MetricSnapshotImpl snapshot(store, time_source, changed_only);
   for (const auto& sink : sinks) {
     sink->flush(snapshot);
   }
@@ -234,6 +249,13 @@ void InstanceImpl::updateServerStats() {
                                        parent_stats.parent_memory_allocated_);
   server_stats_->memory_heap_size_.set(Memory::Stats::totalCurrentlyReserved());
   server_stats_->memory_physical_size_.set(Memory::Stats::totalPhysicalBytes());
+  const Buffer::SliceStoragePoolStats slice_pool_stats = Buffer::SliceStoragePool::stats();
+  server_stats_->memory_slice_pool_held_.set(slice_pool_stats.bytes_held_);
+  server_stats_->memory_slice_pool_hits_.add(slice_pool_stats.hits_ - reported_slice_pool_hits_);
+  server_stats_->memory_slice_pool_misses_.add(slice_pool_stats.misses_ -
+                                               reported_slice_pool_misses_);
+  reported_slice_pool_hits_ = slice_pool_stats.hits_;
+  reported_slice_pool_misses_ = slice_pool_stats.misses_;
   server_stats_->parent_connections_.set(parent_stats.parent_connections_);
   server_stats_->total_connections_.set(listener_manager_->numConnections() +
                                         parent_stats.parent_connections_);
@@ -255,7 +277,8 @@ void InstanceImpl::updateServerStats() {
 void InstanceImpl::flushStatsInternal() {
   updateServerStats();
   auto& stats_config = config_.statsConfig();
-  InstanceUtil::flushMetricsToSinks(stats_config.sinks(), stats_store_, timeSource());
+  InstanceUtil::flushMetricsToSinks(stats_config.sinks(), stats_store_, timeSource(),
+                                    stats_config.flushChangedOnly());
   // TODO(ramaraochavali): consider adding different flush interval for histograms.
   if (stat_flush_timer_ != nullptr) {
     stat_flush_timer_->enableTimer(stats_config.flushInterval());
@@ -384,6 +407,11 @@ void InstanceImpl::initialize(const Options& options,
   stats_store_.setStatsMatcher(
       Config::Utility::createStatsMatcher(bootstrap_, stats_store_.symbolTable()));
   stats_store_.setHistogramSettings(Config::Utility::createHistogramSettings(bootstrap_));
+  stats_store_.setCounterShards(
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(bootstrap_.stats_config(), counter_shards, 1));
+  stats_store_.setHistogramMergeThreads(
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(bootstrap_.stats_config(), histogram_merge_threads, 1),
+      api_->threadFactory());
 
   const std::string server_stats_prefix = "server.";
   const std::string server_compilation_settings_stats_prefix = "server.compilation_settings";
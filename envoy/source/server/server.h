@@ -72,6 +72,8 @@ struct ServerCompilationSettingsStats {
   COUNTER(dynamic_unknown_fields)                                                                  \
   COUNTER(static_unknown_fields)                                                                   \
   COUNTER(dropped_stat_flushes)                                                                    \
+  COUNTER(memory_slice_pool_hits)                                                                  \
+  COUNTER(memory_slice_pool_misses)                                                                \
   GAUGE(concurrency, NeverImport)                                                                  \
   GAUGE(days_until_first_cert_expiring, NeverImport)                                               \
   GAUGE(seconds_until_first_ocsp_response_expiring, NeverImport)                                   \
@@ -81,6 +83,7 @@ struct ServerCompilationSettingsStats {
   GAUGE(memory_allocated, Accumulate)                                                              \
   GAUGE(memory_heap_size, Accumulate)                                                              \
   GAUGE(memory_physical_size, Accumulate)                                                          \
+  GAUGE(memory_slice_pool_held, NeverImport)                                                       \
   GAUGE(parent_connections, Accumulate)                                                            \
   GAUGE(state, NeverImport)                                                                        \
   GAUGE(stats_recent_lookups, NeverImport)                                                         \
@@ -127,9 +130,10 @@ public:
    * flush() on each sink.
    * @param sinks supplies the list of sinks.
    * @param store provides the store being flushed.
+   * @param changed_only whether to flush only the stats that changed since the previous flush.
    */
   static void flushMetricsToSinks(const std::list<Stats::SinkPtr>& sinks, Stats::Store& store,
-                                  TimeSource& time_source);
+                                  TimeSource& time_source, bool changed_only = false);
 
   /**
    * Load a bootstrap config and perform validation.
@@ -339,6 +343,9 @@ private:
   time_t original_start_time_;
   Stats::StoreRoot& stats_store_;
   std::unique_ptr<ServerStats> server_stats_;
+  // Slice pool totals already added to the memory_slice_pool_* counters.
+  uint64_t reported_slice_pool_hits_{};
+  uint64_t reported_slice_pool_misses_{};
   std::unique_ptr<CompilationSettings::ServerCompilationSettingsStats>
       server_compilation_settings_stats_;
   Assert::ActionRegistrationPtr assert_action_registration_;
@@ -408,7 +415,11 @@ private:
 //                     copying and probably be a cleaner API in general.
 class MetricSnapshotImpl : public Stats::MetricSnapshot {
 public:
-  explicit MetricSnapshotImpl(Stats::Store& store, TimeSource& time_source);
+  /**
+   * @param changed_only whether to snap only the counters, gauges and text readouts that changed
+   *        since the previous snapshot that did, and the histograms with values in the interval.
+   */
+  MetricSnapshotImpl(Stats::Store& store, TimeSource& time_source, bool changed_only = false);
 
   // Stats::MetricSnapshot
   const std::vector<CounterSnapshot>& counters() override { return counters_; }
@@ -1,4 +1,7 @@
+#include <atomic>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "source/common/access_log/access_log_manager_impl.h"
 #include "source/common/filesystem/file_shared_impl.h"
@@ -11,6 +14,7 @@
 #include "test/test_common/test_time.h"
 #include "test/test_common/utility.h"
 
+#include "absl/synchronization/notification.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -460,6 +464,75 @@ TEST_F(AccessLogManagerImplTest, BigDataChunkShouldBeFlushedWithoutTimer) {
   EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
 }
 
+TEST_F(AccessLogManagerImplTest, WritesFromManyThreads) {
+  EXPECT_CALL(*file_, open_(_)).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+  AccessLogFileSharedPtr log_file = access_log_manager_.createAccessLog(
+      Filesystem::FilePathAndType{Filesystem::DestinationType::File, "foo"});
+
+  std::atomic<uint64_t> written_bytes{0};
+  EXPECT_CALL(*file_, write_(_))
+      .WillRepeatedly(Invoke([&](absl::string_view data) -> Api::IoCallSizeResult {
+        written_bytes += data.length();
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+
+  const std::string line = "a line of the access log\n";
+  std::vector<Thread::ThreadPtr> threads;
+  for (int i = 0; i < 8; i++) {
+    threads.push_back(thread_factory_.createThread([&]() {
+      for (int j = 0; j < 1000; j++) {
+        log_file->write(line);
+      }
+    }));
+  }
+  for (Thread::ThreadPtr& thread : threads) {
+    thread->join();
+  }
+
+  log_file->flush();
+  waitForGaugeEq("filesystem.write_total_buffered", 0);
+  EXPECT_EQ(8 * 1000 * line.length(), written_bytes);
+  EXPECT_EQ(8 * 1000, store_.counter("filesystem.write_buffered").value());
+  EXPECT_EQ(0UL, store_.counter("filesystem.write_dropped").value());
+
+  EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
+// Writes are dropped once a thread's buffer is full because the file can't keep up.
+TEST_F(AccessLogManagerImplTest, WritesDroppedWhenBufferFull) {
+  EXPECT_CALL(*file_, open_(_)).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+  AccessLogFileSharedPtr log_file = access_log_manager_.createAccessLog(
+      Filesystem::FilePathAndType{Filesystem::DestinationType::File, "foo"});
+
+  absl::Notification writing;
+  absl::Notification unblock;
+  EXPECT_CALL(*file_, write_(_))
+      .WillRepeatedly(Invoke([&](absl::string_view data) -> Api::IoCallSizeResult {
+        if (!writing.HasBeenNotified()) {
+          writing.Notify();
+        }
+        unblock.WaitForNotification();
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+
+  // The first write is flushed right away, and the flush thread blocks writing it.
+  log_file->write("first");
+  writing.WaitForNotification();
+
+  // The buffer holds 8 MiB.
+  const std::string chunk(1024 * 1024, 'a');
+  for (int i = 0; i < 10; i++) {
+    log_file->write(chunk);
+  }
+  EXPECT_EQ(2UL, store_.counter("filesystem.write_dropped").value());
+  EXPECT_EQ(9UL, store_.counter("filesystem.write_buffered").value());
+
+  unblock.Notify();
+  log_file->flush();
+  waitForGaugeEq("filesystem.write_total_buffered", 0);
+  EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
 TEST_F(AccessLogManagerImplTest, ReopenAllFiles) {
   EXPECT_CALL(dispatcher_, createTimer_(_)).WillRepeatedly(ReturnNew<NiceMock<Event::MockTimer>>());
 
@@ -0,0 +1,149 @@
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/buffer/slice_storage_pool.h"
+
+#include "test/test_common/thread_factory_for_test.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+using StoragePtr = SliceStoragePool::StoragePtr;
+
+void runOnNewThread(std::function<void()> cb) {
+  Thread::ThreadPtr thread = Thread::threadFactoryForTest().createThread(std::move(cb));
+  thread->join();
+}
+
+TEST(SliceStoragePoolTest, SizeClasses) {
+  EXPECT_EQ(0, SliceStoragePool::sizeClass(4096));
+  EXPECT_EQ(1, SliceStoragePool::sizeClass(8192));
+  EXPECT_EQ(2, SliceStoragePool::sizeClass(12288));
+  EXPECT_EQ(3, SliceStoragePool::sizeClass(16384));
+  EXPECT_EQ(4, SliceStoragePool::sizeClass(32768));
+  EXPECT_EQ(5, SliceStoragePool::sizeClass(49152));
+  EXPECT_EQ(6, SliceStoragePool::sizeClass(65536));
+
+  // Not pooled.
+  EXPECT_EQ(SliceStoragePool::NumSizeClasses, SliceStoragePool::sizeClass(0));
+  EXPECT_EQ(SliceStoragePool::NumSizeClasses, SliceStoragePool::sizeClass(100));
+  EXPECT_EQ(SliceStoragePool::NumSizeClasses, SliceStoragePool::sizeClass(20480));
+  EXPECT_EQ(SliceStoragePool::NumSizeClasses, SliceStoragePool::sizeClass(69632));
+
+  for (uint32_t size_class = 0; size_class < SliceStoragePool::NumSizeClasses; size_class++) {
+    EXPECT_EQ(size_class, SliceStoragePool::sizeClass(SliceStoragePool::classCapacity(size_class)));
+    EXPECT_GE(SliceStoragePool::threadCacheLimit(size_class),
+              SliceStoragePool::MinThreadCacheEntries);
+  }
+}
+
+TEST(SliceStoragePoolTest, ReusesStorageOnSameThread) {
+  runOnNewThread([]() {
+    StoragePtr storage = SliceStoragePool::allocate(8192);
+    uint8_t* raw = storage.get();
+    const SliceStoragePoolStats before = SliceStoragePool::stats();
+    SliceStoragePool::release(std::move(storage), 8192);
+    EXPECT_EQ(8192, SliceStoragePool::stats().bytes_held_ - before.bytes_held_);
+
+    storage = SliceStoragePool::allocate(8192);
+    EXPECT_EQ(raw, storage.get());
+    const SliceStoragePoolStats after = SliceStoragePool::stats();
+    EXPECT_EQ(1, after.hits_ - before.hits_);
+    EXPECT_EQ(before.misses_, after.misses_);
+    EXPECT_EQ(before.bytes_held_, after.bytes_held_);
+    SliceStoragePool::release(std::move(storage), 8192);
+  });
+}
+
+TEST(SliceStoragePoolTest, UnpooledSizesBypassPool) {
+  runOnNewThread([]() {
+    const SliceStoragePoolStats before = SliceStoragePool::stats();
+    StoragePtr storage = SliceStoragePool::allocate(20480);
+    SliceStoragePool::release(std::move(storage), 20480);
+    const SliceStoragePoolStats after = SliceStoragePool::stats();
+    EXPECT_EQ(before.hits_, after.hits_);
+    EXPECT_EQ(before.misses_, after.misses_);
+    EXPECT_EQ(before.bytes_held_, after.bytes_held_);
+  });
+}
+
+// Storage released on one thread beyond its cache limit is handed to the depot, where another
+// thread picks it up instead of going to the system allocator.
+TEST(SliceStoragePoolTest, CrossThreadReturnGoesThroughDepot) {
+  const uint64_t capacity = 65536;
+  const uint32_t size_class = SliceStoragePool::sizeClass(capacity);
+  const uint64_t count = SliceStoragePool::threadCacheLimit(size_class) * 2;
+
+  std::vector<StoragePtr> storages;
+  runOnNewThread([&]() {
+    for (uint64_t i = 0; i < count; i++) {
+      storages.push_back(SliceStoragePool::allocate(capacity));
+    }
+  });
+
+  // Release everything on a second thread, which exits and leaves its cache in the depot.
+  runOnNewThread([&]() {
+    for (StoragePtr& storage : storages) {
+      SliceStoragePool::release(std::move(storage), capacity);
+    }
+  });
+
+  runOnNewThread([&]() {
+    const SliceStoragePoolStats before = SliceStoragePool::stats();
+    StoragePtr storage = SliceStoragePool::allocate(capacity);
+    const SliceStoragePoolStats after = SliceStoragePool::stats();
+    EXPECT_EQ(1, after.hits_ - before.hits_);
+    EXPECT_EQ(before.misses_, after.misses_);
+    SliceStoragePool::release(std::move(storage), capacity);
+  });
+}
+
+TEST(SliceStoragePoolTest, ThreadCacheIsBounded) {
+  runOnNewThread([]() {
+    const uint64_t capacity = 4096;
+    const uint32_t size_class = SliceStoragePool::sizeClass(capacity);
+    const uint64_t limit = SliceStoragePool::threadCacheLimit(size_class);
+    const uint64_t depot_limit = SliceStoragePool::depotLimit(size_class);
+    const SliceStoragePoolStats before = SliceStoragePool::stats();
+
+    std::vector<StoragePtr> storages;
+    for (uint64_t i = 0; i < limit + depot_limit + 1; i++) {
+      storages.push_back(SliceStoragePool::allocate(capacity));
+    }
+    for (StoragePtr& storage : storages) {
+      SliceStoragePool::release(std::move(storage), capacity);
+    }
+
+    // The thread cache and the depot together never hold more than their limits.
+    const int64_t growth = static_cast<int64_t>(SliceStoragePool::stats().bytes_held_) -
+                           static_cast<int64_t>(before.bytes_held_);
+    EXPECT_LE(growth, static_cast<int64_t>((limit + depot_limit) * capacity));
+  });
+}
+
+TEST(SliceStoragePoolTest, OwnedImplUsesPool) {
+  runOnNewThread([]() {
+    {
+      // Warm the pool with a 64 KiB slice.
+      OwnedImpl buffer;
+      buffer.add(std::string(65536, 'a'));
+    }
+    const SliceStoragePoolStats before = SliceStoragePool::stats();
+    {
+      OwnedImpl buffer;
+      buffer.add(std::string(65536, 'b'));
+    }
+    const SliceStoragePoolStats after = SliceStoragePool::stats();
+    EXPECT_EQ(1, after.hits_ - before.hits_);
+    EXPECT_EQ(before.misses_, after.misses_);
+  });
+}
+
+} // namespace
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,126 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "source/common/common/arena.h"
+#include "source/common/common/linked_object.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace {
+
+// Records its destruction in a shared log.
+class Tracked {
+public:
+  Tracked(std::vector<int>& log, int id) : log_(log), id_(id) {}
+  virtual ~Tracked() { log_.push_back(id_); }
+
+private:
+  std::vector<int>& log_;
+  const int id_;
+};
+
+class LinkedTracked : public Tracked, public LinkedObject<LinkedTracked, ArenaDeleter> {
+public:
+  using Tracked::Tracked;
+};
+
+TEST(ArenaTest, AllocateAligned) {
+  Arena arena;
+  for (size_t alignment : {1, 2, 4, 8, 16, 32, 64}) {
+    void* memory = arena.allocate(3, alignment);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(memory) % alignment);
+  }
+  EXPECT_EQ(1, arena.heapBlocks());
+}
+
+TEST(ArenaTest, AllocationsDontOverlap) {
+  Arena arena(256);
+  std::vector<uint8_t*> blocks;
+  for (int i = 0; i < 100; i++) {
+    uint8_t* block = static_cast<uint8_t*>(arena.allocate(24, 8));
+    std::fill(block, block + 24, static_cast<uint8_t>(i));
+    blocks.push_back(block);
+  }
+  for (int i = 0; i < 100; i++) {
+    for (int j = 0; j < 24; j++) {
+      ASSERT_EQ(i, blocks[i][j]);
+    }
+  }
+  EXPECT_GT(arena.heapBlocks(), 1);
+  EXPECT_GE(arena.allocatedBytes(), 2400);
+}
+
+// Allocations too large for a block get their own, and the current block keeps being used.
+TEST(ArenaTest, LargeAllocation) {
+  Arena arena(256);
+  arena.allocate(8);
+  EXPECT_EQ(1, arena.heapBlocks());
+  char* large = static_cast<char*>(arena.allocate(1000));
+  std::fill(large, large + 1000, 'a');
+  EXPECT_EQ(2, arena.heapBlocks());
+  arena.allocate(8);
+  EXPECT_EQ(2, arena.heapBlocks());
+}
+
+TEST(ArenaTest, InlineArena) {
+  InlineArena<128> arena(256);
+  const char* const begin = reinterpret_cast<const char*>(&arena);
+  const char* const end = begin + sizeof(arena);
+  const char* small = static_cast<char*>(arena.allocate(64));
+  EXPECT_TRUE(small >= begin && small < end);
+  EXPECT_EQ(0, arena.heapBlocks());
+
+  const char* spilled = static_cast<char*>(arena.allocate(100));
+  EXPECT_FALSE(spilled >= begin && spilled < end);
+  EXPECT_EQ(1, arena.heapBlocks());
+  EXPECT_GE(arena.allocatedBytes(), 128);
+}
+
+TEST(ArenaTest, CreateDestroysInReverse) {
+  std::vector<int> log;
+  {
+    Arena arena(128);
+    for (int i = 0; i < 10; i++) {
+      arena.create<Tracked>(log, i);
+    }
+    // Trivially destructible objects don't need a finalizer.
+    int* value = arena.create<int>(5);
+    EXPECT_EQ(5, *value);
+    EXPECT_TRUE(log.empty());
+  }
+  EXPECT_EQ(std::vector<int>({9, 8, 7, 6, 5, 4, 3, 2, 1, 0}), log);
+}
+
+TEST(ArenaTest, MakeUnique) {
+  std::vector<int> log;
+  Arena arena;
+  ArenaPtr<Tracked> first = arena.makeUnique<Tracked>(log, 1);
+  ArenaPtr<Tracked> second = arena.makeUnique<Tracked>(log, 2);
+  first.reset();
+  EXPECT_EQ(std::vector<int>({1}), log);
+  second.reset();
+  EXPECT_EQ(std::vector<int>({1, 2}), log);
+}
+
+TEST(ArenaTest, LinkedObject) {
+  std::vector<int> log;
+  Arena arena;
+  {
+    LinkedTracked::ListType list;
+    LinkedList::moveIntoListBack(arena.makeUnique<LinkedTracked>(log, 1), list);
+    LinkedList::moveIntoListBack(arena.makeUnique<LinkedTracked>(log, 2), list);
+    LinkedList::moveIntoList(arena.makeUnique<LinkedTracked>(log, 3), list);
+    ASSERT_EQ(3, list.size());
+
+    ArenaPtr<LinkedTracked> removed = list.back()->removeFromList(list);
+    EXPECT_EQ(2, list.size());
+    removed.reset();
+    EXPECT_EQ(std::vector<int>({2}), log);
+  }
+  EXPECT_EQ(std::vector<int>({2, 3, 1}), log);
+}
+
+} // namespace
+} // namespace Envoy
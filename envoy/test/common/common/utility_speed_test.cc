@@ -302,4 +302,46 @@ static void BM_IntervalSet50ToVector(benchmark::State& state) {
   }
 }
 BENCHMARK(BM_IntervalSet50ToVector);
+
+// Looks up header names in a trie holding the names of the O(1) request headers.
+static void BM_TrieLookupHeaderNames(benchmark::State& state) {
+  const std::vector<std::string> names{":authority",
+                                       ":method",
+                                       ":path",
+                                       ":scheme",
+                                       "accept-encoding",
+                                       "authorization",
+                                       "cache-control",
+                                       "connection",
+                                       "content-length",
+                                       "content-type",
+                                       "grpc-timeout",
+                                       "host",
+                                       "keep-alive",
+                                       "te",
+                                       "transfer-encoding",
+                                       "upgrade",
+                                       "user-agent",
+                                       "via",
+                                       "x-client-trace-id",
+                                       "x-envoy-attempt-count",
+                                       "x-envoy-internal",
+                                       "x-envoy-original-path",
+                                       "x-envoy-retry-on",
+                                       "x-forwarded-for",
+                                       "x-forwarded-proto",
+                                       "x-request-id"};
+  Envoy::TrieLookupTable<const std::string*> trie;
+  for (const std::string& name : names) {
+    trie.add(name, &name);
+  }
+  const std::vector<std::string> lookups{":path", "user-agent", "x-forwarded-for",
+                                         "x-custom-header", "accept", "x-envoy-retry-on"};
+  for (auto _ : state) {
+    for (const std::string& lookup : lookups) {
+      benchmark::DoNotOptimize(trie.find(lookup));
+    }
+  }
+}
+BENCHMARK(BM_TrieLookupHeaderNames);
 } // namespace Envoy
@@ -1025,6 +1025,60 @@ TEST(TrieLookupTable, LongestPrefix) {
   EXPECT_EQ(nullptr, trie.findLongestPrefix(" "));
 }
 
+TEST(TrieLookupTable, LongestPrefixPastShorterKey) {
+  TrieLookupTable<const char*> trie;
+  const char* cstr_a = "a";
+  const char* cstr_b = "b";
+
+  EXPECT_TRUE(trie.add("foo", cstr_a));
+  EXPECT_TRUE(trie.add("foobar", cstr_b));
+
+  // The lookup ends on a node on the way to "foobar" that has no value of its own.
+  EXPECT_EQ(cstr_a, trie.findLongestPrefix("foob"));
+  EXPECT_EQ(cstr_a, trie.findLongestPrefix("foobaz"));
+  EXPECT_EQ(cstr_b, trie.findLongestPrefix("foobarbaz"));
+  EXPECT_EQ(nullptr, trie.findLongestPrefix("fo"));
+  EXPECT_EQ(nullptr, trie.find("foob"));
+}
+
+TEST(TrieLookupTable, EmptyKey) {
+  TrieLookupTable<const char*> trie;
+  const char* cstr_a = "a";
+
+  EXPECT_EQ(nullptr, trie.find(""));
+  EXPECT_TRUE(trie.add("", cstr_a));
+  EXPECT_EQ(cstr_a, trie.find(""));
+  EXPECT_EQ(cstr_a, trie.findLongestPrefix(""));
+  EXPECT_EQ(cstr_a, trie.findLongestPrefix("foo"));
+  EXPECT_EQ(nullptr, trie.find("foo"));
+}
+
+// Keys are added in an order that widens node ranges downwards and upwards, and cover the whole
+// byte range.
+TEST(TrieLookupTable, ManyKeys) {
+  TrieLookupTable<std::shared_ptr<std::string>> trie;
+  std::vector<std::string> keys;
+  for (int c = 128; c < 256; c++) {
+    keys.push_back(std::string(1, static_cast<char>(c)) + "x");
+    keys.push_back(std::string(1, static_cast<char>(255 - c)) + "y");
+  }
+  for (const std::string& key : {"x-foo", "x-bar", "x-baz", "a", "zz", "x-", "x-foo-bar"}) {
+    keys.push_back(key);
+  }
+  for (const std::string& key : keys) {
+    EXPECT_TRUE(trie.add(key, std::make_shared<std::string>(key), false));
+  }
+  for (const std::string& key : keys) {
+    ASSERT_NE(nullptr, trie.find(key));
+    EXPECT_EQ(key, *trie.find(key));
+    EXPECT_FALSE(trie.add(key, nullptr, false));
+  }
+  EXPECT_EQ(nullptr, trie.find("x-fo"));
+  EXPECT_EQ("x-", *trie.findLongestPrefix("x-fo"));
+  EXPECT_EQ("x-foo", *trie.findLongestPrefix("x-foo-ba"));
+  EXPECT_EQ("x-foo-bar", *trie.findLongestPrefix("x-foo-bar-baz"));
+}
+
 TEST(InlineStorageTest, InlineString) {
   InlineStringPtr hello = InlineString::create("Hello, world!");
   EXPECT_EQ("Hello, world!", hello->toStringView());
@@ -1,5 +1,7 @@
 #include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -2610,6 +2612,116 @@ TEST(SubstitutionFormatterTest, JsonFormatterTest) {
   EXPECT_TRUE(TestUtility::jsonStringEqual(out_json, expected));
 }
 
+TEST(SubstitutionFormatterTest, JsonFormatterOutputTest) {
+  NiceMock<StreamInfo::MockStreamInfo> stream_info;
+  Http::TestRequestHeaderMapImpl request_header{{"x-escaped", "a\"b\\c<d>\te"}};
+  Http::TestResponseHeaderMapImpl response_header;
+  Http::TestResponseTrailerMapImpl response_trailer;
+  std::string body;
+
+  absl::optional<Http::Protocol> protocol = Http::Protocol::Http11;
+  EXPECT_CALL(stream_info, protocol()).WillRepeatedly(Return(protocol));
+  EXPECT_CALL(Const(stream_info), lastDownstreamRxByteReceived())
+      .WillRepeatedly(Return(std::chrono::nanoseconds(5000000)));
+
+  ProtobufWkt::Struct key_mapping;
+  TestUtility::loadFromYaml(R"EOF(
+    request_duration: '%REQUEST_DURATION%'
+    escaped: '%REQ(X-ESCAPED)%'
+    multi: '%PROTOCOL% %REQ(MISSING)%'
+    'quoted"key': plain
+    list: ['%PROTOCOL%', plain, '%REQ(MISSING)%', {}]
+    nested:
+      protocol: '%PROTOCOL%'
+      missing: '%REQ(MISSING)%'
+  )EOF",
+                            key_mapping);
+
+  // The properties are in the order of their keys, and strings are escaped as the protobuf JSON
+  // conversion escapes them.
+  EXPECT_EQ("{\"escaped\":\"a\\\"b\\\\c\\u003cd\\u003e\\te\","
+            "\"list\":[\"HTTP/1.1\",\"plain\",\"-\",{}],\"multi\":\"HTTP/1.1 -\","
+            "\"nested\":{\"missing\":\"-\",\"protocol\":\"HTTP/1.1\"},"
+            "\"quoted\\\"key\":\"plain\",\"request_duration\":\"5\"}\n",
+            JsonFormatterImpl(key_mapping, false, false)
+                .format(request_header, response_header, response_trailer, stream_info, body));
+
+  EXPECT_EQ("{\"escaped\":\"a\\\"b\\\\c\\u003cd\\u003e\\te\","
+            "\"list\":[\"HTTP/1.1\",\"plain\",{}],\"multi\":\"HTTP/1.1 \","
+            "\"nested\":{\"protocol\":\"HTTP/1.1\"},"
+            "\"quoted\\\"key\":\"plain\",\"request_duration\":5}\n",
+            JsonFormatterImpl(key_mapping, true, true)
+                .format(request_header, response_header, response_trailer, stream_info, body));
+}
+
+// The JSON formatter writes the JSON that the struct formatter's output converts to.
+TEST(SubstitutionFormatterTest, JsonFormatterMatchesStructFormatterTest) {
+  NiceMock<StreamInfo::MockStreamInfo> stream_info;
+  Http::TestRequestHeaderMapImpl request_header{{"x-text", "caf\xc3\xa9 \xe2\x80\xa8 </script>"}};
+  Http::TestResponseHeaderMapImpl response_header;
+  Http::TestResponseTrailerMapImpl response_trailer;
+  std::string body;
+
+  envoy::config::core::v3::Metadata metadata;
+  populateMetadataTestData(metadata);
+  EXPECT_CALL(Const(stream_info), dynamicMetadata()).WillRepeatedly(ReturnRef(metadata));
+  EXPECT_CALL(Const(stream_info), lastDownstreamRxByteReceived())
+      .WillRepeatedly(Return(std::chrono::nanoseconds(5000000)));
+
+  ProtobufWkt::Struct key_mapping;
+  TestUtility::loadFromYaml(R"EOF(
+    request_duration: '%REQUEST_DURATION%'
+    text: '%REQ(X-TEXT)%'
+    missing: '%REQ(MISSING)%'
+    metadata: '%DYNAMIC_METADATA(com.test)%'
+    nested:
+      list: ['%REQ(X-TEXT)%', '%DYNAMIC_METADATA(com.test:test_obj)%']
+  )EOF",
+                            key_mapping);
+
+  for (const bool preserve_types : {false, true}) {
+    for (const bool omit_empty_values : {false, true}) {
+      StructFormatter struct_formatter(key_mapping, preserve_types, omit_empty_values);
+      JsonFormatterImpl json_formatter(key_mapping, preserve_types, omit_empty_values);
+      const std::string expected = MessageUtil::getJsonStringFromMessageOrDie(
+          struct_formatter.format(request_header, response_header, response_trailer, stream_info,
+                                  body),
+          false, true);
+      EXPECT_TRUE(TestUtility::jsonStringEqual(
+          json_formatter.format(request_header, response_header, response_trailer, stream_info,
+                                body),
+          expected));
+    }
+  }
+}
+
+TEST(SubstitutionFormatterTest, JsonFormatterValueTest) {
+  const auto to_json = [](const ProtobufWkt::Value& value) {
+    std::string output;
+    JsonFormatterImpl::appendJsonValue(value, output);
+    return output;
+  };
+
+  EXPECT_EQ("null", to_json(ValueUtil::nullValue()));
+  EXPECT_EQ("true", to_json(ValueUtil::boolValue(true)));
+  EXPECT_EQ("\"\\u0001\\n\\u007f\"", to_json(ValueUtil::stringValue("\x01\n\x7f")));
+  EXPECT_EQ("5", to_json(ValueUtil::numberValue(5)));
+  EXPECT_EQ("0.1", to_json(ValueUtil::numberValue(0.1)));
+  EXPECT_EQ("1e+15", to_json(ValueUtil::numberValue(1e15)));
+  EXPECT_EQ("0.33333333333333331", to_json(ValueUtil::numberValue(1.0 / 3)));
+  EXPECT_EQ("\"NaN\"", to_json(ValueUtil::numberValue(std::nan(""))));
+  EXPECT_EQ("\"-Infinity\"",
+            to_json(ValueUtil::numberValue(-std::numeric_limits<double>::infinity())));
+  EXPECT_EQ("[\"a\",1,[]]", to_json(ValueUtil::listValue(
+                                 {ValueUtil::stringValue("a"), ValueUtil::numberValue(1),
+                                  ValueUtil::listValue({})})));
+
+  for (const double number : {0.0, -0.0, 1e21, 123456789.123, 2.5e-300, 1.0 / 7}) {
+    EXPECT_EQ(MessageUtil::getJsonStringFromMessageOrDie(ValueUtil::numberValue(number)),
+              to_json(ValueUtil::numberValue(number)));
+  }
+}
+
 TEST(SubstitutionFormatterTest, CompositeFormatterSuccess) {
   NiceMock<StreamInfo::MockStreamInfo> stream_info;
   Http::TestRequestHeaderMapImpl request_header{{"first", "GET"}, {":path", "/"}};
@@ -0,0 +1,155 @@
+#include <list>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "source/common/http/header_index.h"
+
+#include "absl/strings/str_cat.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+// Stands in for HeaderMapImpl::HeaderEntryImpl, whose key() is a HeaderString.
+struct TestKey {
+  absl::string_view getStringView() const { return key_; }
+  std::string key_;
+};
+
+struct TestEntry {
+  const TestKey& key() const { return key_; }
+  TestKey key_;
+  int value_;
+};
+
+using TestList = std::list<TestEntry>;
+using TestNode = TestList::iterator;
+
+class HeaderIndexTest : public testing::Test {
+protected:
+  void add(absl::string_view key, int value) {
+    index_.add(list_.insert(list_.end(), TestEntry{{std::string(key)}, value}));
+  }
+
+  // Returns the values of the headers with the key, in the order the index has them.
+  std::vector<int> find(absl::string_view key) const {
+    std::vector<int> values;
+    if (const HeaderIndex<TestNode>::NodeVector* nodes = index_.find(key)) {
+      for (const TestNode& node : *nodes) {
+        values.push_back(node->value_);
+      }
+    }
+    return values;
+  }
+
+  TestList list_;
+  HeaderIndex<TestNode> index_;
+};
+
+TEST_F(HeaderIndexTest, AddFindRemove) {
+  EXPECT_TRUE(index_.empty());
+  EXPECT_EQ(nullptr, index_.find("a"));
+
+  add("a", 1);
+  add("b", 2);
+  add("a", 3);
+  EXPECT_EQ(2, index_.size());
+  EXPECT_EQ(std::vector<int>({1, 3}), find("a"));
+  EXPECT_EQ(std::vector<int>({2}), find("b"));
+  EXPECT_EQ(nullptr, index_.find("c"));
+
+  EXPECT_EQ(2, index_.remove("a").size());
+  EXPECT_EQ(nullptr, index_.find("a"));
+  EXPECT_EQ(std::vector<int>({2}), find("b"));
+  EXPECT_TRUE(index_.remove("a").empty());
+  EXPECT_EQ(1, index_.size());
+}
+
+// Keys are compared in full, not just by hash, and the index keeps working as it grows.
+TEST_F(HeaderIndexTest, ManyKeys) {
+  for (int i = 0; i < 200; i++) {
+    add(absl::StrCat("x-header-", i), i);
+  }
+  EXPECT_EQ(200, index_.size());
+  for (int i = 0; i < 200; i++) {
+    EXPECT_EQ(std::vector<int>({i}), find(absl::StrCat("x-header-", i)));
+  }
+  for (int i = 0; i < 200; i += 2) {
+    index_.remove(absl::StrCat("x-header-", i));
+  }
+  for (int i = 0; i < 200; i++) {
+    EXPECT_EQ(i % 2 == 0 ? std::vector<int>() : std::vector<int>({i}),
+              find(absl::StrCat("x-header-", i)));
+  }
+}
+
+TEST_F(HeaderIndexTest, RemoveIf) {
+  add("a", 1);
+  add("b", 2);
+  add("a", 3);
+  add("c", 4);
+  index_.removeIf([](const TestNode& node) { return node->value_ <= 2; });
+  EXPECT_EQ(std::vector<int>({3}), find("a"));
+  EXPECT_EQ(nullptr, index_.find("b"));
+  EXPECT_EQ(std::vector<int>({4}), find("c"));
+  EXPECT_EQ(2, index_.size());
+}
+
+TEST_F(HeaderIndexTest, Clear) {
+  add("a", 1);
+  index_.clear();
+  EXPECT_TRUE(index_.empty());
+  EXPECT_EQ(nullptr, index_.find("a"));
+  add("a", 2);
+  EXPECT_EQ(std::vector<int>({2}), find("a"));
+}
+
+// Compares the index to a map built from the list after random changes.
+TEST_F(HeaderIndexTest, Random) {
+  std::mt19937 random(0);
+  for (int round = 0; round < 20; round++) {
+    list_.clear();
+    index_.clear();
+    const int key_count = 1 + random() % 100;
+    for (int op = 0; op < 1000; op++) {
+      const std::string key = absl::StrCat("k", random() % key_count);
+      switch (random() % 8) {
+      case 0:
+        for (const TestNode& node : index_.remove(key)) {
+          list_.erase(node);
+        }
+        break;
+      case 1: {
+        const int remainder = random() % 7;
+        index_.removeIf([&](const TestNode& node) {
+          if (node->value_ % 7 != remainder) {
+            return false;
+          }
+          list_.erase(node);
+          return true;
+        });
+        break;
+      }
+      default:
+        add(key, op);
+      }
+
+      std::map<std::string, std::vector<int>> expected;
+      for (const TestEntry& entry : list_) {
+        expected[entry.key_.key_].push_back(entry.value_);
+      }
+      ASSERT_EQ(expected.size(), index_.size());
+      for (const auto& [expected_key, expected_values] : expected) {
+        ASSERT_EQ(expected_values, find(expected_key));
+      }
+    }
+  }
+}
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
@@ -67,7 +67,7 @@ static void headerMapImplGet(benchmark::State& state) {
   }
   benchmark::DoNotOptimize(successes);
 }
-BENCHMARK(headerMapImplGet)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplGet)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50)->Arg(150);
 
 /**
  * Measure the retrieval speed of a header for which HeaderMapImpl is expected to
@@ -160,7 +160,7 @@ static void headerMapImplRemove(benchmark::State& state) {
   }
   benchmark::DoNotOptimize(headers->size());
 }
-BENCHMARK(headerMapImplRemove)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplRemove)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50)->Arg(150);
 
 /**
  * Measure the speed of removing a header by key name, for the special case of
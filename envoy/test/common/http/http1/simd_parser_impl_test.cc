@@ -0,0 +1,399 @@
+#include <string>
+#include <vector>
+
+#include "source/common/http/http1/simd_parser_impl.h"
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+namespace {
+
+// Records callbacks as a list of events. Consecutive data callbacks of the same kind are merged,
+// so the events do not depend on how the input was split.
+class RecordingCallbacks : public ParserCallbacks {
+public:
+  Status onMessageBegin() override {
+    record("begin");
+    return okStatus();
+  }
+  Status onUrl(const char* data, size_t length) override {
+    recordData("url", data, length);
+    return okStatus();
+  }
+  Status onHeaderField(const char* data, size_t length) override {
+    recordData("field", data, length);
+    return okStatus();
+  }
+  Status onHeaderValue(const char* data, size_t length) override {
+    recordData("value", data, length);
+    return okStatus();
+  }
+  Envoy::StatusOr<ParserStatus> onHeadersComplete() override {
+    record("headers");
+    if (!headers_status_.ok()) {
+      return headers_status_;
+    }
+    return headers_return_;
+  }
+  void bufferBody(const char* data, size_t length) override { recordData("body", data, length); }
+  StatusOr<ParserStatus> onMessageComplete() override {
+    record("complete");
+    if (pause_on_complete_) {
+      return parser_->pause();
+    }
+    return ParserStatus::Success;
+  }
+  void onChunkHeader(bool is_final) override { record(is_final ? "last-chunk" : "chunk"); }
+  int setAndCheckCallbackStatus(Status&& status) override {
+    return status.ok() ? parser_->statusToInt(ParserStatus::Success)
+                       : parser_->statusToInt(ParserStatus::Error);
+  }
+  int setAndCheckCallbackStatusOr(Envoy::StatusOr<ParserStatus>&& statusor) override {
+    return statusor.ok() ? parser_->statusToInt(statusor.value())
+                         : parser_->statusToInt(ParserStatus::Error);
+  }
+
+  void record(absl::string_view event) {
+    events_.emplace_back(event);
+    last_data_kind_.clear();
+  }
+  void recordData(absl::string_view kind, const char* data, size_t length) {
+    if (last_data_kind_ == kind) {
+      events_.back().append(data, length);
+      return;
+    }
+    events_.push_back(absl::StrCat(kind, ":", absl::string_view(data, length)));
+    last_data_kind_ = std::string(kind);
+  }
+
+  Parser* parser_{};
+  std::vector<std::string> events_;
+  std::string last_data_kind_;
+  ParserStatus headers_return_{ParserStatus::Success};
+  Status headers_status_{okStatus()};
+  bool pause_on_complete_{};
+};
+
+class SimdHttpParserImplTest : public testing::Test {
+protected:
+  void SetUp() override {
+    if (!SimdHttpParserImpl::isSupported()) {
+      GTEST_SKIP() << "CPU does not support the SIMD HTTP/1 parser";
+    }
+  }
+
+  void initialize(MessageType type) {
+    parser_ = std::make_unique<SimdHttpParserImpl>(type, &callbacks_);
+    callbacks_.parser_ = parser_.get();
+  }
+
+  // Parses the input in one go and returns the return code.
+  int parse(absl::string_view input) {
+    auto [nread, rc] = parser_->execute(input.data(), input.size());
+    if (rc == 0) {
+      EXPECT_EQ(input.size(), nread);
+    }
+    return rc;
+  }
+
+  // Parses the input with every possible split into two parts, and byte by byte, and verifies
+  // that each produces the expected events.
+  void expectEventsForAllSplits(MessageType type, absl::string_view input,
+                                const std::vector<std::string>& expected) {
+    for (size_t split = 0; split <= input.size(); split++) {
+      SCOPED_TRACE(absl::StrCat("split at ", split));
+      initialize(type);
+      // Copy each part so that reading past it is caught by sanitizers.
+      const std::string first(input.substr(0, split));
+      const std::string second(input.substr(split));
+      EXPECT_EQ(0, parser_->execute(first.data(), first.size()).rc);
+      EXPECT_EQ(0, parser_->execute(second.data(), second.size()).rc);
+      EXPECT_EQ(expected, callbacks_.events_);
+      callbacks_.events_.clear();
+    }
+
+    SCOPED_TRACE("byte by byte");
+    initialize(type);
+    for (const char c : input) {
+      EXPECT_EQ(0, parser_->execute(&c, 1).rc);
+    }
+    EXPECT_EQ(expected, callbacks_.events_);
+    callbacks_.events_.clear();
+  }
+
+  void expectError(MessageType type, absl::string_view input, absl::string_view error) {
+    SCOPED_TRACE(input);
+    initialize(type);
+    const int rc = parse(input);
+    EXPECT_EQ(error, parser_->errnoName(rc));
+    EXPECT_EQ(ParserStatus::Error, parser_->getStatus());
+  }
+
+  RecordingCallbacks callbacks_;
+  std::unique_ptr<SimdHttpParserImpl> parser_;
+};
+
+TEST_F(SimdHttpParserImplTest, SimpleGet) {
+  initialize(MessageType::Request);
+  EXPECT_EQ(0, parse("GET /path?q=1 HTTP/1.1\r\nHost: example.com\r\nEmpty:\r\n\r\n"));
+  EXPECT_EQ((std::vector<std::string>{"begin", "url:/path?q=1", "field:Host",
+                                      "value:example.com", "field:Empty", "value:", "headers",
+                                      "complete"}),
+            callbacks_.events_);
+  EXPECT_EQ("GET", parser_->methodName());
+  EXPECT_EQ(1, parser_->httpMajor());
+  EXPECT_EQ(1, parser_->httpMinor());
+  EXPECT_FALSE(parser_->contentLength().has_value());
+  EXPECT_FALSE(parser_->isChunked());
+  EXPECT_EQ(0, parser_->hasTransferEncoding());
+  EXPECT_EQ(ParserStatus::Success, parser_->getStatus());
+}
+
+TEST_F(SimdHttpParserImplTest, AllSplits) {
+  // Long enough that every token is scanned with vector instructions for some splits.
+  const std::string value(70, 'v');
+  const std::string input = absl::StrCat(
+      "POST /", std::string(40, 'u'), " HTTP/1.1\r\n", "x-long-name-with-symbols-|~!#$%&'*+.^_`: ",
+      value, "\r\n", "Leading:  \t spaces and\ttabs  \r\n", "Content-Length: 5\r\n\r\nhello");
+  expectEventsForAllSplits(MessageType::Request, input,
+                           {"begin", absl::StrCat("url:/", std::string(40, 'u')),
+                            "field:x-long-name-with-symbols-|~!#$%&'*+.^_`",
+                            absl::StrCat("value:", value), "field:Leading",
+                            "value:spaces and\ttabs  ", "field:Content-Length", "value:5",
+                            "headers", "body:hello", "complete"});
+}
+
+TEST_F(SimdHttpParserImplTest, ChunkedBodyAllSplits) {
+  expectEventsForAllSplits(
+      MessageType::Request,
+      "POST / HTTP/1.1\r\nTransfer-Encoding: gzip, chunked\r\n\r\n"
+      "5;name=value\r\nhello\r\nA\r\n0123456789\r\n0\r\nTrailer: t\r\n\r\n",
+      {"begin", "url:/", "field:Transfer-Encoding", "value:gzip, chunked", "headers", "chunk",
+       "body:hello", "chunk", "body:0123456789", "last-chunk", "field:Trailer", "value:t",
+       "complete"});
+}
+
+TEST_F(SimdHttpParserImplTest, ChunkedBody) {
+  initialize(MessageType::Request);
+  EXPECT_EQ(0, parse("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 3\r\n\r\n"
+                     "0\r\n\r\n"));
+  EXPECT_TRUE(parser_->isChunked());
+  EXPECT_EQ(1, parser_->hasTransferEncoding());
+  EXPECT_EQ(3, parser_->contentLength().value());
+  EXPECT_EQ("complete", callbacks_.events_.back());
+}
+
+TEST_F(SimdHttpParserImplTest, PipelinedRequests) {
+  initialize(MessageType::Request);
+  EXPECT_EQ(0, parse("GET /a HTTP/1.1\r\n\r\n\r\nPOST /b HTTP/1.1\r\nContent-Length: 1\r\n\r\nx"
+                     "PUT /c HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"
+                     "DELETE /d HTTP/1.1\r\n\r\n"));
+  EXPECT_EQ((std::vector<std::string>{
+                "begin", "url:/a", "headers", "complete", "begin", "url:/b", "field:Content-Length",
+                "value:1", "headers", "body:x", "complete", "begin", "url:/c", "field:Connection",
+                "value:keep-alive", "headers", "complete", "begin", "url:/d", "headers",
+                "complete"}),
+            callbacks_.events_);
+  EXPECT_EQ("DELETE", parser_->methodName());
+}
+
+TEST_F(SimdHttpParserImplTest, PauseOnMessageComplete) {
+  initialize(MessageType::Request);
+  callbacks_.pause_on_complete_ = true;
+  const absl::string_view first = "POST / HTTP/1.1\r\nContent-Length: 2\r\n\r\nhi";
+  const std::string input = absl::StrCat(first, "GET / HTTP/1.1\r\n\r\n");
+
+  auto [nread, rc] = parser_->execute(input.data(), input.size());
+  EXPECT_EQ(first.size(), nread);
+  EXPECT_EQ(parser_->statusToInt(ParserStatus::Paused), rc);
+  EXPECT_EQ(ParserStatus::Paused, parser_->getStatus());
+  EXPECT_EQ("HPE_PAUSED", parser_->errnoName(rc));
+
+  // A paused parser does not consume anything.
+  EXPECT_EQ(0, parser_->execute(input.data() + nread, input.size() - nread).nread);
+
+  parser_->resume();
+  callbacks_.pause_on_complete_ = false;
+  EXPECT_EQ(0, parse(input.substr(nread)));
+  EXPECT_EQ("GET", parser_->methodName());
+  EXPECT_EQ("complete", callbacks_.events_.back());
+}
+
+TEST_F(SimdHttpParserImplTest, NoBodyFromHeadersCallback) {
+  initialize(MessageType::Response);
+  callbacks_.headers_return_ = ParserStatus::NoBody;
+  EXPECT_EQ(0, parse("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n"
+                     "HTTP/1.1 204 No Content\r\n\r\n"));
+  EXPECT_EQ((std::vector<std::string>{"begin", "field:Content-Length", "value:10", "headers",
+                                      "complete", "begin", "headers", "complete"}),
+            callbacks_.events_);
+  EXPECT_EQ(204, parser_->statusCode());
+}
+
+TEST_F(SimdHttpParserImplTest, ErrorFromCallback) {
+  initialize(MessageType::Request);
+  callbacks_.headers_status_ = absl::InvalidArgumentError("rejected");
+  const int rc = parse("GET / HTTP/1.1\r\n\r\n");
+  EXPECT_EQ("HPE_CB_headers_complete", parser_->errnoName(rc));
+  EXPECT_EQ(ParserStatus::Error, parser_->getStatus());
+  // Errors are sticky.
+  EXPECT_EQ(rc, parse("GET / HTTP/1.1\r\n\r\n"));
+}
+
+TEST_F(SimdHttpParserImplTest, UpgradeStopsParsing) {
+  initialize(MessageType::Request);
+  const absl::string_view headers =
+      "GET /chat HTTP/1.1\r\nConnection: keep-alive, Upgrade\r\nUpgrade: websocket\r\n\r\n";
+  const std::string input = absl::StrCat(headers, "\x81\x05hello");
+  auto [nread, rc] = parser_->execute(input.data(), input.size());
+  EXPECT_EQ(0, rc);
+  EXPECT_EQ(headers.size(), nread);
+  EXPECT_EQ("complete", callbacks_.events_.back());
+}
+
+TEST_F(SimdHttpParserImplTest, UpgradeRequestedByHeadersCallback) {
+  initialize(MessageType::Request);
+  callbacks_.headers_return_ = ParserStatus::NoBodyData;
+  const absl::string_view headers = "POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\n";
+  const std::string input = absl::StrCat(headers, "hello");
+  auto [nread, rc] = parser_->execute(input.data(), input.size());
+  EXPECT_EQ(0, rc);
+  EXPECT_EQ(headers.size(), nread);
+  EXPECT_EQ("complete", callbacks_.events_.back());
+}
+
+TEST_F(SimdHttpParserImplTest, Connect) {
+  initialize(MessageType::Request);
+  const absl::string_view headers = "CONNECT host:443 HTTP/1.1\r\n\r\n";
+  const std::string input = absl::StrCat(headers, "tunneled");
+  auto [nread, rc] = parser_->execute(input.data(), input.size());
+  EXPECT_EQ(0, rc);
+  EXPECT_EQ(headers.size(), nread);
+  EXPECT_EQ("CONNECT", parser_->methodName());
+  EXPECT_EQ((std::vector<std::string>{"begin", "url:host:443", "headers", "complete"}),
+            callbacks_.events_);
+}
+
+TEST_F(SimdHttpParserImplTest, ResponseAllSplits) {
+  expectEventsForAllSplits(
+      MessageType::Response,
+      "HTTP/1.1 101 Switching Protocols\r\nUpgrade: h2c\r\nConnection: upgrade\r\n\r\n",
+      {"begin", "field:Upgrade", "value:h2c", "field:Connection", "value:upgrade", "headers",
+       "complete"});
+}
+
+TEST_F(SimdHttpParserImplTest, ResponseWithoutReasonPhrase) {
+  initialize(MessageType::Response);
+  EXPECT_EQ(0, parse("HTTP/1.0 304\r\nConnection: keep-alive\r\n\r\n"));
+  EXPECT_EQ(304, parser_->statusCode());
+  EXPECT_EQ(0, parser_->httpMinor());
+  EXPECT_EQ("complete", callbacks_.events_.back());
+  // Like http_parser, a response parser reports the first method.
+  EXPECT_EQ("DELETE", parser_->methodName());
+}
+
+TEST_F(SimdHttpParserImplTest, ResponseBodyEndsWithConnection) {
+  initialize(MessageType::Response);
+  EXPECT_EQ(0, parse("HTTP/1.1 200 OK\r\n\r\nsome"));
+  EXPECT_EQ(0, parse(" body"));
+  EXPECT_EQ("body:some body", callbacks_.events_.back());
+  EXPECT_EQ(0, parser_->execute(nullptr, 0).rc);
+  EXPECT_EQ("complete", callbacks_.events_.back());
+  // Nothing may follow on the connection.
+  EXPECT_EQ("HPE_CLOSED_CONNECTION", parser_->errnoName(parse("HTTP/1.1 200 OK\r\n\r\n")));
+}
+
+TEST_F(SimdHttpParserImplTest, ResponseWithUnchunkedTransferEncodingEndsWithConnection) {
+  initialize(MessageType::Response);
+  EXPECT_EQ(0, parse("HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip\r\n\r\nbody"));
+  EXPECT_EQ(0, parser_->execute(nullptr, 0).rc);
+  EXPECT_EQ("complete", callbacks_.events_.back());
+}
+
+TEST_F(SimdHttpParserImplTest, EofInHeaders) {
+  initialize(MessageType::Request);
+  EXPECT_EQ(0, parse("GET / HTTP/1.1\r\nHost"));
+  EXPECT_EQ("HPE_INVALID_EOF_STATE", parser_->errnoName(parser_->execute(nullptr, 0).rc));
+}
+
+TEST_F(SimdHttpParserImplTest, EofBetweenMessages) {
+  initialize(MessageType::Request);
+  EXPECT_EQ(0, parse("GET / HTTP/1.1\r\n\r\n"));
+  EXPECT_EQ(0, parser_->execute(nullptr, 0).rc);
+}
+
+TEST_F(SimdHttpParserImplTest, BareLineFeeds) {
+  initialize(MessageType::Request);
+  EXPECT_EQ(0, parse("GET / HTTP/1.1\nHost: h\n\n"));
+  EXPECT_EQ((std::vector<std::string>{"begin", "url:/", "field:Host", "value:h", "headers",
+                                      "complete"}),
+            callbacks_.events_);
+}
+
+TEST_F(SimdHttpParserImplTest, Http09) {
+  initialize(MessageType::Request);
+  EXPECT_EQ(0, parse("GET /\r\n\r\n"));
+  EXPECT_EQ(0, parser_->httpMajor());
+  EXPECT_EQ(9, parser_->httpMinor());
+}
+
+TEST_F(SimdHttpParserImplTest, Errors) {
+  expectError(MessageType::Request, "get / HTTP/1.1\r\n\r\n", "HPE_INVALID_METHOD");
+  expectError(MessageType::Request, "FOO / HTTP/1.1\r\n\r\n", "HPE_INVALID_METHOD");
+  expectError(MessageType::Request, "UNSUBSCRIBED / HTTP/1.1\r\n\r\n", "HPE_INVALID_METHOD");
+  expectError(MessageType::Request, "GET \x01 HTTP/1.1\r\n\r\n", "HPE_INVALID_URL");
+  expectError(MessageType::Request, "GET /\x7f HTTP/1.1\r\n\r\n", "HPE_INVALID_URL");
+  expectError(MessageType::Request, "GET / FTP/1.1\r\n\r\n", "HPE_INVALID_CONSTANT");
+  expectError(MessageType::Request, "GET / HTTP/x.1\r\n\r\n", "HPE_INVALID_VERSION");
+  expectError(MessageType::Request, "GET / HTTP/1.10\r\n\r\n", "HPE_INVALID_VERSION");
+  expectError(MessageType::Request, "GET / HTTP/1.1\rX\n\r\n", "HPE_LF_EXPECTED");
+  expectError(MessageType::Request, "GET / HTTP/1.1\r\nHost : h\r\n\r\n",
+              "HPE_INVALID_HEADER_TOKEN");
+  expectError(MessageType::Request, "GET / HTTP/1.1\r\n: h\r\n\r\n", "HPE_INVALID_HEADER_TOKEN");
+  expectError(MessageType::Request, "GET / HTTP/1.1\r\nA: b\r\n folded\r\n\r\n",
+              "HPE_INVALID_HEADER_TOKEN");
+  expectError(MessageType::Request, "GET / HTTP/1.1\r\nA: b\x01\r\n\r\n",
+              "HPE_INVALID_HEADER_TOKEN");
+  expectError(MessageType::Request, "GET / HTTP/1.1\r\nA: b\r\r\n\r\n", "HPE_LF_EXPECTED");
+  expectError(MessageType::Request, "POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n",
+              "HPE_INVALID_CONTENT_LENGTH");
+  expectError(MessageType::Request, "POST / HTTP/1.1\r\nContent-Length: 1 2\r\n\r\n",
+              "HPE_INVALID_CONTENT_LENGTH");
+  expectError(MessageType::Request, "POST / HTTP/1.1\r\nContent-Length:\r\n\r\n",
+              "HPE_INVALID_CONTENT_LENGTH");
+  expectError(MessageType::Request,
+              "POST / HTTP/1.1\r\nContent-Length: 99999999999999999999\r\n\r\n",
+              "HPE_INVALID_CONTENT_LENGTH");
+  expectError(MessageType::Request,
+              "POST / HTTP/1.1\r\nContent-Length: 1\r\ncontent-length: 1\r\n\r\n",
+              "HPE_UNEXPECTED_CONTENT_LENGTH");
+  expectError(MessageType::Request, "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n",
+              "HPE_INVALID_TRANSFER_ENCODING");
+  expectError(MessageType::Request,
+              "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nx\r\n",
+              "HPE_INVALID_CHUNK_SIZE");
+  expectError(MessageType::Request,
+              "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n11111111111111111\r\n",
+              "HPE_INVALID_CHUNK_SIZE");
+  expectError(MessageType::Request,
+              "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n1;a\nb\r\n",
+              "HPE_INVALID_CHUNK_SIZE");
+  expectError(MessageType::Request,
+              "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n1\r\nab\r\n",
+              "HPE_STRICT");
+  expectError(MessageType::Request, "GET / HTTP/1.1\r\nConnection: close\r\n\r\nGET",
+              "HPE_CLOSED_CONNECTION");
+  expectError(MessageType::Request, "GET / HTTP/1.0\r\n\r\nGET", "HPE_CLOSED_CONNECTION");
+  expectError(MessageType::Response, "HTTX/1.1 200 OK\r\n\r\n", "HPE_INVALID_CONSTANT");
+  expectError(MessageType::Response, "HTTP/1.1 20 OK\r\n\r\n", "HPE_INVALID_STATUS");
+  expectError(MessageType::Response, "HTTP/1.1 2000 OK\r\n\r\n", "HPE_INVALID_STATUS");
+  expectError(MessageType::Response, "HTTP/1.1 200 O\x01K\r\n\r\n", "HPE_INVALID_STATUS");
+}
+
+} // namespace
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
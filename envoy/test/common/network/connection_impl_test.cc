@@ -673,6 +673,50 @@ TEST_P(ConnectionImplTest, ConnectionStats) {
 
 // Ensure the new counter logic in ReadDisable avoids tripping asserts in ReadDisable guarding
 // against actual enabling twice in a row.
+TEST_P(ConnectionImplTest, StartSplice) {
+  setUpBasicConnection();
+  connect();
+
+#if defined(__linux__)
+  EXPECT_TRUE(server_connection_->startSplice(*client_connection_));
+  // A connection is only spliced once.
+  EXPECT_FALSE(client_connection_->startSplice(*server_connection_));
+#else
+  EXPECT_FALSE(server_connection_->startSplice(*client_connection_));
+#endif
+
+  // The server stops splicing once the client closes, and sees the close.
+  disconnect(true);
+}
+
+// Test that connections aren't spliced when their data may need to go through a filter.
+TEST_P(ConnectionImplTest, StartSpliceNotPossible) {
+  setUpBasicConnection();
+  connect();
+
+  NiceMock<MockConnection> mock_connection;
+  EXPECT_FALSE(server_connection_->startSplice(mock_connection));
+  EXPECT_FALSE(server_connection_->startSplice(*server_connection_));
+
+  client_connection_->addWriteFilter(std::make_shared<NiceMock<MockWriteFilter>>());
+  EXPECT_FALSE(server_connection_->startSplice(*client_connection_));
+  EXPECT_FALSE(client_connection_->startSplice(*server_connection_));
+
+  disconnect(true);
+}
+
+// Test that connections aren't spliced when a read filter other than the caller would be skipped.
+TEST_P(ConnectionImplTest, StartSpliceSeveralReadFilters) {
+  setUpBasicConnection();
+  connect();
+
+  server_connection_->addReadFilter(std::make_shared<NiceMock<MockReadFilter>>());
+  EXPECT_FALSE(server_connection_->startSplice(*client_connection_));
+  EXPECT_FALSE(client_connection_->startSplice(*server_connection_));
+
+  disconnect(true);
+}
+
 TEST_P(ConnectionImplTest, ReadDisable) {
   ConnectionMocks mocks = createConnectionMocks(false);
   IoHandlePtr io_handle = std::make_unique<IoSocketHandleImpl>(0);
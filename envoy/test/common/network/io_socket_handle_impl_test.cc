@@ -67,6 +67,15 @@ TEST(IoSocketHandleImplTest, TestIoSocketError) {
   EXPECT_EQ(errorDetails(123), error10.getErrorDetails());
 }
 
+TEST(IoSocketHandleImpl, SupportsSplice) {
+  IoSocketHandleImpl invalid_handle;
+  EXPECT_FALSE(invalid_handle.supportsSplice());
+
+  IoSocketHandleImpl io_handle(
+      Api::OsSysCallsSingleton::get().socket(AF_INET, SOCK_STREAM, 0).return_value_);
+  EXPECT_TRUE(io_handle.supportsSplice());
+}
+
 TEST(IoSocketHandleImpl, LastRoundTripTimeReturnsEmptyOptionalIfGetSocketFails) {
   NiceMock<Envoy::Api::MockOsSysCalls> os_sys_calls;
   auto os_calls =
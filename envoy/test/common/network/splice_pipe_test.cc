@@ -0,0 +1,110 @@
+#include <string>
+
+#include "envoy/common/platform.h"
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/network/splice_pipe.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Network {
+namespace {
+
+#if defined(__linux__)
+class SplicePipeTest : public testing::Test {
+public:
+  SplicePipeTest() {
+    for (os_fd_t* fds : {source_, sink_}) {
+      const int rc =
+          os_sys_calls_.socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds).return_value_;
+      RELEASE_ASSERT(rc == 0, "");
+    }
+  }
+
+  ~SplicePipeTest() override {
+    for (os_fd_t fd : {source_[0], source_[1], sink_[0], sink_[1]}) {
+      os_sys_calls_.close(fd);
+    }
+  }
+
+  // Writes data to the socket that the pipe splices in from.
+  void write(const std::string& data) {
+    ASSERT_EQ(static_cast<ssize_t>(data.size()),
+              os_sys_calls_.write(source_[0], data.data(), data.size()).return_value_);
+  }
+
+  // Reads the data that the pipe spliced out.
+  std::string read() {
+    std::string data;
+    char buffer[4096];
+    ssize_t rc;
+    while ((rc = os_sys_calls_.recv(sink_[1], buffer, sizeof(buffer), 0).return_value_) > 0) {
+      data.append(buffer, rc);
+    }
+    return data;
+  }
+
+  Api::OsSysCalls& os_sys_calls_{Api::OsSysCallsSingleton::get()};
+  // The pipe splices in from source_[1] and out to sink_[0].
+  os_fd_t source_[2];
+  os_fd_t sink_[2];
+  SplicePipeSharedPtr pipe_{SplicePipe::create()};
+};
+
+TEST_F(SplicePipeTest, SpliceInAndOut) {
+  ASSERT_NE(nullptr, pipe_);
+
+  // No data yet.
+  Api::SysCallSizeResult result = pipe_->spliceIn(source_[1]);
+  EXPECT_EQ(-1, result.return_value_);
+  EXPECT_EQ(SOCKET_ERROR_AGAIN, result.errno_);
+  EXPECT_FALSE(pipe_->takeSourceBlocked());
+
+  write("hello");
+  EXPECT_EQ(5, pipe_->spliceIn(source_[1]).return_value_);
+  EXPECT_EQ(5, pipe_->length());
+  EXPECT_EQ(5, pipe_->spliceOut(sink_[0]).return_value_);
+  EXPECT_EQ(0, pipe_->length());
+  EXPECT_EQ("hello", read());
+
+  // End of stream.
+  os_sys_calls_.shutdown(source_[0], SHUT_WR);
+  EXPECT_EQ(0, pipe_->spliceIn(source_[1]).return_value_);
+}
+
+TEST_F(SplicePipeTest, FullPipeBlocksSource) {
+  ASSERT_NE(nullptr, pipe_);
+
+  const std::string data(2 * SplicePipe::MaxLength, 'a');
+  write(data);
+  uint64_t spliced = 0;
+  Api::SysCallSizeResult result;
+  while ((result = pipe_->spliceIn(source_[1])).return_value_ > 0) {
+    spliced += result.return_value_;
+  }
+  EXPECT_EQ(SOCKET_ERROR_AGAIN, result.errno_);
+  EXPECT_LE(spliced, SplicePipe::MaxLength);
+  EXPECT_EQ(spliced, pipe_->length());
+  EXPECT_TRUE(pipe_->takeSourceBlocked());
+  EXPECT_FALSE(pipe_->takeSourceBlocked());
+
+  std::string received;
+  while (received.size() < data.size()) {
+    while (pipe_->length() > 0) {
+      ASSERT_GT(pipe_->spliceOut(sink_[0]).return_value_, 0);
+    }
+    received.append(read());
+    while (pipe_->spliceIn(source_[1]).return_value_ > 0) {
+    }
+  }
+  EXPECT_EQ(data, received);
+}
+#else
+TEST(SplicePipeTest, NotSupported) { EXPECT_EQ(nullptr, SplicePipe::create()); }
+#endif
+
+} // namespace
+} // namespace Network
+} // namespace Envoy
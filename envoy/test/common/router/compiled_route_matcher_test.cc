@@ -0,0 +1,82 @@
+#include "source/common/router/compiled_route_matcher.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+TEST(CompiledRouteMatcherTest, Empty) {
+  CompiledRouteMatcher matcher;
+  EXPECT_THAT(matcher.candidates("/"), IsEmpty());
+}
+
+TEST(CompiledRouteMatcherTest, ExactPath) {
+  CompiledRouteMatcher matcher;
+  matcher.addExactPath(0, "/foo", true);
+  matcher.addExactPath(1, "/foo/bar", true);
+  matcher.addExactPath(2, "/foo", true);
+
+  EXPECT_THAT(matcher.candidates("/foo"), ElementsAre(0, 2));
+  EXPECT_THAT(matcher.candidates("/foo/bar"), ElementsAre(1));
+  EXPECT_THAT(matcher.candidates("/foo/"), IsEmpty());
+  EXPECT_THAT(matcher.candidates("/FOO"), IsEmpty());
+  EXPECT_THAT(matcher.candidates("/fo"), IsEmpty());
+}
+
+TEST(CompiledRouteMatcherTest, Prefix) {
+  CompiledRouteMatcher matcher;
+  matcher.addPrefix(0, "/foo/bar", true);
+  matcher.addPrefix(1, "/foo", true);
+  matcher.addPrefix(2, "/baz", true);
+  matcher.addPrefix(3, "/", true);
+  matcher.addPrefix(4, "", true);
+
+  EXPECT_THAT(matcher.candidates("/foo/bar/baz"), ElementsAre(0, 1, 3, 4));
+  EXPECT_THAT(matcher.candidates("/foo"), ElementsAre(1, 3, 4));
+  EXPECT_THAT(matcher.candidates("/fo"), ElementsAre(3, 4));
+  EXPECT_THAT(matcher.candidates("/baz"), ElementsAre(2, 3, 4));
+  EXPECT_THAT(matcher.candidates("x"), ElementsAre(4));
+  EXPECT_THAT(matcher.candidates(""), ElementsAre(4));
+}
+
+TEST(CompiledRouteMatcherTest, CaseInsensitive) {
+  CompiledRouteMatcher matcher;
+  matcher.addPrefix(0, "/Foo", false);
+  matcher.addExactPath(1, "/FOO/bar", false);
+  matcher.addPrefix(2, "/foo", true);
+
+  EXPECT_THAT(matcher.candidates("/fOO/BAR"), ElementsAre(0, 1));
+  EXPECT_THAT(matcher.candidates("/foo/bar"), ElementsAre(0, 1, 2));
+  EXPECT_THAT(matcher.candidates("/FOO"), ElementsAre(0));
+}
+
+TEST(CompiledRouteMatcherTest, Unindexed) {
+  CompiledRouteMatcher matcher;
+  matcher.addUnindexed(0);
+  matcher.addPrefix(1, "/foo", true);
+  matcher.addUnindexed(2);
+  matcher.addExactPath(3, "/foo", true);
+  matcher.addUnindexed(4);
+
+  EXPECT_THAT(matcher.candidates("/foo"), ElementsAre(0, 1, 2, 3, 4));
+  EXPECT_THAT(matcher.candidates("/bar"), ElementsAre(0, 2, 4));
+}
+
+TEST(CompiledRouteMatcherTest, IgnoresQueryAndFragment) {
+  CompiledRouteMatcher matcher;
+  matcher.addExactPath(0, "/foo", true);
+  matcher.addPrefix(1, "/foo?", true);
+  matcher.addPrefix(2, "/fo", true);
+
+  EXPECT_THAT(matcher.candidates("/foo?bar=baz"), ElementsAre(0, 2));
+  EXPECT_THAT(matcher.candidates("/foo#bar"), ElementsAre(0, 2));
+}
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
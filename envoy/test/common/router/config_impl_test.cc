@@ -1195,6 +1195,71 @@ virtual_hosts:
                           EnvoyException, "no argument for repetition operator");
 }
 
+// The compiled route matcher selects the same routes as evaluating the routes in order.
+TEST_F(RouteMatcherTest, CompiledRouteMatcher) {
+  const std::string yaml = R"EOF(
+virtual_hosts:
+  - name: www
+    domains: ["*"]
+    routes:
+      - match: { prefix: "/foo/bar", headers: [{ name: "x-bar", present_match: true }] }
+        route: { cluster: foo_bar_header }
+      - match: { path: "/foo/bar" }
+        route: { cluster: foo_bar_path }
+      - match:
+          safe_regex:
+            google_re2: {}
+            regex: "/foo/[0-9]+"
+        route: { cluster: foo_regex }
+      - match: { prefix: "/FOO", case_sensitive: false }
+        route: { cluster: foo_insensitive }
+      - match: { prefix: "/foo" }
+        route: { cluster: foo }
+      - match: { path: "/baz", query_parameters: [{ name: "qux" }] }
+        route: { cluster: baz_qux }
+      - match: { prefix: "/baz" }
+        route: { cluster: baz }
+      - match: { prefix: "/" }
+        route: { cluster: default }
+)EOF";
+
+  factory_context_.cluster_manager_.initializeClusters(
+      {"foo_bar_header", "foo_bar_path", "foo_regex", "foo_insensitive", "foo", "baz_qux", "baz",
+       "default"},
+      {});
+  envoy::config::route::v3::RouteConfiguration route_config =
+      parseRouteConfigurationFromYaml(yaml);
+  TestConfigImpl config(route_config, factory_context_, true);
+  route_config.mutable_virtual_hosts(0)->set_compile_route_matcher(true);
+  TestConfigImpl compiled_config(route_config, factory_context_, true);
+
+  const std::vector<std::pair<std::string, std::string>> requests{
+      {"/foo/bar", "foo_bar_path"},
+      {"/foo/bar?a=b", "foo_bar_path"},
+      {"/foo/123", "foo_regex"},
+      {"/Foo/bar/baz", "foo_insensitive"},
+      {"/foo/bar/baz", "foo_insensitive"},
+      {"/baz?qux=1", "baz_qux"},
+      {"/baz", "baz"},
+      {"/bazz", "baz"},
+      {"/", "default"},
+      {"/other", "default"},
+  };
+  for (const auto& [path, cluster] : requests) {
+    SCOPED_TRACE(path);
+    EXPECT_EQ(cluster, config.route(genHeaders("www.lyft.com", path, "GET"), 0)
+                           ->routeEntry()
+                           ->clusterName());
+    EXPECT_EQ(cluster, compiled_config.route(genHeaders("www.lyft.com", path, "GET"), 0)
+                           ->routeEntry()
+                           ->clusterName());
+  }
+
+  Http::TestRequestHeaderMapImpl headers = genHeaders("www.lyft.com", "/foo/bar", "GET");
+  headers.addCopy("x-bar", "true");
+  EXPECT_EQ("foo_bar_header", compiled_config.route(headers, 0)->routeEntry()->clusterName());
+}
+
 // Virtual cluster that contains neither pattern nor regex. This must be checked while pattern is
 // deprecated.
 TEST_F(RouteMatcherTest, TestRoutesWithInvalidVirtualCluster) {
@@ -8134,6 +8199,49 @@ virtual_hosts:
   EXPECT_EQ(accepted_route->routeEntry()->clusterName(), "default");
 }
 
+TEST_F(RouteMatchOverrideTest, VerifyAllMatchableRoutesCompiled) {
+  const std::string yaml = R"EOF(
+virtual_hosts:
+  - name: bar
+    domains: ["*"]
+    compile_route_matcher: true
+    routes:
+      - match: { prefix: "/foo/bar/baz" }
+        route:
+          cluster: foo_bar_baz
+      - match: { prefix: "/qux" }
+        route:
+          cluster: qux
+      - match: { prefix: "/foo" }
+        route:
+          cluster: foo
+      - match: { prefix: "/" }
+        route:
+          cluster: default
+)EOF";
+
+  factory_context_.cluster_manager_.initializeClusters({"foo_bar_baz", "qux", "foo", "default"},
+                                                       {});
+  TestConfigImpl config(parseRouteConfigurationFromYaml(yaml), factory_context_, true);
+  std::vector<std::string> clusters{"default", "foo", "foo_bar_baz"};
+
+  RouteConstSharedPtr accepted_route = config.route(
+      [&clusters](RouteConstSharedPtr route,
+                  RouteEvalStatus route_eval_status) -> RouteMatchStatus {
+        EXPECT_FALSE(clusters.empty());
+        EXPECT_EQ(clusters[clusters.size() - 1], route->routeEntry()->clusterName());
+        clusters.pop_back();
+        if (clusters.empty()) {
+          EXPECT_EQ(route_eval_status, RouteEvalStatus::NoMoreRoutes);
+          return RouteMatchStatus::Accept;
+        }
+        EXPECT_EQ(route_eval_status, RouteEvalStatus::HasMoreRoutes);
+        return RouteMatchStatus::Continue;
+      },
+      genHeaders("bat.com", "/foo/bar/baz", "GET"));
+  EXPECT_EQ(accepted_route->routeEntry()->clusterName(), "default");
+}
+
 TEST_F(RouteMatchOverrideTest, VerifyRouteOverrideStops) {
   const std::string yaml = R"EOF(
 virtual_hosts:
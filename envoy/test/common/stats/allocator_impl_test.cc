@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <cmath>
 #include <string>
+#include <vector>
 
 #include "source/common/stats/allocator_impl.h"
 
@@ -7,7 +9,7 @@
 #include "test/test_common/thread_factory_for_test.h"
 
 #include "absl/synchronization/notification.h"
-#include "gmock/gmock-matchers.h"
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 namespace Envoy {
@@ -410,6 +412,163 @@ TEST_F(AllocatorImplTest, AskForDeletedStat) {
   EXPECT_EQ(rejected_text_readout.value(), "deleted value");
 }
 
+TEST_F(AllocatorImplTest, ShardedCounter) {
+  // Counters made before sharding stay as they are.
+  CounterSharedPtr plain = alloc_.makeCounter(makeStat("plain"), StatName(), {});
+  alloc_.setCounterShards(4);
+  CounterSharedPtr sharded = alloc_.makeCounter(makeStat("sharded"), StatName(), {});
+
+  for (Counter* counter : {plain.get(), sharded.get()}) {
+    EXPECT_FALSE(counter->used());
+    counter->inc();
+    counter->add(4);
+    EXPECT_TRUE(counter->used());
+    EXPECT_EQ(5, counter->value());
+    EXPECT_EQ(5, counter->latch());
+    EXPECT_EQ(0, counter->latch());
+    counter->add(2);
+    counter->reset();
+    EXPECT_EQ(0, counter->value());
+    EXPECT_EQ(2, counter->latch());
+    counter->inc();
+    EXPECT_EQ(1, counter->value());
+    EXPECT_EQ(1, counter->latch());
+  }
+
+  // A counter that reuses the slot of a deleted one starts from zero.
+  sharded.reset();
+  CounterSharedPtr reused = alloc_.makeCounter(makeStat("reused"), StatName(), {});
+  EXPECT_EQ(0, reused->value());
+  EXPECT_EQ(0, reused->latch());
+}
+
+// Increments of the same counter from several threads go to different shards and are summed.
+TEST_F(AllocatorImplTest, ShardedCounterThreads) {
+  alloc_.setCounterShards(8);
+  CounterSharedPtr counter = alloc_.makeCounter(makeStat("counter.name"), StatName(), {});
+  Thread::ThreadFactory& thread_factory = Thread::threadFactoryForTest();
+
+  const uint32_t num_threads = 12;
+  const uint32_t iters = 10000;
+  std::vector<Thread::ThreadPtr> threads;
+  absl::Notification go;
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    threads.push_back(thread_factory.createThread([&]() {
+      go.WaitForNotification();
+      for (uint32_t i = 0; i < iters; ++i) {
+        counter->inc();
+      }
+    }));
+  }
+  go.Notify();
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    threads[i]->join();
+  }
+  EXPECT_EQ(num_threads * iters, counter->value());
+  EXPECT_EQ(num_threads * iters, counter->latch());
+}
+
+// Collects the names of the stats visited by one of the forEachChanged*() methods.
+template <class StatType>
+std::vector<std::string>
+changedNames(void (AllocatorImpl::*for_each_changed)(std::function<void(std::size_t)>,
+                                                      std::function<void(StatType&)>),
+             AllocatorImpl& alloc) {
+  std::vector<std::string> names;
+  (alloc.*for_each_changed)(nullptr,
+                            [&names](StatType& stat) { names.push_back(stat.name()); });
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+TEST_F(AllocatorImplTest, ForEachChanged) {
+  CounterSharedPtr counter1 = alloc_.makeCounter(makeStat("counter.1"), StatName(), {});
+  CounterSharedPtr counter2 = alloc_.makeCounter(makeStat("counter.2"), StatName(), {});
+  GaugeSharedPtr gauge1 =
+      alloc_.makeGauge(makeStat("gauge.1"), StatName(), {}, Gauge::ImportMode::Accumulate);
+  GaugeSharedPtr gauge2 =
+      alloc_.makeGauge(makeStat("gauge.2"), StatName(), {}, Gauge::ImportMode::Accumulate);
+  TextReadoutSharedPtr text_readout = alloc_.makeTextReadout(makeStat("text"), StatName(), {});
+
+  // Changes aren't tracked before the first call, which visits every stat.
+  counter1->inc();
+  EXPECT_THAT(changedNames(&AllocatorImpl::forEachChangedCounter, alloc_),
+              testing::ElementsAre("counter.1", "counter.2"));
+  EXPECT_THAT(changedNames(&AllocatorImpl::forEachChangedGauge, alloc_),
+              testing::ElementsAre("gauge.1", "gauge.2"));
+  EXPECT_THAT(changedNames(&AllocatorImpl::forEachChangedTextReadout, alloc_),
+              testing::ElementsAre("text"));
+
+  EXPECT_THAT(changedNames(&AllocatorImpl::forEachChangedCounter, alloc_), testing::IsEmpty());
+  EXPECT_THAT(changedNames(&AllocatorImpl::forEachChangedGauge, alloc_), testing::IsEmpty());
+  EXPECT_THAT(changedNames(&AllocatorImpl::forEachChangedTextReadout, alloc_),
+              testing::IsEmpty());
+
+  counter2->add(5);
+  counter2->inc();
+  gauge1->set(3);
+  gauge2->inc();
+  gauge2->dec();
+  text_readout->set("value");
+  EXPECT_THAT(changedNames(&AllocatorImpl::forEachChangedCounter, alloc_),
+              testing::ElementsAre("counter.2"));
+  EXPECT_THAT(changedNames(&AllocatorImpl::forEachChangedGauge, alloc_),
+              testing::ElementsAre("gauge.1", "gauge.2"));
+  EXPECT_THAT(changedNames(&AllocatorImpl::forEachChangedTextReadout, alloc_),
+              testing::ElementsAre("text"));
+
+  // A stat that is freed after it changed isn't visited.
+  counter1->inc();
+  counter2->inc();
+  counter1.reset();
+  EXPECT_THAT(changedNames(&AllocatorImpl::forEachChangedCounter, alloc_),
+              testing::ElementsAre("counter.2"));
+
+  // Stats created after tracking started are visited once they change.
+  CounterSharedPtr counter3 = alloc_.makeCounter(makeStat("counter.3"), StatName(), {});
+  EXPECT_THAT(changedNames(&AllocatorImpl::forEachChangedCounter, alloc_), testing::IsEmpty());
+  counter3->inc();
+  EXPECT_THAT(changedNames(&AllocatorImpl::forEachChangedCounter, alloc_),
+              testing::ElementsAre("counter.3"));
+}
+
+// Latching the changed counters while other threads increment them loses no increments.
+TEST_F(AllocatorImplTest, ForEachChangedCounterThreads) {
+  const uint32_t num_counters = 16;
+  std::vector<CounterSharedPtr> counters;
+  for (uint32_t i = 0; i < num_counters; ++i) {
+    counters.push_back(alloc_.makeCounter(makeStat(absl::StrCat("counter.", i)), StatName(), {}));
+  }
+  uint64_t latched = 0;
+  auto latch_changed = [this, &latched]() {
+    alloc_.forEachChangedCounter(nullptr,
+                                 [&latched](Counter& counter) { latched += counter.latch(); });
+  };
+  latch_changed();
+
+  Thread::ThreadFactory& thread_factory = Thread::threadFactoryForTest();
+  const uint32_t num_threads = 4;
+  const uint32_t iters = 10000;
+  std::vector<Thread::ThreadPtr> threads;
+  std::atomic<uint32_t> running{num_threads};
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    threads.push_back(thread_factory.createThread([&, i]() {
+      for (uint32_t j = 0; j < iters; ++j) {
+        counters[(i + j) % num_counters]->inc();
+      }
+      --running;
+    }));
+  }
+  while (running > 0) {
+    latch_changed();
+  }
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    threads[i]->join();
+  }
+  latch_changed();
+  EXPECT_EQ(num_threads * iters, latched);
+}
+
 } // namespace
 } // namespace Stats
 } // namespace Envoy
@@ -0,0 +1,77 @@
+#include <vector>
+
+#include "source/common/stats/counter_shards.h"
+
+#include "test/test_common/thread_factory_for_test.h"
+
+#include "absl/synchronization/notification.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+namespace {
+
+TEST(CounterShardsTest, ShardsRoundedUp) {
+  EXPECT_EQ(1, CounterShards(1).shards());
+  EXPECT_EQ(4, CounterShards(3).shards());
+  EXPECT_EQ(64, CounterShards(64).shards());
+}
+
+TEST(CounterShardsTest, ShardsCapped) {
+  EXPECT_EQ(CounterShards::MaxShards, CounterShards(CounterShards::MaxShards + 1).shards());
+  EXPECT_EQ(CounterShards::MaxShards, CounterShards(1024).shards());
+}
+
+TEST(CounterShardsTest, Slots) {
+  CounterShards shards(4);
+  std::vector<uint32_t> slots;
+  // Spans several chunks.
+  for (uint32_t i = 0; i < 2000; i++) {
+    absl::optional<uint32_t> slot = shards.allocateSlot();
+    ASSERT_TRUE(slot.has_value());
+    EXPECT_EQ(i, *slot);
+    EXPECT_EQ(0, shards.sum(*slot));
+    shards.add(*slot, i);
+    slots.push_back(*slot);
+  }
+  for (uint32_t i = 0; i < 2000; i++) {
+    EXPECT_EQ(i, shards.sum(slots[i]));
+  }
+
+  // Freed slots are reused, and zeroed.
+  shards.freeSlot(slots[1000]);
+  EXPECT_EQ(1000, shards.allocateSlot());
+  EXPECT_EQ(0, shards.sum(1000));
+  EXPECT_EQ(2000, shards.allocateSlot());
+}
+
+TEST(CounterShardsTest, SumsThreads) {
+  CounterShards shards(4);
+  const uint32_t slot = *shards.allocateSlot();
+  const uint32_t other_slot = *shards.allocateSlot();
+  Thread::ThreadFactory& thread_factory = Thread::threadFactoryForTest();
+
+  const uint32_t num_threads = 6;
+  const uint32_t iters = 10000;
+  std::vector<Thread::ThreadPtr> threads;
+  absl::Notification go;
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    threads.push_back(thread_factory.createThread([&]() {
+      go.WaitForNotification();
+      for (uint32_t i = 0; i < iters; ++i) {
+        shards.add(slot, 1);
+        shards.add(other_slot, 2);
+      }
+    }));
+  }
+  go.Notify();
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    threads[i]->join();
+  }
+  EXPECT_EQ(num_threads * iters, shards.sum(slot));
+  EXPECT_EQ(2 * num_threads * iters, shards.sum(other_slot));
+}
+
+} // namespace
+} // namespace Stats
+} // namespace Envoy
@@ -0,0 +1,133 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "source/common/stats/fixed_histogram.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Stats {
+namespace {
+
+// Every value is in the bucket whose bounds contain it, and buckets are contiguous.
+TEST(FixedHistogramTest, Buckets) {
+  EXPECT_EQ(0, FixedHistogram::bucketIndex(0));
+  EXPECT_EQ(31, FixedHistogram::bucketIndex(31));
+  EXPECT_EQ(FixedHistogram::NumBuckets - 1,
+            FixedHistogram::bucketIndex(FixedHistogram::MaxValue));
+  EXPECT_EQ(FixedHistogram::NumBuckets - 1, FixedHistogram::bucketIndex(UINT64_MAX));
+
+  uint64_t next_lower_bound = 0;
+  for (uint32_t index = 0; index < FixedHistogram::NumBuckets; index++) {
+    const uint64_t lower = FixedHistogram::bucketLowerBound(index);
+    const uint64_t upper = lower + FixedHistogram::bucketWidth(index) - 1;
+    EXPECT_EQ(next_lower_bound, lower);
+    EXPECT_EQ(index, FixedHistogram::bucketIndex(lower));
+    EXPECT_EQ(index, FixedHistogram::bucketIndex(upper));
+    // Buckets are at most 1/SubBuckets of their values wide.
+    EXPECT_LE(FixedHistogram::bucketWidth(index) * FixedHistogram::SubBuckets,
+              std::max<uint64_t>(lower, FixedHistogram::SubBuckets));
+    next_lower_bound = upper + 1;
+  }
+  EXPECT_EQ(FixedHistogram::MaxValue + 1, next_lower_bound);
+}
+
+TEST(FixedHistogramTest, RecordAddClear) {
+  FixedHistogram a;
+  FixedHistogram b;
+  EXPECT_FALSE(a.used());
+  a.recordValue(5);
+  a.recordValue(5);
+  a.recordValue(1000);
+  b.recordValue(1000);
+  b.recordValue(1 << 20);
+  EXPECT_TRUE(a.used());
+
+  FixedHistogram merged;
+  merged.add(a);
+  merged.add(b);
+  std::vector<std::pair<uint32_t, uint64_t>> buckets;
+  merged.forEachBucket(
+      [&](uint32_t index, uint64_t count) { buckets.emplace_back(index, count); });
+  ASSERT_EQ(3, buckets.size());
+  EXPECT_EQ(std::make_pair(FixedHistogram::bucketIndex(5), uint64_t(2)), buckets[0]);
+  EXPECT_EQ(std::make_pair(FixedHistogram::bucketIndex(1000), uint64_t(2)), buckets[1]);
+  EXPECT_EQ(std::make_pair(FixedHistogram::bucketIndex(1 << 20), uint64_t(1)), buckets[2]);
+
+  merged.clear();
+  EXPECT_FALSE(merged.used());
+  uint32_t count = 0;
+  merged.forEachBucket([&](uint32_t, uint64_t) { count++; });
+  EXPECT_EQ(0, count);
+}
+
+// Counts are only allocated for the powers of two that values fall in.
+TEST(FixedHistogramTest, SparseAllocation) {
+  FixedHistogram histogram;
+  EXPECT_EQ(0, histogram.allocatedBytes());
+  histogram.recordValue(1000);
+  histogram.recordValue(1001);
+  EXPECT_EQ(64, histogram.allocatedBytes());
+
+  FixedHistogram merged;
+  merged.add(histogram);
+  EXPECT_EQ(64, merged.allocatedBytes());
+  merged.clear();
+  EXPECT_EQ(64, merged.allocatedBytes());
+}
+
+// Merging the workers' histograms into circllhist gives quantiles close to the ones given by
+// recording every value into circllhist.
+TEST(FixedHistogramTest, QuantilesCloseToCircllhist) {
+  std::mt19937_64 random(0);
+  std::lognormal_distribution<double> latency(std::log(5000), 1.5);
+  histogram_t* baseline = hist_alloc();
+  std::vector<FixedHistogram> workers(4);
+  for (uint32_t i = 0; i < 100000; i++) {
+    const uint64_t value = latency(random);
+    hist_insert_intscale(baseline, value, 0, 1);
+    workers[i % workers.size()].recordValue(value);
+  }
+  FixedHistogram merged;
+  for (const FixedHistogram& worker : workers) {
+    merged.add(worker);
+  }
+  histogram_t* fixed = hist_alloc();
+  merged.insertInto(fixed);
+  EXPECT_EQ(hist_sample_count(baseline), hist_sample_count(fixed));
+
+  const std::vector<double> quantiles{0, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 0.995, 0.999, 1};
+  std::vector<double> expected(quantiles.size());
+  std::vector<double> actual(quantiles.size());
+  hist_approx_quantile(baseline, quantiles.data(), quantiles.size(), expected.data());
+  hist_approx_quantile(fixed, quantiles.data(), quantiles.size(), actual.data());
+  for (size_t i = 0; i < quantiles.size(); i++) {
+    // Spreading each bucket over the circllhist bins it overlaps keeps the quantiles well within
+    // a bucket's width of the baseline. Putting each bucket's count at its midpoint does not.
+    EXPECT_NEAR(expected[i], actual[i], expected[i] * 0.02) << quantiles[i];
+  }
+  hist_free(baseline);
+  hist_free(fixed);
+}
+
+// The sum of the bucket counts is the number of values, and each bucket's midpoint is within the
+// bucket's relative error of the values in it.
+TEST(FixedHistogramTest, Random) {
+  std::mt19937_64 random(0);
+  FixedHistogram histogram;
+  const uint32_t values = 100000;
+  for (uint32_t i = 0; i < values; i++) {
+    histogram.recordValue(random() >> (random() % 64));
+  }
+  uint64_t total = 0;
+  histogram.forEachBucket([&](uint64_t value, uint64_t count) {
+    total += count;
+    EXPECT_LE(value, FixedHistogram::MaxValue);
+  });
+  EXPECT_EQ(values, total);
+}
+
+} // namespace
+} // namespace Stats
+} // namespace Envoy
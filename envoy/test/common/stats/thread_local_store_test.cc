@@ -20,6 +20,7 @@
 #include "test/mocks/stats/mocks.h"
 #include "test/mocks/thread_local/mocks.h"
 #include "test/test_common/logging.h"
+#include "test/test_common/thread_factory_for_test.h"
 #include "test/test_common/utility.h"
 
 #include "absl/strings/str_split.h"
@@ -1437,6 +1438,69 @@ TEST_F(HistogramTest, MultiHistogramMultipleMerges) {
   EXPECT_EQ(2, validateMerge());
 }
 
+// Values below 2 * FixedHistogram::SubBuckets have buckets of their own, so histograms recorded
+// into fixed buckets merge to the same statistics as circllhist.
+TEST_F(HistogramTest, FixedBucketHistogramMerges) {
+  envoy::config::metrics::v3::StatsConfig stats_config;
+  stats_config.set_fixed_bucket_histograms(true);
+  store_->setHistogramSettings(std::make_unique<HistogramSettingsImpl>(stats_config));
+  Histogram& h1 = store_->histogramFromString("h1", Stats::Histogram::Unit::Unspecified);
+  Histogram& h2 = store_->histogramFromString("h2", Stats::Histogram::Unit::Unspecified);
+
+  expectCallAndAccumulate(h1, 0);
+  expectCallAndAccumulate(h1, 13);
+  expectCallAndAccumulate(h1, 13);
+  expectCallAndAccumulate(h2, 31);
+  EXPECT_EQ(2, validateMerge());
+
+  expectCallAndAccumulate(h2, 1);
+  EXPECT_EQ(2, validateMerge());
+
+  // Nothing recorded in this interval.
+  EXPECT_EQ(2, validateMerge());
+}
+
+TEST_F(HistogramTest, ParallelHistogramMerge) {
+  store_->setHistogramMergeThreads(4, Thread::threadFactoryForTest());
+  // Enough histograms for several batches per thread.
+  const uint64_t num_histograms = 3000;
+  std::vector<Histogram*> histograms;
+  for (uint64_t i = 0; i < num_histograms; ++i) {
+    histograms.push_back(
+        &store_->histogramFromString(absl::StrCat("h", i), Stats::Histogram::Unit::Unspecified));
+  }
+  EXPECT_CALL(sink_, onHistogramComplete(_, _)).Times(num_histograms);
+  for (uint64_t i = 0; i < num_histograms; ++i) {
+    histograms[i]->recordValue(i);
+  }
+
+  bool merge_called = false;
+  store_->mergeHistograms([&merge_called]() -> void { merge_called = true; });
+  EXPECT_TRUE(merge_called);
+  for (const ParentHistogramSharedPtr& histogram : store_->histograms()) {
+    EXPECT_EQ(1, histogram->intervalStatistics().sampleCount()) << histogram->name();
+    EXPECT_EQ(1, histogram->cumulativeStatistics().sampleCount()) << histogram->name();
+  }
+
+  // An interval without values empties the interval statistics and keeps the cumulative ones.
+  merge_called = false;
+  store_->mergeHistograms([&merge_called]() -> void { merge_called = true; });
+  EXPECT_TRUE(merge_called);
+  for (const ParentHistogramSharedPtr& histogram : store_->histograms()) {
+    EXPECT_EQ(0, histogram->intervalStatistics().sampleCount()) << histogram->name();
+    EXPECT_EQ(1, histogram->cumulativeStatistics().sampleCount()) << histogram->name();
+  }
+
+  // Changing the number of threads replaces the pool the merges run on.
+  store_->setHistogramMergeThreads(2, Thread::threadFactoryForTest());
+  merge_called = false;
+  store_->mergeHistograms([&merge_called]() -> void { merge_called = true; });
+  EXPECT_TRUE(merge_called);
+  for (const ParentHistogramSharedPtr& histogram : store_->histograms()) {
+    EXPECT_EQ(1, histogram->cumulativeStatistics().sampleCount()) << histogram->name();
+  }
+}
+
 TEST_F(HistogramTest, BasicScopeHistogramMerge) {
   ScopePtr scope1 = store_->createScope("scope1.");
 
@@ -0,0 +1,178 @@
+#include <string>
+#include <vector>
+
+#include "source/extensions/access_loggers/columnar_file/block_decoder.h"
+#include "source/extensions/access_loggers/columnar_file/block_encoder.h"
+#include "source/extensions/access_loggers/columnar_file/block_format.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace ColumnarFile {
+namespace {
+
+TEST(BlockFormatTest, Varint) {
+  for (uint64_t value : {uint64_t(0), uint64_t(1), uint64_t(127), uint64_t(128), uint64_t(300),
+                         uint64_t(1) << 32, UINT64_MAX}) {
+    std::string encoded;
+    appendVarint(encoded, value);
+    encoded.append("rest");
+    absl::string_view input = encoded;
+    EXPECT_EQ(value, readVarint(input));
+    EXPECT_EQ("rest", input);
+  }
+
+  std::string encoded;
+  appendVarint(encoded, UINT64_MAX);
+  EXPECT_EQ(10, encoded.size());
+  // Truncated.
+  absl::string_view input = absl::string_view(encoded).substr(0, 9);
+  EXPECT_EQ(absl::nullopt, readVarint(input));
+  EXPECT_EQ(9, input.size());
+  // Longer than 64 bits.
+  const std::string too_long = std::string(9, '\xff') + "\x02";
+  input = too_long;
+  EXPECT_EQ(absl::nullopt, readVarint(input));
+}
+
+class BlockCodecTest : public testing::TestWithParam<BlockCompression> {
+public:
+  const Schema schema_{{"method", ColumnType::String}, {"code", ColumnType::Integer}};
+};
+
+INSTANTIATE_TEST_SUITE_P(Compressions, BlockCodecTest,
+                         testing::Values(BlockCompression::None, BlockCompression::Gzip,
+                                         BlockCompression::Brotli));
+
+TEST_P(BlockCodecTest, RoundTrip) {
+  BlockEncoder encoder(schema_, GetParam());
+  const std::string binary("a\0\xff", 3);
+  encoder.appendString("GET");
+  encoder.appendInteger(200);
+  encoder.endRecord();
+  encoder.appendString("");
+  encoder.appendAbsent();
+  encoder.endRecord();
+  encoder.appendAbsent();
+  encoder.appendInteger(UINT64_MAX - 1);
+  encoder.endRecord();
+  encoder.appendString(binary);
+  encoder.appendInteger(0);
+  encoder.endRecord();
+  EXPECT_EQ(4, encoder.records());
+
+  std::string output;
+  encoder.finish(output);
+  EXPECT_EQ(0, encoder.records());
+  EXPECT_EQ(0, encoder.size());
+  // The encoder starts a new block.
+  for (int i = 0; i < 100; i++) {
+    encoder.appendString("POST");
+    encoder.appendInteger(i);
+    encoder.endRecord();
+  }
+  encoder.finish(output);
+
+  absl::string_view input = output;
+  BlockDecoder decoder;
+  DecodedBlock block = decoder.decode(input);
+  EXPECT_EQ(GetParam(), block.compression_);
+  ASSERT_EQ(2, block.schema_.size());
+  EXPECT_EQ("method", block.schema_[0].name_);
+  EXPECT_EQ(ColumnType::String, block.schema_[0].type_);
+  EXPECT_EQ("code", block.schema_[1].name_);
+  EXPECT_EQ(ColumnType::Integer, block.schema_[1].type_);
+  const std::vector<std::vector<DecodedValue>> expected{
+      {std::string("GET"), uint64_t(200)},
+      {std::string(), absl::monostate()},
+      {absl::monostate(), UINT64_MAX - 1},
+      {binary, uint64_t(0)},
+  };
+  EXPECT_EQ(expected, block.records_);
+
+  block = decoder.decode(input);
+  ASSERT_EQ(100, block.records_.size());
+  EXPECT_EQ(std::vector<DecodedValue>({std::string("POST"), uint64_t(99)}), block.records_[99]);
+  EXPECT_TRUE(input.empty());
+}
+
+TEST_P(BlockCodecTest, EmptyBlockIsNotWritten) {
+  BlockEncoder encoder(schema_, GetParam());
+  std::string output;
+  encoder.finish(output);
+  EXPECT_TRUE(output.empty());
+}
+
+// Every proper prefix of a block is rejected, rather than decoded as a shorter block.
+TEST_P(BlockCodecTest, TruncatedBlock) {
+  BlockEncoder encoder(schema_, GetParam());
+  for (int i = 0; i < 10; i++) {
+    encoder.appendString("GET");
+    encoder.appendInteger(i);
+    encoder.endRecord();
+  }
+  std::string data;
+  encoder.finish(data);
+
+  BlockDecoder decoder;
+  for (size_t size = 0; size < data.size(); size++) {
+    absl::string_view input = absl::string_view(data).substr(0, size);
+    EXPECT_THROW(decoder.decode(input), EnvoyException) << size;
+    EXPECT_EQ(size, input.size());
+  }
+}
+
+TEST(BlockDecoderTest, InvalidBlocks) {
+  BlockDecoder decoder;
+  const auto decode = [&decoder](const std::string& data) {
+    absl::string_view input = data;
+    decoder.decode(input);
+  };
+  const auto block = [](uint64_t version, uint64_t compression, uint64_t records,
+                        absl::string_view columns, uint64_t size, absl::string_view payload) {
+    std::string data(BlockMagic);
+    appendVarint(data, version);
+    appendVarint(data, compression);
+    appendVarint(data, records);
+    data.append(columns.data(), columns.size());
+    appendVarint(data, size);
+    appendVarint(data, payload.size());
+    data.append(payload.data(), payload.size());
+    return data;
+  };
+  // One string column named "a".
+  const std::string columns("\x01\x01" "a" "\x00", 4);
+
+  EXPECT_NO_THROW(decode(block(1, 0, 1, columns, 2, "\x02x")));
+  EXPECT_THROW_WITH_MESSAGE(decode("LOGS"), EnvoyException,
+                            "columnar access log: data doesn't start with a block");
+  EXPECT_THROW_WITH_MESSAGE(decode(block(2, 0, 1, columns, 2, "\x02x")), EnvoyException,
+                            "columnar access log: unsupported version 2");
+  EXPECT_THROW_WITH_MESSAGE(decode(block(1, 3, 1, columns, 2, "\x02x")), EnvoyException,
+                            "columnar access log: unknown compression 3");
+  EXPECT_THROW_WITH_MESSAGE(decode(block(1, 0, 1, std::string("\x00", 1), 2, "\x02x")),
+                            EnvoyException, "columnar access log: block has no columns");
+  EXPECT_THROW_WITH_MESSAGE(decode(block(1, 0, 1, std::string("\x01\x01" "a" "\x02", 4), 2,
+                                         "\x02x")),
+                            EnvoyException, "columnar access log: unknown column type 2");
+  EXPECT_THROW_WITH_MESSAGE(decode(block(1, 0, 1, columns, 3, "\x02x")), EnvoyException,
+                            "columnar access log: payload is 2 bytes rather than 3 bytes");
+  EXPECT_THROW_WITH_MESSAGE(decode(block(1, 0, 3, columns, 2, "\x02x")), EnvoyException,
+                            "columnar access log: payload is too small for its records");
+  EXPECT_THROW_WITH_MESSAGE(decode(block(1, 0, 1, columns, 2, "\x03x")), EnvoyException,
+                            "columnar access log: truncated value");
+  EXPECT_THROW_WITH_MESSAGE(decode(block(1, 0, 1, columns, 3, "\x02xy")), EnvoyException,
+                            "columnar access log: payload has bytes past its values");
+  EXPECT_THROW_WITH_MESSAGE(decode(block(1, 1, 1, columns, 2, "\x02x")), EnvoyException,
+                            "columnar access log: payload is 0 bytes rather than 2 bytes");
+}
+
+} // namespace
+} // namespace ColumnarFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
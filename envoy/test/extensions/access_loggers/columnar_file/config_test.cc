@@ -0,0 +1,194 @@
+#include "envoy/config/accesslog/v3/accesslog.pb.h"
+#include "envoy/extensions/access_loggers/columnar_file/v3alpha/columnar_file.pb.h"
+
+#include "source/common/access_log/access_log_impl.h"
+#include "source/extensions/access_loggers/columnar_file/block_decoder.h"
+#include "source/extensions/access_loggers/columnar_file/config.h"
+
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/server/factory_context.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+
+namespace Envoy {
+namespace Extensions {
+namespace AccessLoggers {
+namespace ColumnarFile {
+namespace {
+
+TEST(ColumnarFileAccessLogNegativeTest, ValidateFail) {
+  NiceMock<Server::Configuration::MockServerFactoryContext> context;
+  envoy::extensions::access_loggers::columnar_file::v3alpha::ColumnarFileAccessLog config;
+
+  EXPECT_THROW(ColumnarFileAccessLogFactory().createAccessLogInstance(config, nullptr, context),
+               ProtoValidationException);
+}
+
+class ColumnarFileAccessLogTest : public testing::Test {
+public:
+  ColumnarFileAccessLogTest() {
+    stream_info_.response_code_ = 200;
+    ON_CALL(context_.access_log_manager_, createAccessLog(_)).WillByDefault(Return(file_));
+    ON_CALL(*file_, write(_)).WillByDefault(Invoke([this](absl::string_view data) {
+      written_.append(data.data(), data.size());
+    }));
+  }
+
+  void createLogger(const std::string& yaml) {
+    envoy::extensions::access_loggers::columnar_file::v3alpha::ColumnarFileAccessLog cfal_config;
+    TestUtility::loadFromYaml(yaml, cfal_config);
+    envoy::config::accesslog::v3::AccessLog config;
+    config.mutable_typed_config()->PackFrom(cfal_config);
+    logger_ = AccessLog::AccessLogFactory::fromProto(config, context_);
+  }
+
+  void log() {
+    logger_->log(&request_headers_, &response_headers_, &response_trailers_, stream_info_);
+  }
+
+  // Decodes the blocks written so far.
+  std::vector<DecodedBlock> blocks() {
+    std::vector<DecodedBlock> blocks;
+    absl::string_view input = written_;
+    BlockDecoder decoder;
+    while (!input.empty()) {
+      blocks.push_back(decoder.decode(input));
+    }
+    return blocks;
+  }
+
+  Http::TestRequestHeaderMapImpl request_headers_{
+      {":method", "GET"}, {":path", "/bar/foo"}, {"x-count", "42"}, {"x-text", "abc"}};
+  Http::TestResponseHeaderMapImpl response_headers_;
+  Http::TestResponseTrailerMapImpl response_trailers_;
+  NiceMock<StreamInfo::MockStreamInfo> stream_info_;
+  NiceMock<Server::Configuration::MockServerFactoryContext> context_;
+  std::shared_ptr<AccessLog::MockAccessLogFile> file_{
+      std::make_shared<NiceMock<AccessLog::MockAccessLogFile>>()};
+  std::string written_;
+  AccessLog::InstanceSharedPtr logger_;
+};
+
+TEST_F(ColumnarFileAccessLogTest, Columns) {
+  Event::MockTimer* timer = new NiceMock<Event::MockTimer>(&context_.thread_local_.dispatcher_);
+  createLogger(R"EOF(
+path: /foo
+columns:
+- name: path
+  format: "%REQ(:PATH)%"
+- name: code
+  format: "%RESPONSE_CODE%"
+  type: INTEGER
+- name: count
+  format: "%REQ(X-COUNT)%"
+  type: INTEGER
+- name: text
+  format: "%REQ(X-TEXT)%"
+  type: INTEGER
+- name: missing
+  format: "%REQ(X-MISSING)%"
+- name: request
+  format: "%REQ(:METHOD)% %REQ(X-MISSING)%"
+- name: plain
+  format: "plain"
+)EOF");
+
+  // Entries are held in the block until the timer fires.
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(1000), _));
+  log();
+  log();
+  EXPECT_TRUE(written_.empty());
+  timer->invokeCallback();
+
+  std::vector<DecodedBlock> decoded = blocks();
+  ASSERT_EQ(1, decoded.size());
+  EXPECT_EQ(BlockCompression::None, decoded[0].compression_);
+  ASSERT_EQ(7, decoded[0].schema_.size());
+  EXPECT_EQ("path", decoded[0].schema_[0].name_);
+  EXPECT_EQ(ColumnType::Integer, decoded[0].schema_[1].type_);
+  const std::vector<DecodedValue> expected{std::string("/bar/foo"), uint64_t(200), uint64_t(42),
+                                           absl::monostate(),       absl::monostate(),
+                                           std::string("GET -"),    std::string("plain")};
+  EXPECT_EQ(std::vector<std::vector<DecodedValue>>({expected, expected}), decoded[0].records_);
+}
+
+TEST_F(ColumnarFileAccessLogTest, BlockSize) {
+  new NiceMock<Event::MockTimer>(&context_.thread_local_.dispatcher_);
+  createLogger(R"EOF(
+path: /foo
+columns:
+- name: path
+  format: "%REQ(:PATH)%"
+block_size_bytes: 20
+compression: GZIP
+)EOF");
+
+  // Each entry takes 9 bytes, so the third fills the block.
+  log();
+  log();
+  EXPECT_TRUE(written_.empty());
+  log();
+  std::vector<DecodedBlock> decoded = blocks();
+  ASSERT_EQ(1, decoded.size());
+  EXPECT_EQ(BlockCompression::Gzip, decoded[0].compression_);
+  EXPECT_EQ(3, decoded[0].records_.size());
+
+  log();
+  EXPECT_EQ(1, blocks().size());
+  // Removing the log writes the entries that are left.
+  logger_.reset();
+  decoded = blocks();
+  ASSERT_EQ(2, decoded.size());
+  EXPECT_EQ(1, decoded[1].records_.size());
+}
+
+TEST_F(ColumnarFileAccessLogTest, DuplicateColumn) {
+  EXPECT_THROW_WITH_MESSAGE(createLogger(R"EOF(
+path: /foo
+columns:
+- name: path
+  format: "%REQ(:PATH)%"
+- name: path
+  format: "%REQ(:METHOD)%"
+)EOF"),
+                            EnvoyException, "columnar access log: duplicate column 'path'");
+}
+
+// A block must fit in the file's write buffer to be written at all.
+TEST_F(ColumnarFileAccessLogTest, BlockSizeTooLarge) {
+  EXPECT_THROW(createLogger(R"EOF(
+path: /foo
+columns:
+- name: path
+  format: "%REQ(:PATH)%"
+block_size_bytes: 4194305
+)EOF"),
+               ProtoValidationException);
+}
+
+TEST_F(ColumnarFileAccessLogTest, IntegerColumnWithSeveralOperators) {
+  EXPECT_THROW_WITH_MESSAGE(
+      createLogger(R"EOF(
+path: /foo
+columns:
+- name: bytes
+  format: "%BYTES_RECEIVED% %BYTES_SENT%"
+  type: INTEGER
+)EOF"),
+      EnvoyException,
+      "columnar access log: the format of integer column 'bytes' must be a single command "
+      "operator");
+}
+
+} // namespace
+} // namespace ColumnarFile
+} // namespace AccessLoggers
+} // namespace Extensions
+} // namespace Envoy
@@ -204,6 +204,26 @@ TEST_F(ZlibCompressorImplTest, CallingFinishOnly) {
   expectValidFinishedBuffer(buffer, 4096);
 }
 
+// Exercises compressing a second stream after resetting a finished one.
+TEST_F(ZlibCompressorImplTest, ResetAfterFinish) {
+  Buffer::OwnedImpl buffer;
+
+  ZlibCompressorImplTester compressor;
+  compressor.init(ZlibCompressorImpl::CompressionLevel::Standard,
+                  ZlibCompressorImpl::CompressionStrategy::Standard, gzip_window_bits,
+                  memory_level);
+
+  TestUtility::feedBufferWithRandomCharacters(buffer, 4096);
+  compressor.finish(buffer);
+  expectValidFinishedBuffer(buffer, 4096);
+  drainBuffer(buffer);
+
+  compressor.reset();
+  TestUtility::feedBufferWithRandomCharacters(buffer, default_input_size);
+  compressor.finish(buffer);
+  expectValidFinishedBuffer(buffer, default_input_size);
+}
+
 TEST_F(ZlibCompressorImplTest, CompressWithSmallChunkSize) {
   Buffer::OwnedImpl buffer;
   Buffer::OwnedImpl accumulation_buffer;
@@ -1,12 +1,12 @@
 #include "source/extensions/filters/common/local_ratelimit/local_ratelimit_impl.h"
 
 #include "test/mocks/event/mocks.h"
+#include "test/test_common/simulated_time_system.h"
 #include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
-using testing::_;
 using testing::NiceMock;
 
 namespace Envoy {
@@ -15,19 +15,10 @@ namespace Filters {
 namespace Common {
 namespace LocalRateLimit {
 
-class LocalRateLimiterImplTest : public testing::Test {
+class LocalRateLimiterImplTest : public testing::Test, public Event::TestUsingSimulatedTime {
 public:
-  void initializeTimer() {
-    fill_timer_ = new Event::MockTimer(&dispatcher_);
-    EXPECT_CALL(*fill_timer_, enableTimer(_, nullptr));
-    EXPECT_CALL(*fill_timer_, disableTimer());
-  }
-
   void initialize(const std::chrono::milliseconds fill_interval, const uint32_t max_tokens,
                   const uint32_t tokens_per_fill) {
-
-    initializeTimer();
-
     rate_limiter_ = std::make_shared<LocalRateLimiterImpl>(
         fill_interval, max_tokens, tokens_per_fill, dispatcher_, descriptors_);
   }
@@ -39,7 +30,6 @@ public:
 
   std::vector<Envoy::RateLimit::LocalDescriptor> route_descriptors_;
   NiceMock<Event::MockDispatcher> dispatcher_;
-  Event::MockTimer* fill_timer_{};
   std::shared_ptr<LocalRateLimiterImpl> rate_limiter_;
 };
 
@@ -52,30 +42,54 @@ TEST_F(LocalRateLimiterImplTest, TooFastFillRate) {
 
 // Verify various token bucket CAS edge cases.
 TEST_F(LocalRateLimiterImplTest, CasEdgeCases) {
-  // This tests the case in which an allowed check races with the fill timer.
+  // This tests the case in which two allowed checks race to refill the bucket, which must only be
+  // refilled once.
   {
     initialize(std::chrono::milliseconds(50), 1, 1);
 
+    // 1 -> 0 tokens
+    EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
+    simTime().advanceTimeWait(std::chrono::milliseconds(50));
+
     synchronizer().enable();
 
-    // Start a thread and start the fill callback. This will wait pre-CAS.
-    synchronizer().waitOn("on_fill_timer_pre_cas");
-    std::thread t1([&] {
-      EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(50), nullptr));
-      fill_timer_->invokeCallback();
-    });
+    // Start a thread that refills the bucket and takes the token. This will wait pre-CAS.
+    synchronizer().waitOn("allowed_pre_cas");
+    std::thread t1([&] { EXPECT_FALSE(rate_limiter_->requestAllowed(route_descriptors_)); });
     // Wait until the thread is actually waiting.
-    synchronizer().barrierOn("on_fill_timer_pre_cas");
+    synchronizer().barrierOn("allowed_pre_cas");
 
-    // This should succeed.
+    // Refill the bucket and take the token on this thread, which should cause the CAS to fail on
+    // the other thread, which then finds no fill left to apply.
     EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
-
-    // Now signal the thread to continue which should cause a CAS failure and the loop to repeat.
-    synchronizer().signal("on_fill_timer_pre_cas");
+    synchronizer().signal("allowed_pre_cas");
     t1.join();
+  }
 
-    // 1 -> 0 tokens
+  // This tests the case in which a thread that read the time before the bucket was refilled
+  // races with a thread that read it after.
+  {
+    initialize(std::chrono::milliseconds(50), 2, 1);
+
+    // 2 -> 1 tokens
     EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
+
+    synchronizer().enable();
+
+    // Start a thread that takes a token without a refill. This will wait pre-CAS.
+    synchronizer().waitOn("allowed_pre_cas");
+    std::thread t1([&] { EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_)); });
+    // Wait until the thread is actually waiting.
+    synchronizer().barrierOn("allowed_pre_cas");
+
+    // 1 -> 2 -> 1 tokens on this thread, a fill interval later.
+    simTime().advanceTimeWait(std::chrono::milliseconds(50));
+    EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
+
+    // The other thread's CAS fails, and it takes the last token without refilling the bucket
+    // again, even though its time is behind the bucket's.
+    synchronizer().signal("allowed_pre_cas");
+    t1.join();
     EXPECT_FALSE(rate_limiter_->requestAllowed(route_descriptors_));
   }
 
@@ -108,20 +122,14 @@ TEST_F(LocalRateLimiterImplTest, TokenBucket) {
   EXPECT_FALSE(rate_limiter_->requestAllowed(route_descriptors_));
 
   // 0 -> 1 tokens
-  EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(200), nullptr));
-  fill_timer_->invokeCallback();
+  simTime().advanceTimeWait(std::chrono::milliseconds(200));
 
   // 1 -> 0 tokens
   EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
   EXPECT_FALSE(rate_limiter_->requestAllowed(route_descriptors_));
 
-  // 0 -> 1 tokens
-  EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(200), nullptr));
-  fill_timer_->invokeCallback();
-
-  // 1 -> 1 tokens
-  EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(200), nullptr));
-  fill_timer_->invokeCallback();
+  // 0 -> 1 -> 1 tokens
+  simTime().advanceTimeWait(std::chrono::milliseconds(400));
 
   // 1 -> 0 tokens
   EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
@@ -138,15 +146,13 @@ TEST_F(LocalRateLimiterImplTest, TokenBucketMultipleTokensPerFill) {
   EXPECT_FALSE(rate_limiter_->requestAllowed(route_descriptors_));
 
   // 0 -> 2 tokens
-  EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(200), nullptr));
-  fill_timer_->invokeCallback();
+  simTime().advanceTimeWait(std::chrono::milliseconds(200));
 
   // 2 -> 1 tokens
   EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
 
   // 1 -> 2 tokens
-  EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(200), nullptr));
-  fill_timer_->invokeCallback();
+  simTime().advanceTimeWait(std::chrono::milliseconds(200));
 
   // 2 -> 0 tokens
   EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
@@ -164,21 +170,47 @@ TEST_F(LocalRateLimiterImplTest, TokenBucketMaxTokensGreaterThanTokensPerFill) {
   EXPECT_FALSE(rate_limiter_->requestAllowed(route_descriptors_));
 
   // 0 -> 1 tokens
-  EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(200), nullptr));
-  fill_timer_->invokeCallback();
+  simTime().advanceTimeWait(std::chrono::milliseconds(200));
 
   // 1 -> 0 tokens
   EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
   EXPECT_FALSE(rate_limiter_->requestAllowed(route_descriptors_));
 }
 
+// Verify that a bucket that sees no requests for several fill intervals is refilled up to its max
+// tokens, and only when a whole fill interval has passed.
+TEST_F(LocalRateLimiterImplTest, TokenBucketLazyRefill) {
+  initialize(std::chrono::milliseconds(200), 3, 1);
+
+  // 3 -> 0 tokens
+  EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
+  EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
+  EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
+  EXPECT_FALSE(rate_limiter_->requestAllowed(route_descriptors_));
+
+  // 0 -> 3 tokens
+  simTime().advanceTimeWait(std::chrono::seconds(10));
+
+  // 3 -> 0 tokens
+  EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
+  EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
+  EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
+  EXPECT_FALSE(rate_limiter_->requestAllowed(route_descriptors_));
+
+  // The fill interval hasn't ended yet.
+  simTime().advanceTimeWait(std::chrono::milliseconds(199));
+  EXPECT_FALSE(rate_limiter_->requestAllowed(route_descriptors_));
+
+  // 0 -> 1 -> 0 tokens
+  simTime().advanceTimeWait(std::chrono::milliseconds(1));
+  EXPECT_TRUE(rate_limiter_->requestAllowed(route_descriptors_));
+  EXPECT_FALSE(rate_limiter_->requestAllowed(route_descriptors_));
+}
+
 class LocalRateLimiterDescriptorImplTest : public LocalRateLimiterImplTest {
 public:
   void initializeWithDescriptor(const std::chrono::milliseconds fill_interval,
                                 const uint32_t max_tokens, const uint32_t tokens_per_fill) {
-
-    initializeTimer();
-
     rate_limiter_ = std::make_shared<LocalRateLimiterImpl>(
         fill_interval, max_tokens, tokens_per_fill, dispatcher_, descriptors_);
   }
@@ -238,35 +270,30 @@ TEST_F(LocalRateLimiterDescriptorImplTest, DescriptorRateLimitNoExceptionWithout
 
 // Verify various token bucket CAS edge cases for descriptors.
 TEST_F(LocalRateLimiterDescriptorImplTest, CasEdgeCasesDescriptor) {
-  // This tests the case in which an allowed check races with the fill timer.
+  // This tests the case in which two allowed checks race to refill the bucket, which must only be
+  // refilled once.
   {
     TestUtility::loadFromYaml(fmt::format(single_descriptor_config_yaml, 1, 1, "0.1s"),
                               *descriptors_.Add());
     initializeWithDescriptor(std::chrono::milliseconds(50), 1, 1);
 
+    // 1 -> 0 tokens
+    EXPECT_TRUE(rate_limiter_->requestAllowed(descriptor_));
+    simTime().advanceTimeWait(std::chrono::milliseconds(100));
+
     synchronizer().enable();
 
-    // Start a thread and start the fill callback. This will wait pre-CAS.
-    dispatcher_.globalTimeSystem().advanceTimeAndRun(std::chrono::milliseconds(100), dispatcher_,
-                                                     Envoy::Event::Dispatcher::RunType::NonBlock);
-    synchronizer().waitOn("on_fill_timer_pre_cas");
-    std::thread t1([&] {
-      EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(50), nullptr));
-      fill_timer_->invokeCallback();
-    });
+    // Start a thread that refills the bucket and takes the token. This will wait pre-CAS.
+    synchronizer().waitOn("allowed_pre_cas");
+    std::thread t1([&] { EXPECT_FALSE(rate_limiter_->requestAllowed(descriptor_)); });
     // Wait until the thread is actually waiting.
-    synchronizer().barrierOn("on_fill_timer_pre_cas");
+    synchronizer().barrierOn("allowed_pre_cas");
 
-    // This should succeed.
+    // Refill the bucket and take the token on this thread, which should cause the CAS to fail on
+    // the other thread, which then finds no fill left to apply.
     EXPECT_TRUE(rate_limiter_->requestAllowed(descriptor_));
-
-    // Now signal the thread to continue which should cause a CAS failure and the loop to repeat.
-    synchronizer().signal("on_fill_timer_pre_cas");
+    synchronizer().signal("allowed_pre_cas");
     t1.join();
-
-    // 1 -> 0 tokens
-    EXPECT_TRUE(rate_limiter_->requestAllowed(descriptor_));
-    EXPECT_FALSE(rate_limiter_->requestAllowed(descriptor_));
   }
 
   // This tests the case in which two allowed checks race.
@@ -296,8 +323,12 @@ TEST_F(LocalRateLimiterDescriptorImplTest, TokenBucketDescriptor2) {
   EXPECT_TRUE(rate_limiter_->requestAllowed(descriptor_));
   EXPECT_FALSE(rate_limiter_->requestAllowed(descriptor_));
   EXPECT_FALSE(rate_limiter_->requestAllowed(descriptor_));
-  dispatcher_.globalTimeSystem().advanceTimeAndRun(std::chrono::milliseconds(100), dispatcher_,
-                                                   Envoy::Event::Dispatcher::RunType::NonBlock);
+
+  // The descriptor isn't refilled in the global bucket's fill interval.
+  simTime().advanceTimeWait(std::chrono::milliseconds(50));
+  EXPECT_FALSE(rate_limiter_->requestAllowed(descriptor_));
+  simTime().advanceTimeWait(std::chrono::milliseconds(50));
+  EXPECT_TRUE(rate_limiter_->requestAllowed(descriptor_));
 }
 
 // Verify token bucket functionality with a single token.
@@ -311,26 +342,14 @@ TEST_F(LocalRateLimiterDescriptorImplTest, TokenBucketDescriptor) {
   EXPECT_FALSE(rate_limiter_->requestAllowed(descriptor_));
 
   // 0 -> 1 tokens
-  dispatcher_.globalTimeSystem().advanceTimeAndRun(std::chrono::milliseconds(100), dispatcher_,
-                                                   Envoy::Event::Dispatcher::RunType::NonBlock);
-  EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(50), nullptr));
-  fill_timer_->invokeCallback();
+  simTime().advanceTimeWait(std::chrono::milliseconds(100));
 
   // 1 -> 0 tokens
   EXPECT_TRUE(rate_limiter_->requestAllowed(descriptor_));
   EXPECT_FALSE(rate_limiter_->requestAllowed(descriptor_));
 
-  // 0 -> 1 tokens
-  dispatcher_.globalTimeSystem().advanceTimeAndRun(std::chrono::milliseconds(100), dispatcher_,
-                                                   Envoy::Event::Dispatcher::RunType::NonBlock);
-  EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(50), nullptr));
-  fill_timer_->invokeCallback();
-
-  // 1 -> 1 tokens
-  dispatcher_.globalTimeSystem().advanceTimeAndRun(std::chrono::milliseconds(100), dispatcher_,
-                                                   Envoy::Event::Dispatcher::RunType::NonBlock);
-  EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(50), nullptr));
-  fill_timer_->invokeCallback();
+  // 0 -> 1 -> 1 tokens
+  simTime().advanceTimeWait(std::chrono::milliseconds(200));
 
   // 1 -> 0 tokens
   EXPECT_TRUE(rate_limiter_->requestAllowed(descriptor_));
@@ -349,19 +368,13 @@ TEST_F(LocalRateLimiterDescriptorImplTest, TokenBucketMultipleTokensPerFillDescr
   EXPECT_FALSE(rate_limiter_->requestAllowed(descriptor_));
 
   // 0 -> 2 tokens
-  dispatcher_.globalTimeSystem().advanceTimeAndRun(std::chrono::milliseconds(100), dispatcher_,
-                                                   Envoy::Event::Dispatcher::RunType::NonBlock);
-  EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(50), nullptr));
-  fill_timer_->invokeCallback();
+  simTime().advanceTimeWait(std::chrono::milliseconds(100));
 
   // 2 -> 1 tokens
   EXPECT_TRUE(rate_limiter_->requestAllowed(descriptor_));
 
   // 1 -> 2 tokens
-  dispatcher_.globalTimeSystem().advanceTimeAndRun(std::chrono::milliseconds(100), dispatcher_,
-                                                   Envoy::Event::Dispatcher::RunType::NonBlock);
-  EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(50), nullptr));
-  fill_timer_->invokeCallback();
+  simTime().advanceTimeWait(std::chrono::milliseconds(100));
 
   // 2 -> 0 tokens
   EXPECT_TRUE(rate_limiter_->requestAllowed(descriptor_));
@@ -383,10 +396,7 @@ TEST_F(LocalRateLimiterDescriptorImplTest, TokenBucketDifferentDescriptorDiffere
   EXPECT_FALSE(rate_limiter_->requestAllowed(descriptor_));
 
   // 0 -> 1 tokens for descriptor2_
-  dispatcher_.globalTimeSystem().advanceTimeAndRun(std::chrono::milliseconds(50), dispatcher_,
-                                                   Envoy::Event::Dispatcher::RunType::NonBlock);
-  EXPECT_CALL(*fill_timer_, enableTimer(std::chrono::milliseconds(50), nullptr));
-  fill_timer_->invokeCallback();
+  simTime().advanceTimeWait(std::chrono::milliseconds(50));
 
   // 1 -> 0 tokens for descriptor2_ and 0 only for descriptor_
   EXPECT_TRUE(rate_limiter_->requestAllowed(descriptor2_));
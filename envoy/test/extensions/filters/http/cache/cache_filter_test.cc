@@ -612,6 +612,292 @@ TEST_F(CacheFilterTest, FilterDeletedBeforePostedCallbackExecuted) {
   }
 }
 
+class CollapsedForwardingTest : public CacheFilterTest {
+protected:
+  void SetUp() override {
+    CacheFilterTest::SetUp();
+    ON_CALL(follower_decoder_callbacks_, dispatcher())
+        .WillByDefault(::testing::ReturnRef(*dispatcher_));
+    config_.mutable_collapsed_forwarding()->mutable_wait_timeout()->set_seconds(5);
+    forwarder_ = std::make_shared<CollapsedForwarder>(config_.collapsed_forwarding(),
+                                                      /*stats_prefix=*/"", context_.scope());
+  }
+
+  void setMaxBufferedBytes(uint32_t max_buffered_bytes) {
+    config_.mutable_collapsed_forwarding()->mutable_max_buffered_bytes()->set_value(
+        max_buffered_bytes);
+    forwarder_ = std::make_shared<CollapsedForwarder>(config_.collapsed_forwarding(),
+                                                      /*stats_prefix=*/"", context_.scope());
+  }
+
+  CacheFilterSharedPtr makeCollapsingFilter() {
+    return std::make_shared<CacheFilter>(config_, /*stats_prefix=*/"", context_.scope(),
+                                         context_.timeSource(), simple_cache_, forwarder_);
+  }
+
+  // Creates a filter for the first request, which misses the cache and is forwarded upstream.
+  CacheFilterSharedPtr makeFiller() {
+    CacheFilterSharedPtr filter = makeCollapsingFilter();
+    filter->setDecoderFilterCallbacks(decoder_callbacks_);
+    filter->setEncoderFilterCallbacks(encoder_callbacks_);
+    testDecodeRequestMiss(filter);
+    return filter;
+  }
+
+  // Creates a filter for a second request for the same resource, which waits for the response to
+  // the first one instead of being forwarded upstream.
+  CacheFilterSharedPtr makeFollower() {
+    follower_request_headers_ = request_headers_;
+    CacheFilterSharedPtr filter = makeCollapsingFilter();
+    filter->setDecoderFilterCallbacks(follower_decoder_callbacks_);
+    filter->setEncoderFilterCallbacks(follower_encoder_callbacks_);
+    EXPECT_CALL(follower_decoder_callbacks_, continueDecoding).Times(0);
+    EXPECT_EQ(filter->decodeHeaders(follower_request_headers_, true),
+              Http::FilterHeadersStatus::StopAllIterationAndWatermark);
+    dispatcher_->run(Event::Dispatcher::RunType::Block);
+    ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+    return filter;
+  }
+
+  CollapsedForwarderSharedPtr forwarder_;
+  Http::TestRequestHeaderMapImpl follower_request_headers_;
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> follower_decoder_callbacks_;
+  NiceMock<Http::MockStreamEncoderFilterCallbacks> follower_encoder_callbacks_;
+};
+
+TEST_F(CollapsedForwardingTest, FollowerIsServedFillersResponse) {
+  request_headers_.setHost("FollowerIsServedFillersResponse");
+  const std::string body = "abc";
+  CacheFilterSharedPtr filler = makeFiller();
+  CacheFilterSharedPtr follower = makeFollower();
+  EXPECT_EQ(1, forwarder_->stats().collapsed_.value());
+
+  response_headers_.setContentLength(body.size());
+  EXPECT_CALL(follower_decoder_callbacks_,
+              encodeHeaders_(IsSupersetOfHeaders(response_headers_), false));
+  EXPECT_CALL(
+      follower_decoder_callbacks_,
+      encodeData(testing::Property(&Buffer::Instance::toString, testing::Eq(body)), true));
+  Buffer::OwnedImpl buffer(body);
+  EXPECT_EQ(filler->encodeHeaders(response_headers_, false), Http::FilterHeadersStatus::Continue);
+  EXPECT_EQ(filler->encodeData(buffer, true), Http::FilterDataStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+
+  filler->onDestroy();
+  follower->onDestroy();
+}
+
+TEST_F(CollapsedForwardingTest, FollowerJoinsStreamingResponse) {
+  request_headers_.setHost("FollowerJoinsStreamingResponse");
+  CacheFilterSharedPtr filler = makeFiller();
+  Buffer::OwnedImpl first_chunk("abc");
+  EXPECT_EQ(filler->encodeHeaders(response_headers_, false), Http::FilterHeadersStatus::Continue);
+  EXPECT_EQ(filler->encodeData(first_chunk, false), Http::FilterDataStatus::Continue);
+
+  // The follower is served what has arrived so far as soon as it joins.
+  EXPECT_CALL(follower_decoder_callbacks_,
+              encodeHeaders_(IsSupersetOfHeaders(response_headers_), false));
+  EXPECT_CALL(
+      follower_decoder_callbacks_,
+      encodeData(testing::Property(&Buffer::Instance::toString, testing::Eq("abc")), false));
+  CacheFilterSharedPtr follower = makeFollower();
+
+  // And the rest as it arrives.
+  EXPECT_CALL(
+      follower_decoder_callbacks_,
+      encodeData(testing::Property(&Buffer::Instance::toString, testing::Eq("def")), true));
+  Buffer::OwnedImpl second_chunk("def");
+  EXPECT_EQ(filler->encodeData(second_chunk, true), Http::FilterDataStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+
+  filler->onDestroy();
+  follower->onDestroy();
+}
+
+TEST_F(CollapsedForwardingTest, UncacheableResponseIsNotShared) {
+  request_headers_.setHost("UncacheableResponseIsNotShared");
+  CacheFilterSharedPtr filler = makeFiller();
+  CacheFilterSharedPtr follower = makeFollower();
+
+  // The follower is forwarded upstream on its own.
+  EXPECT_CALL(follower_decoder_callbacks_, encodeHeaders_).Times(0);
+  EXPECT_CALL(follower_decoder_callbacks_, continueDecoding);
+  response_headers_.setReferenceKey(Http::CustomHeaders::get().CacheControl, "no-store");
+  EXPECT_EQ(filler->encodeHeaders(response_headers_, true), Http::FilterHeadersStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+  EXPECT_EQ(1, forwarder_->stats().abandoned_.value());
+
+  filler->onDestroy();
+  follower->onDestroy();
+}
+
+TEST_F(CollapsedForwardingTest, FollowerIsForwardedWhenFillerIsDestroyed) {
+  request_headers_.setHost("FollowerIsForwardedWhenFillerIsDestroyed");
+  CacheFilterSharedPtr filler = makeFiller();
+  CacheFilterSharedPtr follower = makeFollower();
+
+  EXPECT_CALL(follower_decoder_callbacks_, continueDecoding);
+  filler->onDestroy();
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+
+  follower->onDestroy();
+}
+
+TEST_F(CollapsedForwardingTest, FollowerIsForwardedAfterWaitTimeout) {
+  request_headers_.setHost("FollowerIsForwardedAfterWaitTimeout");
+  CacheFilterSharedPtr filler = makeFiller();
+  CacheFilterSharedPtr follower = makeFollower();
+
+  EXPECT_CALL(follower_decoder_callbacks_, continueDecoding);
+  time_source_.advanceTimeAndRun(std::chrono::seconds(6), *dispatcher_,
+                                 Event::Dispatcher::RunType::NonBlock);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+  EXPECT_EQ(1, forwarder_->stats().wait_timeout_.value());
+
+  // The filler's response is no longer served to the follower.
+  EXPECT_CALL(follower_decoder_callbacks_, encodeHeaders_).Times(0);
+  EXPECT_EQ(filler->encodeHeaders(response_headers_, true), Http::FilterHeadersStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+
+  filler->onDestroy();
+  follower->onDestroy();
+}
+
+// Once the body is larger than max_buffered_bytes, new requests are no longer collapsed, but
+// followers that keep up are still served.
+TEST_F(CollapsedForwardingTest, BufferOverflow) {
+  request_headers_.setHost("BufferOverflow");
+  setMaxBufferedBytes(4);
+  CacheFilterSharedPtr filler = makeFiller();
+  CacheFilterSharedPtr follower = makeFollower();
+
+  EXPECT_CALL(follower_decoder_callbacks_,
+              encodeHeaders_(IsSupersetOfHeaders(response_headers_), false));
+  EXPECT_CALL(
+      follower_decoder_callbacks_,
+      encodeData(testing::Property(&Buffer::Instance::toString, testing::Eq("abc")), false));
+  Buffer::OwnedImpl first_chunk("abc");
+  EXPECT_EQ(filler->encodeHeaders(response_headers_, false), Http::FilterHeadersStatus::Continue);
+  EXPECT_EQ(filler->encodeData(first_chunk, false), Http::FilterDataStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+
+  EXPECT_CALL(
+      follower_decoder_callbacks_,
+      encodeData(testing::Property(&Buffer::Instance::toString, testing::Eq("def")), false));
+  Buffer::OwnedImpl second_chunk("def");
+  EXPECT_EQ(filler->encodeData(second_chunk, false), Http::FilterDataStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+  EXPECT_EQ(1, forwarder_->stats().buffer_overflow_.value());
+
+  // The start of the body is gone, so a new request is forwarded on its own.
+  CacheFilterSharedPtr filter = makeCollapsingFilter();
+  filter->setDecoderFilterCallbacks(decoder_callbacks_);
+  filter->setEncoderFilterCallbacks(encoder_callbacks_);
+  testDecodeRequestMiss(filter);
+  EXPECT_EQ(1, forwarder_->stats().collapsed_.value());
+
+  EXPECT_CALL(
+      follower_decoder_callbacks_,
+      encodeData(testing::Property(&Buffer::Instance::toString, testing::Eq("g")), true));
+  Buffer::OwnedImpl last_chunk("g");
+  EXPECT_EQ(filler->encodeData(last_chunk, true), Http::FilterDataStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+
+  filler->onDestroy();
+  follower->onDestroy();
+  filter->onDestroy();
+}
+
+// A follower doesn't take more of the body while its downstream is above the high watermark.
+TEST_F(CollapsedForwardingTest, FollowerRespectsWatermarks) {
+  request_headers_.setHost("FollowerRespectsWatermarks");
+  CacheFilterSharedPtr filler = makeFiller();
+  CacheFilterSharedPtr follower = makeFollower();
+
+  EXPECT_CALL(follower_decoder_callbacks_, encodeHeaders_(testing::_, false));
+  EXPECT_CALL(follower_decoder_callbacks_, encodeData(testing::_, false));
+  Buffer::OwnedImpl first_chunk("abc");
+  EXPECT_EQ(filler->encodeHeaders(response_headers_, false), Http::FilterHeadersStatus::Continue);
+  EXPECT_EQ(filler->encodeData(first_chunk, false), Http::FilterDataStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+
+  follower->onAboveWriteBufferHighWatermark();
+  follower->onAboveWriteBufferHighWatermark();
+  EXPECT_CALL(follower_decoder_callbacks_, encodeData).Times(0);
+  Buffer::OwnedImpl second_chunk("def");
+  EXPECT_EQ(filler->encodeData(second_chunk, true), Http::FilterDataStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  follower->onBelowWriteBufferLowWatermark();
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+
+  EXPECT_CALL(
+      follower_decoder_callbacks_,
+      encodeData(testing::Property(&Buffer::Instance::toString, testing::Eq("def")), true));
+  EXPECT_CALL(follower_decoder_callbacks_, removeDownstreamWatermarkCallbacks(testing::_));
+  follower->onBelowWriteBufferLowWatermark();
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+
+  filler->onDestroy();
+  follower->onDestroy();
+}
+
+// A follower that falls more than max_buffered_bytes behind is reset, instead of the body it
+// hasn't been served being buffered without bound.
+TEST_F(CollapsedForwardingTest, SlowFollowerIsReset) {
+  request_headers_.setHost("SlowFollowerIsReset");
+  setMaxBufferedBytes(4);
+  CacheFilterSharedPtr filler = makeFiller();
+  CacheFilterSharedPtr follower = makeFollower();
+
+  EXPECT_CALL(follower_decoder_callbacks_, encodeHeaders_(testing::_, false));
+  EXPECT_CALL(follower_decoder_callbacks_, encodeData(testing::_, false));
+  Buffer::OwnedImpl first_chunk("abc");
+  EXPECT_EQ(filler->encodeHeaders(response_headers_, false), Http::FilterHeadersStatus::Continue);
+  EXPECT_EQ(filler->encodeData(first_chunk, false), Http::FilterDataStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+
+  follower->onAboveWriteBufferHighWatermark();
+  Buffer::OwnedImpl second_chunk("defgh");
+  EXPECT_EQ(filler->encodeData(second_chunk, false), Http::FilterDataStatus::Continue);
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+
+  EXPECT_CALL(follower_decoder_callbacks_, encodeData).Times(0);
+  EXPECT_CALL(follower_decoder_callbacks_, resetStream());
+  follower->onBelowWriteBufferLowWatermark();
+  dispatcher_->run(Event::Dispatcher::RunType::Block);
+  ::testing::Mock::VerifyAndClearExpectations(&follower_decoder_callbacks_);
+
+  filler->onDestroy();
+  follower->onDestroy();
+}
+
+TEST_F(CollapsedForwardingTest, RangeRequestIsNotCollapsed) {
+  request_headers_.setHost("RangeRequestIsNotCollapsed");
+  CacheFilterSharedPtr filler = makeFiller();
+
+  request_headers_.addCopy(Http::Headers::get().Range, "bytes=0-1");
+  CacheFilterSharedPtr filter = makeCollapsingFilter();
+  filter->setDecoderFilterCallbacks(decoder_callbacks_);
+  filter->setEncoderFilterCallbacks(encoder_callbacks_);
+  testDecodeRequestMiss(filter);
+  EXPECT_EQ(0, forwarder_->stats().collapsed_.value());
+
+  filler->onDestroy();
+  filter->onDestroy();
+}
+
 // A new type alias for a different type of tests that use the exact same class
 using ValidationHeadersTest = CacheFilterTest;
 
@@ -0,0 +1,413 @@
+#include "envoy/http/header_map.h"
+#include "envoy/registry/registry.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/extensions/filters/http/cache/cache_headers_utils.h"
+#include "source/extensions/filters/http/cache/disk_http_cache/disk_http_cache.h"
+
+#include "test/extensions/filters/http/cache/common.h"
+#include "test/mocks/server/factory_context.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/thread_factory_for_test.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/notification.h"
+#include "gtest/gtest.h"
+
+using testing::ReturnRef;
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+envoy::extensions::filters::http::cache::v3alpha::CacheConfig getConfig() {
+  // Allows 'accept' to be varied in the tests.
+  envoy::extensions::filters::http::cache::v3alpha::CacheConfig config;
+  const auto& add_accept = config.mutable_allowed_vary_headers()->Add();
+  add_accept->set_exact("accept");
+  return config;
+}
+
+class DiskHttpCacheTest : public testing::Test {
+protected:
+  DiskHttpCacheTest() : vary_allow_list_(getConfig().allowed_vary_headers()) {
+    TestEnvironment::removePath(path_);
+    config_.set_path(path_);
+    config_.mutable_segment_size_bytes()->set_value(1024 * 1024);
+    config_.mutable_index_entries()->set_value(1024);
+    // With a single thread, the cache runs jobs in the order they are posted, so a lookup sees all
+    // writes that were started before it.
+    config_.mutable_io_threads()->set_value(1);
+    resetCache();
+    request_headers_.setMethod("GET");
+    request_headers_.setHost("example.com");
+    request_headers_.setScheme("https");
+    request_headers_.setCopy(Http::CustomHeaders::get().CacheControl, "max-age=3600");
+  }
+
+  ~DiskHttpCacheTest() override {
+    cache_.reset();
+    TestEnvironment::removePath(path_);
+  }
+
+  // Reopens the cache, which waits for pending writes to finish.
+  void resetCache() {
+    cache_.reset();
+    cache_ = std::make_unique<DiskHttpCache>(config_, Thread::threadFactoryForTest());
+  }
+
+  // Lets the contents of a segment file be changed while the cache is closed.
+  void modifySegment(uint32_t id, const std::function<void(std::string&)>& modify) {
+    cache_.reset();
+    const std::string segment_path = absl::StrCat(path_, "/segment-", id);
+    std::string contents = TestEnvironment::readFileToStringForTest(segment_path);
+    modify(contents);
+    TestEnvironment::writeStringToFileForTest(segment_path, contents, true);
+    resetCache();
+  }
+
+  // Performs a cache lookup and waits for its result.
+  LookupContextPtr lookup(absl::string_view request_path) {
+    request_headers_.setPath(request_path);
+    LookupContextPtr context = cache_->makeLookupContext(
+        LookupRequest(request_headers_, time_source_.systemTime(), vary_allow_list_));
+    absl::Notification done;
+    context->getHeaders([this, &done](LookupResult&& result) {
+      lookup_result_ = std::move(result);
+      done.Notify();
+    });
+    done.WaitForNotification();
+    return context;
+  }
+
+  // Inserts a value into the cache. The value is written asynchronously.
+  void insert(absl::string_view request_path, const absl::string_view response_body) {
+    InsertContextPtr inserter = cache_->makeInsertContext(lookup(request_path));
+    inserter->insertHeaders(response_headers_, {time_source_.systemTime()}, false);
+    inserter->insertBody(Buffer::OwnedImpl(response_body), nullptr, true);
+  }
+
+  Buffer::InstancePtr getBody(LookupContext& context, uint64_t start, uint64_t end) {
+    Buffer::InstancePtr body;
+    absl::Notification done;
+    context.getBody(AdjustedByteRange(start, end), [&body, &done](Buffer::InstancePtr&& data) {
+      body = std::move(data);
+      done.Notify();
+    });
+    done.WaitForNotification();
+    EXPECT_NE(body, nullptr);
+    return body;
+  }
+
+  // Returns the cached body of the response for request_path, or nullopt on a miss.
+  absl::optional<std::string> lookupBody(absl::string_view request_path) {
+    LookupContextPtr context = lookup(request_path);
+    if (lookup_result_.cache_entry_status_ != CacheEntryStatus::Ok) {
+      return absl::nullopt;
+    }
+    if (lookup_result_.content_length_ == 0) {
+      return "";
+    }
+    return getBody(*context, 0, lookup_result_.content_length_)->toString();
+  }
+
+  const std::string path_{TestEnvironment::temporaryPath("disk_http_cache")};
+  envoy::extensions::cache::disk_http_cache::v3alpha::DiskHttpCacheConfig config_;
+  std::unique_ptr<DiskHttpCache> cache_;
+  LookupResult lookup_result_;
+  Http::TestRequestHeaderMapImpl request_headers_;
+  Event::SimulatedTimeSystem time_source_;
+  DateFormatter formatter_{"%a, %d %b %Y %H:%M:%S GMT"};
+  Http::TestResponseHeaderMapImpl response_headers_{
+      {"date", formatter_.fromTime(time_source_.systemTime())},
+      {"cache-control", "public,max-age=3600"}};
+  VaryAllowList vary_allow_list_;
+};
+
+TEST_F(DiskHttpCacheTest, PutGet) {
+  lookup("/name");
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+
+  insert("/name", "Value");
+  EXPECT_EQ("Value", lookupBody("/name"));
+  EXPECT_THAT(lookup_result_.headers_.get(), HeaderMapEqualIgnoreOrder(&response_headers_));
+  EXPECT_EQ(absl::nullopt, lookupBody("/another_name"));
+
+  insert("/name", "NewValue");
+  EXPECT_EQ("NewValue", lookupBody("/name"));
+}
+
+TEST_F(DiskHttpCacheTest, StreamingPut) {
+  InsertContextPtr inserter = cache_->makeInsertContext(lookup("/name"));
+  inserter->insertHeaders(response_headers_, {time_source_.systemTime()}, false);
+  inserter->insertBody(
+      Buffer::OwnedImpl("Hello, "), [](bool ready) { EXPECT_TRUE(ready); }, false);
+  inserter->insertBody(Buffer::OwnedImpl("World!"), nullptr, true);
+
+  LookupContextPtr context = lookup("/name");
+  EXPECT_EQ(CacheEntryStatus::Ok, lookup_result_.cache_entry_status_);
+  ASSERT_EQ(13, lookup_result_.content_length_);
+  EXPECT_EQ("World", getBody(*context, 7, 12)->toString());
+}
+
+// Large bodies are read a chunk at a time, leaving it to the filter to ask for the rest.
+TEST_F(DiskHttpCacheTest, LargeBodyIsReadInChunks) {
+  config_.mutable_segment_size_bytes()->set_value(4 * 1024 * 1024);
+  resetCache();
+  const std::string body = std::string(1024 * 1024, 'a') + std::string(1024 * 1024, 'b');
+  insert("/name", body);
+
+  LookupContextPtr context = lookup("/name");
+  ASSERT_EQ(body.size(), lookup_result_.content_length_);
+  EXPECT_EQ(std::string(1024 * 1024, 'a'), getBody(*context, 0, body.size())->toString());
+  EXPECT_EQ(std::string(1024 * 1024, 'b'),
+            getBody(*context, 1024 * 1024, body.size())->toString());
+}
+
+TEST_F(DiskHttpCacheTest, ResponsesSurviveRestart) {
+  insert("/a", "body a");
+  insert("/b", "body b");
+  resetCache();
+
+  EXPECT_EQ("body a", lookupBody("/a"));
+  EXPECT_EQ("body b", lookupBody("/b"));
+
+  insert("/c", "body c");
+  EXPECT_EQ("body c", lookupBody("/c"));
+  EXPECT_EQ("body a", lookupBody("/a"));
+  EXPECT_EQ(1, cache_->segmentCount());
+}
+
+// Records that a crash left incomplete are dropped once the I/O threads have checked the segment,
+// so that the index doesn't refer to them.
+TEST_F(DiskHttpCacheTest, IncompleteRecordIsDroppedOnLoad) {
+  insert("/a", "body a");
+  insert("/b", "body b");
+  modifySegment(1, [](std::string& contents) { contents.pop_back(); });
+
+  // With a single I/O thread, the segment has been checked before the lookups run.
+  EXPECT_EQ("body a", lookupBody("/a"));
+  EXPECT_EQ(0, cache_->unverifiedSegmentCount());
+  EXPECT_EQ(absl::nullopt, lookupBody("/b"));
+
+  // New records take the place of the dropped one.
+  insert("/c", "body c");
+  EXPECT_EQ("body c", lookupBody("/c"));
+  EXPECT_EQ("body a", lookupBody("/a"));
+  EXPECT_EQ(1, cache_->segmentCount());
+}
+
+TEST_F(DiskHttpCacheTest, CorruptRecordIsDroppedOnLoad) {
+  insert("/a", "body a");
+  insert("/b", "body b");
+  // The body of the last record is followed by the 8 byte trailer.
+  modifySegment(1, [](std::string& contents) { contents[contents.size() - 9] = 'c'; });
+
+  EXPECT_EQ("body a", lookupBody("/a"));
+  EXPECT_EQ(absl::nullopt, lookupBody("/b"));
+}
+
+// The records can't be found if the index is reset, so the segments are deleted.
+TEST_F(DiskHttpCacheTest, SegmentsAreDeletedWithIndex) {
+  insert("/name", "body");
+  config_.mutable_index_entries()->set_value(2048);
+  resetCache();
+
+  EXPECT_EQ(0, cache_->segmentCount());
+  EXPECT_EQ(0, cache_->sizeBytes());
+  EXPECT_EQ(absl::nullopt, lookupBody("/name"));
+}
+
+TEST_F(DiskHttpCacheTest, EvictsOldestSegment) {
+  // Every segment fits one response, and the cache fits two of them.
+  config_.mutable_segment_size_bytes()->set_value(64 * 1024);
+  config_.mutable_max_size_bytes()->set_value(100 * 1024);
+  resetCache();
+  const std::string body(40 * 1024, 'a');
+
+  insert("/a", body);
+  insert("/b", body);
+  EXPECT_EQ(body, lookupBody("/a"));
+  EXPECT_EQ(2, cache_->segmentCount());
+
+  insert("/c", body);
+  insert("/d", body);
+  EXPECT_EQ(absl::nullopt, lookupBody("/a"));
+  EXPECT_EQ(absl::nullopt, lookupBody("/b"));
+  EXPECT_EQ(body, lookupBody("/c"));
+  EXPECT_EQ(body, lookupBody("/d"));
+  EXPECT_EQ(2, cache_->segmentCount());
+  EXPECT_LE(cache_->sizeBytes(), 100 * 1024);
+
+  // Segments that are deleted while a lookup uses them stay readable.
+  LookupContextPtr context = lookup("/c");
+  insert("/e", body);
+  insert("/f", body);
+  EXPECT_EQ(body, getBody(*context, 0, body.size())->toString());
+}
+
+TEST_F(DiskHttpCacheTest, ResponseLargerThanSegmentIsNotCached) {
+  config_.mutable_segment_size_bytes()->set_value(64 * 1024);
+  resetCache();
+  EXPECT_EQ(64 * 1024, cache_->maxBodySizeBytes());
+
+  InsertContextPtr inserter = cache_->makeInsertContext(lookup("/name"));
+  inserter->insertHeaders(response_headers_, {time_source_.systemTime()}, false);
+  inserter->insertBody(
+      Buffer::OwnedImpl(std::string(40 * 1024, 'a')), [](bool ready) { EXPECT_TRUE(ready); },
+      false);
+  bool called = false;
+  inserter->insertBody(
+      Buffer::OwnedImpl(std::string(40 * 1024, 'a')),
+      [&called](bool ready) {
+        called = true;
+        EXPECT_FALSE(ready);
+      },
+      false);
+  EXPECT_TRUE(called);
+  inserter->insertBody(Buffer::OwnedImpl("a"), nullptr, true);
+
+  EXPECT_EQ(absl::nullopt, lookupBody("/name"));
+  EXPECT_EQ(0, cache_->sizeBytes());
+}
+
+TEST_F(DiskHttpCacheTest, VaryResponses) {
+  response_headers_.setCopy(Http::LowerCaseString("vary"), "accept");
+
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "image/*");
+  insert("/resource", "image");
+  EXPECT_EQ("image", lookupBody("/resource"));
+
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "text/html");
+  EXPECT_EQ(absl::nullopt, lookupBody("/resource"));
+  insert("/resource", "html");
+  EXPECT_EQ("html", lookupBody("/resource"));
+
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "image/*");
+  EXPECT_EQ("image", lookupBody("/resource"));
+
+  // A cached variant is not served once the header it varies on is no longer allowed.
+  Protobuf::RepeatedPtrField<::envoy::type::matcher::v3::StringMatcher> proto_allow_list;
+  proto_allow_list.Add()->set_exact("width");
+  vary_allow_list_ = VaryAllowList(proto_allow_list);
+  EXPECT_EQ(absl::nullopt, lookupBody("/resource"));
+}
+
+TEST_F(DiskHttpCacheTest, UpdateHeadersAndMetadata) {
+  insert("/name", "body");
+
+  time_source_.advanceTimeWait(Seconds(3601));
+  Http::TestResponseHeaderMapImpl response_headers{
+      {"date", formatter_.fromTime(time_source_.systemTime())},
+      {"cache-control", "public,max-age=3600"}};
+  cache_->updateHeaders(*lookup("/name"), response_headers, {time_source_.systemTime()});
+
+  lookup("/name");
+  ASSERT_EQ(CacheEntryStatus::Ok, lookup_result_.cache_entry_status_);
+  EXPECT_THAT(lookup_result_.headers_.get(), HeaderMapEqualIgnoreOrder(&response_headers));
+  EXPECT_EQ("body", lookupBody("/name"));
+}
+
+// The body is copied to the new record a chunk at a time instead of being read into memory.
+TEST_F(DiskHttpCacheTest, UpdateHeadersOfLargeBody) {
+  config_.mutable_segment_size_bytes()->set_value(8 * 1024 * 1024);
+  resetCache();
+  const std::string body = std::string(1024 * 1024, 'a') + std::string(1024 * 1024 + 1, 'b');
+  insert("/name", body);
+
+  time_source_.advanceTimeWait(Seconds(3601));
+  Http::TestResponseHeaderMapImpl response_headers{
+      {"date", formatter_.fromTime(time_source_.systemTime())},
+      {"cache-control", "public,max-age=3600"}};
+  cache_->updateHeaders(*lookup("/name"), response_headers, {time_source_.systemTime()});
+  // The copy has to pass the checks done when the cache is opened.
+  resetCache();
+
+  LookupContextPtr context = lookup("/name");
+  ASSERT_EQ(CacheEntryStatus::Ok, lookup_result_.cache_entry_status_);
+  EXPECT_THAT(lookup_result_.headers_.get(), HeaderMapEqualIgnoreOrder(&response_headers));
+  ASSERT_EQ(body.size(), lookup_result_.content_length_);
+  EXPECT_EQ(std::string(1024 * 1024, 'a'), getBody(*context, 0, body.size())->toString());
+  EXPECT_EQ(std::string(1024 * 1024, 'b'),
+            getBody(*context, 1024 * 1024, body.size())->toString());
+  EXPECT_EQ("b", getBody(*context, 2 * 1024 * 1024, body.size())->toString());
+}
+
+TEST_F(DiskHttpCacheTest, UpdateHeadersOfVariant) {
+  response_headers_.setCopy(Http::LowerCaseString("vary"), "accept");
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "image/*");
+  insert("/resource", "image");
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "text/html");
+  insert("/resource", "html");
+
+  time_source_.advanceTimeWait(Seconds(3601));
+  Http::TestResponseHeaderMapImpl response_headers{
+      {"date", formatter_.fromTime(time_source_.systemTime())},
+      {"cache-control", "public,max-age=3600"},
+      {"vary", "accept"}};
+  cache_->updateHeaders(*lookup("/resource"), response_headers, {time_source_.systemTime()});
+
+  lookup("/resource");
+  ASSERT_EQ(CacheEntryStatus::Ok, lookup_result_.cache_entry_status_);
+  EXPECT_THAT(lookup_result_.headers_.get(), HeaderMapEqualIgnoreOrder(&response_headers));
+  EXPECT_EQ("html", lookupBody("/resource"));
+
+  // Only the variant the request was served is updated.
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "image/*");
+  lookup("/resource");
+  EXPECT_EQ(CacheEntryStatus::RequiresValidation, lookup_result_.cache_entry_status_);
+
+  // A response that now varies on other headers doesn't replace the variant.
+  response_headers.setCopy(Http::LowerCaseString("vary"), "accept-language");
+  cache_->updateHeaders(*lookup("/resource"), response_headers, {time_source_.systemTime()});
+  lookup("/resource");
+  EXPECT_EQ(CacheEntryStatus::RequiresValidation, lookup_result_.cache_entry_status_);
+  EXPECT_EQ("image", lookupBody("/resource"));
+}
+
+TEST_F(DiskHttpCacheTest, UpdateHeadersForMissingKey) {
+  cache_->updateHeaders(*lookup("/name"), response_headers_, {time_source_.systemTime()});
+  EXPECT_EQ(absl::nullopt, lookupBody("/name"));
+  EXPECT_EQ(0, cache_->segmentCount());
+}
+
+TEST(Registration, GetFactory) {
+  HttpCacheFactory* factory = Registry::FactoryRegistry<HttpCacheFactory>::getFactoryByType(
+      "envoy.extensions.cache.disk_http_cache.v3alpha.DiskHttpCacheConfig");
+  ASSERT_NE(factory, nullptr);
+  envoy::extensions::cache::disk_http_cache::v3alpha::DiskHttpCacheConfig disk_config;
+  disk_config.set_path(TestEnvironment::temporaryPath("disk_http_cache_registration"));
+  envoy::extensions::filters::http::cache::v3alpha::CacheConfig config;
+  config.mutable_typed_config()->PackFrom(disk_config);
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  ON_CALL(factory_context.api_, threadFactory())
+      .WillByDefault(ReturnRef(Thread::threadFactoryForTest()));
+  HttpCacheSharedPtr cache = factory->getCache(config, factory_context);
+  EXPECT_EQ(cache->cacheInfo().name_, "envoy.extensions.http.cache.disk");
+  // Filters that use the same directory share the cache, others get their own.
+  EXPECT_EQ(factory->getCache(config, factory_context), cache);
+  envoy::extensions::cache::disk_http_cache::v3alpha::DiskHttpCacheConfig other_disk_config;
+  other_disk_config.set_path(TestEnvironment::temporaryPath("disk_http_cache_registration_other"));
+  envoy::extensions::filters::http::cache::v3alpha::CacheConfig other_config;
+  other_config.mutable_typed_config()->PackFrom(other_disk_config);
+  EXPECT_NE(factory->getCache(other_config, factory_context), cache);
+
+  // The directory can't be used with other settings while the cache is open.
+  disk_config.mutable_io_threads()->set_value(1);
+  config.mutable_typed_config()->PackFrom(disk_config);
+  EXPECT_THROW_WITH_REGEX(factory->getCache(config, factory_context), EnvoyException,
+                          "with different settings");
+  cache.reset();
+  cache = factory->getCache(config, factory_context);
+  EXPECT_NE(cache, nullptr);
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
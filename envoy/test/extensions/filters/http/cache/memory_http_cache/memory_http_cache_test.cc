@@ -0,0 +1,322 @@
+#include "envoy/http/header_map.h"
+#include "envoy/registry/registry.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/extensions/filters/http/cache/cache_headers_utils.h"
+#include "source/extensions/filters/http/cache/memory_http_cache/memory_http_cache.h"
+
+#include "test/extensions/filters/http/cache/common.h"
+#include "test/mocks/server/factory_context.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+envoy::extensions::filters::http::cache::v3alpha::CacheConfig getConfig() {
+  // Allows 'accept' to be varied in the tests.
+  envoy::extensions::filters::http::cache::v3alpha::CacheConfig config;
+  const auto& add_accept = config.mutable_allowed_vary_headers()->Add();
+  add_accept->set_exact("accept");
+  return config;
+}
+
+class MemoryHttpCacheTest : public testing::Test {
+protected:
+  MemoryHttpCacheTest() : vary_allow_list_(getConfig().allowed_vary_headers()) {
+    request_headers_.setMethod("GET");
+    request_headers_.setHost("example.com");
+    request_headers_.setScheme("https");
+    request_headers_.setCopy(Http::CustomHeaders::get().CacheControl, "max-age=3600");
+  }
+
+  void resetCache(uint64_t max_size_bytes, uint32_t shard_count) {
+    cache_ = std::make_unique<MemoryHttpCache>(max_size_bytes, shard_count);
+  }
+
+  // Performs a cache lookup.
+  LookupContextPtr lookup(absl::string_view request_path) {
+    request_headers_.setPath(request_path);
+    LookupContextPtr context = cache_->makeLookupContext(
+        LookupRequest(request_headers_, time_source_.systemTime(), vary_allow_list_));
+    context->getHeaders([this](LookupResult&& result) { lookup_result_ = std::move(result); });
+    return context;
+  }
+
+  // Inserts a value into the cache.
+  void insert(absl::string_view request_path, const absl::string_view response_body) {
+    InsertContextPtr inserter = cache_->makeInsertContext(lookup(request_path));
+    inserter->insertHeaders(response_headers_, {time_source_.systemTime()}, false);
+    inserter->insertBody(Buffer::OwnedImpl(response_body), nullptr, true);
+  }
+
+  Buffer::InstancePtr getBody(LookupContext& context, uint64_t start, uint64_t end) {
+    Buffer::InstancePtr body;
+    context.getBody(AdjustedByteRange(start, end),
+                    [&body](Buffer::InstancePtr&& data) { body = std::move(data); });
+    EXPECT_NE(body, nullptr);
+    return body;
+  }
+
+  // Returns the cached body of the response for request_path, or nullopt on a miss.
+  absl::optional<std::string> lookupBody(absl::string_view request_path) {
+    LookupContextPtr context = lookup(request_path);
+    if (lookup_result_.cache_entry_status_ != CacheEntryStatus::Ok) {
+      return absl::nullopt;
+    }
+    if (lookup_result_.content_length_ == 0) {
+      return "";
+    }
+    return getBody(*context, 0, lookup_result_.content_length_)->toString();
+  }
+
+  std::unique_ptr<MemoryHttpCache> cache_{std::make_unique<MemoryHttpCache>(1024 * 1024, 4)};
+  LookupResult lookup_result_;
+  Http::TestRequestHeaderMapImpl request_headers_;
+  Event::SimulatedTimeSystem time_source_;
+  DateFormatter formatter_{"%a, %d %b %Y %H:%M:%S GMT"};
+  Http::TestResponseHeaderMapImpl response_headers_{
+      {"date", formatter_.fromTime(time_source_.systemTime())},
+      {"cache-control", "public,max-age=3600"}};
+  VaryAllowList vary_allow_list_;
+};
+
+TEST_F(MemoryHttpCacheTest, PutGet) {
+  lookup("/name");
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+
+  insert("/name", "Value");
+  EXPECT_EQ("Value", lookupBody("/name"));
+  EXPECT_EQ(absl::nullopt, lookupBody("/another_name"));
+
+  insert("/name", "NewValue");
+  EXPECT_EQ("NewValue", lookupBody("/name"));
+  EXPECT_EQ(1, cache_->entryCount());
+}
+
+TEST_F(MemoryHttpCacheTest, StreamingPut) {
+  InsertContextPtr inserter = cache_->makeInsertContext(lookup("/name"));
+  inserter->insertHeaders(response_headers_, {time_source_.systemTime()}, false);
+  inserter->insertBody(
+      Buffer::OwnedImpl("Hello, "), [](bool ready) { EXPECT_TRUE(ready); }, false);
+  inserter->insertBody(Buffer::OwnedImpl("World!"), nullptr, true);
+
+  LookupContextPtr context = lookup("/name");
+  EXPECT_EQ(CacheEntryStatus::Ok, lookup_result_.cache_entry_status_);
+  ASSERT_EQ(13, lookup_result_.content_length_);
+  EXPECT_EQ("World", getBody(*context, 7, 12)->toString());
+}
+
+// Lookups are served from the cached body instead of from a copy of it.
+TEST_F(MemoryHttpCacheTest, BodyIsNotCopied) {
+  insert("/name", "Value");
+  LookupContextPtr first = lookup("/name");
+  LookupContextPtr second = lookup("/name");
+  Buffer::InstancePtr first_body = getBody(*first, 0, 5);
+  Buffer::InstancePtr second_body = getBody(*second, 1, 5);
+  EXPECT_EQ(static_cast<const uint8_t*>(first_body->frontSlice().mem_) + 1,
+            second_body->frontSlice().mem_);
+
+  // The body outlives its entry for as long as a buffer refers to it.
+  insert("/name", "NewValue");
+  EXPECT_EQ("Value", first_body->toString());
+}
+
+TEST_F(MemoryHttpCacheTest, EvictsLeastRecentlyUsed) {
+  resetCache(1024 * 1024, 1);
+  insert("/a", "body");
+  const uint64_t entry_size_bytes = cache_->sizeBytes();
+  resetCache(3 * entry_size_bytes, 1);
+
+  insert("/a", "body");
+  insert("/b", "body");
+  insert("/c", "body");
+  EXPECT_EQ(3, cache_->entryCount());
+  EXPECT_EQ(3 * entry_size_bytes, cache_->sizeBytes());
+
+  // "/a" is the oldest entry, but as it has been used since, "/b" is evicted instead.
+  EXPECT_EQ("body", lookupBody("/a"));
+  insert("/d", "body");
+  EXPECT_EQ(3, cache_->entryCount());
+  EXPECT_EQ(absl::nullopt, lookupBody("/b"));
+  EXPECT_EQ("body", lookupBody("/a"));
+  EXPECT_EQ("body", lookupBody("/c"));
+  EXPECT_EQ("body", lookupBody("/d"));
+}
+
+TEST_F(MemoryHttpCacheTest, ReplacedEntryIsEvictedLast) {
+  resetCache(1024 * 1024, 1);
+  insert("/a", "body");
+  const uint64_t entry_size_bytes = cache_->sizeBytes();
+  resetCache(2 * entry_size_bytes, 1);
+
+  insert("/a", "body");
+  insert("/b", "body");
+  insert("/a", "BODY");
+  insert("/c", "body");
+  EXPECT_EQ("BODY", lookupBody("/a"));
+  EXPECT_EQ(absl::nullopt, lookupBody("/b"));
+  EXPECT_EQ("body", lookupBody("/c"));
+}
+
+TEST_F(MemoryHttpCacheTest, ResponseLargerThanShardIsNotCached) {
+  resetCache(400, 4);
+  EXPECT_EQ(100, cache_->maxBodySizeBytes());
+
+  InsertContextPtr inserter = cache_->makeInsertContext(lookup("/name"));
+  inserter->insertHeaders(response_headers_, {time_source_.systemTime()}, false);
+  inserter->insertBody(
+      Buffer::OwnedImpl(std::string(60, 'a')), [](bool ready) { EXPECT_TRUE(ready); }, false);
+  bool called = false;
+  inserter->insertBody(
+      Buffer::OwnedImpl(std::string(60, 'a')),
+      [&called](bool ready) {
+        called = true;
+        EXPECT_FALSE(ready);
+      },
+      false);
+  EXPECT_TRUE(called);
+  inserter->insertBody(Buffer::OwnedImpl("a"), nullptr, true);
+
+  EXPECT_EQ(absl::nullopt, lookupBody("/name"));
+  EXPECT_EQ(0, cache_->entryCount());
+  EXPECT_EQ(0, cache_->sizeBytes());
+}
+
+TEST_F(MemoryHttpCacheTest, VaryResponses) {
+  response_headers_.setCopy(Http::LowerCaseString("vary"), "accept");
+
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "image/*");
+  insert("/resource", "image");
+  EXPECT_EQ("image", lookupBody("/resource"));
+
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "text/html");
+  EXPECT_EQ(absl::nullopt, lookupBody("/resource"));
+  insert("/resource", "html");
+  EXPECT_EQ("html", lookupBody("/resource"));
+
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "image/*");
+  EXPECT_EQ("image", lookupBody("/resource"));
+  // One entry per variant, and one that marks the resource as varying.
+  EXPECT_EQ(3, cache_->entryCount());
+
+  // A cached variant is not served once the header it varies on is no longer allowed.
+  Protobuf::RepeatedPtrField<::envoy::type::matcher::v3::StringMatcher> proto_allow_list;
+  proto_allow_list.Add()->set_exact("width");
+  vary_allow_list_ = VaryAllowList(proto_allow_list);
+  EXPECT_EQ(absl::nullopt, lookupBody("/resource"));
+}
+
+TEST_F(MemoryHttpCacheTest, UpdateHeadersAndMetadata) {
+  insert("/name", "body");
+
+  time_source_.advanceTimeWait(Seconds(3601));
+  Http::TestResponseHeaderMapImpl response_headers{
+      {"date", formatter_.fromTime(time_source_.systemTime())},
+      {"cache-control", "public,max-age=3600"}};
+  cache_->updateHeaders(*lookup("/name"), response_headers, {time_source_.systemTime()});
+
+  lookup("/name");
+  ASSERT_EQ(CacheEntryStatus::Ok, lookup_result_.cache_entry_status_);
+  EXPECT_THAT(lookup_result_.headers_.get(), HeaderMapEqualIgnoreOrder(&response_headers));
+  EXPECT_EQ("body", lookupBody("/name"));
+}
+
+TEST_F(MemoryHttpCacheTest, UpdateHeadersOfVariant) {
+  response_headers_.setCopy(Http::LowerCaseString("vary"), "accept");
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "image/*");
+  insert("/resource", "image");
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "text/html");
+  insert("/resource", "html");
+
+  time_source_.advanceTimeWait(Seconds(3601));
+  Http::TestResponseHeaderMapImpl response_headers{
+      {"date", formatter_.fromTime(time_source_.systemTime())},
+      {"cache-control", "public,max-age=3600"},
+      {"vary", "accept"}};
+  cache_->updateHeaders(*lookup("/resource"), response_headers, {time_source_.systemTime()});
+
+  lookup("/resource");
+  ASSERT_EQ(CacheEntryStatus::Ok, lookup_result_.cache_entry_status_);
+  EXPECT_THAT(lookup_result_.headers_.get(), HeaderMapEqualIgnoreOrder(&response_headers));
+  EXPECT_EQ("html", lookupBody("/resource"));
+
+  // Only the variant the request was served is updated.
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "image/*");
+  lookup("/resource");
+  EXPECT_EQ(CacheEntryStatus::RequiresValidation, lookup_result_.cache_entry_status_);
+
+  // A response that now varies on other headers doesn't replace the variant.
+  response_headers.setCopy(Http::LowerCaseString("vary"), "accept-language");
+  cache_->updateHeaders(*lookup("/resource"), response_headers, {time_source_.systemTime()});
+  lookup("/resource");
+  EXPECT_EQ(CacheEntryStatus::RequiresValidation, lookup_result_.cache_entry_status_);
+  EXPECT_EQ("image", lookupBody("/resource"));
+}
+
+TEST_F(MemoryHttpCacheTest, UpdateHeadersForMissingKey) {
+  cache_->updateHeaders(*lookup("/name"), response_headers_, {time_source_.systemTime()});
+  EXPECT_EQ(absl::nullopt, lookupBody("/name"));
+  EXPECT_EQ(0, cache_->entryCount());
+}
+
+TEST(Registration, GetFactory) {
+  HttpCacheFactory* factory = Registry::FactoryRegistry<HttpCacheFactory>::getFactoryByType(
+      "envoy.extensions.cache.memory_http_cache.v3alpha.MemoryHttpCacheConfig");
+  ASSERT_NE(factory, nullptr);
+  envoy::extensions::filters::http::cache::v3alpha::CacheConfig config;
+  config.mutable_typed_config()->PackFrom(*factory->createEmptyConfigProto());
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  HttpCacheSharedPtr cache = factory->getCache(config, factory_context);
+  EXPECT_EQ(cache->cacheInfo().name_, "envoy.extensions.http.cache.memory");
+  EXPECT_EQ(factory->getCache(config, factory_context), cache);
+}
+
+TEST(Registration, CachesAreKeyedByConfig) {
+  HttpCacheFactory* factory = Registry::FactoryRegistry<HttpCacheFactory>::getFactoryByType(
+      "envoy.extensions.cache.memory_http_cache.v3alpha.MemoryHttpCacheConfig");
+  ASSERT_NE(factory, nullptr);
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  envoy::extensions::cache::memory_http_cache::v3alpha::MemoryHttpCacheConfig memory_config;
+  memory_config.mutable_max_size_bytes()->set_value(1024);
+  memory_config.mutable_shard_count()->set_value(1);
+  envoy::extensions::filters::http::cache::v3alpha::CacheConfig small_config;
+  small_config.mutable_typed_config()->PackFrom(memory_config);
+  memory_config.mutable_max_size_bytes()->set_value(2048);
+  envoy::extensions::filters::http::cache::v3alpha::CacheConfig large_config;
+  large_config.mutable_typed_config()->PackFrom(memory_config);
+
+  HttpCacheSharedPtr small_cache = factory->getCache(small_config, factory_context);
+  HttpCacheSharedPtr large_cache = factory->getCache(large_config, factory_context);
+  EXPECT_NE(small_cache, large_cache);
+  EXPECT_EQ(1024, dynamic_cast<MemoryHttpCache&>(*small_cache).maxBodySizeBytes());
+  EXPECT_EQ(2048, dynamic_cast<MemoryHttpCache&>(*large_cache).maxBodySizeBytes());
+  EXPECT_EQ(factory->getCache(small_config, factory_context), small_cache);
+  EXPECT_EQ(factory->getCache(large_config, factory_context), large_cache);
+}
+
+TEST(Registration, RejectsMoreShardsThanBytes) {
+  HttpCacheFactory* factory = Registry::FactoryRegistry<HttpCacheFactory>::getFactoryByType(
+      "envoy.extensions.cache.memory_http_cache.v3alpha.MemoryHttpCacheConfig");
+  ASSERT_NE(factory, nullptr);
+  envoy::extensions::cache::memory_http_cache::v3alpha::MemoryHttpCacheConfig memory_config;
+  memory_config.mutable_max_size_bytes()->set_value(16);
+  memory_config.mutable_shard_count()->set_value(32);
+  envoy::extensions::filters::http::cache::v3alpha::CacheConfig config;
+  config.mutable_typed_config()->PackFrom(memory_config);
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  EXPECT_THROW_WITH_MESSAGE(
+      factory->getCache(config, factory_context), EnvoyException,
+      "memory cache max_size_bytes (16) must be at least its shard_count (32)");
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,353 @@
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/network/address_impl.h"
+#include "source/extensions/io_socket/io_uring/io_handle_impl.h"
+#include "source/extensions/io_socket/io_uring/io_uring_worker.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+namespace {
+
+class TestWorkerProvider : public IoUringWorkerProvider {
+public:
+  OptRef<IoUringWorker> workerForDispatcher(Event::Dispatcher&) const override {
+    if (worker_ == nullptr) {
+      return {};
+    }
+    return *worker_;
+  }
+
+  IoUringWorker* worker_{};
+};
+
+class IoUringSocketHandleImplTest : public testing::Test {
+protected:
+  IoUringSocketHandleImplTest()
+      : api_(Api::createApiForTest()), dispatcher_(api_->allocateDispatcher("test_thread")) {}
+
+  void SetUp() override {
+    config_.write_buffer_limit_ = 8192;
+    config_.close_flush_timeout_ = std::chrono::milliseconds(100);
+    worker_ = std::make_unique<IoUringWorker>(config_, *dispatcher_);
+    if (!worker_->enabled()) {
+      GTEST_SKIP() << "io_uring is not available";
+    }
+    provider_.worker_ = worker_.get();
+
+    // Accept a loopback connection through the handle, which puts the accepted socket on the
+    // ring.
+    const os_fd_t listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_TRUE(SOCKET_VALID(listen_fd));
+    listener_ = std::make_unique<IoUringSocketHandleImpl>(provider_, listen_fd);
+    listen_addr_.sin_family = AF_INET;
+    listen_addr_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(listen_addr_);
+    ASSERT_EQ(0, bind(listen_fd, reinterpret_cast<sockaddr*>(&listen_addr_), addr_len));
+    ASSERT_EQ(0, listen(listen_fd, 1));
+    ASSERT_EQ(0, getsockname(listen_fd, reinterpret_cast<sockaddr*>(&listen_addr_), &addr_len));
+
+    peer_ = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(0, ::connect(peer_, reinterpret_cast<sockaddr*>(&listen_addr_), addr_len));
+    handle_ = listener_->accept(nullptr, nullptr);
+    ASSERT_NE(nullptr, handle_);
+    handle_->setBlocking(false);
+  }
+
+  void TearDown() override {
+    handle_.reset();
+    listener_.reset();
+    if (SOCKET_VALID(peer_)) {
+      close(peer_);
+    }
+  }
+
+  void initializeFileEvent(uint32_t events) {
+    handle_->initializeFileEvent(
+        *dispatcher_, [this](uint32_t events) { ready_events_ |= events; },
+        Event::FileTriggerType::Edge, events);
+  }
+
+  // Run the dispatcher until one of the given events has been delivered.
+  void waitForEvents(uint32_t events) {
+    while ((ready_events_ & events) == 0) {
+      dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+      poll(nullptr, 0, 1);
+    }
+  }
+
+  // Run the dispatcher for the given time.
+  void runFor(std::chrono::milliseconds duration) {
+    const auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end) {
+      dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+      poll(nullptr, 0, 1);
+    }
+  }
+
+  // Write to the handle until neither the kernel nor the handle's queue take more, because the
+  // peer doesn't read. Returns the number of bytes written.
+  uint64_t writeUntilBlocked() {
+    const int buffer_size = 4096;
+    EXPECT_EQ(0, setsockopt(peer_, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size)));
+    EXPECT_EQ(0, handle_->setOption(SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size))
+                     .return_value_);
+    const std::string chunk(config_.write_buffer_limit_, 'c');
+    uint64_t written = 0;
+    for (int refused = 0; refused < 100;) {
+      Buffer::OwnedImpl buffer(chunk);
+      auto result = handle_->write(buffer);
+      if (result.ok()) {
+        written += result.return_value_;
+        refused = 0;
+      } else {
+        refused++;
+      }
+      runFor(std::chrono::milliseconds(1));
+    }
+    return written;
+  }
+
+  // Read from the peer until the given number of bytes or EOF.
+  std::string peerRead(size_t length) {
+    std::string data;
+    char buf[4096];
+    while (data.size() < length) {
+      dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+      pollfd pfd{peer_, POLLIN, 0};
+      if (poll(&pfd, 1, 10) <= 0) {
+        continue;
+      }
+      const ssize_t rc = ::read(peer_, buf, sizeof(buf));
+      if (rc <= 0) {
+        break;
+      }
+      data.append(buf, rc);
+    }
+    return data;
+  }
+
+  Api::ApiPtr api_;
+  Event::DispatcherPtr dispatcher_;
+  IoUringConfig config_;
+  std::unique_ptr<IoUringWorker> worker_;
+  TestWorkerProvider provider_;
+  std::unique_ptr<IoUringSocketHandleImpl> listener_;
+  struct sockaddr_in listen_addr_ {};
+  Network::IoHandlePtr handle_;
+  os_fd_t peer_{INVALID_SOCKET};
+  uint32_t ready_events_{};
+};
+
+TEST_F(IoUringSocketHandleImplTest, Read) {
+  initializeFileEvent(Event::FileReadyType::Read);
+  Buffer::OwnedImpl buffer;
+  EXPECT_EQ(EAGAIN, handle_->read(buffer, absl::nullopt).err_->getSystemErrorCode());
+
+  EXPECT_EQ(5, write(peer_, "hello", 5));
+  waitForEvents(Event::FileReadyType::Read);
+  auto result = handle_->read(buffer, absl::nullopt);
+  EXPECT_TRUE(result.ok());
+  EXPECT_EQ(5, result.return_value_);
+  EXPECT_EQ("hello", buffer.toString());
+}
+
+TEST_F(IoUringSocketHandleImplTest, LargeReadIsNotCopied) {
+  initializeFileEvent(Event::FileReadyType::Read);
+  const std::string data(config_.read_buffer_size_, 'a');
+  EXPECT_EQ(data.size(), write(peer_, data.data(), data.size()));
+
+  Buffer::OwnedImpl buffer;
+  while (buffer.length() < data.size()) {
+    ready_events_ = 0;
+    waitForEvents(Event::FileReadyType::Read);
+    handle_->read(buffer, absl::nullopt);
+  }
+  EXPECT_EQ(data, buffer.toString());
+}
+
+TEST_F(IoUringSocketHandleImplTest, ReadEndOfStream) {
+  initializeFileEvent(Event::FileReadyType::Read | Event::FileReadyType::Closed);
+  shutdown(peer_, SHUT_WR);
+  waitForEvents(Event::FileReadyType::Closed);
+  Buffer::OwnedImpl buffer;
+  auto result = handle_->read(buffer, absl::nullopt);
+  EXPECT_TRUE(result.ok());
+  EXPECT_EQ(0, result.return_value_);
+}
+
+TEST_F(IoUringSocketHandleImplTest, Write) {
+  initializeFileEvent(Event::FileReadyType::Write);
+  waitForEvents(Event::FileReadyType::Write);
+
+  Buffer::OwnedImpl buffer("hello");
+  auto result = handle_->write(buffer);
+  EXPECT_TRUE(result.ok());
+  EXPECT_EQ(5, result.return_value_);
+  EXPECT_EQ(0, buffer.length());
+  EXPECT_EQ("hello", peerRead(5));
+}
+
+TEST_F(IoUringSocketHandleImplTest, WriteBlocksAtLimit) {
+  initializeFileEvent(Event::FileReadyType::Write);
+  const std::string data(config_.write_buffer_limit_ * 2, 'a');
+  Buffer::OwnedImpl buffer(data);
+  auto result = handle_->write(buffer);
+  EXPECT_EQ(config_.write_buffer_limit_, result.return_value_);
+  result = handle_->write(buffer);
+  EXPECT_EQ(EAGAIN, result.err_->getSystemErrorCode());
+
+  // Draining the peer makes room again.
+  ready_events_ = 0;
+  EXPECT_EQ(config_.write_buffer_limit_, peerRead(config_.write_buffer_limit_).size());
+  waitForEvents(Event::FileReadyType::Write);
+  result = handle_->write(buffer);
+  EXPECT_EQ(config_.write_buffer_limit_, result.return_value_);
+  EXPECT_EQ(config_.write_buffer_limit_, peerRead(config_.write_buffer_limit_).size());
+}
+
+TEST_F(IoUringSocketHandleImplTest, CloseFlushesQueuedWrites) {
+  initializeFileEvent(Event::FileReadyType::Read | Event::FileReadyType::Write);
+  const std::string data(config_.write_buffer_limit_, 'b');
+  Buffer::OwnedImpl buffer(data);
+  EXPECT_EQ(data.size(), handle_->write(buffer).return_value_);
+  EXPECT_TRUE(handle_->close().ok());
+  EXPECT_FALSE(handle_->isOpen());
+
+  // Everything queued arrives, followed by end of stream once the worker closes the socket.
+  EXPECT_EQ(data, peerRead(data.size() + 1));
+}
+
+// Data still queued when the close flush timeout passes is dropped, and the socket closed.
+TEST_F(IoUringSocketHandleImplTest, CloseFlushTimeout) {
+  initializeFileEvent(Event::FileReadyType::Read | Event::FileReadyType::Write);
+  const uint64_t written = writeUntilBlocked();
+  EXPECT_TRUE(handle_->close().ok());
+  runFor(config_.close_flush_timeout_ * 2);
+
+  // The peer gets what the kernel had taken, and then end of stream.
+  EXPECT_LT(peerRead(written).size(), written);
+}
+
+// A socket that is reset on close drops its queued data and closes right away.
+TEST_F(IoUringSocketHandleImplTest, CloseWithResetDropsQueuedWrites) {
+  initializeFileEvent(Event::FileReadyType::Read | Event::FileReadyType::Write);
+  const uint64_t written = writeUntilBlocked();
+  struct linger linger {};
+  linger.l_onoff = 1;
+  EXPECT_EQ(0, handle_->setOption(SOL_SOCKET, SO_LINGER, &linger, sizeof(linger)).return_value_);
+  EXPECT_TRUE(handle_->close().ok());
+
+  EXPECT_LT(peerRead(written).size(), written);
+}
+
+// A ring too small to hold everything queued in one loop iteration defers what doesn't fit
+// instead of failing.
+TEST_F(IoUringSocketHandleImplTest, SmallRing) {
+  handle_.reset();
+  worker_.reset();
+  config_.ring_size_ = 2;
+  worker_ = std::make_unique<IoUringWorker>(config_, *dispatcher_);
+  provider_.worker_ = worker_.get();
+  close(peer_);
+  peer_ = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(0, ::connect(peer_, reinterpret_cast<sockaddr*>(&listen_addr_), sizeof(listen_addr_)));
+  handle_ = listener_->accept(nullptr, nullptr);
+  ASSERT_NE(nullptr, handle_);
+  handle_->setBlocking(false);
+
+  // A read, a write and the cancellation of the read are queued in the same iteration.
+  initializeFileEvent(Event::FileReadyType::Read | Event::FileReadyType::Write);
+  Buffer::OwnedImpl buffer("hello");
+  EXPECT_EQ(5, handle_->write(buffer).return_value_);
+  EXPECT_TRUE(handle_->close().ok());
+  EXPECT_EQ("hello", peerRead(6));
+}
+
+TEST_F(IoUringSocketHandleImplTest, WorkerDestroyed) {
+  initializeFileEvent(Event::FileReadyType::Read);
+  worker_.reset();
+  provider_.worker_ = nullptr;
+  // The stream is ended rather than continued with system calls.
+  Buffer::OwnedImpl buffer;
+  auto result = handle_->read(buffer, absl::nullopt);
+  EXPECT_TRUE(result.ok());
+  EXPECT_EQ(0, result.return_value_);
+  EXPECT_TRUE(handle_->close().ok());
+}
+
+// The ring owns the reads and writes of the socket, so the connection must not splice it.
+TEST_F(IoUringSocketHandleImplTest, DoesNotSupportSplice) {
+  EXPECT_FALSE(handle_->supportsSplice());
+}
+
+// Client sockets set up their file event before connect(), as ConnectionImpl does, and still use
+// the ring once connected.
+TEST_F(IoUringSocketHandleImplTest, Connect) {
+  IoUringSocketHandleImpl client(provider_, socket(AF_INET, SOCK_STREAM, 0));
+  ASSERT_TRUE(client.isOpen());
+  client.setBlocking(false);
+  uint32_t client_events = 0;
+  client.initializeFileEvent(
+      *dispatcher_, [&client_events](uint32_t events) { client_events |= events; },
+      Event::FileTriggerType::Edge, Event::FileReadyType::Read | Event::FileReadyType::Write);
+
+  // Nothing is reported until connect() has been called.
+  runFor(std::chrono::milliseconds(10));
+  EXPECT_EQ(0, client_events);
+
+  const auto result =
+      client.connect(std::make_shared<Network::Address::Ipv4Instance>(&listen_addr_));
+  EXPECT_TRUE(result.return_value_ == 0 || result.errno_ == SOCKET_ERROR_IN_PROGRESS);
+  while ((client_events & Event::FileReadyType::Write) == 0) {
+    dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    poll(nullptr, 0, 1);
+  }
+  const os_fd_t server = ::accept(listener_->fdDoNotUse(), nullptr, nullptr);
+  ASSERT_TRUE(SOCKET_VALID(server));
+
+  // Writes go to the handle's queue, which takes no more than its limit, rather than straight to
+  // the socket.
+  const std::string data(config_.write_buffer_limit_ * 2, 'd');
+  Buffer::OwnedImpl buffer(data);
+  EXPECT_EQ(config_.write_buffer_limit_, client.write(buffer).return_value_);
+
+  // Reads complete on the ring too.
+  client_events = 0;
+  EXPECT_EQ(5, write(server, "hello", 5));
+  while ((client_events & Event::FileReadyType::Read) == 0) {
+    dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    poll(nullptr, 0, 1);
+  }
+  Buffer::OwnedImpl read_buffer;
+  EXPECT_EQ(5, client.read(read_buffer, absl::nullopt).return_value_);
+  EXPECT_EQ("hello", read_buffer.toString());
+
+  EXPECT_TRUE(client.close().ok());
+  close(server);
+}
+
+TEST_F(IoUringSocketHandleImplTest, FallbackWithoutWorker) {
+  provider_.worker_ = nullptr;
+  initializeFileEvent(Event::FileReadyType::Read);
+  EXPECT_EQ(5, write(peer_, "hello", 5));
+  waitForEvents(Event::FileReadyType::Read);
+  Buffer::OwnedImpl buffer;
+  EXPECT_EQ(5, handle_->read(buffer, absl::nullopt).return_value_);
+  EXPECT_EQ("hello", buffer.toString());
+}
+
+} // namespace
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
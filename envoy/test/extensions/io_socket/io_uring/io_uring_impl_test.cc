@@ -0,0 +1,134 @@
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "source/extensions/io_socket/io_uring/io_uring_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+namespace {
+
+class IoUringImplTest : public testing::Test {
+protected:
+  void SetUp() override {
+    if (!ring_.isOpen()) {
+      GTEST_SKIP() << "io_uring is not available";
+    }
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds_));
+  }
+
+  void TearDown() override {
+    if (ring_.isOpen()) {
+      close(fds_[0]);
+      close(fds_[1]);
+    }
+  }
+
+  // Wait for and collect the completions of the given number of operations.
+  std::vector<std::pair<uint64_t, int32_t>> waitForCompletions(size_t count) {
+    std::vector<std::pair<uint64_t, int32_t>> completions;
+    while (completions.size() < count) {
+      EXPECT_GE(ring_.submitAndWait(1), 0);
+      ring_.forEveryCompletion([&completions](uint64_t user_data, int32_t result) {
+        completions.emplace_back(user_data, result);
+      });
+    }
+    return completions;
+  }
+
+  IoUringImpl ring_{16};
+  int fds_[2];
+};
+
+TEST_F(IoUringImplTest, ReadWrite) {
+  const std::string data = "hello world";
+  struct iovec iov {
+    const_cast<char*>(data.data()), data.size()
+  };
+  EXPECT_TRUE(ring_.prepareWritev(fds_[1], &iov, 1, 1));
+  EXPECT_EQ(1, ring_.pending());
+  EXPECT_EQ(1, ring_.submit());
+  EXPECT_EQ(0, ring_.pending());
+  auto completions = waitForCompletions(1);
+  EXPECT_EQ(std::make_pair(uint64_t(1), int32_t(data.size())), completions[0]);
+
+  uint8_t buf[64];
+  EXPECT_TRUE(ring_.prepareRead(fds_[0], buf, sizeof(buf), 2));
+  ring_.submit();
+  completions = waitForCompletions(1);
+  EXPECT_EQ(std::make_pair(uint64_t(2), int32_t(data.size())), completions[0]);
+  EXPECT_EQ(data, std::string(reinterpret_cast<char*>(buf), data.size()));
+}
+
+TEST_F(IoUringImplTest, ReadFixed) {
+  std::vector<uint8_t> buf(4096);
+  if (!ring_.registerBuffers({{buf.data(), buf.size()}})) {
+    GTEST_SKIP() << "registered buffers are not available";
+  }
+
+  EXPECT_EQ(3, write(fds_[1], "abc", 3));
+  EXPECT_TRUE(ring_.prepareReadFixed(fds_[0], buf.data(), buf.size(), 0, 7));
+  ring_.submit();
+  const auto completions = waitForCompletions(1);
+  EXPECT_EQ(std::make_pair(uint64_t(7), int32_t(3)), completions[0]);
+  EXPECT_EQ("abc", std::string(reinterpret_cast<char*>(buf.data()), 3));
+}
+
+TEST_F(IoUringImplTest, LinkedPollThenRead) {
+  uint8_t buf[64];
+  EXPECT_TRUE(ring_.preparePollAdd(fds_[0], POLLIN, 1, true));
+  EXPECT_TRUE(ring_.prepareRead(fds_[0], buf, sizeof(buf), 2));
+  EXPECT_EQ(2, ring_.submit());
+
+  EXPECT_EQ(2, write(fds_[1], "ok", 2));
+  auto completions = waitForCompletions(2);
+  EXPECT_EQ(1, completions[0].first);
+  EXPECT_TRUE(completions[0].second & POLLIN);
+  EXPECT_EQ(std::make_pair(uint64_t(2), int32_t(2)), completions[1]);
+}
+
+TEST_F(IoUringImplTest, CancelLinkedPoll) {
+  uint8_t buf[64];
+  EXPECT_TRUE(ring_.preparePollAdd(fds_[0], POLLIN, 1, true));
+  EXPECT_TRUE(ring_.prepareRead(fds_[0], buf, sizeof(buf), 2));
+  ring_.submit();
+  EXPECT_TRUE(ring_.prepareCancel(1, 3));
+  ring_.submit();
+
+  // The cancel, the poll and the read linked to it all complete.
+  const auto completions = waitForCompletions(3);
+  for (const auto& completion : completions) {
+    if (completion.first == 3) {
+      EXPECT_EQ(0, completion.second);
+    } else {
+      EXPECT_EQ(-ECANCELED, completion.second);
+    }
+  }
+}
+
+TEST_F(IoUringImplTest, FullSubmissionQueue) {
+  const uint32_t entries = ring_.entries();
+  for (uint32_t i = 0; i < entries; i++) {
+    EXPECT_TRUE(ring_.preparePollAdd(fds_[0], POLLIN, i + 1, false));
+  }
+  EXPECT_FALSE(ring_.preparePollAdd(fds_[0], POLLIN, entries + 1, false));
+  EXPECT_EQ(entries, ring_.submit());
+  EXPECT_TRUE(ring_.preparePollAdd(fds_[0], POLLIN, entries + 1, false));
+  ring_.submit();
+
+  EXPECT_EQ(1, write(fds_[1], "x", 1));
+  EXPECT_EQ(entries + 1, waitForCompletions(entries + 1).size());
+}
+
+} // namespace
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
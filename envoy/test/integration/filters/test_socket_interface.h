@@ -34,6 +34,9 @@ public:
     IoSocketHandleImpl::initializeFileEvent(dispatcher, cb, trigger, events);
   }
 
+  // Splicing would bypass the writev() override.
+  bool supportsSplice() const override { return false; }
+
   // Schedule resumption on the IoHandle by posting a callback to the IoHandle's dispatcher. Note
   // that this operation is inherently racy, nothing guarantees that the TestIoSocketHandle is not
   // deleted before the posted callback executes.
@@ -117,7 +117,8 @@ void IntegrationTcpClient::waitForHalfClose() {
 void IntegrationTcpClient::readDisable(bool disabled) { connection_->readDisable(disabled); }
 
 AssertionResult IntegrationTcpClient::write(const std::string& data, bool end_stream, bool verify,
-                                            std::chrono::milliseconds timeout) {
+                                            std::chrono::milliseconds timeout,
+                                            bool wait_for_drain) {
   Event::TestTimeSystem::RealTimeBound bound(timeout);
   Buffer::OwnedImpl buffer(data);
   if (verify) {
@@ -130,6 +131,14 @@ AssertionResult IntegrationTcpClient::write(const std::string& data, bool end_st
   uint64_t bytes_expected = client_write_buffer_->bytesDrained() + data.size();
 
   connection_->write(buffer, end_stream);
+  if (!wait_for_drain) {
+    // Let the connection write what the socket accepts; the rest stays buffered.
+    connection_->dispatcher().run(Event::Dispatcher::RunType::NonBlock);
+    if (verify && disconnected_) {
+      return AssertionFailure() << "Unexpected disconnect";
+    }
+    return AssertionSuccess();
+  }
   do {
     connection_->dispatcher().run(Event::Dispatcher::RunType::NonBlock);
     if (client_write_buffer_->bytesDrained() == bytes_expected || disconnected_) {
@@ -41,7 +41,8 @@ public:
   void readDisable(bool disabled);
   ABSL_MUST_USE_RESULT AssertionResult
   write(const std::string& data, bool end_stream = false, bool verify = true,
-        std::chrono::milliseconds timeout = TestUtility::DefaultTimeout);
+        std::chrono::milliseconds timeout = TestUtility::DefaultTimeout,
+        bool wait_for_drain = true);
   const std::string& data() { return payload_reader_->data(); }
   bool connected() const { return !disconnected_; }
   // clear up to the `count` number of bytes of received data
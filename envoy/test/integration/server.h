@@ -296,6 +296,21 @@ public:
     Thread::LockGuard lock(lock_);
     store_.forEachTextReadout(f_size, f_stat);
   }
+  void forEachChangedCounter(std::function<void(std::size_t)> f_size,
+                             std::function<void(Stats::Counter&)> f_stat) override {
+    Thread::LockGuard lock(lock_);
+    store_.forEachChangedCounter(f_size, f_stat);
+  }
+  void forEachChangedGauge(std::function<void(std::size_t)> f_size,
+                           std::function<void(Stats::Gauge&)> f_stat) override {
+    Thread::LockGuard lock(lock_);
+    store_.forEachChangedGauge(f_size, f_stat);
+  }
+  void forEachChangedTextReadout(std::function<void(std::size_t)> f_size,
+                                 std::function<void(Stats::TextReadout&)> f_stat) override {
+    Thread::LockGuard lock(lock_);
+    store_.forEachChangedTextReadout(f_size, f_stat);
+  }
   Counter& counterFromString(const std::string& name) override {
     Thread::LockGuard lock(lock_);
     return store_.counterFromString(name);
@@ -384,6 +399,8 @@ public:
   void setTagProducer(TagProducerPtr&&) override {}
   void setStatsMatcher(StatsMatcherPtr&&) override {}
   void setHistogramSettings(HistogramSettingsConstPtr&&) override {}
+  void setCounterShards(uint32_t) override {}
+  void setHistogramMergeThreads(uint32_t, Thread::ThreadFactory&) override {}
   void initializeThreading(Event::Dispatcher&, ThreadLocal::Instance&) override {}
   void shutdownThreading() override {}
   void mergeHistograms(PostMergeCb cb) override { merge_cb_ = cb; }
@@ -301,6 +301,52 @@ TEST_P(TcpProxyIntegrationTest, TcpProxyLargeWrite) {
   EXPECT_EQ(downstream_pauses, downstream_resumes);
 }
 
+// Test that data and half-closes are proxied in both directions when the connections are spliced.
+TEST_P(TcpProxyIntegrationTest, TcpProxySplice) {
+  config_helper_.addConfigModifier([&](envoy::config::bootstrap::v3::Bootstrap& bootstrap) -> void {
+    auto* listener = bootstrap.mutable_static_resources()->mutable_listeners(0);
+    auto* filter_chain = listener->mutable_filter_chains(0);
+    auto* config_blob = filter_chain->mutable_filters(0)->mutable_typed_config();
+
+    ASSERT_TRUE(config_blob->Is<envoy::extensions::filters::network::tcp_proxy::v3::TcpProxy>());
+    auto tcp_proxy_config =
+        MessageUtil::anyConvert<envoy::extensions::filters::network::tcp_proxy::v3::TcpProxy>(
+            *config_blob);
+    tcp_proxy_config.set_use_splice(true);
+    config_blob->PackFrom(tcp_proxy_config);
+  });
+  initialize();
+
+  // Much larger than a pipe, so that splicing has to wait for the pipes to be drained.
+  const std::string data(1024 * 1024, 'a');
+  IntegrationTcpClientPtr tcp_client = makeTcpConnection(lookupPort("tcp_proxy"));
+  FakeRawConnectionPtr fake_upstream_connection;
+  ASSERT_TRUE(fake_upstreams_[0]->waitForRawConnection(fake_upstream_connection));
+#if defined(__linux__)
+  test_server_->waitForCounterEq("tcp.tcp_stats.downstream_cx_splice_total", 1);
+#else
+  EXPECT_EQ(0, test_server_->counter("tcp.tcp_stats.downstream_cx_splice_total")->value());
+#endif
+
+  ASSERT_TRUE(tcp_client->write(data));
+  ASSERT_TRUE(fake_upstream_connection->waitForData(data.size()));
+  ASSERT_TRUE(fake_upstream_connection->write(data));
+  tcp_client->waitForData(data);
+
+  ASSERT_TRUE(tcp_client->write("", true));
+  ASSERT_TRUE(fake_upstream_connection->waitForHalfClose());
+  ASSERT_TRUE(fake_upstream_connection->write("", true));
+  tcp_client->waitForHalfClose();
+  ASSERT_TRUE(fake_upstream_connection->waitForDisconnect());
+  tcp_client->close();
+
+  // The spliced bytes are counted on both connections.
+  test_server_->waitForCounterEq("tcp.tcp_stats.downstream_cx_rx_bytes_total", data.size());
+  test_server_->waitForCounterEq("tcp.tcp_stats.downstream_cx_tx_bytes_total", data.size());
+  test_server_->waitForCounterEq("cluster.cluster_0.upstream_cx_rx_bytes_total", data.size());
+  test_server_->waitForCounterEq("cluster.cluster_0.upstream_cx_tx_bytes_total", data.size());
+}
+
 // Test that a downstream flush works correctly (all data is flushed)
 TEST_P(TcpProxyIntegrationTest, TcpProxyDownstreamFlush) {
   // Use a very large size to make sure it is larger than the kernel socket read buffer.
@@ -1,5 +1,7 @@
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "envoy/stats/sink.h"
 #include "envoy/stats/stats.h"
@@ -27,7 +29,8 @@ public:
     // Create counters
     for (uint64_t idx = 0; idx < num_stats; ++idx) {
       auto stat_name = pool_.add(absl::StrCat("counter.", idx));
-      stats_store_.counterFromStatName(stat_name).inc();
+      counters_.push_back(stats_store_.counterFromStatName(stat_name));
+      counters_.back().get().inc();
     }
     // Create gauges
     for (uint64_t idx = 0; idx < num_stats; ++idx) {
@@ -51,11 +54,27 @@ public:
     }
   }
 
+  // Flushes only the changed stats, with 1% of the counters changing between flushes.
+  void testChangedOnly(::benchmark::State& state) {
+    std::list<Stats::SinkPtr> sinks;
+    sinks.emplace_back(new testing::NiceMock<Stats::MockSink>());
+    // The first flush visits every stat.
+    Server::InstanceUtil::flushMetricsToSinks(sinks, stats_store_, time_system_, true);
+    for (auto _ : state) {
+      UNREFERENCED_PARAMETER(_);
+      for (size_t idx = 0; idx < counters_.size(); idx += 100) {
+        counters_[idx].get().inc();
+      }
+      Server::InstanceUtil::flushMetricsToSinks(sinks, stats_store_, time_system_, true);
+    }
+  }
+
 private:
   Stats::SymbolTableImpl symbol_table_;
   Stats::StatNamePool pool_;
   Stats::AllocatorImpl stats_allocator_;
   Stats::ThreadLocalStoreImpl stats_store_;
+  std::vector<std::reference_wrapper<Stats::Counter>> counters_;
   Event::SimulatedTimeSystem time_system_;
 };
 
@@ -71,4 +90,19 @@ static void bmFlushToSinks(::benchmark::State& state) {
 }
 BENCHMARK(bmFlushToSinks)->Unit(::benchmark::kMillisecond)->RangeMultiplier(10)->Range(10, 1000000);
 
+static void bmFlushChangedToSinks(::benchmark::State& state) {
+  // Skip expensive benchmarks for unit tests.
+  if (benchmark::skipExpensiveBenchmarks() && state.range(0) > 100) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  StatsSinkFlushSpeedTest speed_test(state.range(0));
+  speed_test.testChangedOnly(state);
+}
+BENCHMARK(bmFlushChangedToSinks)
+    ->Unit(::benchmark::kMillisecond)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000000);
+
 } // namespace Envoy
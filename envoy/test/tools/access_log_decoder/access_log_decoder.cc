@@ -0,0 +1,100 @@
+// NOLINT(namespace-envoy)
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "envoy/common/exception.h"
+
+#include "source/common/common/fmt.h"
+#include "source/extensions/access_loggers/columnar_file/block_decoder.h"
+
+#include "absl/strings/string_view.h"
+#include "absl/types/variant.h"
+
+namespace {
+
+using Envoy::Extensions::AccessLoggers::ColumnarFile::BlockDecoder;
+using Envoy::Extensions::AccessLoggers::ColumnarFile::DecodedBlock;
+using Envoy::Extensions::AccessLoggers::ColumnarFile::DecodedValue;
+
+// Appends str as a JSON string. Bytes above 0x7f are copied as they are, so strings that are
+// valid UTF-8 remain so.
+void appendJsonString(absl::string_view str, std::string& output) {
+  output.push_back('"');
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      output.push_back('\\');
+      output.push_back(c);
+    } else if (static_cast<uint8_t>(c) < 0x20 || c == 0x7f) {
+      output.append(fmt::format("\\u{:04x}", static_cast<uint8_t>(c)));
+    } else {
+      output.push_back(c);
+    }
+  }
+  output.push_back('"');
+}
+
+// Prints each entry of a block as a JSON object, keyed by the block's column names in column
+// order. Absent values are printed as null.
+void printBlock(const DecodedBlock& block) {
+  std::string line;
+  for (const std::vector<DecodedValue>& record : block.records_) {
+    line = "{";
+    for (size_t column = 0; column < record.size(); column++) {
+      if (column > 0) {
+        line.push_back(',');
+      }
+      appendJsonString(block.schema_[column].name_, line);
+      line.push_back(':');
+      if (const std::string* str = absl::get_if<std::string>(&record[column])) {
+        appendJsonString(*str, line);
+      } else if (const uint64_t* integer = absl::get_if<uint64_t>(&record[column])) {
+        line.append(std::to_string(*integer));
+      } else {
+        line.append("null");
+      }
+    }
+    line.append("}\n");
+    std::cout << line;
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 2) {
+    std::cerr << "Usage: access_log_decoder [PATH]\n"
+                 "\nPrints the entries of a columnar file access log as JSON lines.\n"
+                 "\n\tPATH - the log file. The log is read from stdin if PATH is omitted."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::ostringstream contents;
+  if (argc == 2) {
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+      std::cerr << "Unable to open " << argv[1] << std::endl;
+      return EXIT_FAILURE;
+    }
+    contents << file.rdbuf();
+  } else {
+    contents << std::cin.rdbuf();
+  }
+  const std::string data = contents.str();
+
+  BlockDecoder decoder;
+  absl::string_view input = data;
+  try {
+    while (!input.empty()) {
+      printBlock(decoder.decode(input));
+    }
+  } catch (const Envoy::EnvoyException& e) {
+    std::cout.flush();
+    std::cerr << fmt::format("At offset {}: {}", data.size() - input.size(), e.what())
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -2,33 +2,205 @@
 
 #include "http_filter.h"
 
+#include "envoy/common/exception.h"
 #include "envoy/server/filter_config.h"
 
+#include "source/common/common/fmt.h"
+#include "source/common/http/utility.h"
+
 namespace Envoy {
 namespace Http {
 
 HttpSampleDecoderFilterConfig::HttpSampleDecoderFilterConfig(
-    const sample::Decoder& proto_config)
-    : key_(proto_config.key()), val_(proto_config.val()) {}
+    const sample::Decoder& proto_config) {
+  if (proto_config.key().empty() != proto_config.val().empty()) {
+    throw EnvoyException("sample: key and val must be set together");
+  }
+  if (!proto_config.key().empty()) {
+    // The single key/val pair predates value templates, so val is always a literal.
+    keys_.emplace_back(proto_config.key());
+    program_.push_back({Instruction::Op::AddHeaderReference, 0, addLiteral(proto_config.val())});
+  }
+  for (const auto& mutation : proto_config.mutations()) {
+    compile(mutation.action(), mutation.key(), mutation.value());
+  }
+  if (program_.empty()) {
+    throw EnvoyException("sample: at least one header mutation must be configured");
+  }
+}
 
-HttpSampleDecoderFilter::HttpSampleDecoderFilter(HttpSampleDecoderFilterConfigSharedPtr config)
-    : config_(config) {}
+void HttpSampleDecoderFilterConfig::compile(sample::HeaderMutation::Action action,
+                                            const std::string& key, const std::string& value) {
+  const uint32_t key_index = keys_.size();
+  keys_.emplace_back(key);
+  if (action == sample::HeaderMutation::REMOVE) {
+    program_.push_back({Instruction::Op::RemoveHeader, key_index});
+    return;
+  }
 
-HttpSampleDecoderFilter::~HttpSampleDecoderFilter() {}
+  // Split the value into literals and attribute commands.
+  std::vector<Instruction> value_program;
+  std::string literal;
+  size_t pos = 0;
+  while (pos < value.size()) {
+    const size_t start = value.find('%', pos);
+    if (start == std::string::npos) {
+      literal.append(value, pos, std::string::npos);
+      break;
+    }
+    literal.append(value, pos, start - pos);
+    const size_t end = value.find('%', start + 1);
+    if (end == std::string::npos) {
+      throw EnvoyException(fmt::format("sample: unterminated '%' in header value '{}'", value));
+    }
+    const absl::string_view command(value.data() + start + 1, end - start - 1);
+    pos = end + 1;
 
-void HttpSampleDecoderFilter::onDestroy() {}
+    if (command.empty()) {
+      literal.push_back('%');
+      continue;
+    }
+
+    Instruction::Op op;
+    if (command == "DOWNSTREAM_REMOTE_ADDRESS") {
+      op = Instruction::Op::AppendDownstreamRemoteAddress;
+    } else if (command == "DOWNSTREAM_REMOTE_ADDRESS_WITHOUT_PORT") {
+      op = Instruction::Op::AppendDownstreamRemoteAddressWithoutPort;
+    } else if (command == "DOWNSTREAM_LOCAL_ADDRESS") {
+      op = Instruction::Op::AppendDownstreamLocalAddress;
+    } else if (command == "ROUTE_NAME") {
+      op = Instruction::Op::AppendRouteName;
+    } else {
+      throw EnvoyException(
+          fmt::format("sample: unknown command '{}' in header value '{}'", command, value));
+    }
+    if (!literal.empty()) {
+      value_program.push_back({Instruction::Op::AppendLiteral, 0, addLiteral(literal)});
+      literal.clear();
+    }
+    value_program.push_back({op});
+  }
+
+  if (value_program.empty() && action != sample::HeaderMutation::APPEND) {
+    // A literal value can be inserted by reference.
+    program_.push_back({action == sample::HeaderMutation::SET
+                            ? Instruction::Op::SetHeaderReference
+                            : Instruction::Op::AddHeaderReference,
+                        key_index, addLiteral(literal)});
+    return;
+  }
+
+  if (!literal.empty()) {
+    value_program.push_back({Instruction::Op::AppendLiteral, 0, addLiteral(literal)});
+  }
+  program_.insert(program_.end(), value_program.begin(), value_program.end());
+  switch (action) {
+  case sample::HeaderMutation::SET:
+    program_.push_back({Instruction::Op::SetHeader, key_index});
+    break;
+  case sample::HeaderMutation::APPEND:
+    program_.push_back({Instruction::Op::AppendHeader, key_index});
+    break;
+  default:
+    program_.push_back({Instruction::Op::AddHeader, key_index});
+    break;
+  }
+}
 
-const LowerCaseString HttpSampleDecoderFilter::headerKey() const {
-  return LowerCaseString(config_->key());
+uint32_t HttpSampleDecoderFilterConfig::addLiteral(std::string literal) {
+  literals_.push_back(std::move(literal));
+  return literals_.size() - 1;
 }
 
-const std::string HttpSampleDecoderFilter::headerValue() const {
-  return config_->val();
+void HttpSampleDecoderFilterConfig::mutate(RequestHeaderMap& headers,
+                                           StreamDecoderFilterCallbacks& callbacks) const {
+  std::string value;
+  for (const Instruction& instruction : program_) {
+    switch (instruction.op_) {
+    case Instruction::Op::AppendLiteral:
+      value.append(literals_[instruction.literal_]);
+      break;
+    case Instruction::Op::AppendDownstreamRemoteAddress:
+      value.append(
+          callbacks.streamInfo().downstreamAddressProvider().remoteAddress()->asStringView());
+      break;
+    case Instruction::Op::AppendDownstreamRemoteAddressWithoutPort: {
+      const auto& address = callbacks.streamInfo().downstreamAddressProvider().remoteAddress();
+      value.append(address->ip() != nullptr ? address->ip()->addressAsString()
+                                            : address->asString());
+      break;
+    }
+    case Instruction::Op::AppendDownstreamLocalAddress:
+      value.append(
+          callbacks.streamInfo().downstreamAddressProvider().localAddress()->asStringView());
+      break;
+    case Instruction::Op::AppendRouteName: {
+      const Router::RouteConstSharedPtr route = callbacks.route();
+      if (route != nullptr && route->routeEntry() != nullptr) {
+        value.append(route->routeEntry()->routeName());
+      }
+      break;
+    }
+    case Instruction::Op::AddHeader:
+      headers.addCopy(keys_[instruction.key_], value);
+      value.clear();
+      break;
+    case Instruction::Op::SetHeader:
+      headers.setCopy(keys_[instruction.key_], value);
+      value.clear();
+      break;
+    case Instruction::Op::AppendHeader:
+      headers.appendCopy(keys_[instruction.key_], value);
+      value.clear();
+      break;
+    case Instruction::Op::RemoveHeader:
+      headers.remove(keys_[instruction.key_]);
+      break;
+    case Instruction::Op::AddHeaderReference:
+      // The config outlives the request since the filter holds a reference to it or to its route,
+      // so both the key and the value can be referenced instead of copied.
+      headers.addReference(keys_[instruction.key_], literals_[instruction.literal_]);
+      break;
+    case Instruction::Op::SetHeaderReference:
+      headers.setReference(keys_[instruction.key_], literals_[instruction.literal_]);
+      break;
+    }
+  }
 }
 
+const HttpSampleDecoderFilterConfig*
+HttpSampleRouteConfigCache::resolve(const Router::RouteConstSharedPtr& route) {
+  if (route == nullptr) {
+    return nullptr;
+  }
+  // Routes are heap allocated, so the low bits of their address carry no information.
+  Entry& entry = entries_[(reinterpret_cast<uintptr_t>(route.get()) >> 4) % entries_.size()];
+  // The weak reference keeps the control block of a cached route from being reused, so a route
+  // with the same address and owner is the cached route, and its config is still alive.
+  if (entry.route_ != route.get() || entry.owner_.owner_before(route) ||
+      route.owner_before(entry.owner_)) {
+    entry.route_ = route.get();
+    entry.owner_ = route;
+    entry.config_ =
+        Utility::resolveMostSpecificPerFilterConfig<HttpSampleDecoderFilterConfig>(filter_name_,
+                                                                                    route);
+  }
+  return entry.config_;
+}
+
+HttpSampleDecoderFilter::HttpSampleDecoderFilter(
+    HttpSampleDecoderFilterConfigSharedPtr config,
+    HttpSampleRouteConfigCacheSlotSharedPtr route_configs)
+    : config_(config), route_configs_(route_configs) {}
+
+HttpSampleDecoderFilter::~HttpSampleDecoderFilter() {}
+
+void HttpSampleDecoderFilter::onDestroy() {}
+
 FilterHeadersStatus HttpSampleDecoderFilter::decodeHeaders(RequestHeaderMap& headers, bool) {
-  // add a header
-  headers.addCopy(headerKey(), headerValue());
+  route_ = decoder_callbacks_->route();
+  const HttpSampleDecoderFilterConfig* route_config = (*route_configs_)->resolve(route_);
+  (route_config != nullptr ? *route_config : *config_).mutate(headers, *decoder_callbacks_);
 
   return FilterHeadersStatus::Continue;
 }
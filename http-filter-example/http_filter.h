@@ -1,6 +1,12 @@
 #pragma once
 
+#include <array>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include "envoy/router/router.h"
+#include "envoy/thread_local/thread_local.h"
 
 #include "source/extensions/filters/http/common/pass_through_filter.h"
 
@@ -9,23 +15,95 @@
 namespace Envoy {
 namespace Http {
 
-class HttpSampleDecoderFilterConfig {
+/**
+ * Configuration shared by all filter instances, or by all requests on a route when used as a
+ * per-route override.
+ *
+ * The configured header mutations are compiled once into a flat program. Value instructions
+ * append a literal or a request attribute to the value being built; header instructions apply the
+ * built value to a header and start a new one. Mutations whose value is a single literal insert
+ * the precomputed key and value by reference, so the per-request path neither lowercases keys
+ * nor copies those strings.
+ */
+class HttpSampleDecoderFilterConfig : public Router::RouteSpecificFilterConfig {
 public:
   HttpSampleDecoderFilterConfig(const sample::Decoder& proto_config);
 
-  const std::string& key() const { return key_; }
-  const std::string& val() const { return val_; }
+  /**
+   * Applies the configured mutations to the request headers.
+   */
+  void mutate(RequestHeaderMap& headers, StreamDecoderFilterCallbacks& callbacks) const;
 
 private:
-  const std::string key_;
-  const std::string val_;
+  struct Instruction {
+    enum class Op : uint8_t {
+      // Append literals_[literal_] to the value.
+      AppendLiteral,
+      // Append a request attribute to the value.
+      AppendDownstreamRemoteAddress,
+      AppendDownstreamRemoteAddressWithoutPort,
+      AppendDownstreamLocalAddress,
+      AppendRouteName,
+      // Apply the value to the header keys_[key_].
+      AddHeader,
+      SetHeader,
+      AppendHeader,
+      RemoveHeader,
+      // Apply literals_[literal_] to the header keys_[key_] by reference.
+      AddHeaderReference,
+      SetHeaderReference,
+    };
+
+    Op op_;
+    uint32_t key_{};
+    uint32_t literal_{};
+  };
+
+  void compile(sample::HeaderMutation::Action action, const std::string& key,
+               const std::string& value);
+  uint32_t addLiteral(std::string literal);
+
+  std::vector<Instruction> program_;
+  std::vector<LowerCaseString> keys_;
+  std::vector<std::string> literals_;
 };
 
 using HttpSampleDecoderFilterConfigSharedPtr = std::shared_ptr<HttpSampleDecoderFilterConfig>;
 
+/**
+ * Per-worker cache of the per-route config resolved for a route, so that the common case is a
+ * pointer comparison instead of the per-filter config map lookups through the route, its
+ * weighted clusters and its virtual host. Entries are direct mapped by route address. They only
+ * hold weak references, so routes replaced by a route config update are still destroyed, and the
+ * ownership of the reference tells a new route apart from a freed one that had the same address.
+ */
+class HttpSampleRouteConfigCache : public ThreadLocal::ThreadLocalObject {
+public:
+  HttpSampleRouteConfigCache(const std::string& filter_name) : filter_name_(filter_name) {}
+
+  /**
+   * @return the per-route config for the route, or nullptr if it has none.
+   */
+  const HttpSampleDecoderFilterConfig* resolve(const Router::RouteConstSharedPtr& route);
+
+private:
+  struct Entry {
+    const Router::Route* route_{};
+    std::weak_ptr<const Router::Route> owner_;
+    const HttpSampleDecoderFilterConfig* config_{};
+  };
+
+  const std::string filter_name_;
+  std::array<Entry, 64> entries_;
+};
+
+using HttpSampleRouteConfigCacheSlot = ThreadLocal::TypedSlot<HttpSampleRouteConfigCache>;
+using HttpSampleRouteConfigCacheSlotSharedPtr = std::shared_ptr<HttpSampleRouteConfigCacheSlot>;
+
 class HttpSampleDecoderFilter : public PassThroughDecoderFilter {
 public:
-  HttpSampleDecoderFilter(HttpSampleDecoderFilterConfigSharedPtr);
+  HttpSampleDecoderFilter(HttpSampleDecoderFilterConfigSharedPtr,
+                          HttpSampleRouteConfigCacheSlotSharedPtr);
   ~HttpSampleDecoderFilter();
 
   // Http::StreamFilterBase
@@ -38,10 +116,11 @@ public:
 
 private:
   const HttpSampleDecoderFilterConfigSharedPtr config_;
+  const HttpSampleRouteConfigCacheSlotSharedPtr route_configs_;
   StreamDecoderFilterCallbacks* decoder_callbacks_;
-
-  const LowerCaseString headerKey() const;
-  const std::string headerValue() const;
+  // Keeps a per-route config, whose strings may be referenced by the request headers, alive for
+  // the lifetime of the request even if the stream's route is cleared.
+  Router::RouteConstSharedPtr route_;
 };
 
 } // namespace Http
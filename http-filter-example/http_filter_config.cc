@@ -29,16 +29,30 @@ public:
     return ProtobufTypes::MessagePtr{new sample::Decoder()};
   }
 
+  /**
+   *  Return the per-route config, which overrides the filter config for requests on that route.
+   */
+  Router::RouteSpecificFilterConfigConstSharedPtr
+  createRouteSpecificFilterConfig(const Protobuf::Message& proto_config, ServerFactoryContext&,
+                                  ProtobufMessage::ValidationVisitor& validator) override {
+    return std::make_shared<const Http::HttpSampleDecoderFilterConfig>(
+        Envoy::MessageUtil::downcastAndValidate<const sample::Decoder&>(proto_config, validator));
+  }
+
   std::string name() const override { return "sample"; }
 
 private:
-  Http::FilterFactoryCb createFilter(const sample::Decoder& proto_config, FactoryContext&) {
+  Http::FilterFactoryCb createFilter(const sample::Decoder& proto_config, FactoryContext& context) {
     Http::HttpSampleDecoderFilterConfigSharedPtr config =
-        std::make_shared<Http::HttpSampleDecoderFilterConfig>(
-            Http::HttpSampleDecoderFilterConfig(proto_config));
+        std::make_shared<Http::HttpSampleDecoderFilterConfig>(proto_config);
+    Http::HttpSampleRouteConfigCacheSlotSharedPtr route_configs =
+        std::make_shared<Http::HttpSampleRouteConfigCacheSlot>(context.threadLocal());
+    route_configs->set([filter_name = name()](Event::Dispatcher&) {
+      return std::make_shared<Http::HttpSampleRouteConfigCache>(filter_name);
+    });
 
-    return [config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
-      auto filter = new Http::HttpSampleDecoderFilter(config);
+    return [config, route_configs](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+      auto filter = new Http::HttpSampleDecoderFilter(config, route_configs);
       callbacks.addStreamDecoderFilter(Http::StreamDecoderFilterSharedPtr{filter});
     };
   }
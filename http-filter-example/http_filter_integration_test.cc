@@ -1,4 +1,9 @@
+#include "envoy/extensions/filters/network/http_connection_manager/v3/http_connection_manager.pb.h"
+
 #include "test/integration/http_integration.h"
+#include "test/test_common/network_utility.h"
+
+#include "http-filter-example/http_filter.pb.h"
 
 namespace Envoy {
 class HttpFilterSampleIntegrationTest : public HttpIntegrationTest,
@@ -46,4 +51,106 @@ TEST_P(HttpFilterSampleIntegrationTest, Test1) {
 
   codec_client->close();
 }
+
+class HttpFilterSampleMutationsIntegrationTest : public HttpFilterSampleIntegrationTest {
+public:
+  void initialize() override {
+    config_helper_.prependFilter(R"EOF(
+name: sample
+typed_config:
+  "@type": type.googleapis.com/sample.Decoder
+  mutations:
+  - { action: SET, key: x-set, value: new }
+  - { action: APPEND, key: x-append, value: b }
+  - { action: REMOVE, key: x-remove }
+  - { action: ADD, key: x-client, value: "client=%DOWNSTREAM_REMOTE_ADDRESS_WITHOUT_PORT%" }
+  - { action: ADD, key: x-percent, value: "100%%" }
+)EOF");
+    HttpIntegrationTest::initialize();
+  }
+};
+
+INSTANTIATE_TEST_SUITE_P(IpVersions, HttpFilterSampleMutationsIntegrationTest,
+                         testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
+
+TEST_P(HttpFilterSampleMutationsIntegrationTest, Mutations) {
+  Http::TestRequestHeaderMapImpl headers{{":method", "GET"},  {":path", "/"},
+                                         {":authority", "host"}, {"x-set", "old"},
+                                         {"x-append", "a"},      {"x-remove", "gone"}};
+  Http::TestRequestHeaderMapImpl response_headers{{":status", "200"}};
+
+  IntegrationCodecClientPtr codec_client;
+  FakeHttpConnectionPtr fake_upstream_connection;
+  FakeStreamPtr request_stream;
+
+  codec_client = makeHttpConnection(lookupPort("http"));
+  auto response = codec_client->makeHeaderOnlyRequest(headers);
+  ASSERT_TRUE(fake_upstreams_[0]->waitForHttpConnection(*dispatcher_, fake_upstream_connection));
+  ASSERT_TRUE(fake_upstream_connection->waitForNewStream(*dispatcher_, request_stream));
+  ASSERT_TRUE(request_stream->waitForEndStream(*dispatcher_));
+  request_stream->encodeHeaders(response_headers, true);
+  ASSERT_TRUE(response->waitForEndStream());
+
+  const auto& upstream_headers = request_stream->headers();
+  EXPECT_EQ("new",
+            upstream_headers.get(Http::LowerCaseString("x-set"))[0]->value().getStringView());
+  EXPECT_EQ("a,b",
+            upstream_headers.get(Http::LowerCaseString("x-append"))[0]->value().getStringView());
+  EXPECT_TRUE(upstream_headers.get(Http::LowerCaseString("x-remove")).empty());
+  EXPECT_EQ(
+      "client=" + Network::Test::getLoopbackAddressString(GetParam()),
+      upstream_headers.get(Http::LowerCaseString("x-client"))[0]->value().getStringView());
+  EXPECT_EQ("100%",
+            upstream_headers.get(Http::LowerCaseString("x-percent"))[0]->value().getStringView());
+
+  codec_client->close();
+}
+
+class HttpFilterSamplePerRouteIntegrationTest : public HttpFilterSampleIntegrationTest {
+public:
+  void initialize() override {
+    config_helper_.addConfigModifier(
+        [](envoy::extensions::filters::network::http_connection_manager::v3::HttpConnectionManager&
+               hcm) {
+          sample::Decoder per_route;
+          per_route.set_key("via");
+          per_route.set_val("sample-route");
+          auto* virtual_host = hcm.mutable_route_config()->mutable_virtual_hosts(0);
+          (*virtual_host->mutable_routes(0)->mutable_typed_per_filter_config())["sample"].PackFrom(
+              per_route);
+        });
+    HttpFilterSampleIntegrationTest::initialize();
+  }
+};
+
+INSTANTIATE_TEST_SUITE_P(IpVersions, HttpFilterSamplePerRouteIntegrationTest,
+                         testing::ValuesIn(TestEnvironment::getIpVersionsForTest()));
+
+// The route's config replaces the listener's config, for every request on that route.
+TEST_P(HttpFilterSamplePerRouteIntegrationTest, PerRouteOverride) {
+  Http::TestRequestHeaderMapImpl headers{
+      {":method", "GET"}, {":path", "/"}, {":authority", "host"}};
+  Http::TestRequestHeaderMapImpl response_headers{{":status", "200"}};
+
+  IntegrationCodecClientPtr codec_client = makeHttpConnection(lookupPort("http"));
+  FakeHttpConnectionPtr fake_upstream_connection;
+  for (int i = 0; i < 2; i++) {
+    FakeStreamPtr request_stream;
+    auto response = codec_client->makeHeaderOnlyRequest(headers);
+    if (fake_upstream_connection == nullptr) {
+      ASSERT_TRUE(
+          fake_upstreams_[0]->waitForHttpConnection(*dispatcher_, fake_upstream_connection));
+    }
+    ASSERT_TRUE(fake_upstream_connection->waitForNewStream(*dispatcher_, request_stream));
+    ASSERT_TRUE(request_stream->waitForEndStream(*dispatcher_));
+    request_stream->encodeHeaders(response_headers, true);
+    ASSERT_TRUE(response->waitForEndStream());
+
+    const auto via = request_stream->headers().get(Http::LowerCaseString("via"));
+    ASSERT_EQ(1, via.size());
+    EXPECT_EQ("sample-route", via[0]->value().getStringView());
+  }
+
+  codec_client->close();
+}
 } // namespace Envoy